@@ -0,0 +1,467 @@
+/**
+ * \file cave-noise.c
+ * \brief Keeping the noise field up to date
+ *
+ * Copyright (c) 2026 Angband developers
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ *
+ * The noise field holds, for every grid, the number of steps noise takes to
+ * get there from the noise source (the player, or a decoy), passing only
+ * through grids which transmit sound and never through the player's grid;
+ * grids noise doesn't reach hold 0.  The source holds 0 too, or 2 if it is
+ * a grid noise could pass through, as it does when noise spreads out from
+ * the source and back again.
+ *
+ * Rather than build the whole field again every player turn, it is repaired
+ * where something it depends on has changed, touching only the grids whose
+ * distance changes:
+ * - when grids come closer to the source, the new distances are simply
+ *   spread outwards from where the change happened;
+ * - when grids go further away (or out of earshot), those which relied on
+ *   the change for their distance are found first, by following the field
+ *   outwards, and then they get distances again from the grids around them
+ *   which were unaffected.
+ */
+
+#include "angband.h"
+#include "cave.h"
+#include "generate.h"
+
+/**
+ * Distance of a grid noise doesn't reach
+ */
+#define NOISE_UNHEARD	0x7FFFFFFF
+
+/**
+ * Most changes to sound transmission kept until the next update before the
+ * whole field is built again instead
+ */
+#define NOISE_PENDING_MAX	32
+
+/**
+ * States of a grid while the field is repaired after it has gone quieter
+ */
+enum {
+	NOISE_CLEAR = 0,
+	NOISE_QUEUED,	/* Waiting to be checked */
+	NOISE_KEPT,		/* Still has a grid to hear the noise from */
+	NOISE_LOST		/* Lost the grid it heard the noise from */
+};
+
+/**
+ * Sound transmission of a grid as the field last saw it
+ */
+enum {
+	NOISE_CURRENT = 0,
+	NOISE_HELD_OPEN,
+	NOISE_HELD_CLOSED
+};
+
+/**
+ * Whether a grid is a noise source
+ */
+static bool noise_is_source(struct noise_flow *flow, struct loc grid)
+{
+	return loc_eq(grid, flow->source) ||
+		(flow->moving && loc_eq(grid, flow->next));
+}
+
+/**
+ * Whether noise can pass through a grid; changes to terrain the field hasn't
+ * been repaired for yet are ignored
+ */
+static bool noise_passes(struct chunk *c, struct loc grid)
+{
+	struct noise_flow *flow = &c->noise_flow;
+	int held;
+
+	if (!square_in_bounds(c, grid)) return false;
+	if (loc_eq(grid, flow->player)) return false;
+	held = flow->held ? flow->held[grid_to_i(grid, c->width)] : NOISE_CURRENT;
+	if (held != NOISE_CURRENT) return held == NOISE_HELD_OPEN;
+	return !square_isnoflow(c, grid);
+}
+
+/**
+ * Number of steps noise takes to reach a grid
+ */
+static int noise_dist(struct chunk *c, struct loc grid)
+{
+	int noise;
+
+	if (noise_is_source(&c->noise_flow, grid)) return 0;
+	noise = c->noise.grids[grid.y][grid.x];
+	return noise ? noise : NOISE_UNHEARD;
+}
+
+static void noise_set(struct chunk *c, struct loc grid, int dist)
+{
+	c->noise.grids[grid.y][grid.x] = (dist == NOISE_UNHEARD) ? 0 : dist;
+}
+
+/**
+ * Distance a grid would have from the grids around it
+ */
+static int noise_from_neighbours(struct chunk *c, struct loc grid)
+{
+	int d, best = NOISE_UNHEARD;
+
+	for (d = 0; d < 8; d++) {
+		struct loc adj = loc_sum(grid, ddgrid_ddd[d]);
+		int dist;
+
+		if (!square_in_bounds(c, adj)) continue;
+		dist = noise_dist(c, adj);
+		if ((dist != NOISE_UNHEARD) && (dist + 1 < best)) best = dist + 1;
+	}
+
+	return best;
+}
+
+/**
+ * Give the source the value the full propagation leaves it with
+ */
+static void noise_mark_source(struct chunk *c)
+{
+	struct loc source = c->noise_flow.source;
+	int d;
+
+	c->noise.grids[source.y][source.x] = 0;
+	if (!noise_passes(c, source)) return;
+	for (d = 0; d < 8; d++) {
+		if (noise_passes(c, loc_sum(source, ddgrid_ddd[d]))) {
+			c->noise.grids[source.y][source.x] = 2;
+			return;
+		}
+	}
+}
+
+/**
+ * Build the whole field from scratch
+ */
+static void noise_build(struct chunk *c)
+{
+	struct noise_flow *flow = &c->noise_flow;
+	int y, i, reached = 1;
+
+	for (y = 0; y < c->height; y++) {
+		memset(c->noise.grids[y], 0, c->width * sizeof(u16b));
+	}
+
+	/* Player makes noise; the source grid can be reached a second time */
+	flow->queue[0] = grid_to_i(flow->source, c->width);
+
+	/* Propagate noise */
+	for (i = 0; i < reached; i++) {
+		struct loc next;
+		int noise, d;
+
+		/* Get the next grid */
+		i_to_grid(flow->queue[i], c->width, &next);
+		noise = c->noise.grids[next.y][next.x] + 1;
+
+		/* Assign noise to the children and enqueue them */
+		for (d = 0; d < 8; d++) {
+			struct loc grid = loc_sum(next, ddgrid_ddd[d]);
+
+			if (!noise_passes(c, grid)) continue;
+			if (c->noise.grids[grid.y][grid.x] != 0) continue;
+			c->noise.grids[grid.y][grid.x] = noise;
+			flow->queue[reached++] = grid_to_i(grid, c->width);
+		}
+	}
+}
+
+/**
+ * Spread noise outwards from a grid which has just come closer to the source
+ */
+static void noise_spread(struct chunk *c, struct loc start)
+{
+	struct noise_flow *flow = &c->noise_flow;
+	int head = 0, tail = 0;
+
+	flow->queue[tail++] = grid_to_i(start, c->width);
+	while (head < tail) {
+		struct loc grid;
+		int dist, d;
+
+		i_to_grid(flow->queue[head++], c->width, &grid);
+		dist = noise_dist(c, grid);
+		for (d = 0; d < 8; d++) {
+			struct loc adj = loc_sum(grid, ddgrid_ddd[d]);
+
+			if (!noise_passes(c, adj) || noise_is_source(flow, adj)) continue;
+			if (noise_dist(c, adj) <= dist + 1) continue;
+			noise_set(c, adj, dist + 1);
+			flow->queue[tail++] = grid_to_i(adj, c->width);
+		}
+	}
+}
+
+/**
+ * Repair the field after a grid, which was old steps from the source, has
+ * got further away or stopped carrying noise
+ */
+static void noise_retreat(struct chunk *c, struct loc start, int old)
+{
+	struct noise_flow *flow = &c->noise_flow;
+	int head = 0, tail = 0, lost = 0, sorted = 0, low = NOISE_UNHEARD, high = 0;
+	int i;
+
+	/* Find the grids which only heard the noise through the start grid */
+	flow->queue[tail++] = grid_to_i(start, c->width);
+	flow->mark[flow->queue[0]] = NOISE_QUEUED;
+	while (head < tail) {
+		int idx = flow->queue[head++];
+		struct loc grid;
+		int dist, d;
+
+		i_to_grid(idx, c->width, &grid);
+		dist = head == 1 ? old : noise_dist(c, grid);
+
+		/* A grid still one step further out than an unaffected one keeps its
+		 * distance; grids are checked in order of distance, so all those
+		 * closer in have already been decided */
+		if (head > 1) {
+			for (d = 0; d < 8; d++) {
+				struct loc adj = loc_sum(grid, ddgrid_ddd[d]);
+
+				if (!square_in_bounds(c, adj)) continue;
+				if (flow->mark[grid_to_i(adj, c->width)] == NOISE_LOST) continue;
+				if (noise_dist(c, adj) == dist - 1) break;
+			}
+			if (d < 8) {
+				flow->mark[idx] = NOISE_KEPT;
+				continue;
+			}
+		}
+
+		/* Anything which heard the noise from here has to be checked */
+		flow->mark[idx] = NOISE_LOST;
+		flow->list[lost++] = idx;
+		for (d = 0; d < 8; d++) {
+			struct loc adj = loc_sum(grid, ddgrid_ddd[d]);
+			int adj_idx;
+
+			if (!noise_passes(c, adj) || noise_is_source(flow, adj)) continue;
+			adj_idx = grid_to_i(adj, c->width);
+			if (flow->mark[adj_idx] != NOISE_CLEAR) continue;
+			if (noise_dist(c, adj) != dist + 1) continue;
+			flow->mark[adj_idx] = NOISE_QUEUED;
+			flow->queue[tail++] = adj_idx;
+		}
+	}
+	for (i = 0; i < tail; i++) {
+		flow->mark[flow->queue[i]] = NOISE_CLEAR;
+	}
+
+	/* Silence the affected grids, then see how close the unaffected grids
+	 * around each one would put it */
+	for (i = 0; i < lost; i++) {
+		struct loc grid;
+		i_to_grid(flow->list[i], c->width, &grid);
+		noise_set(c, grid, NOISE_UNHEARD);
+	}
+	for (i = 0; i < lost; i++) {
+		struct loc grid;
+		i_to_grid(flow->list[i], c->width, &grid);
+		flow->key[i] = noise_passes(c, grid) ?
+			noise_from_neighbours(c, grid) : NOISE_UNHEARD;
+		if (flow->key[i] == NOISE_UNHEARD) continue;
+		low = MIN(low, flow->key[i]);
+		high = MAX(high, flow->key[i]);
+	}
+
+	/* Sort those which can hear anything by that distance */
+	if (low <= high) {
+		memset(flow->counts, 0, (high - low + 2) * sizeof(int));
+		for (i = 0; i < lost; i++) {
+			if (flow->key[i] == NOISE_UNHEARD) continue;
+			flow->counts[flow->key[i] - low + 1]++;
+		}
+		for (i = 1; i <= high - low + 1; i++) {
+			flow->counts[i] += flow->counts[i - 1];
+		}
+		for (i = 0; i < lost; i++) {
+			if (flow->key[i] == NOISE_UNHEARD) continue;
+			flow->sorted[flow->counts[flow->key[i] - low]++] = i;
+			sorted++;
+		}
+	}
+
+	/* Spread noise into the affected grids, nearest first */
+	head = tail = i = 0;
+	while ((i < sorted) || (head < tail)) {
+		struct loc grid;
+		int dist, d, queued = NOISE_UNHEARD;
+
+		if (head < tail) {
+			i_to_grid(flow->queue[head], c->width, &grid);
+			queued = noise_dist(c, grid);
+		}
+
+		if ((i < sorted) && (flow->key[flow->sorted[i]] <= queued)) {
+			int entry = flow->sorted[i++];
+
+			i_to_grid(flow->list[entry], c->width, &grid);
+			if (noise_dist(c, grid) <= flow->key[entry]) continue;
+			noise_set(c, grid, flow->key[entry]);
+		} else {
+			head++;
+		}
+
+		dist = noise_dist(c, grid);
+		for (d = 0; d < 8; d++) {
+			struct loc adj = loc_sum(grid, ddgrid_ddd[d]);
+
+			if (!noise_passes(c, adj) || noise_is_source(flow, adj)) continue;
+			if (noise_dist(c, adj) <= dist + 1) continue;
+			noise_set(c, adj, dist + 1);
+			flow->queue[tail++] = grid_to_i(adj, c->width);
+		}
+	}
+}
+
+/**
+ * Repair the field at a grid which may have started or stopped carrying noise
+ */
+static void noise_repair(struct chunk *c, struct loc grid)
+{
+	struct noise_flow *flow = &c->noise_flow;
+	int dist;
+
+	if (noise_is_source(flow, grid)) return;
+	dist = noise_dist(c, grid);
+	if (noise_passes(c, grid)) {
+		int closer = noise_from_neighbours(c, grid);
+		if (closer < dist) {
+			noise_set(c, grid, closer);
+			noise_spread(c, grid);
+		}
+	} else if (dist != NOISE_UNHEARD) {
+		noise_retreat(c, grid, dist);
+	}
+}
+
+/**
+ * Bring the noise field up to date for a noise source and player grid.
+ *
+ * The field is built from scratch the first time, and after the source jumps
+ * more than a step or too much terrain has changed; otherwise it is repaired.
+ */
+void cave_update_noise(struct chunk *c, struct loc source, struct loc player)
+{
+	struct noise_flow *flow = &c->noise_flow;
+	int i;
+
+	/* Work space, which can hold the source twice */
+	if (!flow->queue) {
+		int n = c->height * c->width;
+		flow->queue = mem_zalloc((n + 1) * sizeof(int));
+		flow->list = mem_zalloc(n * sizeof(int));
+		flow->key = mem_zalloc(n * sizeof(int));
+		flow->sorted = mem_zalloc(n * sizeof(int));
+		flow->counts = mem_zalloc((n + 2) * sizeof(int));
+		flow->mark = mem_zalloc(n * sizeof(byte));
+		flow->held = mem_zalloc(n * sizeof(byte));
+		flow->pending = mem_zalloc(NOISE_PENDING_MAX * sizeof(int));
+	}
+
+	if (!flow->valid || (distance(flow->source, source) > 1)) {
+		for (i = 0; i < flow->pending_count; i++) {
+			flow->held[flow->pending[i]] = NOISE_CURRENT;
+		}
+		flow->pending_count = 0;
+		flow->source = source;
+		flow->player = player;
+		noise_build(c);
+		flow->valid = true;
+		return;
+	}
+
+	/* Catch up with changes to the terrain, one at a time */
+	for (i = 0; i < flow->pending_count; i++) {
+		struct loc grid;
+
+		flow->held[flow->pending[i]] = NOISE_CURRENT;
+		i_to_grid(flow->pending[i], c->width, &grid);
+		noise_repair(c, grid);
+	}
+	flow->pending_count = 0;
+
+	/* Add the new source before removing the old one */
+	if (!loc_eq(source, flow->source)) {
+		struct loc old = flow->source;
+
+		flow->next = source;
+		flow->moving = true;
+		noise_spread(c, source);
+		flow->source = source;
+		flow->moving = false;
+		noise_retreat(c, old, 0);
+	}
+
+	/* Let noise through where the player was, and stop it where they are */
+	if (!loc_eq(player, flow->player)) {
+		struct loc old = flow->player;
+
+		flow->player = loc(-1, -1);
+		if (square_in_bounds(c, old)) noise_repair(c, old);
+		flow->player = player;
+		noise_repair(c, player);
+	}
+
+	noise_mark_source(c);
+}
+
+/**
+ * Note that sound transmission has changed at a grid.
+ *
+ * The field is repaired at the next cave_update_noise(), so that it keeps
+ * the terrain it saw until then.
+ */
+void cave_noise_terrain_changed(struct chunk *c, struct loc grid)
+{
+	struct noise_flow *flow = &c->noise_flow;
+	int idx = grid_to_i(grid, c->width);
+
+	if (!flow->valid) return;
+
+	/* Already waiting */
+	if (flow->held[idx] != NOISE_CURRENT) return;
+
+	if (flow->pending_count == NOISE_PENDING_MAX) {
+		flow->valid = false;
+		return;
+	}
+	flow->held[idx] = square_isnoflow(c, grid) ?
+		NOISE_HELD_OPEN : NOISE_HELD_CLOSED;
+	flow->pending[flow->pending_count++] = idx;
+}
+
+/**
+ * Free the noise field's work space
+ */
+void cave_noise_free(struct chunk *c)
+{
+	struct noise_flow *flow = &c->noise_flow;
+
+	mem_free(flow->queue);
+	mem_free(flow->list);
+	mem_free(flow->key);
+	mem_free(flow->sorted);
+	mem_free(flow->counts);
+	mem_free(flow->mark);
+	mem_free(flow->held);
+	mem_free(flow->pending);
+}
@@ -19,6 +19,7 @@
 #include "angband.h"
 #include "cave.h"
 #include "game-world.h"
+#include "generate.h"
 #include "init.h"
 #include "monster.h"
 #include "obj-knowledge.h"
@@ -185,8 +186,8 @@ bool feat_is_smooth(int feat)
  * SQUARE FEATURE PREDICATES
  *
  * These functions are used to figure out what kind of square something is,
- * via c->squares[y][x].feat (preferably accessed via square(c, grid)).
- * All direct testing of square(c, grid).feat should be rewritten
+ * via c->squares.feat (preferably accessed via square_fidx(c, grid)).
+ * All direct testing of square_fidx(c, grid) should be rewritten
  * in terms of these functions.
  *
  * It's often better to use square behavior predicates (written in terms of
@@ -202,7 +203,7 @@ bool feat_is_smooth(int feat)
  */
 bool square_isfloor(struct chunk *c, struct loc grid)
 {
-	return feat_is_floor(square(c, grid).feat);
+	return feat_is_floor(square_fidx(c, grid));
 }
 
 /**
@@ -210,7 +211,7 @@ bool square_isfloor(struct chunk *c, struct loc grid)
  */
 bool square_istrappable(struct chunk *c, struct loc grid)
 {
-	return feat_is_trap_holding(square(c, grid).feat);
+	return feat_is_trap_holding(square_fidx(c, grid));
 }
 
 /**
@@ -218,7 +219,7 @@ bool square_istrappable(struct chunk *c, struct loc grid)
  */
 bool square_isobjectholding(struct chunk *c, struct loc grid)
 {
-	return feat_is_object_holding(square(c, grid).feat);
+	return feat_is_object_holding(square_fidx(c, grid));
 }
 
 /**
@@ -226,8 +227,8 @@ bool square_isobjectholding(struct chunk *c, struct loc grid)
  */
 bool square_isrock(struct chunk *c, struct loc grid)
 {
-	return (tf_has(f_info[square(c, grid).feat].flags, TF_GRANITE) &&
-			!tf_has(f_info[square(c, grid).feat].flags, TF_DOOR_ANY));
+	return (tf_has(f_info[square_fidx(c, grid)].flags, TF_GRANITE) &&
+			!tf_has(f_info[square_fidx(c, grid)].flags, TF_DOOR_ANY));
 }
 
 /**
@@ -235,7 +236,7 @@ bool square_isrock(struct chunk *c, struct loc grid)
  */
 bool square_isgranite(struct chunk *c, struct loc grid)
 {
-	return feat_is_granite(square(c, grid).feat);
+	return feat_is_granite(square_fidx(c, grid));
 }
 
 /**
@@ -243,8 +244,8 @@ bool square_isgranite(struct chunk *c, struct loc grid)
  */
 bool square_isperm(struct chunk *c, struct loc grid)
 {
-	return (tf_has(f_info[square(c, grid).feat].flags, TF_PERMANENT) &&
-			tf_has(f_info[square(c, grid).feat].flags, TF_ROCK));
+	return (tf_has(f_info[square_fidx(c, grid)].flags, TF_PERMANENT) &&
+			tf_has(f_info[square_fidx(c, grid)].flags, TF_ROCK));
 }
 
 /**
@@ -252,7 +253,7 @@ bool square_isperm(struct chunk *c, struct loc grid)
  */
 bool square_ismagma(struct chunk *c, struct loc grid)
 {
-	return feat_is_magma(square(c, grid).feat);
+	return feat_is_magma(square_fidx(c, grid));
 }
 
 /**
@@ -260,7 +261,7 @@ bool square_ismagma(struct chunk *c, struct loc grid)
  */
 bool square_isquartz(struct chunk *c, struct loc grid)
 {
-	return feat_is_quartz(square(c, grid).feat);
+	return feat_is_quartz(square_fidx(c, grid));
 }
 
 /**
@@ -274,7 +275,7 @@ bool square_ismineral(struct chunk *c, struct loc grid)
 
 bool square_hasgoldvein(struct chunk *c, struct loc grid)
 {
-	return tf_has(f_info[square(c, grid).feat].flags, TF_GOLD);
+	return tf_has(f_info[square_fidx(c, grid)].flags, TF_GOLD);
 }
 
 /**
@@ -282,8 +283,8 @@ bool square_hasgoldvein(struct chunk *c, struct loc grid)
  */
 bool square_isrubble(struct chunk *c, struct loc grid)
 {
-    return (!tf_has(f_info[square(c, grid).feat].flags, TF_WALL) &&
-			tf_has(f_info[square(c, grid).feat].flags, TF_ROCK));
+    return (!tf_has(f_info[square_fidx(c, grid)].flags, TF_WALL) &&
+			tf_has(f_info[square_fidx(c, grid)].flags, TF_ROCK));
 }
 
 /**
@@ -294,8 +295,8 @@ bool square_isrubble(struct chunk *c, struct loc grid)
  */
 bool square_issecretdoor(struct chunk *c, struct loc grid)
 {
-    return (tf_has(f_info[square(c, grid).feat].flags, TF_DOOR_ANY) &&
-			tf_has(f_info[square(c, grid).feat].flags, TF_ROCK));
+    return (tf_has(f_info[square_fidx(c, grid)].flags, TF_DOOR_ANY) &&
+			tf_has(f_info[square_fidx(c, grid)].flags, TF_ROCK));
 }
 
 /**
@@ -303,7 +304,7 @@ bool square_issecretdoor(struct chunk *c, struct loc grid)
  */
 bool square_isopendoor(struct chunk *c, struct loc grid)
 {
-    return (tf_has(f_info[square(c, grid).feat].flags, TF_CLOSABLE));
+    return (tf_has(f_info[square_fidx(c, grid)].flags, TF_CLOSABLE));
 }
 
 /**
@@ -311,13 +312,13 @@ bool square_isopendoor(struct chunk *c, struct loc grid)
  */
 bool square_iscloseddoor(struct chunk *c, struct loc grid)
 {
-	int feat = square(c, grid).feat;
+	int feat = square_fidx(c, grid);
 	return tf_has(f_info[feat].flags, TF_DOOR_CLOSED);
 }
 
 bool square_isbrokendoor(struct chunk *c, struct loc grid)
 {
-	int feat = square(c, grid).feat;
+	int feat = square_fidx(c, grid);
     return (tf_has(f_info[feat].flags, TF_DOOR_ANY) &&
 			tf_has(f_info[feat].flags, TF_PASSABLE) &&
 			!tf_has(f_info[feat].flags, TF_CLOSABLE));
@@ -330,7 +331,7 @@ bool square_isbrokendoor(struct chunk *c, struct loc grid)
  */
 bool square_isdoor(struct chunk *c, struct loc grid)
 {
-	int feat = square(c, grid).feat;
+	int feat = square_fidx(c, grid);
 	return tf_has(f_info[feat].flags, TF_DOOR_ANY);
 }
 
@@ -339,7 +340,7 @@ bool square_isdoor(struct chunk *c, struct loc grid)
  */
 bool square_isstairs(struct chunk *c, struct loc grid)
 {
-	int feat = square(c, grid).feat;
+	int feat = square_fidx(c, grid);
 	return tf_has(f_info[feat].flags, TF_STAIR);
 }
 
@@ -348,7 +349,7 @@ bool square_isstairs(struct chunk *c, struct loc grid)
  */
 bool square_isupstairs(struct chunk*c, struct loc grid)
 {
-	int feat = square(c, grid).feat;
+	int feat = square_fidx(c, grid);
 	return tf_has(f_info[feat].flags, TF_UPSTAIR);
 }
 
@@ -357,7 +358,7 @@ bool square_isupstairs(struct chunk*c, struct loc grid)
  */
 bool square_isdownstairs(struct chunk *c, struct loc grid)
 {
-	int feat = square(c, grid).feat;
+	int feat = square_fidx(c, grid);
 	return tf_has(f_info[feat].flags, TF_DOWNSTAIR);
 }
 
@@ -366,21 +367,21 @@ bool square_isdownstairs(struct chunk *c, struct loc grid)
  */
 bool square_isshop(struct chunk *c, struct loc grid)
 {
-	return feat_is_shop(square(c, grid).feat);
+	return feat_is_shop(square_fidx(c, grid));
 }
 
 /**
  * True if the square contains the player
  */
 bool square_isplayer(struct chunk *c, struct loc grid) {
-	return square(c, grid).mon < 0 ? true : false;
+	return square_midx(c, grid) < 0 ? true : false;
 }
 
 /**
  * True if the square contains the player or a monster
  */
 bool square_isoccupied(struct chunk *c, struct loc grid) {
-	return square(c, grid).mon != 0 ? true : false;
+	return square_midx(c, grid) != 0 ? true : false;
 }
 
 /**
@@ -389,7 +390,7 @@ bool square_isoccupied(struct chunk *c, struct loc grid) {
 bool square_isknown(struct chunk *c, struct loc grid) {
 	if (c != cave) return false;
 	if (player->cave == NULL) return false;
-	return square(player->cave, grid).feat == FEAT_NONE ? false : true;
+	return square_fidx(player->cave, grid) == FEAT_NONE ? false : true;
 }
 
 /**
@@ -399,7 +400,7 @@ bool square_isknown(struct chunk *c, struct loc grid) {
 bool square_isnotknown(struct chunk *c, struct loc grid) {
 	if (c != cave) return false;
 	if (player->cave == NULL) return true;
-	return square(player->cave, grid).feat != square(c, grid).feat;
+	return square_fidx(player->cave, grid) != square_fidx(c, grid);
 }
 
 /**
@@ -415,7 +416,7 @@ bool square_isnotknown(struct chunk *c, struct loc grid) {
  */
 bool square_ismark(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_MARK);
+	return sqinfo_has(square_info(c, grid), SQUARE_MARK);
 }
 
 /**
@@ -423,7 +424,7 @@ bool square_ismark(struct chunk *c, struct loc grid) {
  */
 bool square_isglow(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_GLOW);
+	return sqinfo_has(square_info(c, grid), SQUARE_GLOW);
 }
 
 /**
@@ -433,7 +434,7 @@ bool square_isglow(struct chunk *c, struct loc grid) {
  */
 bool square_isvault(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_VAULT);
+	return sqinfo_has(square_info(c, grid), SQUARE_VAULT);
 }
 
 /**
@@ -441,7 +442,7 @@ bool square_isvault(struct chunk *c, struct loc grid) {
  */
 bool square_isroom(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_ROOM);
+	return sqinfo_has(square_info(c, grid), SQUARE_ROOM);
 }
 
 /**
@@ -449,7 +450,7 @@ bool square_isroom(struct chunk *c, struct loc grid) {
  */
 bool square_isseen(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_SEEN);
+	return sqinfo_has(square_info(c, grid), SQUARE_SEEN);
 }
 
 /**
@@ -457,7 +458,7 @@ bool square_isseen(struct chunk *c, struct loc grid) {
  */
 bool square_isview(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_VIEW);
+	return sqinfo_has(square_info(c, grid), SQUARE_VIEW);
 }
 
 /**
@@ -465,7 +466,7 @@ bool square_isview(struct chunk *c, struct loc grid) {
  */
 bool square_wasseen(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_WASSEEN);
+	return sqinfo_has(square_info(c, grid), SQUARE_WASSEEN);
 }
 
 /**
@@ -473,7 +474,7 @@ bool square_wasseen(struct chunk *c, struct loc grid) {
  */
 bool square_isfeel(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_FEEL);
+	return sqinfo_has(square_info(c, grid), SQUARE_FEEL);
 }
 
 /**
@@ -481,7 +482,7 @@ bool square_isfeel(struct chunk *c, struct loc grid) {
  */
 bool square_istrap(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_TRAP);
+	return sqinfo_has(square_info(c, grid), SQUARE_TRAP);
 }
 
 /**
@@ -489,7 +490,7 @@ bool square_istrap(struct chunk *c, struct loc grid) {
  */
 bool square_isinvis(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_INVIS);
+	return sqinfo_has(square_info(c, grid), SQUARE_INVIS);
 }
 
 /**
@@ -497,7 +498,7 @@ bool square_isinvis(struct chunk *c, struct loc grid) {
  */
 bool square_iswall_inner(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_WALL_INNER);
+	return sqinfo_has(square_info(c, grid), SQUARE_WALL_INNER);
 }
 
 /**
@@ -505,7 +506,7 @@ bool square_iswall_inner(struct chunk *c, struct loc grid) {
  */
 bool square_iswall_outer(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_WALL_OUTER);
+	return sqinfo_has(square_info(c, grid), SQUARE_WALL_OUTER);
 }
 
 /**
@@ -513,7 +514,7 @@ bool square_iswall_outer(struct chunk *c, struct loc grid) {
  */
 bool square_iswall_solid(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_WALL_SOLID);
+	return sqinfo_has(square_info(c, grid), SQUARE_WALL_SOLID);
 }
 
 /**
@@ -521,7 +522,7 @@ bool square_iswall_solid(struct chunk *c, struct loc grid) {
  */
 bool square_ismon_restrict(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_MON_RESTRICT);
+	return sqinfo_has(square_info(c, grid), SQUARE_MON_RESTRICT);
 }
 
 /**
@@ -529,7 +530,7 @@ bool square_ismon_restrict(struct chunk *c, struct loc grid) {
  */
 bool square_isno_teleport(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_NO_TELEPORT);
+	return sqinfo_has(square_info(c, grid), SQUARE_NO_TELEPORT);
 }
 
 /**
@@ -537,7 +538,7 @@ bool square_isno_teleport(struct chunk *c, struct loc grid) {
  */
 bool square_isno_map(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_NO_MAP);
+	return sqinfo_has(square_info(c, grid), SQUARE_NO_MAP);
 }
 
 /**
@@ -545,7 +546,7 @@ bool square_isno_map(struct chunk *c, struct loc grid) {
  */
 bool square_isno_esp(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_NO_ESP);
+	return sqinfo_has(square_info(c, grid), SQUARE_NO_ESP);
 }
 
 /**
@@ -553,7 +554,7 @@ bool square_isno_esp(struct chunk *c, struct loc grid) {
  */
 bool square_isproject(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_PROJECT);
+	return sqinfo_has(square_info(c, grid), SQUARE_PROJECT);
 }
 
 /**
@@ -561,7 +562,7 @@ bool square_isproject(struct chunk *c, struct loc grid) {
  */
 bool square_isdtrap(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_DTRAP);
+	return sqinfo_has(square_info(c, grid), SQUARE_DTRAP);
 }
 
 /**
@@ -569,7 +570,7 @@ bool square_isdtrap(struct chunk *c, struct loc grid) {
  */
 bool square_isno_stairs(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid).info, SQUARE_NO_STAIRS);
+	return sqinfo_has(square_info(c, grid), SQUARE_NO_STAIRS);
 }
 
 
@@ -587,7 +588,7 @@ bool square_isno_stairs(struct chunk *c, struct loc grid) {
  * True if the square is open (a floor square not occupied by a monster).
  */
 bool square_isopen(struct chunk *c, struct loc grid) {
-	return square_isfloor(c, grid) && !square(c, grid).mon;
+	return square_isfloor(c, grid) && !square_midx(c, grid);
 }
 
 /**
@@ -603,7 +604,7 @@ bool square_isempty(struct chunk *c, struct loc grid) {
  * True if the square is empty (an open square without any items).
  */
 bool square_isarrivable(struct chunk *c, struct loc grid) {
-	if (square(c, grid).mon) return false;
+	if (square_midx(c, grid)) return false;
 	if (square_isplayertrap(c, grid)) return false;
 	if (square_iswebbed(c, grid)) return false;
 	if (square_isfloor(c, grid)) return true;
@@ -647,7 +648,7 @@ bool square_iswebbable(struct chunk *c, struct loc grid) {
 bool square_is_monster_walkable(struct chunk *c, struct loc grid)
 {
 	assert(square_in_bounds(c, grid));
-	return feat_is_monster_walkable(square(c, grid).feat);
+	return feat_is_monster_walkable(square_fidx(c, grid));
 }
 
 /**
@@ -655,7 +656,7 @@ bool square_is_monster_walkable(struct chunk *c, struct loc grid)
  */
 bool square_ispassable(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return feat_is_passable(square(c, grid).feat);
+	return feat_is_passable(square_fidx(c, grid));
 }
 
 /**
@@ -665,7 +666,7 @@ bool square_ispassable(struct chunk *c, struct loc grid) {
  */
 bool square_isprojectable(struct chunk *c, struct loc grid) {
 	if (!square_in_bounds(c, grid)) return false;
-	return feat_is_projectable(square(c, grid).feat);
+	return feat_is_projectable(square_fidx(c, grid));
 }
 
 /**
@@ -694,7 +695,7 @@ bool square_isstrongwall(struct chunk *c, struct loc grid) {
  */
 bool square_isbright(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return feat_is_bright(square(c, grid).feat);
+	return feat_is_bright(square_fidx(c, grid));
 }
 
 /**
@@ -702,7 +703,7 @@ bool square_isbright(struct chunk *c, struct loc grid) {
  */
 bool square_isfiery(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return feat_is_fiery(square(c, grid).feat);
+	return feat_is_fiery(square_fidx(c, grid));
 }
 
 /**
@@ -737,7 +738,7 @@ bool square_islitwall(struct chunk *c, struct loc grid) {
  */
 bool square_isdamaging(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return feat_is_fiery(square(c, grid).feat);
+	return feat_is_fiery(square_fidx(c, grid));
 }
 
 /**
@@ -745,7 +746,7 @@ bool square_isdamaging(struct chunk *c, struct loc grid) {
  */
 bool square_isnoflow(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return feat_is_no_flow(square(c, grid).feat);
+	return feat_is_no_flow(square_fidx(c, grid));
 }
 
 /**
@@ -753,7 +754,7 @@ bool square_isnoflow(struct chunk *c, struct loc grid) {
  */
 bool square_isnoscent(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return feat_is_no_scent(square(c, grid).feat);
+	return feat_is_no_scent(square_fidx(c, grid));
 }
 
 bool square_iswarded(struct chunk *c, struct loc grid)
@@ -776,12 +777,12 @@ bool square_iswebbed(struct chunk *c, struct loc grid)
 
 bool square_seemslikewall(struct chunk *c, struct loc grid)
 {
-	return tf_has(f_info[square(c, grid).feat].flags, TF_ROCK);
+	return tf_has(f_info[square_fidx(c, grid)].flags, TF_ROCK);
 }
 
 bool square_isinteresting(struct chunk *c, struct loc grid)
 {
-	int f = square(c, grid).feat;
+	int f = square_fidx(c, grid);
 	return tf_has(f_info[f].flags, TF_INTERESTING);
 }
 
@@ -939,22 +940,16 @@ bool square_suits_stairs_ok(struct chunk *c, struct loc grid)
  * Below are various square-specific functions which are not predicates
  */
 
-struct square square(struct chunk *c, struct loc grid)
-{
-	assert(square_in_bounds(c, grid));
-	return c->squares[grid.y][grid.x];
-}
-
 struct feature *square_feat(struct chunk *c, struct loc grid)
 {
 	assert(square_in_bounds(c, grid));
-	return &f_info[square(c, grid).feat];
+	return &f_info[square_fidx(c, grid)];
 }
 
 int square_light(struct chunk *c, struct loc grid)
 {
 	assert(square_in_bounds(c, grid));
-	return square(c, grid).light;
+	return c->squares.light[square_idx(c, grid)];
 }
 
 /**
@@ -963,8 +958,8 @@ int square_light(struct chunk *c, struct loc grid)
 struct monster *square_monster(struct chunk *c, struct loc grid)
 {
 	if (!square_in_bounds(c, grid)) return NULL;
-	if (square(c, grid).mon > 0) {
-		struct monster *mon = cave_monster(c, square(c, grid).mon);
+	if (square_midx(c, grid) > 0) {
+		struct monster *mon = cave_monster(c, square_midx(c, grid));
 		return mon->race ? mon : NULL;
 	}
 
@@ -976,7 +971,7 @@ struct monster *square_monster(struct chunk *c, struct loc grid)
  */
 struct object *square_object(struct chunk *c, struct loc grid) {
 	if (!square_in_bounds(c, grid)) return NULL;
-	return square(c, grid).obj;
+	return c->squares.obj[square_idx(c, grid)];
 }
 
 /**
@@ -985,7 +980,7 @@ struct object *square_object(struct chunk *c, struct loc grid) {
 struct trap *square_trap(struct chunk *c, struct loc grid)
 {
 	if (!square_in_bounds(c, grid)) return NULL;
-    return square(c, grid).trap;
+	return c->squares.trap[square_idx(c, grid)];
 }
 
 /**
@@ -1001,7 +996,7 @@ bool square_holds_object(struct chunk *c, struct loc grid, struct object *obj) {
  */
 void square_excise_object(struct chunk *c, struct loc grid, struct object *obj){
 	assert(square_in_bounds(c, grid));
-	pile_excise(&c->squares[grid.y][grid.x].obj, obj);
+	pile_excise(&c->squares.obj[square_idx(c, grid)], obj);
 }
 
 /**
@@ -1083,10 +1078,10 @@ int square_num_walls_adjacent(struct chunk *c, struct loc grid)
     int k = 0;
     assert(square_in_bounds(c, grid));
 
-    if (feat_is_wall(square(c, next_grid(grid, DIR_S)).feat)) k++;
-	if (feat_is_wall(square(c, next_grid(grid, DIR_N)).feat)) k++;
-    if (feat_is_wall(square(c, next_grid(grid, DIR_E)).feat)) k++;
-    if (feat_is_wall(square(c, next_grid(grid, DIR_W)).feat)) k++;
+    if (feat_is_wall(square_fidx(c, next_grid(grid, DIR_S)))) k++;
+	if (feat_is_wall(square_fidx(c, next_grid(grid, DIR_N)))) k++;
+    if (feat_is_wall(square_fidx(c, next_grid(grid, DIR_E)))) k++;
+    if (feat_is_wall(square_fidx(c, next_grid(grid, DIR_W)))) k++;
 
     return k;
 }
@@ -1103,10 +1098,10 @@ int square_num_walls_diagonal(struct chunk *c, struct loc grid)
     int k = 0;
     assert(square_in_bounds(c, grid));
 
-    if (feat_is_wall(square(c, next_grid(grid, DIR_SE)).feat)) k++;
-    if (feat_is_wall(square(c, next_grid(grid, DIR_NW)).feat)) k++;
-    if (feat_is_wall(square(c, next_grid(grid, DIR_NE)).feat)) k++;
-    if (feat_is_wall(square(c, next_grid(grid, DIR_SW)).feat)) k++;
+    if (feat_is_wall(square_fidx(c, next_grid(grid, DIR_SE)))) k++;
+    if (feat_is_wall(square_fidx(c, next_grid(grid, DIR_NW)))) k++;
+    if (feat_is_wall(square_fidx(c, next_grid(grid, DIR_NE)))) k++;
+    if (feat_is_wall(square_fidx(c, next_grid(grid, DIR_SW)))) k++;
 
     return k;
 }
@@ -1123,18 +1118,38 @@ void square_set_feat(struct chunk *c, struct loc grid, int feat)
 	int current_feat;
 
 	assert(square_in_bounds(c, grid));
-	current_feat = square(c, grid).feat;
+	current_feat = square_fidx(c, grid);
 
 	/* Track changes */
 	if (current_feat) c->feat_count[current_feat]--;
 	if (feat) c->feat_count[feat]++;
 
 	/* Make the change */
-	c->squares[grid.y][grid.x].feat = feat;
+	c->squares.feat[square_idx(c, grid)] = feat;
+	cave_floor_update(c, square_idx(c, grid), current_feat, feat);
+
+	/* Bright terrain lights the neighbours before it row by row, as
+	 * calc_lighting() does */
+	if (c->light_known &&
+		(feat_is_bright(current_feat) != feat_is_bright(feat))) {
+		int d, change = feat_is_bright(feat) ? 1 : -1;
+		c->squares.light[square_idx(c, grid)] += 2 * change;
+		for (d = 0; d < 8; d++) {
+			struct loc adj = loc_sum(grid, ddgrid_ddd[d]);
+			if (!square_in_bounds(c, adj)) continue;
+			if ((adj.y > grid.y) || ((adj.y == grid.y) && (adj.x > grid.x)))
+				continue;
+			c->squares.light[square_idx(c, adj)] += change;
+		}
+	}
+
+	/* Changes to sound transmission may alter the noise field */
+	if (feat_is_no_flow(current_feat) != feat_is_no_flow(feat))
+		cave_noise_terrain_changed(c, grid);
 
 	/* Light bright terrain */
 	if (feat_is_bright(feat)) {
-		sqinfo_on(square(c, grid).info, SQUARE_GLOW);
+		square_glow(c, grid);
 	}
 
 	/* Make the new terrain feel at home */
@@ -1147,9 +1162,9 @@ void square_set_feat(struct chunk *c, struct loc grid, int feat)
 		square_light_spot(c, grid);
 	} else {
 		/* Make sure no incorrect wall flags set for dungeon generation */
-		sqinfo_off(square(c, grid).info, SQUARE_WALL_INNER);
-		sqinfo_off(square(c, grid).info, SQUARE_WALL_OUTER);
-		sqinfo_off(square(c, grid).info, SQUARE_WALL_SOLID);
+		sqinfo_off(square_info(c, grid), SQUARE_WALL_INNER);
+		sqinfo_off(square_info(c, grid), SQUARE_WALL_OUTER);
+		sqinfo_off(square_info(c, grid), SQUARE_WALL_SOLID);
 	}
 }
 
@@ -1159,7 +1174,9 @@ void square_set_feat(struct chunk *c, struct loc grid, int feat)
 static void square_set_known_feat(struct chunk *c, struct loc grid, int feat)
 {
 	if (c != cave) return;
-	player->cave->squares[grid.y][grid.x].feat = feat;
+	cave_floor_update(player->cave, square_idx(player->cave, grid),
+					  square_fidx(player->cave, grid), feat);
+	player->cave->squares.feat[square_idx(player->cave, grid)] = feat;
 }
 
 /**
@@ -1167,7 +1184,8 @@ static void square_set_known_feat(struct chunk *c, struct loc grid, int feat)
  */
 void square_set_mon(struct chunk *c, struct loc grid, int midx)
 {
-	c->squares[grid.y][grid.x].mon = midx;
+	cave_monster_file(c, grid, square_midx(c, grid), midx);
+	c->squares.mon[square_idx(c, grid)] = midx;
 }
 
 /**
@@ -1175,7 +1193,7 @@ void square_set_mon(struct chunk *c, struct loc grid, int midx)
  */
 void square_set_obj(struct chunk *c, struct loc grid, struct object *obj)
 {
-	c->squares[grid.y][grid.x].obj = obj;
+	c->squares.obj[square_idx(c, grid)] = obj;
 }
 
 /**
@@ -1183,7 +1201,7 @@ void square_set_obj(struct chunk *c, struct loc grid, struct object *obj)
  */
 void square_set_trap(struct chunk *c, struct loc grid, struct trap *trap)
 {
-	c->squares[grid.y][grid.x].trap = trap;
+	c->squares.trap[square_idx(c, grid)] = trap;
 }
 
 void square_add_trap(struct chunk *c, struct loc grid)
@@ -1223,7 +1241,7 @@ void square_add_stairs(struct chunk *c, struct loc grid, int depth) {
 	int down = randint0(100) < 50;
 	if (depth == 0)
 		down = 1;
-	else if (is_quest(depth) || depth >= z_info->max_depth - 1)
+	else if (is_quest(gen_player(c), depth) || depth >= z_info->max_depth - 1)
 		down = 0;
 
 	square_set_feat(c, grid, down ? FEAT_MORE : FEAT_LESS);
@@ -1355,9 +1373,9 @@ void square_earthquake(struct chunk *c, struct loc grid) {
  */
 void square_upgrade_mineral(struct chunk *c, struct loc grid)
 {
-	if (square(c, grid).feat == FEAT_MAGMA)
+	if (square_fidx(c, grid) == FEAT_MAGMA)
 		square_set_feat(c, grid, FEAT_MAGMA_K);
-	if (square(c, grid).feat == FEAT_QUARTZ)
+	if (square_fidx(c, grid) == FEAT_QUARTZ)
 		square_set_feat(c, grid, FEAT_QUARTZ_K);
 }
 
@@ -1373,18 +1391,18 @@ void square_force_floor(struct chunk *c, struct loc grid) {
 /* Note that this returns the STORE_ index, which is one less than shopnum */
 int square_shopnum(struct chunk *c, struct loc grid) {
 	if (square_isshop(c, grid))
-		return f_info[square(c, grid).feat].shopnum - 1;
+		return f_info[square_fidx(c, grid)].shopnum - 1;
 	return -1;
 }
 
 int square_digging(struct chunk *c, struct loc grid) {
 	if (square_isdiggable(c, grid))
-		return f_info[square(c, grid).feat].dig;
+		return f_info[square_fidx(c, grid)].dig;
 	return 0;
 }
 
 const char *square_apparent_name(struct chunk *c, struct player *p, struct loc grid) {
-	int actual = square(player->cave, grid).feat;
+	int actual = square_fidx(player->cave, grid);
 	char *mimic_name = f_info[actual].mimic;
 	int f = mimic_name ? lookup_feat(mimic_name) : actual;
 	return f_info[f].name;
@@ -1393,7 +1411,7 @@ const char *square_apparent_name(struct chunk *c, struct player *p, struct loc g
 /* Memorize the terrain */
 void square_memorize(struct chunk *c, struct loc grid) {
 	if (c != cave) return;
-	square_set_known_feat(c, grid, square(c, grid).feat);
+	square_set_known_feat(c, grid, square_fidx(c, grid));
 }
 
 /* Forget the terrain */
@@ -1403,9 +1421,32 @@ void square_forget(struct chunk *c, struct loc grid) {
 }
 
 void square_mark(struct chunk *c, struct loc grid) {
-	sqinfo_on(square(c, grid).info, SQUARE_MARK);
+	sqinfo_on(square_info(c, grid), SQUARE_MARK);
 }
 
 void square_unmark(struct chunk *c, struct loc grid) {
-	sqinfo_off(square(c, grid).info, SQUARE_MARK);
+	sqinfo_off(square_info(c, grid), SQUARE_MARK);
+}
+
+/**
+ * Permanently light a square.
+ *
+ * Once a chunk's light plane has been built (see calc_lighting()), changes
+ * to SQUARE_GLOW must go through here and square_unglow() so the static
+ * part of the plane stays correct; chunks still being generated may set the
+ * flag directly.
+ */
+void square_glow(struct chunk *c, struct loc grid) {
+	if (square_isglow(c, grid)) return;
+	sqinfo_on(square_info(c, grid), SQUARE_GLOW);
+	if (c->light_known) c->squares.light[square_idx(c, grid)]++;
+}
+
+/**
+ * Remove permanent light from a square
+ */
+void square_unglow(struct chunk *c, struct loc grid) {
+	if (!square_isglow(c, grid)) return;
+	sqinfo_off(square_info(c, grid), SQUARE_GLOW);
+	if (c->light_known) c->squares.light[square_idx(c, grid)]--;
 }
@@ -23,6 +23,7 @@
 #include "monster.h"
 #include "player-calcs.h"
 #include "player-timed.h"
+#include "profile.h"
 #include "trap.h"
 
 /**
@@ -426,109 +427,350 @@ bool los(struct chunk *c, struct loc grid1, struct loc grid2)
  */
 
 
+/**
+ * Precomputed lines of sight from the player to every offset within
+ * z_info->max_sight.
+ *
+ * The grids los() tests on the way to a given offset depend only on that
+ * offset, so they are traced once at startup and stored in the order los()
+ * tests them.  The view then needs only one projectability check per grid
+ * on each line, with no slope arithmetic.
+ */
+struct view_ray {
+	bool knight;			/**< Knight's move, clear if knight_grid is */
+	struct loc knight_grid;	/**< Grid which on its own gives a knight's move */
+	int first;				/**< Index of the first grid in view_ray_grids */
+	int count;				/**< Number of grids between the endpoints */
+};
+
+static struct view_ray *view_rays;
+static struct loc *view_ray_grids;
+static int view_ray_radius;
+
+/**
+ * Store the grid at position n of a traced line, if there is a buffer
+ */
+static void view_ray_add(struct loc *grids, int n, int x, int y)
+{
+	if (grids) grids[n] = loc(x, y);
+}
+
+/**
+ * Trace the grids los() tests between the origin and an offset, in the order
+ * they are tested, and return how many there are; this follows los() step
+ * by step, and must be kept in line with it.
+ */
+static int view_ray_trace(struct loc offset, struct loc *grids)
+{
+	int dx = offset.x, dy = offset.y;
+	int ax = ABS(dx), ay = ABS(dy);
+	int sx = (dx < 0) ? -1 : 1, sy = (dy < 0) ? -1 : 1;
+	int f1, f2, m, qx, qy, tx, ty;
+	int n = 0;
+
+	/* Adjacent (or identical) grids */
+	if ((ax < 2) && (ay < 2)) return 0;
+
+	/* Directly South/North */
+	if (!dx) {
+		for (ty = sy; ty != dy; ty += sy)
+			view_ray_add(grids, n++, 0, ty);
+		return n;
+	}
+
+	/* Directly East/West */
+	if (!dy) {
+		for (tx = sx; tx != dx; tx += sx)
+			view_ray_add(grids, n++, tx, 0);
+		return n;
+	}
+
+	f2 = (ax * ay);
+	f1 = f2 << 1;
+
+	if (ax >= ay) {
+		/* Travel horizontally */
+		qy = ay * ay;
+		m = qy << 1;
+		tx = sx;
+		if (qy == f2) {
+			ty = sy;
+			qy -= f1;
+		} else {
+			ty = 0;
+		}
+		while (dx - tx) {
+			view_ray_add(grids, n++, tx, ty);
+			qy += m;
+			if (qy < f2) {
+				tx += sx;
+			} else if (qy > f2) {
+				ty += sy;
+				view_ray_add(grids, n++, tx, ty);
+				qy -= f1;
+				tx += sx;
+			} else {
+				ty += sy;
+				qy -= f1;
+				tx += sx;
+			}
+		}
+	} else {
+		/* Travel vertically */
+		qx = ax * ax;
+		m = qx << 1;
+		ty = sy;
+		if (qx == f2) {
+			tx = sx;
+			qx -= f1;
+		} else {
+			tx = 0;
+		}
+		while (dy - ty) {
+			view_ray_add(grids, n++, tx, ty);
+			qx += m;
+			if (qx < f2) {
+				ty += sy;
+			} else if (qx > f2) {
+				tx += sx;
+				view_ray_add(grids, n++, tx, ty);
+				qx -= f1;
+				ty += sy;
+			} else {
+				tx += sx;
+				qx -= f1;
+				ty += sy;
+			}
+		}
+	}
+
+	return n;
+}
+
+/**
+ * Build the line of sight table for the current maximum sight
+ */
+static void view_init(void)
+{
+	int r = z_info->max_sight, side = 2 * r + 1;
+	int x, y, total = 0;
+
+	view_ray_radius = r;
+	view_rays = mem_zalloc(side * side * sizeof(struct view_ray));
+
+	/* Size and place each line */
+	for (y = -r; y <= r; y++) {
+		for (x = -r; x <= r; x++) {
+			struct view_ray *ray = &view_rays[(y + r) * side + (x + r)];
+			int ax = ABS(x), ay = ABS(y);
+
+			ray->first = total;
+			ray->count = view_ray_trace(loc(x, y), NULL);
+			total += ray->count;
+
+			/* Vertical and horizontal "knights" */
+			if ((ax == 1) && (ay == 2)) {
+				ray->knight = true;
+				ray->knight_grid = loc(0, (y < 0) ? -1 : 1);
+			} else if ((ay == 1) && (ax == 2)) {
+				ray->knight = true;
+				ray->knight_grid = loc((x < 0) ? -1 : 1, 0);
+			}
+		}
+	}
+
+	/* Fill in the grids */
+	view_ray_grids = mem_zalloc((total + 1) * sizeof(struct loc));
+	for (y = -r; y <= r; y++) {
+		for (x = -r; x <= r; x++) {
+			struct view_ray *ray = &view_rays[(y + r) * side + (x + r)];
+			view_ray_trace(loc(x, y), view_ray_grids + ray->first);
+		}
+	}
+}
+
+static void view_cleanup(void)
+{
+	mem_free(view_rays);
+	mem_free(view_ray_grids);
+	view_rays = NULL;
+	view_ray_grids = NULL;
+}
+
+/**
+ * Equivalent to los(), for a grid within the maximum sight of the origin
+ */
+static bool view_los(struct chunk *c, struct loc origin, struct loc grid)
+{
+	int r = view_ray_radius, i;
+	struct loc offset = loc_diff(grid, origin);
+	const struct view_ray *ray =
+		&view_rays[(offset.y + r) * (2 * r + 1) + (offset.x + r)];
+	const struct loc *grids = view_ray_grids + ray->first;
+
+	assert(ABS(offset.x) <= r && ABS(offset.y) <= r);
+
+	if (ray->knight &&
+		square_isprojectable(c, loc_sum(origin, ray->knight_grid))) {
+		return true;
+	}
+
+	for (i = 0; i < ray->count; i++) {
+		if (!square_isprojectable(c, loc_sum(origin, grids[i]))) return false;
+	}
+
+	return true;
+}
+
+/**
+ * Find the part of the chunk the view from a grid could reach
+ */
+static void view_area(struct chunk *c, struct loc grid, struct loc *top_left,
+					  struct loc *bottom_right)
+{
+	int r = z_info->max_sight;
+
+	top_left->x = MAX(grid.x - r, 0);
+	top_left->y = MAX(grid.y - r, 0);
+	bottom_right->x = MIN(grid.x + r, c->width - 1);
+	bottom_right->y = MIN(grid.y + r, c->height - 1);
+}
+
 /**
  * Mark the currently seen grids, then wipe in preparation for recalculating
  */
-static void mark_wasseen(struct chunk *c)
+static void mark_wasseen(struct chunk *c, struct loc top_left,
+						 struct loc bottom_right)
 {
 	int x, y;
 	/* Save the old "view" grids for later */
-	for (y = 0; y < c->height; y++) {
-		for (x = 0; x < c->width; x++) {
+	for (y = top_left.y; y <= bottom_right.y; y++) {
+		for (x = top_left.x; x <= bottom_right.x; x++) {
 			struct loc grid = loc(x, y);
 			if (square_isseen(c, grid))
-				sqinfo_on(square(c, grid).info, SQUARE_WASSEEN);
-			sqinfo_off(square(c, grid).info, SQUARE_VIEW);
-			sqinfo_off(square(c, grid).info, SQUARE_SEEN);
+				sqinfo_on(square_info(c, grid), SQUARE_WASSEEN);
+			sqinfo_off(square_info(c, grid), SQUARE_VIEW);
+			sqinfo_off(square_info(c, grid), SQUARE_SEEN);
 		}
 	}
 }
 
 /**
- * Calculate light level for every grid in view - stolen from Sil
+ * Add (sign 1) or remove (sign -1) the light from one source
  */
-static void calc_lighting(struct chunk *c, struct player *p)
+static void apply_light_source(struct chunk *c, struct loc centre, int light,
+							   int sign)
 {
-	int dir, k, x, y;
-	int light = p->state.cur_light, radius = ABS(light) - 1;
-	int old_light = square_light(c, p->grid);
+	int x, y, radius = ABS(light) - 1;
 
-	/* Starting values based on permanent light */
-	for (y = 0; y < c->height; y++) {
-		for (x = 0; x < c->width; x++) {
-			struct loc grid = loc(x, y);
-			c->squares[y][x].light = square_isglow(c, grid) ? 1 : 0;
-
-			/* Squares with bright terrain have intensity 2 */
-			if (square_isbright(c, grid)) {
-				c->squares[y][x].light += 2;
-				for (dir = 0; dir < 8; dir++) {
-					struct loc adj_grid = loc_sum(grid, ddgrid_ddd[dir]);
-					if (!square_in_bounds(c, adj_grid)) continue;
-					c->squares[adj_grid.y][adj_grid.x].light += 1;
-				}
-			}
-		}
-	}
-
-	/* Light around the player */
 	for (y = -radius; y <= radius; y++) {
 		for (x = -radius; x <= radius; x++) {
-			/* Get valid grids within the player's light effect radius */
-			struct loc grid = loc_sum(p->grid, loc(x, y));
-			int dist = distance(p->grid, grid);
+			/* Get valid grids within the light effect radius */
+			struct loc grid = loc_sum(centre, loc(x, y));
+			int dist = distance(centre, grid);
 			if (!square_in_bounds(c, grid)) continue;
 			if (dist > radius) continue;
 
 			/* Adjust the light level */
 			if (light > 0) {
 				/* Light getting less further away */
-				c->squares[grid.y][grid.x].light += light - dist;
+				c->squares.light[square_idx(c, grid)] += sign * (light - dist);
 			} else {
 				/* Light getting greater further away */
-				c->squares[grid.y][grid.x].light += light + dist;
+				c->squares.light[square_idx(c, grid)] += sign * (light + dist);
 			}
 		}
 	}
+}
+
+/**
+ * Move a light source in the light plane, if it has changed
+ */
+static void update_light_source(struct chunk *c, struct light_record *record,
+								struct loc grid, int light)
+{
+	if ((record->light == light) &&
+		(!light || loc_eq(record->grid, grid))) {
+		return;
+	}
+
+	apply_light_source(c, record->grid, record->light, -1);
+	apply_light_source(c, grid, light, 1);
+	record->grid = grid;
+	record->light = light;
+}
+
+/**
+ * Calculate light level for every grid in view - stolen from Sil
+ *
+ * The light plane holds the permanent light from glowing and bright grids,
+ * which is built once per chunk and then kept up to date by square_glow(),
+ * square_unglow() and square_set_feat(), plus the light from the player and
+ * monsters.  Each of those sources is remembered as it was applied, and is
+ * only removed and re-added when it moves or changes strength.
+ *
+ * Monster light is applied everywhere rather than only within max_sight of
+ * the player; light is only ever consulted for grids in view, so this makes
+ * no difference to play and means the player moving disturbs nothing else.
+ */
+static void calc_lighting(struct chunk *c, struct player *p)
+{
+	int dir, k, x, y;
+	int old_light = square_light(c, p->grid);
+
+	/* Starting values based on permanent light, the first time */
+	if (!c->light_known) {
+		for (y = 0; y < c->height; y++) {
+			for (x = 0; x < c->width; x++) {
+				struct loc grid = loc(x, y);
+				int idx = square_idx(c, grid);
+				c->squares.light[idx] = square_isglow(c, grid) ? 1 : 0;
+
+				/* Squares with bright terrain have intensity 2, and light
+				 * by 1 those neighbours which come before them row by row
+				 * (the old full rebuild reset each grid after its earlier
+				 * neighbours had lit it, and this keeps that) */
+				for (dir = 0; dir < 9; dir++) {
+					struct loc adj_grid = loc_sum(grid, ddgrid_ddd[dir]);
+					if (!square_in_bounds(c, adj_grid)) continue;
+					if (!square_isbright(c, adj_grid)) continue;
+					if (loc_eq(adj_grid, grid)) {
+						c->squares.light[idx] += 2;
+					} else if ((adj_grid.y > y) ||
+							   ((adj_grid.y == y) && (adj_grid.x > x))) {
+						c->squares.light[idx] += 1;
+					}
+				}
+			}
+		}
+
+		/* Nothing else has been added yet */
+		memset(&c->player_light, 0, sizeof(c->player_light));
+		mem_free(c->mon_light);
+		c->mon_light = mem_zalloc(z_info->level_monster_max *
+								  sizeof(struct light_record));
+		c->mon_light_max = 0;
+		c->light_known = true;
+	}
+
+	/* Light around the player */
+	update_light_source(c, &c->player_light, p->grid, p->state.cur_light);
 
 	/* Scan monster list and add monster light or darkness */
-	for (k = 1; k < cave_monster_max(c); k++) {
+	for (k = 1; k < MAX(cave_monster_max(c), c->mon_light_max); k++) {
 		/* Check the k'th monster */
 		struct monster *mon = cave_monster(c, k);
+		int light = 0;
 
-		/* Skip dead monsters */
-		if (!mon->race) continue;
-
-		/* Get light info for this monster */
-		light = mon->race->light;
-		radius = ABS(light) - 1;
-
-		/* Skip monsters not affecting light */
-		if (!radius) continue;
-
-		/* Light or darken around the monster */
-		for (y = -radius; y <= radius; y++) {
-			for (x = -radius; x <= radius; x++) {
-				/* Get valid grids within the monster's light effect radius */
-				struct loc grid = loc_sum(mon->grid, loc(x, y));
-				int dist = distance(mon->grid, grid);
-				if (!square_in_bounds(c, grid)) continue;
-				if (dist > radius) continue;
-
-				/* Only set it if the player can see it */
-				if (distance(p->grid, grid) > z_info->max_sight) continue;
-
-				/* Adjust the light level */
-				if (light > 0) {
-					/* Light getting less further away */
-					c->squares[grid.y][grid.x].light += light - dist;
-				} else {
-					/* Light getting greater further away */
-					c->squares[grid.y][grid.x].light += light + dist;
-				}
-			}
+		/* Get light info for living monsters which affect light */
+		if ((k < cave_monster_max(c)) && mon->race &&
+			(ABS(mon->race->light) > 1)) {
+			light = mon->race->light;
 		}
+
+		update_light_source(c, &c->mon_light[k], mon->grid, light);
 	}
+	c->mon_light_max = cave_monster_max(c);
 
 	/* Update light level indicator */
 	if (square_light(c, p->grid) != old_light) {
@@ -549,9 +791,9 @@ static void become_viewable(struct chunk *c, struct loc grid, struct player *p,
 	if (square_isview(c, grid)) return;
 
 	/* Add the grid to the view, make seen if it's close enough to the player */
-	sqinfo_on(square(c, grid).info, SQUARE_VIEW);
+	sqinfo_on(square_info(c, grid), SQUARE_VIEW);
 	if (close)
-		sqinfo_on(square(c, grid).info, SQUARE_SEEN);
+		sqinfo_on(square_info(c, grid), SQUARE_SEEN);
 
 	/* Mark lit grids, and walls near to them, as seen */
 	if (square_islit(c, grid)) {
@@ -560,10 +802,10 @@ static void become_viewable(struct chunk *c, struct loc grid, struct player *p,
 			int xc = (x < p->grid.x) ? (x + 1) : (x > p->grid.x) ? (x - 1) : x;
 			int yc = (y < p->grid.y) ? (y + 1) : (y > p->grid.y) ? (y - 1) : y;
 			if (square_islit(c, loc(xc, yc))) {
-				sqinfo_on(square(c, grid).info, SQUARE_SEEN);
+				sqinfo_on(square_info(c, grid), SQUARE_SEEN);
 			}
 		} else {
-			sqinfo_on(square(c, grid).info, SQUARE_SEEN);
+			sqinfo_on(square_info(c, grid), SQUARE_SEEN);
 		}
 	}
 }
@@ -634,7 +876,7 @@ static void update_view_one(struct chunk *c, struct loc grid, struct player *p)
 		}
 	}
 
-	if (los(c, p->grid, loc(xc, yc)))
+	if (view_los(c, p->grid, loc(xc, yc)))
 		become_viewable(c, grid, p, close);
 }
 
@@ -645,7 +887,7 @@ static void update_one(struct chunk *c, struct loc grid, int blind)
 {
 	/* Remove view if blind, check visible squares for traps */
 	if (blind) {
-		sqinfo_off(square(c, grid).info, SQUARE_SEEN);
+		sqinfo_off(square_info(c, grid), SQUARE_SEEN);
 	} else if (square_isseen(c, grid)) {
 		square_reveal_trap(c, grid, false, true);
 	}
@@ -654,7 +896,7 @@ static void update_one(struct chunk *c, struct loc grid, int blind)
 	if (square_isseen(c, grid) && !square_wasseen(c, grid)) {
 		if (square_isfeel(c, grid)) {
 			c->feeling_squares++;
-			sqinfo_off(square(c, grid).info, SQUARE_FEEL);
+			sqinfo_off(square_info(c, grid), SQUARE_FEEL);
 			/* Don't display feeling if it will display for the new level */
 			if ((c->feeling_squares == z_info->feeling_need) &&
 				!player->upkeep->only_partial) {
@@ -671,38 +913,66 @@ static void update_one(struct chunk *c, struct loc grid, int blind)
 	if (!square_isseen(c, grid) && square_wasseen(c, grid))
 		square_light_spot(c, grid);
 
-	sqinfo_off(square(c, grid).info, SQUARE_WASSEEN);
+	sqinfo_off(square_info(c, grid), SQUARE_WASSEEN);
 }
 
 /**
  * Update the player's current view
+ *
+ * Only grids within z_info->max_sight of the player can enter the view, and
+ * only those near where the view was last calculated can leave it, so the
+ * rest of the level is left alone.
  */
 void update_view(struct chunk *c, struct player *p)
 {
 	int x, y;
+	struct loc old_top_left, old_bottom_right, top_left, bottom_right;
+
+	PROFILE_START(VIEW);
+
+	/* Find the old and new view areas; the first time, assume anything */
+	view_area(c, p->grid, &top_left, &bottom_right);
+	if (c->view_known) {
+		view_area(c, c->view_grid, &old_top_left, &old_bottom_right);
+	} else {
+		old_top_left = loc(0, 0);
+		old_bottom_right = loc(c->width - 1, c->height - 1);
+	}
+	c->view_grid = p->grid;
+	c->view_known = true;
 
 	/* Record the current view */
-	mark_wasseen(c);
+	mark_wasseen(c, old_top_left, old_bottom_right);
+	mark_wasseen(c, top_left, bottom_right);
 
 	/* Assume we can view the player grid */
-	sqinfo_on(square(c, p->grid).info, SQUARE_VIEW);
+	sqinfo_on(square_info(c, p->grid), SQUARE_VIEW);
 	if (p->state.cur_light > 0 || square_isglow(c, p->grid) ||
 		player_has(p, PF_UNLIGHT)) {
-		sqinfo_on(square(c, p->grid).info, SQUARE_SEEN);
+		sqinfo_on(square_info(c, p->grid), SQUARE_SEEN);
 	}
 
 	/* Calculate light levels */
 	calc_lighting(c, p);
 
 	/* Squares we have LOS to get marked as in the view, and perhaps seen */
-	for (y = 0; y < c->height; y++)
-		for (x = 0; x < c->width; x++)
+	for (y = top_left.y; y <= bottom_right.y; y++)
+		for (x = top_left.x; x <= bottom_right.x; x++)
 			update_view_one(c, loc(x, y), p);
 
-	/* Update each grid */
-	for (y = 0; y < c->height; y++)
-		for (x = 0; x < c->width; x++)
+	/* Update each grid which was or may now be in view, once */
+	for (y = old_top_left.y; y <= old_bottom_right.y; y++)
+		for (x = old_top_left.x; x <= old_bottom_right.x; x++)
+			update_one(c, loc(x, y), p->timed[TMD_BLIND]);
+	for (y = top_left.y; y <= bottom_right.y; y++) {
+		for (x = top_left.x; x <= bottom_right.x; x++) {
+			if ((y >= old_top_left.y) && (y <= old_bottom_right.y) &&
+				(x >= old_top_left.x) && (x <= old_bottom_right.x)) continue;
 			update_one(c, loc(x, y), p->timed[TMD_BLIND]);
+		}
+	}
+
+	PROFILE_STOP(VIEW);
 }
 
 
@@ -713,3 +983,9 @@ bool no_light(void)
 {
 	return (!square_isseen(cave, player->grid));
 }
+
+struct init_module view_module = {
+	.name = "view",
+	.init = view_init,
+	.cleanup = view_cleanup
+};
@@ -24,6 +24,7 @@
 #include "game-world.h"
 #include "init.h"
 #include "mon-group.h"
+#include "mon-move.h"
 #include "monster.h"
 #include "obj-ignore.h"
 #include "obj-pile.h"
@@ -32,9 +33,10 @@
 #include "object.h"
 #include "player-timed.h"
 #include "trap.h"
+#include "z-pool.h"
 
 struct feature *f_info;
-struct chunk *cave = NULL;
+THREAD_LOCAL struct chunk *cave = NULL;
 
 int FEAT_NONE;
 int FEAT_FLOOR;
@@ -337,27 +339,42 @@ void set_terrain(void)
 	FEAT_LAVA = lookup_feat("lava");
 }
 
+/**
+ * Side of the square blocks of grids monsters are filed by
+ */
+#define MON_BLOCK	8
+
 /**
  * Allocate a new chunk of the world
  */
 struct chunk *cave_new(int height, int width) {
-	int y, x;
+	int y, i;
 
 	struct chunk *c = mem_zalloc(sizeof *c);
+	int n = height * width;
 	c->height = height;
 	c->width = width;
 	c->feat_count = mem_zalloc((z_info->f_max + 1) * sizeof(int));
 
-	c->squares = mem_zalloc(c->height * sizeof(struct square*));
+	c->squares.feat = mem_zalloc(n * sizeof(byte));
+	c->squares.info = mem_zalloc(n * SQUARE_SIZE * sizeof(bitflag));
+	c->squares.light = mem_zalloc(n * sizeof(int));
+	c->squares.mon = mem_zalloc(n * sizeof(s16b));
+	c->squares.obj = mem_zalloc(n * sizeof(struct object*));
+	c->squares.trap = mem_zalloc(n * sizeof(struct trap*));
+	c->floor.grids = mem_alloc(n * sizeof(int));
+	c->floor.place = mem_alloc(n * sizeof(int));
+
+	/* Room for the noise and scent rows in one block, with some to spare
+	 * for the connectors */
+	c->arena = mem_arena_new("chunks",
+							 2 * n * sizeof(u16b) + 4 * height * sizeof(long));
+
 	c->noise.grids = mem_zalloc(c->height * sizeof(u16b*));
 	c->scent.grids = mem_zalloc(c->height * sizeof(u16b*));
 	for (y = 0; y < c->height; y++) {
-		c->squares[y] = mem_zalloc(c->width * sizeof(struct square));
-		for (x = 0; x < c->width; x++) {
-			c->squares[y][x].info = mem_zalloc(SQUARE_SIZE * sizeof(bitflag));
-		}
-		c->noise.grids[y] = mem_zalloc(c->width * sizeof(u16b));
-		c->scent.grids[y] = mem_zalloc(c->width * sizeof(u16b));
+		c->noise.grids[y] = mem_arena_alloc(c->arena, c->width * sizeof(u16b));
+		c->scent.grids[y] = mem_arena_alloc(c->arena, c->width * sizeof(u16b));
 	}
 
 	c->objects = mem_zalloc(OBJECT_LIST_SIZE * sizeof(struct object*));
@@ -370,7 +387,18 @@ struct chunk *cave_new(int height, int width) {
 	c->monster_groups = mem_zalloc(z_info->level_monster_max *
 								   sizeof(struct monster_group*));
 
-	c->turn = turn;
+	c->mon_blocks.width = (width + MON_BLOCK - 1) / MON_BLOCK;
+	c->mon_blocks.first = mem_zalloc(c->mon_blocks.width *
+									 ((height + MON_BLOCK - 1) / MON_BLOCK) *
+									 sizeof(int));
+	c->mon_blocks.next = mem_zalloc(z_info->level_monster_max * sizeof(int));
+	c->mon_blocks.prev = mem_zalloc(z_info->level_monster_max * sizeof(int));
+	c->mon_blocks.block = mem_alloc(z_info->level_monster_max * sizeof(int));
+	c->mon_blocks.grid = mem_zalloc(z_info->level_monster_max *
+									sizeof(struct loc));
+	for (i = 0; i < z_info->level_monster_max; i++)
+		c->mon_blocks.block[i] = -1;
+
 	return c;
 }
 
@@ -380,38 +408,66 @@ struct chunk *cave_new(int height, int width) {
 void cave_free(struct chunk *c) {
 	int y, x;
 
-	while (c->join) {
-		struct connector *current = c->join;
-		mem_free(current->info);
-		c->join = current->next;
-		mem_free(current);
-	}
-
 	for (y = 0; y < c->height; y++) {
 		for (x = 0; x < c->width; x++) {
-			mem_free(c->squares[y][x].info);
-			if (c->squares[y][x].trap)
+			int idx = square_idx(c, loc(x, y));
+			if (c->squares.trap[idx])
 				square_free_trap(c, loc(x, y));
-			if (c->squares[y][x].obj)
-				object_pile_free(c->squares[y][x].obj);
+			if (c->squares.obj[idx])
+				object_pile_free(c->squares.obj[idx]);
 		}
-		mem_free(c->squares[y]);
-		mem_free(c->noise.grids[y]);
-		mem_free(c->scent.grids[y]);
 	}
-	mem_free(c->squares);
+	mem_free(c->squares.feat);
+	mem_free(c->squares.info);
+	mem_free(c->squares.light);
+	mem_free(c->squares.mon);
+	mem_free(c->squares.obj);
+	mem_free(c->squares.trap);
+	mem_free(c->floor.grids);
+	mem_free(c->floor.place);
 	mem_free(c->noise.grids);
+	cave_noise_free(c);
+	mem_free(c->mon_light);
 	mem_free(c->scent.grids);
+	mem_free(c->scent.live);
 
 	mem_free(c->feat_count);
 	mem_free(c->objects);
 	mem_free(c->monsters);
 	mem_free(c->monster_groups);
+	mem_free(c->mon_blocks.first);
+	mem_free(c->mon_blocks.next);
+	mem_free(c->mon_blocks.prev);
+	mem_free(c->mon_blocks.block);
+	mem_free(c->mon_blocks.grid);
+	free_monster_queue(c);
+	mem_arena_destroy(c->arena);
 	if (c->name)
 		string_free(c->name);
 	mem_free(c);
 }
 
+/**
+ * Keep the floor list of a chunk up to date when the terrain of the square
+ * with index 'idx' changes from 'old_feat' to 'feat'
+ */
+void cave_floor_update(struct chunk *c, int idx, int old_feat, int feat)
+{
+	struct floor_list *floor = &c->floor;
+
+	if (feat_is_floor(old_feat) == feat_is_floor(feat)) return;
+
+	if (feat_is_floor(feat)) {
+		floor->place[idx] = floor->count;
+		floor->grids[floor->count++] = idx;
+	} else {
+		/* Fill the gap with the last entry */
+		int last = floor->grids[--floor->count];
+		floor->grids[floor->place[idx]] = last;
+		floor->place[last] = floor->place[idx];
+	}
+}
+
 
 /**
  * Enter an object in the list of objects for the current level/chunk.  This
@@ -565,6 +621,118 @@ int cave_monster_count(struct chunk *c) {
 	return c->mon_cnt;
 }
 
+static void monster_unfile(struct chunk *c, int midx)
+{
+	struct monster_blocks *blocks = &c->mon_blocks;
+	int prev = blocks->prev[midx], next = blocks->next[midx];
+
+	if (prev)
+		blocks->next[prev] = next;
+	else
+		blocks->first[blocks->block[midx]] = next;
+	if (next)
+		blocks->prev[next] = prev;
+	blocks->block[midx] = -1;
+}
+
+/**
+ * Keep the monster blocks up to date when the monster index of a grid
+ * changes from 'old' to 'midx'.
+ *
+ * A monster is only unfiled if it is still filed at this grid, as it may
+ * already have been filed somewhere else, as when monsters swap places.
+ */
+void cave_monster_file(struct chunk *c, struct loc grid, int old, int midx)
+{
+	struct monster_blocks *blocks = &c->mon_blocks;
+	int block = (grid.y / MON_BLOCK) * blocks->width + grid.x / MON_BLOCK;
+
+	if ((old > 0) && (old != midx) && (blocks->block[old] >= 0) &&
+		loc_eq(blocks->grid[old], grid))
+		monster_unfile(c, old);
+
+	if (midx <= 0) return;
+	blocks->grid[midx] = grid;
+	if (blocks->block[midx] == block) return;
+	if (blocks->block[midx] >= 0)
+		monster_unfile(c, midx);
+
+	blocks->block[midx] = block;
+	blocks->prev[midx] = 0;
+	blocks->next[midx] = blocks->first[block];
+	if (blocks->first[block])
+		blocks->prev[blocks->first[block]] = midx;
+	blocks->first[block] = midx;
+}
+
+/**
+ * Start going through the monsters in a rectangle of grids, corners included.
+ *
+ * Monsters come in no particular order.  The monster last returned by
+ * monster_iter_next() may be deleted, but no monster may be moved or placed
+ * until the iteration is over.
+ */
+void monster_iter_rect(struct monster_iter *iter, struct chunk *c,
+					   struct loc top_left, struct loc bottom_right)
+{
+	iter->c = c;
+	iter->top_left = loc(MAX(top_left.x, 0), MAX(top_left.y, 0));
+	iter->bottom_right = loc(MIN(bottom_right.x, c->width - 1),
+							 MIN(bottom_right.y, c->height - 1));
+	iter->dist = -1;
+	iter->block = loc(iter->top_left.x / MON_BLOCK - 1,
+					  iter->top_left.y / MON_BLOCK);
+	iter->next = 0;
+}
+
+/**
+ * Start going through the monsters within distance 'dist' of a grid, in the
+ * same way as monster_iter_rect()
+ */
+void monster_iter_near(struct monster_iter *iter, struct chunk *c,
+					   struct loc grid, int dist)
+{
+	monster_iter_rect(iter, c, loc(grid.x - dist, grid.y - dist),
+					  loc(grid.x + dist, grid.y + dist));
+	iter->centre = grid;
+	iter->dist = dist;
+}
+
+/**
+ * Return the next monster for an iterator, or NULL when there are no more
+ */
+struct monster *monster_iter_next(struct monster_iter *iter)
+{
+	struct monster_blocks *blocks = &iter->c->mon_blocks;
+
+	while (true) {
+		while (iter->next) {
+			int midx = iter->next;
+			struct loc grid = blocks->grid[midx];
+
+			iter->next = blocks->next[midx];
+			if ((grid.x < iter->top_left.x) || (grid.y < iter->top_left.y) ||
+				(grid.x > iter->bottom_right.x) ||
+				(grid.y > iter->bottom_right.y))
+				continue;
+			if ((iter->dist >= 0) && (distance(iter->centre, grid) > iter->dist))
+				continue;
+			return cave_monster(iter->c, midx);
+		}
+
+		/* Move on to the next block */
+		if (++iter->block.x > iter->bottom_right.x / MON_BLOCK) {
+			iter->block.x = iter->top_left.x / MON_BLOCK;
+			iter->block.y++;
+		}
+		if ((iter->block.y > iter->bottom_right.y / MON_BLOCK) ||
+			(iter->top_left.x > iter->bottom_right.x))
+			return NULL;
+		iter->next = blocks->first[iter->block.y * blocks->width +
+								   iter->block.x];
+	}
+}
+
 /**
  * Return the number of doors/traps around (or under) the character.
  */
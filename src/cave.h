@@ -25,6 +25,9 @@
 struct player;
 struct monster;
 struct monster_group;
+struct monster_queue;
+struct mem_arena;
+struct gen_context;
 
 extern const s16b ddd[9];
 extern const s16b ddx[10];
@@ -82,7 +85,6 @@ enum
 #define sqinfo_inter(f1, f2)       flag_inter(f1, f2, SQUARE_SIZE)
 #define sqinfo_diff(f1, f2)        flag_diff(f1, f2, SQUARE_SIZE)
 
-
 /**
  * Terrain flags
  */
@@ -155,17 +157,92 @@ struct grid_data {
 	bool hallucinate;
 };
 
-struct square {
-	byte feat;
-	bitflag *info;
-	int light;
-	s16b mon;
-	struct object *obj;
-	struct trap *trap;
+/**
+ * Per-grid data for a chunk, held as parallel planes of height * width
+ * entries indexed by square_idx(), so full-map scans walk contiguous memory
+ */
+struct square_grid {
+	byte *feat;				/**< Terrain */
+	bitflag *info;			/**< SQUARE_SIZE bitflags per grid */
+	int *light;				/**< Light level */
+	s16b *mon;				/**< Monster index (-1 for the player) */
+	struct object **obj;	/**< First object of the floor pile */
+	struct trap **trap;		/**< First trap */
 };
 
 struct heatmap {
     u16b **grids;
+    int *live;			/**< Inner grids with a non-zero value, if tracked */
+    int live_count;		/**< Number of entries in live */
+};
+
+/**
+ * Every floor square of a chunk, in no particular order, so that one can be
+ * picked at random without scanning the whole map
+ */
+struct floor_list {
+	int *grids;		/**< Square indices of the floor squares */
+	int *place;		/**< Where each floor square is in grids */
+	int count;		/**< Number of floor squares */
+};
+
+/**
+ * A light source as it was last added to a chunk's light plane
+ */
+struct light_record {
+	struct loc grid;
+	int light;
+};
+
+/**
+ * Bookkeeping which lets the noise heatmap be kept between player turns and
+ * repaired where something it depends on has changed, see cave-noise.c
+ */
+struct noise_flow {
+	struct loc source;	/**< Grid the noise is propagated from */
+	struct loc player;	/**< Player grid, which noise doesn't pass through */
+	struct loc next;	/**< Grid the source is moving to */
+	bool moving;		/**< Whether next is a source too */
+	bool valid;			/**< Whether the field has been built */
+	int *pending;		/**< Grids whose sound transmission has changed */
+	int pending_count;	/**< Number of entries in pending */
+	byte *held;			/**< Sound transmission of pending grids before */
+
+	/* Work space for repairs */
+	int *queue;
+	int *list;
+	int *key;
+	int *sorted;
+	int *counts;
+	byte *mark;
+};
+
+/**
+ * Monsters of a chunk filed by the block of grids they stand in, so that
+ * those near a grid can be found without looking at every monster; kept up
+ * to date by square_set_mon()
+ */
+struct monster_blocks {
+	int width;			/**< Blocks across the chunk */
+	int *first;			/**< First monster in each block, 0 for none */
+	int *next;			/**< Next monster in the same block, by index */
+	int *prev;			/**< Previous monster in the same block, by index */
+	int *block;			/**< Block of each monster, -1 if not filed */
+	struct loc *grid;	/**< Grid each monster was filed at */
+};
+
+/**
+ * Progress through the monsters in part of a chunk, see monster_iter_near()
+ * and monster_iter_rect()
+ */
+struct monster_iter {
+	struct chunk *c;
+	struct loc top_left;		/**< Corners of the rectangle, inclusive */
+	struct loc bottom_right;
+	struct loc centre;			/**< Centre of the circle, if any */
+	int dist;					/**< Radius of the circle, -1 for none */
+	struct loc block;			/**< Block being looked at */
+	int next;					/**< Next monster in that block */
 };
 
 struct connector {
@@ -191,11 +268,21 @@ struct chunk {
 	u16b feeling_squares; /* How many feeling squares the player has visited */
 	int *feat_count;
 
-	struct square **squares;
+	struct square_grid squares;
+	struct floor_list floor;	/**< Kept up to date by square_set_feat() */
 	struct heatmap noise;
+	struct noise_flow noise_flow;
 	struct heatmap scent;
 	struct loc decoy;
 
+	bool light_known;		/**< Light plane is built, see calc_lighting() */
+	struct light_record player_light;
+	struct light_record *mon_light;	/**< Monster light, by monster index */
+	int mon_light_max;		/**< Entries of mon_light which may be in use */
+
+	struct loc view_grid;	/**< Player grid at the last update_view() */
+	bool view_known;		/**< Whether view_grid has been set */
+
 	struct object **objects;
 	u16b obj_max;
 
@@ -206,10 +293,44 @@ struct chunk {
 	int num_repro;
 
 	struct monster_group **monster_groups;
+	struct monster_blocks mon_blocks;	/**< Monsters by where they are */
+	struct monster_queue *mon_queue;	/**< When monsters can next move */
 
 	struct connector *join;
+
+	struct mem_arena *arena;	/**< Memory freed with the chunk */
+
+	struct gen_context *gen;	/**< What it's being generated from, if it is */
 };
 
+/*** Square plane lookups ***/
+
+/**
+ * Index of a grid in the square planes; grids must be in bounds, as
+ * square_in_bounds() checks
+ */
+static inline int square_idx(struct chunk *c, struct loc grid)
+{
+	assert(grid.x >= 0 && grid.x < c->width &&
+		   grid.y >= 0 && grid.y < c->height);
+	return grid.y * c->width + grid.x;
+}
+
+static inline int square_fidx(struct chunk *c, struct loc grid)
+{
+	return c->squares.feat[square_idx(c, grid)];
+}
+
+static inline int square_midx(struct chunk *c, struct loc grid)
+{
+	return c->squares.mon[square_idx(c, grid)];
+}
+
+static inline bitflag *square_info(struct chunk *c, struct loc grid)
+{
+	return c->squares.info + square_idx(c, grid) * SQUARE_SIZE;
+}
+
 /*** Feature Indexes (see "lib/gamedata/terrain.txt") ***/
 
 /* Nothing */
@@ -242,11 +363,11 @@ extern int FEAT_PERM;
 extern int FEAT_LAVA;
 
 
-/* Current level */
-extern struct chunk *cave;
+/* Current level, which a thread generating a level ahead doesn't have */
+extern THREAD_LOCAL struct chunk *cave;
 /* Stored levels */
-extern struct chunk **chunk_list;
 extern u16b chunk_list_max;
+extern size_t chunk_list_memory;
 
 /* cave-view.c */
 int distance(struct loc grid1, struct loc grid2);
@@ -265,6 +386,11 @@ void cave_illuminate(struct chunk *c, bool daytime);
 void cave_update_flow(struct chunk *c);
 void cave_forget_flow(struct chunk *c);
 
+/* cave-noise.c */
+void cave_update_noise(struct chunk *c, struct loc source, struct loc player);
+void cave_noise_terrain_changed(struct chunk *c, struct loc grid);
+void cave_noise_free(struct chunk *c);
+
 /* cave-square.c */
 /**
  * square_predicate is a function pointer which tests a given square to
@@ -379,7 +505,6 @@ bool square_suits_stairs_well(struct chunk *c, struct loc grid);
 bool square_suits_stairs_ok(struct chunk *c, struct loc grid);
 
 
-struct square square(struct chunk *c, struct loc grid);
 struct feature *square_feat(struct chunk *c, struct loc grid);
 int square_light(struct chunk *c, struct loc grid);
 struct monster *square_monster(struct chunk *c, struct loc grid);
@@ -432,6 +557,8 @@ void square_memorize(struct chunk *c, struct loc grid);
 void square_forget(struct chunk *c, struct loc grid);
 void square_mark(struct chunk *c, struct loc grid);
 void square_unmark(struct chunk *c, struct loc grid);
+void square_glow(struct chunk *c, struct loc grid);
+void square_unglow(struct chunk *c, struct loc grid);
 
 /* cave.c */
 int motion_dir(struct loc source, struct loc target);
@@ -440,6 +567,7 @@ int lookup_feat(const char *name);
 void set_terrain(void);
 struct chunk *cave_new(int height, int width);
 void cave_free(struct chunk *c);
+void cave_floor_update(struct chunk *c, int idx, int old_feat, int feat);
 void list_object(struct chunk *c, struct object *obj);
 void delist_object(struct chunk *c, struct object *obj);
 void object_lists_check_integrity(struct chunk *c, struct chunk *c_k);
@@ -449,12 +577,18 @@ void scatter(struct chunk *c, struct loc *place, struct loc grid, int d,
 struct monster *cave_monster(struct chunk *c, int idx);
 int cave_monster_max(struct chunk *c);
 int cave_monster_count(struct chunk *c);
+void cave_monster_file(struct chunk *c, struct loc grid, int old, int midx);
+void monster_iter_rect(struct monster_iter *iter, struct chunk *c,
+					   struct loc top_left, struct loc bottom_right);
+void monster_iter_near(struct monster_iter *iter, struct chunk *c,
+					   struct loc grid, int dist);
+struct monster *monster_iter_next(struct monster_iter *iter);
 
 int count_feats(struct loc *grid,
 				bool (*test)(struct chunk *c, struct loc grid), bool under);
 struct loc cave_find_decoy(struct chunk *c);
 void prepare_next_level(struct chunk **c, struct player *p);
-bool is_quest(int level);
+bool is_quest(const struct player *p, int level);
 
 void cave_known(struct player *p);
 
@@ -111,7 +111,7 @@ void do_cmd_go_down(struct command *cmd)
 	/* Warn a force_descend player if they're going to a quest level */
 	if (OPT(player, birth_force_descend)) {
 		descend_to = dungeon_get_next_level(player->max_depth, 1);
-		if (is_quest(descend_to) &&
+		if (is_quest(player, descend_to) &&
 			!get_check("Are you sure you want to descend?"))
 			return;
 	}
@@ -417,7 +417,7 @@ void do_cmd_close(struct command *cmd)
 	}
 
 	/* Monster - alert, then attack */
-	if (square(cave, grid).mon > 0) {
+	if (square_midx(cave, grid) > 0) {
 		msg("There is a monster in the way!");
 		py_attack(player, grid);
 	} else
@@ -607,7 +607,7 @@ void do_cmd_tunnel(struct command *cmd)
 	}
 
 	/* Attack any monster we run into */
-	if (square(cave, grid).mon > 0) {
+	if (square_midx(cave, grid) > 0) {
 		msg("There is a monster in the way!");
 		py_attack(player, grid);
 	} else {
@@ -711,7 +711,7 @@ static bool do_cmd_lock_door(struct loc grid)
 static bool do_cmd_disarm_aux(struct loc grid)
 {
 	int skill, power, chance;
-    struct trap *trap = square(cave, grid).trap;
+    struct trap *trap = square_trap(cave, grid);
 	bool more = false;
 
 	/* Verify legality */
@@ -831,7 +831,7 @@ void do_cmd_disarm(struct command *cmd)
 
 
 	/* Monster */
-	if (square(cave, grid).mon > 0) {
+	if (square_midx(cave, grid) > 0) {
 		msg("There is a monster in the way!");
 		py_attack(player, grid);
 	} else if (obj)
@@ -878,7 +878,7 @@ void do_cmd_alter_aux(int dir)
 	}
 
 	/* Action depends on what's there */
-	if (square(cave, grid).mon > 0) {
+	if (square_midx(cave, grid) > 0) {
 		/* Attack monster */
 		py_attack(player, grid);
 	} else if (square_isdiggable(cave, grid)) {
@@ -925,7 +925,7 @@ void do_cmd_steal_aux(int dir)
 	}
 
 	/* Attack or steal from monsters */
-	if ((square(cave, grid).mon > 0) && player_has(player, PF_STEAL)) {
+	if ((square_midx(cave, grid) > 0) && player_has(player, PF_STEAL)) {
 			steal_monster_item(square_monster(cave, grid), -1);
 	} else {
 		/* Oops */
@@ -956,7 +956,7 @@ void move_player(int dir, bool disarm)
 {
 	struct loc grid = loc_sum(player->grid, ddgrid[dir]);
 
-	int m_idx = square(cave, grid).mon;
+	int m_idx = square_midx(cave, grid);
 	struct monster *mon = cave_monster(cave, m_idx);
 	bool trapsafe = player_is_trapsafe(player);
 	bool alterable = square_isdisarmabletrap(cave, grid) ||
@@ -1096,7 +1096,7 @@ void move_player(int dir, bool disarm)
  */
 static bool do_cmd_walk_test(struct loc grid)
 {
-	int m_idx = square(cave, grid).mon;
+	int m_idx = square_midx(cave, grid);
 	struct monster *mon = cave_monster(cave, m_idx);
 
 	/* Allow attack on visible monsters if unafraid */
@@ -21,6 +21,7 @@
 #include "cmds.h"
 #include "cmd-core.h"
 #include "game-input.h"
+#include "journal.h"
 #include "obj-chest.h"
 #include "obj-desc.h"
 #include "obj-tval.h"
@@ -144,7 +145,6 @@ static int cmd_idx(cmd_code code)
  * The command queue.
  * ------------------------------------------------------------------------ */
 
-#define CMD_QUEUE_SIZE 20
 #define prev_cmd_idx(idx) ((idx + CMD_QUEUE_SIZE - 1) % CMD_QUEUE_SIZE)
 
 static int cmd_head = 0;
@@ -185,6 +185,9 @@ errr cmdq_push_copy(struct command *cmd)
 			cmd_queue[cmd_head] = cmd_queue[cmd_prev];
 	}
 
+	/* Note where it came from */
+	journal_note_push(cmd_head);
+
 	/* Advance point in queue, wrapping around at the end */
 	cmd_head++;
 	if (cmd_head == CMD_QUEUE_SIZE) cmd_head = 0;
@@ -229,11 +232,18 @@ void process_command(cmd_context ctx, struct command *cmd)
 
 	/* Actually execute the command function */
 	if (game_cmds[idx].fn) {
+		journal_enter(JOURNAL_GAME);
+
 		/* Occasional attack instead for bloodlust-affected characters */
 		if (randint0(200) < player->timed[TMD_BLOODLUST]) {
-			if (player_attack_random_monster(player)) return;
+			if (player_attack_random_monster(player)) {
+				journal_leave();
+				return;
+			}
 		}
 		game_cmds[idx].fn(cmd);
+
+		journal_leave();
 	}
 
 	/* If the command hasn't changed nrepeats, count this execution. */
@@ -253,6 +263,7 @@ bool cmdq_pop(cmd_context c)
 		cmd = &cmd_queue[prev_cmd_idx(cmd_tail)];
 	} else if (cmd_head != cmd_tail) {
 		/* If we have a command ready, set it. */
+		journal_note_pop(cmd_tail, &cmd_queue[cmd_tail], c);
 		cmd = &cmd_queue[cmd_tail++];
 		if (cmd_tail == CMD_QUEUE_SIZE)
 			cmd_tail = 0;
@@ -164,6 +164,11 @@ struct cmd_arg {
  */
 #define CMD_MAX_ARGS 4
 
+/**
+ * Number of commands the queue can hold.
+ */
+#define CMD_QUEUE_SIZE 20
+
 
 
 /**
@@ -20,6 +20,7 @@
  */
 
 #include "angband.h"
+#include "buildid.h"
 #include "datafile.h"
 #include "game-world.h"
 #include "init.h"
@@ -78,35 +79,225 @@ errr parse_file_quit_not_found(struct parser *p, const char *filename) {
 /**
  * The basic file parsing function.
  */
+/**
+ * ------------------------------------------------------------------------
+ * Gamedata snapshots
+ *
+ * Each time a data file is parsed from its text, what the parser made of it
+ * is saved as a snapshot (see parser.c) in the cache directory under the
+ * user directory.  Later loads of the same text replay the snapshot instead
+ * of parsing it again.  The snapshot is only used if it was made by this
+ * version of the game, from a text of the same length and hash; otherwise
+ * the text is parsed and the snapshot replaced.
+ *
+ * A snapshot file is a header of seven four-byte little-endian numbers, then
+ * the snapshot itself:
+ *   - SNAPSHOT_MAGIC
+ *   - SNAPSHOT_VERSION, for changes to the format
+ *   - the hash of the game version
+ *   - the length and hash of the text
+ *   - the length and hash of the snapshot
+ * ------------------------------------------------------------------------ */
+
+#define SNAPSHOT_MAGIC		0x50534447	/* "GDSP" */
+#define SNAPSHOT_VERSION	1
+#define SNAPSHOT_HEADER		7
+
+static u32b data_hash(const char *data, size_t len)
+{
+	u32b hash = 5381;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		hash = ((hash << 5) + hash) + (byte)data[i];
+	return hash;
+}
+
+/**
+ * Reads the whole of a file at once.  Returns NULL if it can't be read;
+ * otherwise the contents, which should be freed by the caller.
+ */
+static char *read_whole_file(const char *path, size_t *len)
+{
+	ang_file *fh = file_open(path, MODE_READ, FTYPE_RAW);
+	size_t size = 16384;
+	char *data;
+	int n;
+
+	if (!fh) return NULL;
+	data = mem_alloc(size);
+	*len = 0;
+	while ((n = file_read(fh, data + *len, size - *len)) > 0) {
+		*len += n;
+		if (*len == size) {
+			size *= 2;
+			data = mem_realloc(data, size);
+		}
+	}
+	file_close(fh);
+
+	if (n < 0) {
+		mem_free(data);
+		return NULL;
+	}
+	return data;
+}
+
+static void snapshot_path(char *buf, size_t len, const char *filename)
+{
+	char dir[1024];
+
+	path_build(dir, sizeof(dir), ANGBAND_DIR_USER, "cache");
+	path_build(buf, len, dir, format("%s.dat", filename));
+}
+
+static void snapshot_header(u32b *header, const char *text, size_t text_len,
+							const char *snap, size_t snap_len)
+{
+	header[0] = SNAPSHOT_MAGIC;
+	header[1] = SNAPSHOT_VERSION;
+	header[2] = djb2_hash(buildver);
+	header[3] = text_len;
+	header[4] = data_hash(text, text_len);
+	header[5] = snap_len;
+	header[6] = data_hash(snap, snap_len);
+}
+
+/**
+ * Replays the snapshot of a data file, if there is an up to date one.
+ * Returns whether it did, and the result of the replay in `r`.
+ */
+static bool replay_snapshot(struct parser *p, const char *filename,
+							const char *text, size_t text_len, errr *r)
+{
+	char path[1024];
+	u32b header[SNAPSHOT_HEADER];
+	size_t len, snap_len;
+	const byte *stored;
+	char *data;
+	int i;
+
+	snapshot_path(path, sizeof(path), filename);
+	data = read_whole_file(path, &len);
+	if (!data) return false;
+	if (len < sizeof(header)) {
+		mem_free(data);
+		return false;
+	}
+
+	snap_len = len - sizeof(header);
+	snapshot_header(header, text, text_len, data + sizeof(header), snap_len);
+	stored = (const byte *)data;
+	for (i = 0; i < SNAPSHOT_HEADER; i++, stored += 4) {
+		u32b n = stored[0] | (stored[1] << 8) | (stored[2] << 16) |
+			((u32b)stored[3] << 24);
+		if (n != header[i]) break;
+	}
+	if (i < SNAPSHOT_HEADER ||
+		!parser_snapshot_valid(p, data + sizeof(header), snap_len)) {
+		mem_free(data);
+		return false;
+	}
+
+	*r = parser_replay(p, data + sizeof(header), snap_len);
+	mem_free(data);
+	return true;
+}
+
+/**
+ * Saves the snapshot of a data file.  Several copies of the game may be
+ * doing this at once, so the file is written under another name and then
+ * moved into place.
+ */
+static void save_snapshot(const char *filename, const char *text,
+						  size_t text_len, const char *snap, size_t snap_len)
+{
+	char dir[1024], path[1024], new_path[1024];
+	u32b header[SNAPSHOT_HEADER];
+	byte stored[SNAPSHOT_HEADER * 4];
+	ang_file *fh;
+	bool written;
+	int i;
+
+	path_build(dir, sizeof(dir), ANGBAND_DIR_USER, "cache");
+	if (!dir_create(dir)) return;
+
+	snapshot_header(header, text, text_len, snap, snap_len);
+	for (i = 0; i < SNAPSHOT_HEADER; i++) {
+		stored[i * 4] = header[i] & 0xFF;
+		stored[i * 4 + 1] = (header[i] >> 8) & 0xFF;
+		stored[i * 4 + 2] = (header[i] >> 16) & 0xFF;
+		stored[i * 4 + 3] = (header[i] >> 24) & 0xFF;
+	}
+
+	snapshot_path(path, sizeof(path), filename);
+	strnfmt(new_path, sizeof(new_path), "%s.new", path);
+	fh = file_open(new_path, MODE_WRITE, FTYPE_RAW);
+	if (!fh) return;
+	written = file_write(fh, (const char *)stored, sizeof(stored)) &&
+		file_write(fh, snap, snap_len);
+	file_close(fh);
+
+	if (!written || !file_move(new_path, path))
+		file_delete(new_path);
+}
+
+/**
+ * The basic file parsing function.
+ *
+ * The file is replayed from its snapshot if that is up to date, and parsed
+ * from its text (saving a new snapshot) if not.
+ */
 errr parse_file(struct parser *p, const char *filename) {
 	char path[1024];
 	char buf[1024];
 	ang_file *fh;
+	char *text, *snap;
+	size_t text_len, snap_len;
 	errr r = 0;
 
 	/* The player can put a customised file in the user directory */
 	path_build(path, sizeof(path), ANGBAND_DIR_USER, format("%s.txt",
 															filename));
-	fh = file_open(path, MODE_READ, FTYPE_TEXT);
+	text = read_whole_file(path, &text_len);
 
 	/* If no custom file, just load the standard one */
-	if (!fh) {
+	if (!text) {
 		path_build(path, sizeof(path), ANGBAND_DIR_GAMEDATA,
 				   format("%s.txt", filename));
-		fh = file_open(path, MODE_READ, FTYPE_TEXT);
+		text = read_whole_file(path, &text_len);
 	}
 
 	/* File wasn't found, return the error */
-	if (!fh)
+	if (!text)
 		return PARSE_ERROR_NO_FILE_FOUND;
 
+	/* Use the snapshot if we can */
+	if (replay_snapshot(p, filename, text, text_len, &r)) {
+		mem_free(text);
+		return r;
+	}
+
 	/* Parse it */
+	fh = file_open(path, MODE_READ, FTYPE_TEXT);
+	if (!fh) {
+		mem_free(text);
+		return PARSE_ERROR_NO_FILE_FOUND;
+	}
+	parser_record(p);
 	while (file_getl(fh, buf, sizeof(buf))) {
 		r = parser_parse(p, buf);
 		if (r)
 			break;
 	}
 	file_close(fh);
+
+	/* Keep what the parser made of it for next time */
+	snap = parser_recording(p, &snap_len);
+	if (!r)
+		save_snapshot(filename, text, text_len, snap, snap_len);
+	mem_free(snap);
+	mem_free(text);
 	return r;
 }
 
@@ -1441,7 +1441,7 @@ bool effect_handler_RECALL(effect_handler_context_t *context)
 	}
 
 	/* No recall from quest levels with force_descend */
-	if (OPT(player, birth_force_descend) && (is_quest(player->depth))) {
+	if (OPT(player, birth_force_descend) && (is_quest(player, player->depth))) {
 		msg("Nothing happens.");
 		return true;
 	}
@@ -1449,7 +1449,7 @@ bool effect_handler_RECALL(effect_handler_context_t *context)
 	/* Warn the player if they're descending to an unrecallable level */
 	target_depth = dungeon_get_next_level(player->max_depth, 1);
 	if (OPT(player, birth_force_descend) && !(player->depth) &&
-			(is_quest(target_depth))) {
+			(is_quest(player, target_depth))) {
 		if (!get_check("Are you sure you want to descend? ")) {
 			return false;
 		}
@@ -1499,7 +1499,7 @@ bool effect_handler_DEEP_DESCENT(effect_handler_context_t *context)
 	target_increment = (4 / z_info->stair_skip) + 1;
 	target_depth = dungeon_get_next_level(player->max_depth, target_increment);
 	for (i = 5; i > 0; i--) {
-		if (is_quest(target_depth)) break;
+		if (is_quest(player, target_depth)) break;
 		if (target_depth >= z_info->max_depth - 1) break;
 
 		target_depth++;
@@ -1706,7 +1706,7 @@ bool effect_handler_DETECT_TRAPS(effect_handler_context_t *context)
 				}
 			}
 			/* Mark as trap-detected */
-			sqinfo_on(square(cave, loc(x, y)).info, SQUARE_DTRAP);
+			sqinfo_on(square_info(cave, loc(x, y)), SQUARE_DTRAP);
 		}
 	}
 
@@ -2487,24 +2487,21 @@ bool effect_handler_ACQUIRE(effect_handler_context_t *context)
  */
 bool effect_handler_WAKE(effect_handler_context_t *context)
 {
-	int i;
+	struct monster_iter iter;
+	struct monster *mon;
 	bool woken = false;
 
 	struct loc origin = origin_get_loc(context->origin);
 
 	/* Wake everyone nearby */
-	for (i = 1; i < cave_monster_max(cave); i++) {
-		struct monster *mon = cave_monster(cave, i);
-		if (mon->race) {
-			int radius = z_info->max_sight * 2;
-			int dist = distance(origin, mon->grid);
-
-			/* Skip monsters too far away */
-			if ((dist < radius) && mon->m_timed[MON_TMD_SLEEP]) {
-				/* Monster wakes, closer means likelier to become aware */
-				monster_wake(mon, false, 100 - 2 * dist);
-				woken = true;
-			}
+	monster_iter_near(&iter, cave, origin, z_info->max_sight * 2 - 1);
+	while ((mon = monster_iter_next(&iter))) {
+		int dist = distance(origin, mon->grid);
+
+		if (mon->m_timed[MON_TMD_SLEEP]) {
+			/* Monster wakes, closer means likelier to become aware */
+			monster_wake(mon, false, 100 - 2 * dist);
+			woken = true;
 		}
 	}
 
@@ -2702,17 +2699,15 @@ bool effect_handler_MASS_BANISH(effect_handler_context_t *context)
  */
 bool effect_handler_PROBE(effect_handler_context_t *context)
 {
-	int i;
+	struct monster_iter iter;
+	struct monster *mon;
 
 	bool probe = false;
 
-	/* Probe all (nearby) monsters */
-	for (i = 1; i < cave_monster_max(cave); i++) {
-		struct monster *mon = cave_monster(cave, i);
-
-		/* Paranoia -- Skip dead monsters */
-		if (!mon->race) continue;
-
+	/* Probe all (nearby) monsters; the view reaches no further than
+	 * max_sight */
+	monster_iter_near(&iter, cave, player->grid, z_info->max_sight);
+	while ((mon = monster_iter_next(&iter))) {
 		/* Require line of sight */
 		if (!square_isview(cave, mon->grid)) continue;
 
@@ -2907,7 +2902,7 @@ bool effect_handler_TELEPORT(effect_handler_context_t *context)
 	monster_swap(start, spots->grid);
 
 	/* Clear any projection marker to prevent double processing */
-	sqinfo_off(square(cave, spots->grid).info, SQUARE_PROJECT);
+	sqinfo_off(square_info(cave, spots->grid), SQUARE_PROJECT);
 
 	/* Clear monster target if it's no longer visible */
 	if (!target_able(target_get_monster())) {
@@ -3036,7 +3031,7 @@ bool effect_handler_TELEPORT_TO(effect_handler_context_t *context)
 	monster_swap(start, land);
 
 	/* Clear any projection marker to prevent double processing */
-	sqinfo_off(square(cave, land).info, SQUARE_PROJECT);
+	sqinfo_off(square_info(cave, land), SQUARE_PROJECT);
 
 	/* Lots of updates after monster_swap */
 	handle_stuff(player);
@@ -3099,11 +3094,11 @@ bool effect_handler_TELEPORT_LEVEL(effect_handler_context_t *context)
 		up = false;
 
 	/* No forcing player down to quest levels if they can't leave */
-	if (!up && is_quest(target_depth))
+	if (!up && is_quest(player, target_depth))
 		down = false;
 
 	/* Can't leave quest levels or go down deeper than the dungeon */
-	if (is_quest(player->depth) || (player->depth >= z_info->max_depth - 1))
+	if (is_quest(player, player->depth) || (player->depth >= z_info->max_depth - 1))
 		down = false;
 
 	/* Determine up/down if not already done */
@@ -3238,14 +3233,14 @@ bool effect_handler_DESTRUCTION(effect_handler_context_t *context)
 			if (k > r) continue;
 
 			/* Lose room and vault */
-			sqinfo_off(square(cave, grid).info, SQUARE_ROOM);
-			sqinfo_off(square(cave, grid).info, SQUARE_VAULT);
+			sqinfo_off(square_info(cave, grid), SQUARE_ROOM);
+			sqinfo_off(square_info(cave, grid), SQUARE_VAULT);
 
 			/* Forget completely */
 			if (!square_isbright(cave, grid)) {
-				sqinfo_off(square(cave, grid).info, SQUARE_GLOW);
+				square_unglow(cave, grid);
 			}
-			sqinfo_off(square(cave, grid).info, SQUARE_SEEN);
+			sqinfo_off(square_info(cave, grid), SQUARE_SEEN);
 			square_forget(cave, grid);
 			square_light_spot(cave, grid);
 
@@ -3375,14 +3370,14 @@ bool effect_handler_EARTHQUAKE(effect_handler_context_t *context)
 			if (distance(centre, grid) > r) continue;
 
 			/* Lose room and vault */
-			sqinfo_off(square(cave, grid).info, SQUARE_ROOM);
-			sqinfo_off(square(cave, grid).info, SQUARE_VAULT);
+			sqinfo_off(square_info(cave, grid), SQUARE_ROOM);
+			sqinfo_off(square_info(cave, grid), SQUARE_VAULT);
 
 			/* Forget completely */
 			if (!square_isbright(cave, grid)) {
-				sqinfo_off(square(cave, grid).info, SQUARE_GLOW);
+				square_unglow(cave, grid);
 			}
-			sqinfo_off(square(cave, grid).info, SQUARE_SEEN);
+			sqinfo_off(square_info(cave, grid), SQUARE_SEEN);
 			square_forget(cave, grid);
 			square_light_spot(cave, grid);
 
@@ -3489,7 +3484,7 @@ bool effect_handler_EARTHQUAKE(effect_handler_context_t *context)
 			if (!map[16 + grid.y - centre.y][16 + grid.x - centre.x]) continue;
 
 			/* Process monsters */
-			if (square(cave, grid).mon > 0) {
+			if (square_midx(cave, grid) > 0) {
 				struct monster *mon = square_monster(cave, grid);
 
 				/* Most monsters cannot co-exist with rock */
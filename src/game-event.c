@@ -18,6 +18,7 @@
 
 #include <assert.h>
 #include "game-event.h"
+#include "journal.h"
 #include "object.h"
 #include "z-virt.h"
 
@@ -34,6 +35,9 @@ static void game_event_dispatch(game_event_type type, game_event_data *data)
 {
 	struct event_handler_entry *this = event_handlers[type];
 
+	/* Let the journal know the UI is handling it */
+	journal_event();
+
 	/* 
 	 * Send the word out to all interested event handlers.
 	 */
@@ -43,6 +47,8 @@ static void game_event_dispatch(game_event_type type, game_event_data *data)
 		this->fn(type, data, this->user);
 		this = this->next;
 	}
+
+	journal_leave();
 }
 
 void event_add_handler(game_event_type type, game_event_handler *fn, void *user)
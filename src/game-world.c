@@ -34,17 +34,18 @@
 #include "player-calcs.h"
 #include "player-timed.h"
 #include "player-util.h"
+#include "profile.h"
 #include "source.h"
 #include "target.h"
 #include "trap.h"
-#include "z-queue.h"
 
 u16b daycount = 0;
 u32b seed_randart;		/* Hack -- consistent random artifacts */
 u32b seed_flavor;		/* Hack -- consistent object colors */
+struct rand_state level_rng;	/* Levels don't depend on play's random numbers */
 s32b turn;				/* Current game turn */
 bool character_generated;	/* The character exists */
-bool character_dungeon;		/* The character has a dungeon */
+THREAD_LOCAL bool character_dungeon;	/* The character has a dungeon */
 struct level *world;
 
 /**
@@ -375,69 +376,22 @@ static void decrease_timeouts(void)
  * values, thereby homing in on the player even though twisty tunnels and
  * mazes.  Monsters have a hearing value, which is the largest sound value
  * they can detect.
+ *
+ * The field is kept between turns, and repaired by cave_update_noise() where
+ * the source or the player has moved or sound transmitting terrain has
+ * changed.
  */
 static void make_noise(struct player *p)
 {
-	struct loc next = p->grid;
-	int y, x, d;
-	int noise = 0;
-    struct queue *queue = q_new(cave->height * cave->width);
+	struct loc source = p->grid;
 	struct loc decoy = cave_find_decoy(cave);
 
-	/* Set all the grids to silence */
-	for (y = 1; y < cave->height - 1; y++) {
-		for (x = 1; x < cave->width - 1; x++) {
-			cave->noise.grids[y][x] = 0;
-		}
-	}
-
 	/* If there's a decoy, use that instead of the player */
 	if (!loc_is_zero(decoy)) {
-		next = decoy;
-	}
-
-	/* Player makes noise */
-	cave->noise.grids[next.y][next.x] = noise;
-	q_push_int(queue, grid_to_i(next, cave->width));
-	noise++;
-
-	/* Propagate noise */
-	while (q_len(queue) > 0) {
-		/* Get the next grid */
-		i_to_grid(q_pop_int(queue), cave->width, &next);
-
-		/* If we've reached the current noise level, put it back and step */
-		if (cave->noise.grids[next.y][next.x] == noise) {
-			q_push_int(queue, grid_to_i(next, cave->width));
-			noise++;
-			continue;
-		}
-
-		/* Assign noise to the children and enqueue them */
-		for (d = 0; d < 8; d++)	{
-			/* Child location */
-			struct loc grid = loc_sum(next, ddgrid_ddd[d]);
-
-			if (!square_in_bounds(cave, grid)) continue;
-
-			/* Ignore features that don't transmit sound */
-			if (square_isnoflow(cave, grid)) continue;
-
-			/* Skip grids that already have noise */
-			if (cave->noise.grids[grid.y][grid.x] != 0) continue;
-
-			/* Skip the player grid */
-			if (loc_eq(player->grid, grid)) continue;
-
-			/* Save the noise */
-			cave->noise.grids[grid.y][grid.x] = noise;
-
-			/* Enqueue that entry */
-			q_push_int(queue, grid_to_i(grid, cave->width));
-		}
+		source = decoy;
 	}
 
-	q_free(queue);
+	cave_update_noise(cave, source, p->grid);
 }
 
 /**
@@ -453,10 +407,14 @@ static void make_noise(struct player *p)
  * value which indicates the oldest scent they can detect.  Grids where the
  * player has never been will have scent 0.  The player's grid will also have
  * scent 0, but this is OK as no monster will ever be smelling it.
+ *
+ * Only the grids which have scent are aged, from the list of them kept with
+ * the scent map.
  */
 static void update_scent(void)
 {
-	int y, x;
+	struct heatmap *scent_map = &cave->scent;
+	int i, y, x, live = 0;
 	int scent_strength[5][5] = {
 		{2, 2, 2, 2, 2},
 		{2, 1, 1, 1, 2},
@@ -465,14 +423,21 @@ static void update_scent(void)
 		{2, 2, 2, 2, 2},
 	};
 
-	/* Update scent for all grids */
-	for (y = 1; y < cave->height - 1; y++) {
-		for (x = 1; x < cave->width - 1; x++) {
-			if (cave->scent.grids[y][x] > 0) {
-				cave->scent.grids[y][x]++;
+	if (!scent_map->live) {
+		scent_map->live = mem_zalloc(cave->height * cave->width * sizeof(int));
+	}
+
+	/* Update scent for all grids with scent, dropping those which lose it */
+	for (i = 0; i < scent_map->live_count; i++) {
+		struct loc grid;
+		i_to_grid(scent_map->live[i], cave->width, &grid);
+		if (scent_map->grids[grid.y][grid.x] > 0) {
+			if (++scent_map->grids[grid.y][grid.x] > 0) {
+				scent_map->live[live++] = scent_map->live[i];
 			}
 		}
 	}
+	scent_map->live_count = live;
 
 	/* Scentless player */
 	if (player->timed[TMD_SCENTLESS]) return;
@@ -517,7 +482,12 @@ static void update_scent(void)
 				continue;
 			}
 
-			/* Mark the scent */
+			/* Mark the scent, and age it from now on if it's new */
+			if (!cave->scent.grids[scent.y][scent.x] && new_scent &&
+				square_in_bounds_fully(cave, scent)) {
+				scent_map->live[scent_map->live_count++] =
+					grid_to_i(scent, cave->width);
+			}
 			cave->scent.grids[scent.y][scent.x] = new_scent;
 		}
 	}
@@ -530,6 +500,8 @@ void process_world(struct chunk *c)
 {
 	int i, y, x;
 
+	PROFILE_START(WORLD);
+
 	/* Compact the monster list if we're approaching the limit */
 	if (cave_monster_count(c) + 32 > z_info->level_monster_max)
 		compact_monsters(64);
@@ -703,8 +675,12 @@ void process_world(struct chunk *c)
 	player_update_light(player);
 
 	/* Update noise and scent */
+	PROFILE_START(NOISE);
 	make_noise(player);
+	PROFILE_STOP(NOISE);
+	PROFILE_START(SCENT);
 	update_scent();
+	PROFILE_STOP(SCENT);
 
 
 	/*** Process Inventory ***/
@@ -731,7 +707,7 @@ void process_world(struct chunk *c)
 	for (y = 0; y < c->height; y++) {
 		for (x = 0; x < c->width; x++) {
 			struct loc grid = loc(x, y);
-			struct trap *trap = square(c, grid).trap;
+			struct trap *trap = square_trap(c, grid);
 			while (trap) {
 				if (trap->timeout) {
 					trap->timeout--;
@@ -795,6 +771,8 @@ void process_world(struct chunk *c)
 			}
 		}
 	}
+
+	PROFILE_STOP(WORLD);
 }
 
 
@@ -877,6 +855,8 @@ static void process_player_cleanup(void)
  */
 void process_player(void)
 {
+	PROFILE_START(PLAYER);
+
 	/* Check for interrupts */
 	player_resting_complete_special(player);
 	event_signal(EVENT_CHECK_INTERRUPT);
@@ -925,6 +905,9 @@ void process_player(void)
 			event_signal(EVENT_REFRESH);
 		}
 
+		/* Think ahead about the level below while the player decides */
+		gen_ahead(player);
+
 		/* Get a command from the queue if there is one */
 		if (!cmdq_pop(CTX_GAME))
 			break;
@@ -939,6 +922,8 @@ void process_player(void)
 
 	/* Notice stuff (if needed) */
 	notice_stuff(player);
+
+	PROFILE_STOP(PLAYER);
 }
 
 /**
@@ -946,6 +931,12 @@ void process_player(void)
  */
 void on_new_level(void)
 {
+	/* Count what happens here towards this level, if not already */
+	PROFILE_LEVEL(player->depth, turn);
+
+	/* Start the monsters from where they were */
+	schedule_monsters(cave);
+
 	/* Arena levels are not really a level change */
 	if (!player->upkeep->arena_level) {
 		/* Play ambient sound on change of level. */
@@ -1016,6 +1007,46 @@ static void on_leave_level(void) {
 }
 
 
+/**
+ * Pass straight over game turns on which nothing would happen.
+ *
+ * Until the player has the energy to move, a monster is ready to, or the
+ * world is due to be processed, a game turn only hands out energy.  Those
+ * turns are skipped together, and the player given the energy they would
+ * have gained; monsters are given theirs lazily by the monster scheduler.
+ */
+static void skip_idle_turns(void)
+{
+	int energy = turn_energy(player->state.speed);
+	s32b to, next;
+
+	/* A new level, or the end of the game, has to be dealt with first */
+	if (player->upkeep->generate_level || player->is_dead ||
+		!player->upkeep->playing)
+		return;
+
+	if (player->energy >= z_info->move_energy || energy <= 0) return;
+
+	/* The player moves after the turn which gives them enough energy */
+	to = turn + (z_info->move_energy - player->energy + energy - 1) / energy;
+
+	/* The world is processed every ten turns */
+	to = MIN(to, turn + (10 - turn % 10) % 10);
+
+	/* Monsters move when they have the energy */
+	next = next_monster_turn(cave);
+	if (next >= 0)
+		to = MIN(to, next);
+	if (to <= turn) return;
+
+	skip_monster_turns(cave, to);
+	player->energy += (to - turn) * energy;
+	while (turn < to) {
+		PROFILE_TURN(turn);
+		turn++;
+	}
+}
+
 /**
  * The main game loop.
  *
@@ -1101,7 +1132,11 @@ void run_game_loop(void)
 			player->energy += turn_energy(player->state.speed);
 
 			/* Count game turns */
+			PROFILE_TURN(turn);
 			turn++;
+
+			/* Skip ahead to the next turn on which anything happens */
+			skip_idle_turns();
 		}
 
 		/* Make a new level if requested */
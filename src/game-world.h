@@ -32,9 +32,10 @@ struct level {
 extern u16b daycount;
 extern u32b seed_randart;
 extern u32b seed_flavor;
+extern struct rand_state level_rng;
 extern s32b turn;
 extern bool character_generated;
-extern bool character_dungeon;
+extern THREAD_LOCAL bool character_dungeon;
 extern const byte extract_energy[200];
 extern struct level *world;
 
@@ -86,8 +86,8 @@
 static bool square_is_granite_with_flag(struct chunk *c, struct loc grid,
 										int flag)
 {
-	if (square(c, grid).feat != FEAT_GRANITE) return false;
-	if (!sqinfo_has(square(c, grid).info, flag)) return false;
+	if (square_fidx(c, grid) != FEAT_GRANITE) return false;
+	if (!sqinfo_has(square_info(c, grid), flag)) return false;
 
 	return true;
 }
@@ -106,6 +106,8 @@ static bool square_is_granite_with_flag(struct chunk *c, struct loc grid,
  */
 static void build_streamer(struct chunk *c, int feat, int chance)
 {
+	struct dun_data *dun = c->gen->dun;
+
     /* Hack -- Choose starting point */
 	struct loc grid = rand_loc(loc(c->width / 2, c->height / 2), 15, 10);
 
@@ -169,6 +171,7 @@ static void build_streamer(struct chunk *c, int feat, int chance)
  */
 static void build_tunnel(struct chunk *c, struct loc grid1, struct loc grid2)
 {
+	struct dun_data *dun = c->gen->dun;
     int i;
     int main_loop_count = 0;
 	struct loc start = grid1, tmp_grid, offset;
@@ -388,6 +391,8 @@ static bool possible_doorway(struct chunk *c, struct loc grid)
  */
 static void try_door(struct chunk *c, struct loc grid)
 {
+	struct dun_data *dun = c->gen->dun;
+
     assert(square_in_bounds(c, grid));
 
     if (square_isstrongwall(c, grid)) return;
@@ -404,10 +409,13 @@ static void try_door(struct chunk *c, struct loc grid)
 
 /**
  * Generate a new dungeon level.
- * \param p is the player 
+ * \param g is the generation context
  * \return a pointer to the generated chunk
  */
-struct chunk *classic_gen(struct player *p, int min_height, int min_width) {
+struct chunk *classic_gen(struct gen_context *g, int min_height,
+						  int min_width) {
+	struct player *p = g->p;
+	struct dun_data *dun = g->dun;
     int i, j, k;
 	struct loc grid;
     int by, bx = 0, tby, tbx, key, rarity, built;
@@ -422,7 +430,7 @@ struct chunk *classic_gen(struct player *p, int min_height, int min_width) {
 
     /* This code currently does nothing - see comments below */
     i = randint1(10) + p->depth / 24;
-    if (is_quest(p->depth)) size_percent = 100;
+    if (is_quest(p, p->depth)) size_percent = 100;
     else if (i < 2) size_percent = 75;
     else if (i < 3) size_percent = 80;
     else if (i < 4) size_percent = 85;
@@ -434,9 +442,10 @@ struct chunk *classic_gen(struct player *p, int min_height, int min_width) {
     num_rooms = (dun->profile->dun_rooms * size_percent) / 100;
 	dun->block_hgt = dun->profile->block_size;
 	dun->block_wid = dun->profile->block_size;
-	c = cave_new(z_info->dungeon_hgt, z_info->dungeon_wid);
+	c = gen_cave_new(g, z_info->dungeon_hgt, z_info->dungeon_wid);
 	c->depth = p->depth;
-    ROOM_LOG("height=%d  width=%d  nrooms=%d", c->height, c->width, num_rooms);
+    ROOM_LOG(c, "height=%d  width=%d  nrooms=%d", c->height, c->width,
+			 num_rooms);
 
     /* Fill cave area with basic granite */
     fill_rectangle(c, 0, 0, c->height - 1, c->width - 1, 
@@ -665,6 +674,7 @@ static bool lab_is_tunnel(struct chunk *c, struct loc grid) {
 /**
  * Build a labyrinth chunk of a given height and width
  *
+ * \param g is the generation context
  * \param depth is the native depth 
  * \param h are the dimensions of the chunk
  * \param w are the dimensions of the chunk
@@ -672,7 +682,8 @@ static bool lab_is_tunnel(struct chunk *c, struct loc grid) {
  * \param soft is true if we use regular walls, false if permanent walls
  * \return a pointer to the generated chunk
  */
-struct chunk *labyrinth_chunk(int depth, int h, int w, bool lit, bool soft)
+struct chunk *labyrinth_chunk(struct gen_context *g, int depth, int h, int w,
+							  bool lit, bool soft)
 {
     int i, j, k;
 	struct loc grid;
@@ -693,7 +704,7 @@ struct chunk *labyrinth_chunk(int depth, int h, int w, bool lit, bool soft)
     int *walls;
 
 	/* The labyrinth chunk */
-	struct chunk *c = cave_new(h + 2, w + 2);
+	struct chunk *c = gen_cave_new(g, h + 2, w + 2);
 	c->depth = depth;
     /* allocate our arrays */
     sets = mem_zalloc(n * sizeof(int));
@@ -721,7 +732,7 @@ struct chunk *labyrinth_chunk(int depth, int h, int w, bool lit, bool soft)
 			struct loc diag = next_grid(grid, DIR_SE);
 			sets[k_local] = k_local;
 			square_set_feat(c, diag, FEAT_FLOOR);
-			if (lit) sqinfo_on(square(c, diag).info, SQUARE_GLOW);
+			if (lit) sqinfo_on(square_info(c, diag), SQUARE_GLOW);
 		}
     }
 
@@ -752,7 +763,7 @@ struct chunk *labyrinth_chunk(int depth, int h, int w, bool lit, bool soft)
 			int sb = sets[b];
 			square_set_feat(c, next_grid(grid, DIR_SE), FEAT_FLOOR);
 			if (lit) {
-				sqinfo_on(square(c, next_grid(grid, DIR_SE)).info, SQUARE_GLOW);
+				sqinfo_on(square_info(c, next_grid(grid, DIR_SE)), SQUARE_GLOW);
 			}
 			for (k = 0; k < n; k++) {
 				if (sets[k] == sb) sets[k] = sa;
@@ -790,13 +801,15 @@ struct chunk *labyrinth_chunk(int depth, int h, int w, bool lit, bool soft)
 
 /**
  * Build a labyrinth level.
- * \param p is the player
+ * \param g is the generation context
  * Note that if the function returns false, a level wasn't generated.
  * Labyrinths use the dungeon level's number to determine whether to generate
  * themselves (which means certain level numbers are more likely to generate
  * labyrinths than others).
  */
-struct chunk *labyrinth_gen(struct player *p, int min_height, int min_width) {
+struct chunk *labyrinth_gen(struct gen_context *g, int min_height,
+							int min_width) {
+	struct player *p = g->p;
     int i, k;
 	struct chunk *c;
 	struct loc grid;
@@ -824,7 +837,7 @@ struct chunk *labyrinth_gen(struct player *p, int min_height, int min_width) {
 	w = MAX(w, min_width);
 
 	/* Generate the actual labyrinth */
-	c = labyrinth_chunk(p->depth, h, w, lit, soft);
+	c = labyrinth_chunk(g, p->depth, h, w, lit, soft);
 	if (!c) return NULL;
 	c->depth = p->depth;
 
@@ -865,7 +878,7 @@ struct chunk *labyrinth_gen(struct player *p, int min_height, int min_width) {
 
     /* Notify if we want the player to see the maze layout */
     if (known) {
-		player->upkeep->light_level = true;
+		p->upkeep->light_level = true;
 	}
 
     return c;
@@ -935,7 +948,7 @@ static void mutate_cavern(struct chunk *c) {
 			else if (count < 4)
 				temp[grid_to_i(grid, w)] = FEAT_FLOOR;
 			else
-				temp[grid_to_i(grid, w)] = square(c, grid).feat;
+				temp[grid_to_i(grid, w)] = square_fidx(c, grid);
 		}
     }
 
@@ -1264,12 +1277,13 @@ void ensure_connectedness(struct chunk *c) {
 #define MAX_CAVERN_TRIES 10
 /**
  * The cavern generator's main function.
+ * \param g is the generation context
  * \param depth the chunk's native depth
  * \param h the chunk's dimensions
  * \param w the chunk's dimensions
  * \return a pointer to the generated chunk
  */
-struct chunk *cavern_chunk(int depth, int h, int w)
+struct chunk *cavern_chunk(struct gen_context *g, int depth, int h, int w)
 {
     int i;
     int size = h * w;
@@ -1282,10 +1296,10 @@ struct chunk *cavern_chunk(int depth, int h, int w)
 
     int tries;
 
-	struct chunk *c = cave_new(h, w);
+	struct chunk *c = gen_cave_new(g, h, w);
 	c->depth = depth;
 
-    ROOM_LOG("cavern h=%d w=%d size=%d density=%d times=%d", h, w, size,
+    ROOM_LOG(c, "cavern h=%d w=%d size=%d density=%d times=%d", h, w, size,
 			 density, times);
 
 	/* Start trying to build caverns */
@@ -1296,10 +1310,10 @@ struct chunk *cavern_chunk(int depth, int h, int w)
 
 		/* If there are enough open squares then we're done */
 		if (c->feat_count[FEAT_FLOOR] >= limit) {
-			ROOM_LOG("cavern ok (%d vs %d)", c->feat_count[FEAT_FLOOR], limit);
+			ROOM_LOG(c, "cavern ok (%d vs %d)", c->feat_count[FEAT_FLOOR], limit);
 			break;
 		}
-		ROOM_LOG("cavern failed--try again (%d vs %d)",
+		ROOM_LOG(c, "cavern failed--try again (%d vs %d)",
 				 c->feat_count[FEAT_FLOOR], limit);
 	}
 
@@ -1324,9 +1338,10 @@ struct chunk *cavern_chunk(int depth, int h, int w)
 
 /**
  * Make a cavern level.
- * \param p is the player
+ * \param g is the generation context
  */
-struct chunk *cavern_gen(struct player *p, int min_height, int min_width) {
+struct chunk *cavern_gen(struct gen_context *g, int min_height, int min_width) {
+	struct player *p = g->p;
     int i, k;
 
     int h = rand_range(z_info->dungeon_hgt / 2, (z_info->dungeon_hgt * 3) / 4);
@@ -1347,7 +1362,7 @@ struct chunk *cavern_gen(struct player *p, int min_height, int min_width) {
 		w = MAX(w, min_width);
 
 		/* Try to build the cavern, fail gracefully */
-		c = cavern_chunk(p->depth, h, w);
+		c = cavern_chunk(g, p->depth, h, w);
 		if (!c) return NULL;
     }
 	c->depth = p->depth;
@@ -1455,7 +1470,7 @@ static void town_gen_layout(struct chunk *c, struct player *p)
 	for (grid.y = 1; grid.y < c->height - 1; grid.y++) {
 		for (grid.x = 1; grid.x < c->width - 1; grid.x++) {
 			if (square_isfloor(c, grid))
-				sqinfo_off(square(c, grid).info, SQUARE_ROOM);
+				sqinfo_off(square_info(c, grid), SQUARE_ROOM);
 			else if (!square_isperm(c, grid) && !square_isfiery(c, grid))
 				square_set_feat(c, grid, FEAT_PERM);
 		}
@@ -1524,22 +1539,23 @@ static void town_gen_layout(struct chunk *c, struct player *p)
 
 /**
  * Town logic flow for generation of new town.
- * \param p is the player
+ * \param g is the generation context
  * \return a pointer to the generated chunk
  * We start with a fully wiped cave of normal floors. This function does NOT do
  * anything about the owners of the stores, nor the contents thereof. It only
  * handles the physical layout.
  */
-struct chunk *town_gen(struct player *p, int min_height, int min_width)
+struct chunk *town_gen(struct gen_context *g, int min_height, int min_width)
 {
+	struct player *p = g->p;
 	int i;
 	struct loc grid;
-	int residents = is_daytime() ? z_info->town_monsters_day :
+	int residents = g->daytime ? z_info->town_monsters_day :
 		z_info->town_monsters_night;
-	struct chunk *c_new, *c_old = chunk_find_name("Town");
+	struct chunk *c_new, *c_old = g->town;
 
 	/* Make a new chunk */
-	c_new = cave_new(z_info->town_hgt, z_info->town_wid);
+	c_new = gen_cave_new(g, z_info->town_hgt, z_info->town_wid);
 
 	/* First time */
 	if (!c_old) {
@@ -1548,11 +1564,11 @@ struct chunk *town_gen(struct player *p, int min_height, int min_width)
 		/* Build stuff */
 		town_gen_layout(c_new, p);
 	} else {
-		/* Copy from the chunk list, remove the old one */
+		/* Copy from the stored town, which the copy empties */
 		if (!chunk_copy(c_new, c_old, 0, 0, 0, 0))
 			quit_fmt("chunk_copy() level bounds failed!");
-		chunk_list_remove("Town");
 		cave_free(c_old);
+		g->town = NULL;
 
 		/* Find the stairs (lame) */
 		for (grid.y = 0; grid.y < c_new->height; grid.y++) {
@@ -1571,7 +1587,7 @@ struct chunk *town_gen(struct player *p, int min_height, int min_width)
 	}
 
 	/* Apply illumination */
-	cave_illuminate(c_new, is_daytime());
+	cave_illuminate(c_new, g->daytime);
 
 	/* Make some residents */
 	for (i = 0; i < residents; i++)
@@ -1584,13 +1600,16 @@ struct chunk *town_gen(struct player *p, int min_height, int min_width)
 /* ------------------ MODIFIED ---------------- */
 /**
  * The main modified generation algorithm
+ * \param g is the generation context
  * \param depth is the chunk's native depth
  * \param height are the chunk's dimensions
  * \param width are the chunk's dimensions
  * \return a pointer to the generated chunk
  */
-struct chunk *modified_chunk(int depth, int height, int width)
+struct chunk *modified_chunk(struct gen_context *g, int depth, int height,
+							 int width)
 {
+	struct dun_data *dun = g->dun;
     int i;
 	struct loc grid;
     int by = 0, bx = 0, key, rarity;
@@ -1600,12 +1619,13 @@ struct chunk *modified_chunk(int depth, int height, int width)
 	struct connector *join = dun->join;
 
     /* Make the cave */
-    struct chunk *c = cave_new(height, width);
+    struct chunk *c = gen_cave_new(g, height, width);
 	c->depth = depth;
 
 	/* Set the intended number of floor grids based on cave floor area */
     num_floors = c->height * c->width / 7;
-    ROOM_LOG("height=%d  width=%d  nfloors=%d", c->height, c->width,num_floors);
+    ROOM_LOG(c, "height=%d  width=%d  nfloors=%d", c->height, c->width,
+			 num_floors);
 
     /* Fill cave area with basic granite */
     fill_rectangle(c, 0, 0, c->height - 1, c->width - 1, 
@@ -1629,7 +1649,7 @@ struct chunk *modified_chunk(int depth, int height, int width)
     dun->cent_n = 0;
 
 	/* Build the special staircase rooms */
-	if (OPT(player, birth_levels_persist)) {
+	if (OPT(g->p, birth_levels_persist)) {
 		struct room_profile profile;
 		for (i = 0; i < num_rooms; i++) {
 			profile = dun->profile->room_profiles[i];
@@ -1723,7 +1743,7 @@ struct chunk *modified_chunk(int depth, int height, int width)
 
 /**
  * Generate a new dungeon level.
- * \param p is the player
+ * \param g is the generation context
  * \return a pointer to the generated chunk
  *
  * This is sample code to illustrate some of the new dungeon generation
@@ -1744,14 +1764,17 @@ struct chunk *modified_chunk(int depth, int height, int width)
  *   interesting rooms, as well as to make general monster restrictions in
  *   areas or the whole dungeon
  */
-struct chunk *modified_gen(struct player *p, int min_height, int min_width) {
+struct chunk *modified_gen(struct gen_context *g, int min_height,
+						   int min_width) {
+	struct player *p = g->p;
+	struct dun_data *dun = g->dun;
     int i, k;
     int size_percent, y_size, x_size;
 	struct chunk *c;
 
     /* Scale the level */
     i = randint1(10) + p->depth / 24;
-    if (is_quest(p->depth)) size_percent = 100;
+    if (is_quest(p, p->depth)) size_percent = 100;
     else if (i < 2) size_percent = 75;
     else if (i < 3) size_percent = 80;
     else if (i < 4) size_percent = 85;
@@ -1769,7 +1792,7 @@ struct chunk *modified_gen(struct player *p, int min_height, int min_width) {
 	dun->block_hgt = dun->profile->block_size;
 	dun->block_wid = dun->profile->block_size;
 
-    c = modified_chunk(p->depth, MIN(z_info->dungeon_hgt, y_size),
+    c = modified_chunk(g, p->depth, MIN(z_info->dungeon_hgt, y_size),
 					   MIN(z_info->dungeon_wid, x_size));
 	c->depth = p->depth;
 
@@ -1811,7 +1834,7 @@ struct chunk *modified_gen(struct player *p, int min_height, int min_width) {
     i = z_info->level_monster_min + randint1(8) + k;
 
 	/* Remove all monster restrictions. */
-	mon_restrict(NULL, c->depth, true);
+	mon_restrict(c, NULL, c->depth, true);
 
     /* Put some monsters in the dungeon */
     for (; i > 0; i--)
@@ -1834,13 +1857,16 @@ struct chunk *modified_gen(struct player *p, int min_height, int min_width) {
 /* ------------------ MORIA ---------------- */
 /**
  * The main moria generation algorithm
+ * \param g is the generation context
  * \param depth is the chunk's native depth
  * \param height are the chunk's dimensions
  * \param width are the chunk's dimensions
  * \return a pointer to the generated chunk
  */
-struct chunk *moria_chunk(int depth, int height, int width)
+struct chunk *moria_chunk(struct gen_context *g, int depth, int height,
+						  int width)
 {
+	struct dun_data *dun = g->dun;
     int i;
 	struct loc grid;
     int by = 0, bx = 0, key, rarity;
@@ -1849,12 +1875,13 @@ struct chunk *moria_chunk(int depth, int height, int width)
     int dun_unusual = dun->profile->dun_unusual;
 
     /* Make the cave */
-    struct chunk *c = cave_new(height, width);
+    struct chunk *c = gen_cave_new(g, height, width);
 	c->depth = depth;
 
 	/* Set the intended number of floor grids based on cave floor area */
     num_floors = c->height * c->width / 7;
-    ROOM_LOG("height=%d  width=%d  nfloors=%d", c->height, c->width,num_floors);
+    ROOM_LOG(c, "height=%d  width=%d  nfloors=%d", c->height, c->width,
+			 num_floors);
 
     /* Fill cave area with basic granite */
     fill_rectangle(c, 0, 0, c->height - 1, c->width - 1, 
@@ -1954,7 +1981,7 @@ struct chunk *moria_chunk(int depth, int height, int width)
 
 /**
  * Generate a new dungeon level.
- * \param p is the player
+ * \param g is the generation context
  * \return a pointer to the generated chunk
  *
  * This produces Oangband-style moria levels.
@@ -1968,14 +1995,16 @@ struct chunk *moria_chunk(int depth, int height, int width)
  * labyrinth levels are selected) would be
  *	if ((c->depth >= 10) && (c->depth < 40) && one_in_(40))
  */
-struct chunk *moria_gen(struct player *p, int min_height, int min_width) {
+struct chunk *moria_gen(struct gen_context *g, int min_height, int min_width) {
+	struct player *p = g->p;
+	struct dun_data *dun = g->dun;
     int i, k;
     int size_percent, y_size, x_size;
 	struct chunk *c;
 
     /* Scale the level */
     i = randint1(10) + p->depth / 24;
-    if (is_quest(p->depth)) size_percent = 100;
+    if (is_quest(p, p->depth)) size_percent = 100;
     else if (i < 2) size_percent = 75;
     else if (i < 3) size_percent = 80;
     else if (i < 4) size_percent = 85;
@@ -1993,7 +2022,7 @@ struct chunk *moria_gen(struct player *p, int min_height, int min_width) {
 	dun->block_hgt = dun->profile->block_size;
 	dun->block_wid = dun->profile->block_size;
 
-    c = moria_chunk(p->depth, MIN(z_info->dungeon_hgt, y_size),
+    c = moria_chunk(g, p->depth, MIN(z_info->dungeon_hgt, y_size),
 					   MIN(z_info->dungeon_wid, x_size));
 	c->depth = p->depth;
 
@@ -2031,14 +2060,14 @@ struct chunk *moria_gen(struct player *p, int min_height, int min_width) {
     i = z_info->level_monster_min + randint1(8) + k;
 
 	/* Moria levels have a high proportion of cave dwellers. */
-	mon_restrict("Moria dwellers", c->depth, true);
+	mon_restrict(c, "Moria dwellers", c->depth, true);
 
     /* Put some monsters in the dungeon */
     for (; i > 0; i--)
 		pick_and_place_distant_monster(c, p, 0, true, c->depth);
 
 	/* Remove our restrictions. */
-	(void) mon_restrict(NULL, c->depth, false);
+	(void) mon_restrict(c, NULL, c->depth, false);
 
     /* Put some objects in rooms */
     alloc_objects(c, SET_ROOM, TYP_OBJECT, Rand_normal(z_info->room_item_av, 3),
@@ -2057,11 +2086,12 @@ struct chunk *moria_gen(struct player *p, int min_height, int min_width) {
 /* ------------------ HARD CENTRE ---------------- */
 /**
  * Make a chunk consisting only of a greater vault
- * \param p is the player
+ * \param g is the generation context
  * \return a pointer to the generated chunk
  */
-struct chunk *vault_chunk(struct player *p)
+struct chunk *vault_chunk(struct gen_context *g)
 {
+	struct player *p = g->p;
 	struct vault *v;
 	struct chunk *c;
 
@@ -2069,7 +2099,7 @@ struct chunk *vault_chunk(struct player *p)
 	else v = random_vault(p->depth, "Greater vault");
 
 	/* Make the chunk */
-	c = cave_new(v->hgt, v->wid);
+	c = gen_cave_new(g, v->hgt, v->wid);
 	c->depth = p->depth;
 
 	/* Build the vault in it */
@@ -2116,13 +2146,16 @@ void connect_caverns(struct chunk *c, struct loc floor[])
 }
 /**
  * Generate a hard centre level - a greater vault surrounded by caverns
- * \param p is the player
+ * \param g is the generation context
  * \return a pointer to the generated chunk
 */
-struct chunk *hard_centre_gen(struct player *p, int min_height, int min_width)
+struct chunk *hard_centre_gen(struct gen_context *g, int min_height,
+							  int min_width)
 {
+	struct player *p = g->p;
+
 	/* Make a vault for the centre */
-	struct chunk *centre = vault_chunk(p);
+	struct chunk *centre = vault_chunk(g);
 	int rotate = 0;
 
 	/* Dimensions for the surrounding caverns */
@@ -2155,18 +2188,22 @@ struct chunk *hard_centre_gen(struct player *p, int min_height, int min_width)
 	}
 
 	/* Make the caverns */
-	upper_cavern = cavern_chunk(p->depth, centre_cavern_hgt, centre_cavern_wid);
-	lower_cavern = cavern_chunk(p->depth, centre_cavern_hgt, centre_cavern_wid);
+	upper_cavern = cavern_chunk(g, p->depth, centre_cavern_hgt,
+								centre_cavern_wid);
+	lower_cavern = cavern_chunk(g, p->depth, centre_cavern_hgt,
+								centre_cavern_wid);
 	side_cavern_wid = (z_info->dungeon_wid - centre_cavern_wid) / 2;
-	left_cavern = cavern_chunk(p->depth, z_info->dungeon_hgt, side_cavern_wid);
-	right_cavern = cavern_chunk(p->depth, z_info->dungeon_hgt, side_cavern_wid);
+	left_cavern = cavern_chunk(g, p->depth, z_info->dungeon_hgt,
+							   side_cavern_wid);
+	right_cavern = cavern_chunk(g, p->depth, z_info->dungeon_hgt,
+								side_cavern_wid);
 
 	/* Return on failure */
 	if (!upper_cavern || !lower_cavern || !left_cavern || !right_cavern)
 		return NULL;
 
 	/* Make a cave to copy them into, and find a floor square in each cavern */
-	c = cave_new(z_info->dungeon_hgt, z_info->dungeon_wid);
+	c = gen_cave_new(g, z_info->dungeon_hgt, z_info->dungeon_wid);
 	c->depth = p->depth;
 
 	/* Left */
@@ -2276,10 +2313,12 @@ struct chunk *hard_centre_gen(struct player *p, int min_height, int min_width)
 /**
  * Generate a lair level - a regular cave generated with the modified
  * algorithm, connected to a cavern with themed monsters
- * \param p is the player
+ * \param g is the generation context
  * \return a pointer to the generated chunk
  */
-struct chunk *lair_gen(struct player *p, int min_height, int min_width) {
+struct chunk *lair_gen(struct gen_context *g, int min_height, int min_width) {
+	struct player *p = g->p;
+	struct dun_data *dun = g->dun;
     int i, k;
     int size_percent, y_size, x_size;
 	struct chunk *c;
@@ -2291,7 +2330,7 @@ struct chunk *lair_gen(struct player *p, int min_height, int min_width) {
 
     /* Scale the level */
     i = randint1(10) + p->depth / 24;
-    if (is_quest(p->depth)) size_percent = 100;
+    if (is_quest(p, p->depth)) size_percent = 100;
     else if (i < 2) size_percent = 75;
     else if (i < 3) size_percent = 80;
     else if (i < 4) size_percent = 85;
@@ -2309,11 +2348,11 @@ struct chunk *lair_gen(struct player *p, int min_height, int min_width) {
 	dun->block_hgt = dun->profile->block_size;
 	dun->block_wid = dun->profile->block_size;
 
-    normal = modified_chunk(p->depth, y_size, x_size / 2);
+    normal = modified_chunk(g, p->depth, y_size, x_size / 2);
 	if (!normal) return NULL;
 	normal->depth = p->depth;
 
-	lair = cavern_chunk(p->depth, y_size, x_size / 2);
+	lair = cavern_chunk(g, p->depth, y_size, x_size / 2);
 	if (!lair) return NULL;
 	lair->depth = p->depth;
 
@@ -2344,14 +2383,14 @@ struct chunk *lair_gen(struct player *p, int min_height, int min_width) {
 	/* Find appropriate monsters */
 	while (true) {
 		/* Choose a pit profile */
-		set_pit_type(lair->depth, 0);
+		set_pit_type(lair, lair->depth, 0);
 
 		/* Set monster generation restrictions */
-		if (mon_restrict(dun->pit_type->name, lair->depth, true))
+		if (mon_restrict(lair, dun->pit_type->name, lair->depth, true))
 			break;
 	}
 
-	ROOM_LOG("Monster lair - %s", dun->pit_type->name);
+	ROOM_LOG(lair, "Monster lair - %s", dun->pit_type->name);
 
     /* Place lair monsters */
 	spread_monsters(lair, dun->pit_type->name, lair->depth, i, lair->height / 2,
@@ -2359,10 +2398,10 @@ struct chunk *lair_gen(struct player *p, int min_height, int min_width) {
 					ORIGIN_CAVERN);
 
 	/* Remove our restrictions. */
-	(void) mon_restrict(NULL, lair->depth, false);
+	(void) mon_restrict(lair, NULL, lair->depth, false);
 
 	/* Make the level */
-	c = cave_new(y_size, x_size);
+	c = gen_cave_new(g, y_size, x_size);
 	c->depth = p->depth;
 	if (one_in_(2)) {
 		chunk_copy(c, lair, 0, 0, 0, false);
@@ -2419,10 +2458,13 @@ struct chunk *lair_gen(struct player *p, int min_height, int min_width) {
  * between them, and no teleport and only upstairs from the side where the
  * player starts.
  *
- * \param p is the player
+ * \param g is the generation context
  * \return a pointer to the generated chunk
  */
-struct chunk *gauntlet_gen(struct player *p, int min_height, int min_width) {
+struct chunk *gauntlet_gen(struct gen_context *g, int min_height,
+						   int min_width) {
+	struct player *p = g->p;
+	struct dun_data *dun = g->dun;
 	int i, k, y;
 	struct chunk *c;
 	struct chunk *arrival;
@@ -2437,19 +2479,19 @@ struct chunk *gauntlet_gen(struct player *p, int min_height, int min_width) {
 	/* No persistent levels of this type for now */
 	if (OPT(p, birth_levels_persist)) return NULL;
 
-	gauntlet = labyrinth_chunk(p->depth, gauntlet_hgt, gauntlet_wid, false,
+	gauntlet = labyrinth_chunk(g, p->depth, gauntlet_hgt, gauntlet_wid, false,
 							   false);
 	if (!gauntlet) return NULL;
 	gauntlet->depth = p->depth;
 
-	arrival = cavern_chunk(p->depth, y_size, x_size);
+	arrival = cavern_chunk(g, p->depth, y_size, x_size);
 	if (!arrival) {
 		cave_free(gauntlet);
 		return NULL;
 	}
 	arrival->depth = p->depth;
 
-	departure = cavern_chunk(p->depth, y_size, x_size);
+	departure = cavern_chunk(g, p->depth, y_size, x_size);
 	if (!departure) {
 		cave_free(gauntlet);
 		cave_free(arrival);
@@ -2508,14 +2550,15 @@ struct chunk *gauntlet_gen(struct player *p, int min_height, int min_width) {
 	/* Find appropriate monsters */
 	while (true) {
 		/* Choose a pit profile */
-		set_pit_type(gauntlet->depth, 0);
+		set_pit_type(gauntlet, gauntlet->depth, 0);
 
 		/* Set monster generation restrictions */
-		if (mon_restrict(dun->pit_type->name, gauntlet->depth, true))
+		if (mon_restrict(gauntlet, dun->pit_type->name, gauntlet->depth,
+						 true))
 			break;
 	}
 
-	ROOM_LOG("Gauntlet - %s", dun->pit_type->name);
+	ROOM_LOG(gauntlet, "Gauntlet - %s", dun->pit_type->name);
 
 	/* Place labyrinth monsters */
 	spread_monsters(gauntlet, dun->pit_type->name, gauntlet->depth, i,
@@ -2524,10 +2567,11 @@ struct chunk *gauntlet_gen(struct player *p, int min_height, int min_width) {
 					ORIGIN_LABYRINTH);
 
 	/* Remove our restrictions. */
-	(void) mon_restrict(NULL, gauntlet->depth, false);
+	(void) mon_restrict(gauntlet, NULL, gauntlet->depth, false);
 
 	/* Make the level */
-	c = cave_new(y_size, arrival->width + gauntlet->width + departure->width);
+	c = gen_cave_new(g, y_size,
+					 arrival->width + gauntlet->width + departure->width);
 	c->depth = p->depth;
 
 	/* Fill cave area with basic granite */
@@ -2587,14 +2631,15 @@ struct chunk *gauntlet_gen(struct player *p, int min_height, int min_width) {
 /**
  * Generate an arena level - an open single combat arena.
  *
- * \param p is the player
+ * \param g is the generation context
  * \return a pointer to the generated chunk
  */
-struct chunk *arena_gen(struct player *p, int min_height, int min_width) {
+struct chunk *arena_gen(struct gen_context *g, int min_height, int min_width) {
+	struct player *p = g->p;
 	struct chunk *c;
-	struct monster *mon = player->upkeep->health_who;
+	struct monster *mon = p->upkeep->health_who;
 
-	c = cave_new(min_height, min_width);
+	c = gen_cave_new(g, min_height, min_width);
 	c->depth = p->depth;
 	c->name = string_make("arena");
 
@@ -2617,7 +2662,7 @@ struct chunk *arena_gen(struct player *p, int min_height, int min_width) {
 	c->mon_max = mon->midx + 1;
 	c->mon_cnt = 1;
 	update_mon(mon, c, true);
-	player->upkeep->health_who = mon;
+	p->upkeep->health_who = mon;
 
 	/* Ignore its held objects */
 	mon->held_obj = NULL;
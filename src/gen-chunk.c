@@ -19,6 +19,11 @@
  * at any time.  The intitial example of this is the town, which is saved 
  * immediately after generation and restored when the player returns there.
  *
+ * Stored levels are packed, in the form they take in the savefile, as soon
+ * as the player has left them, and only unpacked when they are needed again.
+ * Packed levels are kept in memory up to a limit; beyond that, the ones
+ * visited longest ago are moved out to a spill file in the user directory.
+ *
  * The copying routines are also useful for generating a level in pieces and
  * then copying those pieces into the actual level chunk.
  */
@@ -29,12 +34,49 @@
 #include "generate.h"
 #include "init.h"
 #include "mon-make.h"
+#include "obj-pile.h"
 #include "obj-util.h"
+#include "savefile.h"
 #include "trap.h"
+#include "z-names.h"
 
 #define CHUNK_LIST_INCR 10
-struct chunk **chunk_list;     /**< list of pointers to saved chunks */
-u16b chunk_list_max = 0;      /**< current max actual chunk index */
+#define CHUNK_LIST_MEMORY (16 * 1024 * 1024)
+
+/**
+ * A stored level, and what is needed to know about it without unpacking it
+ */
+struct chunk_entry {
+	char *name;
+	int depth;
+	struct connector *join;		/**< Copy of the level's stairs */
+	struct chunk *chunk;		/**< The level, if it is unpacked */
+	byte *packed;				/**< The packed level, if it is in memory */
+	u32b size;					/**< Size of the packed level */
+	long offset;				/**< Where it is in the spill file, or -1 */
+	u32b visited;				/**< When the player was last there */
+};
+
+static struct chunk_entry **chunk_list;	/**< list of saved chunks */
+u16b chunk_list_max = 0;			/**< current max actual chunk index */
+static struct name_map *chunk_names;	/**< chunk_list indices by name */
+static u32b chunk_visits;			/**< clock for chunk_entry.visited */
+
+/**
+ * Bytes of packed levels kept in memory before spilling to file
+ */
+size_t chunk_list_memory = CHUNK_LIST_MEMORY;
+static size_t chunk_list_in_memory;
+
+/**
+ * The spill file; levels are only ever appended to it, so it is rewritten
+ * when most of it is levels which have been unpacked
+ */
+static char spill_path[1024];
+static long spill_size;
+static long spill_live;
+static byte *spill_buffer;
+static u32b spill_buffer_size;
 
 /**
  * Write the terrain info of a chunk to memory and return a pointer to it
@@ -48,79 +90,385 @@ struct chunk *chunk_write(struct chunk *c)
 
 	struct chunk *new = cave_new(c->height, c->width);
 
+	/* Keep the feature counts */
+	memcpy(new->feat_count, c->feat_count,
+		   (z_info->f_max + 1) * sizeof(int));
+
 	/* Write the location stuff */
 	for (y = 0; y < new->height; y++) {
 		for (x = 0; x < new->width; x++) {
 			/* Terrain */
-			new->squares[y][x].feat = square(c, loc(x, y)).feat;
-			sqinfo_copy(square(new, loc(x, y)).info, square(c, loc(x, y)).info);
+			cave_floor_update(new, square_idx(new, loc(x, y)), FEAT_NONE,
+							  square_fidx(c, loc(x, y)));
+			new->squares.feat[square_idx(new, loc(x, y))] =
+				square_fidx(c, loc(x, y));
+			sqinfo_copy(square_info(new, loc(x, y)), square_info(c, loc(x, y)));
 		}
 	}
 
 	return new;
 }
 
+/**
+ * Free a level which has been packed.  Its monsters stay counted in their
+ * races, as they still exist; chunk_unpack() allows for that.
+ */
+static void chunk_free_packed(struct chunk *c)
+{
+	int i;
+
+	/* Objects which aren't in a floor pile are freed by hand */
+	for (i = 1; i < c->obj_max; i++) {
+		struct object *obj = c->objects[i];
+		if (!obj) continue;
+		if (obj->held_m_idx || !square_in_bounds_fully(c, obj->grid))
+			object_free(obj);
+	}
+
+	cave_free(c);
+}
+
+/**
+ * Return the buffer for reading from the spill file, with room for 'size'
+ * bytes
+ */
+static byte *spill_buffer_get(u32b size)
+{
+	if (spill_buffer_size < size) {
+		spill_buffer = mem_realloc(spill_buffer, size);
+		spill_buffer_size = size;
+	}
+	return spill_buffer;
+}
+
+/**
+ * Read a spilled level into the spill buffer
+ */
+static byte *spill_read(const char *path, const struct chunk_entry *e)
+{
+	byte *data = spill_buffer_get(e->size);
+	ang_file *f = file_open(path, MODE_READ, FTYPE_RAW);
+
+	if (!f || !file_skip(f, e->offset) ||
+		file_read(f, (char *)data, e->size) != (int)e->size)
+		quit_fmt("Couldn't read level %s from %s", e->name, path);
+	file_close(f);
+
+	return data;
+}
+
+/**
+ * Forget the spill file
+ */
+static void spill_delete(void)
+{
+	if (spill_path[0]) file_delete(spill_path);
+	spill_path[0] = '\0';
+	spill_size = 0;
+	spill_live = 0;
+}
+
+/**
+ * Copy the spilled levels still stored to a new spill file
+ */
+static void spill_compact(void)
+{
+	char path[1024];
+	ang_file *f;
+	int i;
+
+	path_build(path, sizeof(path), ANGBAND_DIR_USER,
+			   format("levels%u.new", Rand_simple(1000000)));
+	f = file_open(path, MODE_WRITE, FTYPE_RAW);
+	if (!f) return;
+
+	spill_size = 0;
+	for (i = 0; i < chunk_list_max; i++) {
+		struct chunk_entry *e = chunk_list[i];
+
+		if (e->offset < 0) continue;
+		file_write(f, (char *)spill_read(spill_path, e), e->size);
+		e->offset = spill_size;
+		spill_size += e->size;
+	}
+	file_close(f);
+
+	file_delete(spill_path);
+	file_move(path, spill_path);
+}
+
+/**
+ * Move a packed level from memory to the end of the spill file; if that
+ * can't be done it just stays in memory
+ */
+static bool spill_write(struct chunk_entry *e)
+{
+	ang_file *f;
+
+	if (!spill_path[0]) {
+		int count = 0;
+
+		do {
+			path_build(spill_path, sizeof(spill_path), ANGBAND_DIR_USER,
+					   format("levels%u.tmp", Rand_simple(1000000)));
+		} while (file_exists(spill_path) && (count++ < 100));
+	}
+
+	f = file_open(spill_path, MODE_APPEND, FTYPE_RAW);
+	if (!f) return false;
+	if (!file_write(f, (char *)e->packed, e->size)) {
+		file_close(f);
+		return false;
+	}
+	file_close(f);
+
+	e->offset = spill_size;
+	spill_size += e->size;
+	spill_live += e->size;
+	chunk_list_in_memory -= e->size;
+	mem_free(e->packed);
+	e->packed = NULL;
+	return true;
+}
+
+/**
+ * Pack a level
+ */
+static void chunk_pack(struct chunk_entry *e)
+{
+	savefile_pack_begin();
+	wr_chunk(e->chunk);
+	e->packed = savefile_pack_end(&e->size);
+	chunk_list_in_memory += e->size;
+}
+
+/**
+ * Unpack a level
+ */
+static struct chunk *chunk_unpack(struct chunk_entry *e)
+{
+	byte *data = e->packed ? e->packed : spill_read(spill_path, e);
+	struct chunk *c;
+	int i;
+
+	savefile_unpack_begin(data, e->size);
+	if (rd_packed_chunk(&c))
+		quit_fmt("Couldn't unpack level %s", e->name);
+	savefile_unpack_end();
+
+	/* Placing the monsters counted them again */
+	for (i = 1; i < cave_monster_max(c); i++) {
+		struct monster *mon = cave_monster(c, i);
+		if (mon->race) mon->race->cur_num--;
+	}
+
+	return c;
+}
+
+/**
+ * Free a chunk list entry, and the level if 'level' is true
+ */
+static void chunk_entry_free(struct chunk_entry *e, bool level)
+{
+	while (e->join) {
+		struct connector *next = e->join->next;
+		mem_free(e->join->info);
+		mem_free(e->join);
+		e->join = next;
+	}
+
+	if (e->packed) chunk_list_in_memory -= e->size;
+	if (e->offset >= 0) spill_live -= e->size;
+	if (level && e->chunk) cave_free(e->chunk);
+
+	mem_free(e->packed);
+	string_free(e->name);
+	mem_free(e);
+}
+
 /**
  * Add an entry to the chunk list - any problems with the length of this will
- * be more in the memory used by the chunks themselves rather than the list
+ * be more in the memory used by the chunks themselves rather than the list.
+ * The chunk belongs to the list until chunk_list_remove(), and is packed by
+ * the next chunk_list_pack().
  * \param c the chunk being added to the list
  */
 void chunk_list_add(struct chunk *c)
 {
-	int newsize = (chunk_list_max + CHUNK_LIST_INCR) *	sizeof(struct chunk *);
+	int newsize = (chunk_list_max + CHUNK_LIST_INCR) *	sizeof(*chunk_list);
+	struct chunk_entry *e = mem_zalloc(sizeof(*e));
+	struct connector *join;
 
 	/* Lengthen the list if necessary */
 	if (chunk_list_max == 0)
 		chunk_list = mem_zalloc(newsize);
 	else if ((chunk_list_max % CHUNK_LIST_INCR) == 0)
-		chunk_list = (struct chunk **) mem_realloc(chunk_list, newsize);
+		chunk_list = mem_realloc(chunk_list, newsize);
+
+	if (!chunk_names)
+		chunk_names = name_map_new(0);
+
+	e->name = string_make(c->name);
+	e->depth = c->depth;
+	e->chunk = c;
+	e->offset = -1;
+	e->visited = ++chunk_visits;
+
+	/* Keep the stairs, for joining up the levels next to this one */
+	for (join = c->join; join; join = join->next) {
+		struct connector *copy = mem_zalloc(sizeof(*copy));
+		copy->grid = join->grid;
+		copy->feat = join->feat;
+		copy->info = mem_zalloc(SQUARE_SIZE * sizeof(bitflag));
+		sqinfo_copy(copy->info, join->info);
+		copy->next = e->join;
+		e->join = copy;
+	}
 
 	/* Add the new one */
-	chunk_list[chunk_list_max++] = c;
+	name_map_set(chunk_names, e->name, chunk_list_max);
+	chunk_list[chunk_list_max++] = e;
 }
 
 /**
- * Remove an entry from the chunk list, return whether it was found
- * \param name the name of the chunk being removed from the list
- * \return whether it was found; success means it was successfully removed
+ * Pack every unpacked level in the chunk list, then move the levels
+ * visited longest ago to the spill file until the rest fit in memory
  */
-bool chunk_list_remove(char *name)
+void chunk_list_pack(void)
 {
 	int i;
 
-	/* Find the match */
 	for (i = 0; i < chunk_list_max; i++) {
-		if (!strcmp(name, chunk_list[i]->name)) {
-			/* Copy all the succeeding chunks back one */
-			int j;
-			for (j = i + 1; j < chunk_list_max; j++) {
-				chunk_list[j - 1] = chunk_list[j];
-			}
+		struct chunk_entry *e = chunk_list[i];
 
-			/* Shorten the list and return */
-			chunk_list_max--;
-			chunk_list[chunk_list_max] = NULL;
-			return true;
+		if (!e->chunk) continue;
+		if (!e->packed && (e->offset < 0))
+			chunk_pack(e);
+		chunk_free_packed(e->chunk);
+		e->chunk = NULL;
+	}
+
+	while (chunk_list_in_memory > chunk_list_memory) {
+		struct chunk_entry *oldest = NULL;
+
+		for (i = 0; i < chunk_list_max; i++) {
+			struct chunk_entry *e = chunk_list[i];
+			if (e->packed && (!oldest || (e->visited < oldest->visited)))
+				oldest = e;
 		}
+		if (!oldest || !spill_write(oldest)) break;
 	}
+}
 
-	return false;
+/**
+ * Remove an entry from the chunk list, return whether it was found.  The
+ * chunk itself, found with chunk_find_name(), belongs to the caller.
+ * \param name the name of the chunk being removed from the list
+ * \return whether it was found; success means it was successfully removed
+ */
+bool chunk_list_remove(const char *name)
+{
+	int i = chunk_names ? name_map_find(chunk_names, name) : -1;
+
+	if (i < 0) return false;
+
+	chunk_entry_free(chunk_list[i], false);
+	name_map_remove(chunk_names, name);
+
+	/* Move the last chunk into the gap */
+	chunk_list_max--;
+	if (i < chunk_list_max) {
+		chunk_list[i] = chunk_list[chunk_list_max];
+		name_map_set(chunk_names, chunk_list[i]->name, i);
+	}
+	chunk_list[chunk_list_max] = NULL;
+
+	/* Keep the spill file mostly in use */
+	if (!spill_live)
+		spill_delete();
+	else if (spill_size > 2 * spill_live + CHUNK_LIST_MEMORY)
+		spill_compact();
+
+	return true;
 }
 
 /**
- * Find a chunk by name
- * \param name the name of the chunk being sought
- * \return the pointer to the chunk
+ * Free the whole chunk list
  */
-struct chunk *chunk_find_name(char *name)
+void chunk_list_free(void)
 {
 	int i;
 
 	for (i = 0; i < chunk_list_max; i++)
-		if (!strcmp(name, chunk_list[i]->name))
-			return chunk_list[i];
+		chunk_entry_free(chunk_list[i], true);
+	mem_free(chunk_list);
+	chunk_list = NULL;
+	chunk_list_max = 0;
+	name_map_free(chunk_names);
+	chunk_names = NULL;
+	chunk_list_in_memory = 0;
+
+	spill_delete();
+	mem_free(spill_buffer);
+	spill_buffer = NULL;
+	spill_buffer_size = 0;
+}
+
+/**
+ * Return the packed form of the level at 'index' in the chunk list, as
+ * written by wr_chunk(), and its size; a spilled level is read into a
+ * buffer which is reused by the next call
+ */
+const byte *chunk_list_packed(int index, u32b *size)
+{
+	struct chunk_entry *e = chunk_list[index];
+
+	if (!e->packed && (e->offset < 0))
+		chunk_pack(e);
 
-	return NULL;
+	*size = e->size;
+	return e->packed ? e->packed : spill_read(spill_path, e);
+}
+
+/**
+ * Find whether a chunk is stored
+ * \param name the name of the chunk being sought
+ */
+bool chunk_is_stored(const char *name)
+{
+	return chunk_names && (name_map_find(chunk_names, name) >= 0);
+}
+
+/**
+ * Find a chunk by name, unpacking it if necessary
+ * \param name the name of the chunk being sought
+ * \return the pointer to the chunk
+ */
+struct chunk *chunk_find_name(const char *name)
+{
+	int i = chunk_names ? name_map_find(chunk_names, name) : -1;
+	struct chunk_entry *e;
+
+	if (i < 0) return NULL;
+
+	e = chunk_list[i];
+	if (!e->chunk)
+		e->chunk = chunk_unpack(e);
+	e->visited = ++chunk_visits;
+
+	return e->chunk;
+}
+
+/**
+ * Find the stairs of a stored chunk, without unpacking it
+ * \param name the name of the chunk being sought
+ * \return the stairs, or NULL if there are none or no such chunk is stored
+ */
+struct connector *chunk_find_join(const char *name)
+{
+	int i = chunk_names ? name_map_find(chunk_names, name) : -1;
+
+	return (i < 0) ? NULL : chunk_list[i]->join;
 }
 
 /**
@@ -133,24 +481,33 @@ bool chunk_find(struct chunk *c)
 	int i;
 
 	for (i = 0; i < chunk_list_max; i++)
-		if (c == chunk_list[i]) return true;
+		if (c == chunk_list[i]->chunk) return true;
+
+	return false;
+}
+
+/**
+ * Find whether a chunk is stored at the given depth
+ */
+bool chunk_find_depth(int depth)
+{
+	int i;
+
+	for (i = 0; i < chunk_list_max; i++)
+		if (chunk_list[i]->depth == depth) return true;
 
 	return false;
 }
 
 /**
- * Find the saved chunk above or below the current player depth
+ * Find whether there is a saved chunk above or below the current player depth
  */
-struct chunk *chunk_find_adjacent(struct player *p, bool above)
+bool chunk_find_adjacent(struct player *p, bool above)
 {
 	int depth = above ? p->depth - 1 : p->depth + 1;
 	struct level *lev = level_by_depth(depth);
 
-	if (lev) {
-		return chunk_find_name(lev->name);
-	}
-
-	return NULL;
+	return lev && chunk_is_stored(lev->name);
 }
 
 /**
@@ -219,27 +576,31 @@ bool chunk_copy(struct chunk *dest, struct chunk *source, int y0, int x0,
 			/* Work out where we're going */
 			int dest_y = y;
 			int dest_x = x;
+			int dest_idx, source_idx = square_idx(source, loc(x, y));
 			symmetry_transform(&dest_y, &dest_x, y0, x0, h, w, rotate, reflect);
+			dest_idx = square_idx(dest, loc(dest_x, dest_y));
 
 			/* Terrain */
-			dest->squares[dest_y][dest_x].feat = square(source, loc(x, y)).feat;
-			sqinfo_copy(square(dest, loc(dest_x, dest_y)).info,
-						square(source, loc(x, y)).info);
+			cave_floor_update(dest, dest_idx, dest->squares.feat[dest_idx],
+							  source->squares.feat[source_idx]);
+			dest->squares.feat[dest_idx] = source->squares.feat[source_idx];
+			sqinfo_copy(square_info(dest, loc(dest_x, dest_y)),
+						square_info(source, loc(x, y)));
 
 			/* Dungeon objects */
 			if (square_object(source, loc(x, y))) {
 				struct object *obj;
-				dest->squares[dest_y][dest_x].obj = square_object(source, loc(x, y));
+				dest->squares.obj[dest_idx] = square_object(source, loc(x, y));
 
 				for (obj = square_object(source, loc(x, y)); obj; obj = obj->next) {
 					/* Adjust position */
 					obj->grid = loc(dest_x, dest_y);
 				}
-				source->squares[y][x].obj = NULL;
+				source->squares.obj[source_idx] = NULL;
 			}
 
 			/* Monsters */
-			if (square(source, loc(x, y)).mon > 0) {
+			if (square_midx(source, loc(x, y)) > 0) {
 				struct monster *source_mon = square_monster(source, loc(x, y));
 				struct monster *dest_mon = NULL;
 				int idx;
@@ -257,7 +618,7 @@ bool chunk_copy(struct chunk *dest, struct chunk *source, int y0, int x0,
 
 				/* Copy over */
 				dest_mon = cave_monster(dest, idx);
-				dest->squares[dest_y][dest_x].mon = idx;
+				square_set_mon(dest, loc(dest_x, dest_y), idx);
 				memcpy(dest_mon, source_mon, sizeof(*source_mon));
 
 				/* Adjust stuff */
@@ -270,9 +631,9 @@ bool chunk_copy(struct chunk *dest, struct chunk *source, int y0, int x0,
 			}
 
 			/* Traps */
-			if (square(source, loc(x, y)).trap) {
-				struct trap *trap = square(source, loc(x, y)).trap;
-				dest->squares[dest_y][dest_x].trap = trap;
+			if (square_trap(source, loc(x, y))) {
+				struct trap *trap = square_trap(source, loc(x, y));
+				dest->squares.trap[dest_idx] = trap;
 
 				/* Traverse the trap list */
 				while (trap) {
@@ -280,12 +641,12 @@ bool chunk_copy(struct chunk *dest, struct chunk *source, int y0, int x0,
 					trap->grid = loc(dest_x, dest_y);
 					trap = trap->next;
 				}
-				source->squares[y][x].trap = NULL;
+				source->squares.trap[source_idx] = NULL;
 			}
 
 			/* Player */
-			if (square(source, loc(x, y)).mon == -1) 
-				dest->squares[dest_y][dest_x].mon = -1;
+			if (square_midx(source, loc(x, y)) == -1) 
+				dest->squares.mon[dest_idx] = -1;
 		}
 	}
 
@@ -336,7 +697,7 @@ void chunk_validate_objects(struct chunk *c) {
 			struct loc grid = loc(x, y);
 			for (obj = square_object(c, grid); obj; obj = obj->next)
 				assert(obj->tval != 0);
-			if (square(c, grid).mon > 0) {
+			if (square_midx(c, grid) > 0) {
 				struct monster *mon = square_monster(c, grid);
 				if (mon->held_obj)
 					for (obj = mon->held_obj; obj; obj = obj->next)
@@ -33,10 +33,12 @@
 #include "mon-spell.h"
 
 /**
- * Restrictions on monsters, used in pits, vaults, and chambers.
+ * Restrictions on monsters, used in pits, vaults, and chambers; each thread
+ * generating a level has its own.
  */
-static bool allow_unique;
-static char base_d_char[15];
+static THREAD_LOCAL bool allow_unique;
+static THREAD_LOCAL char base_d_char[15];
+static THREAD_LOCAL int select_depth;
 
 
 /**
@@ -76,7 +78,7 @@ static bool mon_select(struct monster_race *race)
     }
 
 	/* No invisible undead until deep. */
-	if ((player->depth < 40) && (rf_has(race->flags, RF_UNDEAD))
+	if ((select_depth < 40) && (rf_has(race->flags, RF_UNDEAD))
 		&& (rf_has(race->flags, RF_INVISIBLE)))
 		return (false);
 
@@ -97,6 +99,7 @@ static bool mon_select(struct monster_race *race)
  * an (adjusted) depth, and use these to set values for required
  * monster base symbol.
  *
+ * \param c the chunk being generated
  * \param monster_type the monster type to be selected, as described below
  * \param depth the native depth to choose monsters
  * \param unique_ok whether to allow uniques to be chosen
@@ -112,12 +115,14 @@ static bool mon_select(struct monster_race *race)
  * If called with monster_type "random", it will get a random monster base and 
  * describe the monsters by its name (for use by cheat_room).
  */
-bool mon_restrict(const char *monster_type, int depth, bool unique_ok)
+bool mon_restrict(struct chunk *c, const char *monster_type, int depth,
+				  bool unique_ok)
 {
     int i, j = 0;
 
     /* Clear global monster restriction variables. */
     allow_unique = unique_ok;
+	select_depth = gen_player(c)->depth;
     for (i = 0; i < 10; i++)
 		base_d_char[i] = '\0';
 
@@ -139,8 +144,8 @@ bool mon_restrict(const char *monster_type, int depth, bool unique_ok)
 			if (i < 200) {
 				if ((!rf_has(r_info[j].flags, RF_UNIQUE))
 					&& (r_info[j].level != 0) && (r_info[j].level <= depth)
-					&& (ABS(r_info[j].level - player->depth) <
-						1 + (player->depth / 4)))
+					&& (ABS(r_info[j].level - select_depth) <
+						1 + (select_depth / 4)))
 					break;
 			} else {
 				if ((!rf_has(r_info[j].flags, RF_UNIQUE))
@@ -167,12 +172,12 @@ bool mon_restrict(const char *monster_type, int depth, bool unique_ok)
 
 		/* Accept the profile or leave area empty if none found */
 		if (profile)
-			dun->pit_type = profile;
+			c->gen->dun->pit_type = profile;
 		else
 			return false;
 
 		/* Prepare allocation table */
-		get_mon_num_prep(mon_pit_hook);
+		pit_mon_num_prep(profile);
 		return true;
 	}
 }
@@ -205,11 +210,11 @@ void spread_monsters(struct chunk *c, const char *type, int depth, int num,
     int start_mon_num = c->mon_max;
 
     /* Restrict monsters.  Allow uniques. Leave area empty if none found. */
-    if (!mon_restrict(type, depth, true))
+    if (!mon_restrict(c, type, depth, true))
 		return;
 
     /* Build the monster probability table. */
-    if (!get_mon_num(depth))
+    if (!get_mon_num(c, depth))
 		return;
 
 
@@ -220,7 +225,7 @@ void spread_monsters(struct chunk *c, const char *type, int depth, int num,
 			y = y0;
 			x = x0;
 			if (!square_in_bounds(c, loc(x, y))) {
-				(void) mon_restrict(NULL, depth, true);
+				(void) mon_restrict(c, NULL, depth, true);
 				return;
 			}
 		} else {
@@ -231,7 +236,7 @@ void spread_monsters(struct chunk *c, const char *type, int depth, int num,
 					if (j < 9) {
 						continue;
 					} else {
-						(void) mon_restrict(NULL, depth, true);
+						(void) mon_restrict(c, NULL, depth, true);
 						return;
 					}
 				}
@@ -255,7 +260,7 @@ void spread_monsters(struct chunk *c, const char *type, int depth, int num,
     }
 
     /* Remove monster restrictions. */
-    (void) mon_restrict(NULL, depth, true);
+    (void) mon_restrict(c, NULL, depth, true);
 }
 
 
@@ -281,24 +286,25 @@ void get_vault_monsters(struct chunk *c, char racial_symbol[], char *vault_type,
     for (i = 0; racial_symbol[i] != '\0'; i++) {
 		/* Require correct race, allow uniques. */
 		allow_unique = true;
+		select_depth = gen_player(c)->depth;
 		my_strcpy(base_d_char, format("%c", racial_symbol[i]),
 				  sizeof(base_d_char));
 
 		/* Determine level of monster */
 		if (strstr(vault_type, "Lesser vault"))
-			depth = player->depth + 2;
+			depth = select_depth + 2;
 		else if (strstr(vault_type, "Medium vault"))
-			depth = player->depth + 4;
+			depth = select_depth + 4;
 		else if (strstr(vault_type, "Greater vault"))
-			depth = player->depth + 6;
+			depth = select_depth + 6;
 		else
-			depth = player->depth;
+			depth = select_depth;
 
 		/* Prepare allocation table */
 		get_mon_num_prep(mon_select);
 
 		/* Build the monster probability table. */
-		if (!get_mon_num(depth))
+		if (!get_mon_num(c, depth))
 			continue;
 
 
@@ -343,11 +349,11 @@ void get_chamber_monsters(struct chunk *c, int y1, int x1, int y2, int x2,
 	if (!random) {
 		while (true) {
 			/* Choose a pit profile */
-			set_pit_type(depth, 0);
+			set_pit_type(c, depth, 0);
 
 			/* Check if the pit was set correctly
 			   Done currently by checking if a name was saved */
-			if (dun->pit_type->name)
+			if (c->gen->dun->pit_type->name)
 				break;
 		}
 	}
@@ -357,18 +363,18 @@ void get_chamber_monsters(struct chunk *c, int y1, int x1, int y2, int x2,
 
 	/* Set monster generation restrictions. Occasionally random. */
 	if (random) {
-		if (!mon_restrict("random", depth, true))
+		if (!mon_restrict(c, "random", depth, true))
 			return;
 		my_strcpy(name, "random", sizeof(name));
 	} else {
-		if (!mon_restrict(dun->pit_type->name, depth, true))
+		if (!mon_restrict(c, c->gen->dun->pit_type->name, depth, true))
 			return;
-		my_strcpy(name, dun->pit_type->name, sizeof(name));
+		my_strcpy(name, c->gen->dun->pit_type->name, sizeof(name));
 	}
 
 	/* Build the monster probability table. */
-	if (!get_mon_num(depth)) {
-		(void) mon_restrict(NULL, depth, false);
+	if (!get_mon_num(c, depth)) {
+		(void) mon_restrict(c, NULL, depth, false);
 		name = NULL;
 		return;
 	}
@@ -402,6 +408,6 @@ void get_chamber_monsters(struct chunk *c, int y1, int x1, int y2, int x2,
 	}
 
 	/* Remove our restrictions. */
-	(void) mon_restrict(NULL, depth, false);
+	(void) mon_restrict(c, NULL, depth, false);
 }
 
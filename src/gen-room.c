@@ -110,9 +110,9 @@ static void generate_room(struct chunk *c, int y1, int x1, int y2, int x2,
 	struct loc grid;
 	for (grid.y = y1; grid.y <= y2; grid.y++)
 		for (grid.x = x1; grid.x <= x2; grid.x++) {
-			sqinfo_on(square(c, grid).info, SQUARE_ROOM);
+			sqinfo_on(square_info(c, grid), SQUARE_ROOM);
 			if (light)
-				sqinfo_on(square(c, grid).info, SQUARE_GLOW);
+				sqinfo_on(square_info(c, grid), SQUARE_GLOW);
 		}
 }
 
@@ -130,7 +130,7 @@ void generate_mark(struct chunk *c, int y1, int x1, int y2, int x2, int flag)
 	struct loc grid;
 	for (grid.y = y1; grid.y <= y2; grid.y++) {
 		for (grid.x = x1; grid.x <= x2; grid.x++) {
-			sqinfo_on(square(c, grid).info, flag);
+			sqinfo_on(square_info(c, grid), flag);
 		}
 	}
 }
@@ -205,10 +205,10 @@ static void fill_xrange(struct chunk *c, int y, int x1, int x2, int feat,
 	for (x = x1; x <= x2; x++) {
 		struct loc grid = loc(x, y);
 		square_set_feat(c, grid, feat);
-		sqinfo_on(square(c, grid).info, SQUARE_ROOM);
-		if (flag) sqinfo_on(square(c, grid).info, flag);
+		sqinfo_on(square_info(c, grid), SQUARE_ROOM);
+		if (flag) sqinfo_on(square_info(c, grid), flag);
 		if (light)
-			sqinfo_on(square(c, grid).info, SQUARE_GLOW);
+			sqinfo_on(square_info(c, grid), SQUARE_GLOW);
 	}
 }
 
@@ -229,10 +229,10 @@ static void fill_yrange(struct chunk *c, int x, int y1, int y2, int feat,
 	for (y = y1; y <= y2; y++) {
 		struct loc grid = loc(x, y);
 		square_set_feat(c, grid, feat);
-		sqinfo_on(square(c, grid).info, SQUARE_ROOM);
-		if (flag) sqinfo_on(square(c, grid).info, flag);
+		sqinfo_on(square_info(c, grid), SQUARE_ROOM);
+		if (flag) sqinfo_on(square_info(c, grid), flag);
 		if (light)
-			sqinfo_on(square(c, grid).info, SQUARE_GLOW);
+			sqinfo_on(square_info(c, grid), SQUARE_GLOW);
 	}
 }
 
@@ -660,15 +660,15 @@ extern bool generate_starburst_room(struct chunk *c, int y1, int x1, int y2,
 							square_set_feat(c, grid, feat);
 
 							if (feat_is_floor(feat)) {
-								sqinfo_on(square(c, grid).info, SQUARE_ROOM);
+								sqinfo_on(square_info(c, grid), SQUARE_ROOM);
 							} else {
-								sqinfo_off(square(c, grid).info, SQUARE_ROOM);
+								sqinfo_off(square_info(c, grid), SQUARE_ROOM);
 							}
 
 							if (light) {
-								sqinfo_on(square(c, grid).info, SQUARE_GLOW);
+								sqinfo_on(square_info(c, grid), SQUARE_GLOW);
 							} else if (!square_isbright(c, grid)) {
-								sqinfo_off(square(c, grid).info, SQUARE_GLOW);
+								sqinfo_off(square_info(c, grid), SQUARE_GLOW);
 							}
 						}
 
@@ -688,7 +688,7 @@ extern bool generate_starburst_room(struct chunk *c, int y1, int x1, int y2,
 
 							/* Light grid. */
 							if (light)
-								sqinfo_on(square(c, grid).info, SQUARE_GLOW);
+								sqinfo_on(square_info(c, grid), SQUARE_GLOW);
 						}
 					}
 
@@ -716,15 +716,15 @@ extern bool generate_starburst_room(struct chunk *c, int y1, int x1, int y2,
 						struct loc grid1 = loc_sum(grid, ddgrid_ddd[d]);
 
 						/* Join to room, forbid stairs */
-						sqinfo_on(square(c, grid1).info, SQUARE_ROOM);
-						sqinfo_on(square(c, grid1).info, SQUARE_NO_STAIRS);
+						sqinfo_on(square_info(c, grid1), SQUARE_ROOM);
+						sqinfo_on(square_info(c, grid1), SQUARE_NO_STAIRS);
 
 						/* Illuminate if requested. */
 						if (light)
-							sqinfo_on(square(c, grid1).info, SQUARE_GLOW);
+							sqinfo_on(square_info(c, grid1), SQUARE_GLOW);
 
 						/* Look for dungeon granite. */
-						if (square(c, grid1).feat == FEAT_GRANITE) {
+						if (square_fidx(c, grid1) == FEAT_GRANITE) {
 							/* Mark as outer wall. */
 							set_marked_granite(c, grid1, SQUARE_WALL_OUTER);
 						}
@@ -738,58 +738,63 @@ extern bool generate_starburst_room(struct chunk *c, int y1, int x1, int y2,
 	return (true);
 }
 
+/**
+ * The pit profile mon_pit_hook() tests against, for this thread
+ */
+static THREAD_LOCAL const struct pit_profile *pit_hook_type;
+
 /**
  * Hook for picking monsters appropriate to a nest/pit or region.
  * \param race the race being tested for inclusion
  * \return the race is acceptable
- * Requires dun->pit_type to be set.
+ * Requires pit_hook_type to be set.
  */
-bool mon_pit_hook(struct monster_race *race)
+static bool mon_pit_hook(struct monster_race *race)
 {
 	bool match_base = true;
 	bool match_color = true;
-	int innate_freq = dun->pit_type->freq_innate;
+	int innate_freq = pit_hook_type->freq_innate;
 
 	assert(race);
-	assert(dun->pit_type);
+	assert(pit_hook_type);
 
 	if (rf_has(race->flags, RF_UNIQUE)) {
 		return false;
-	} else if (!rf_is_subset(race->flags, dun->pit_type->flags)) {
+	} else if (!rf_is_subset(race->flags, pit_hook_type->flags)) {
 		return false;
-	} else if (rf_is_inter(race->flags, dun->pit_type->forbidden_flags)) {
+	} else if (rf_is_inter(race->flags, pit_hook_type->forbidden_flags)) {
 		return false;
-	} else if (!rsf_is_subset(race->spell_flags, dun->pit_type->spell_flags)) {
+	} else if (!rsf_is_subset(race->spell_flags, pit_hook_type->spell_flags)) {
 		return false;
 	} else if (rsf_is_inter(race->spell_flags,
-							dun->pit_type->forbidden_spell_flags)) {
+							pit_hook_type->forbidden_spell_flags)) {
 		return false;
 	} else if (race->freq_innate < innate_freq) {
 		return false;
-	} else if (dun->pit_type->forbidden_monsters) {
+	} else if (pit_hook_type->forbidden_monsters) {
 		struct pit_forbidden_monster *monster;
-		for (monster = dun->pit_type->forbidden_monsters; monster;
+		for (monster = pit_hook_type->forbidden_monsters; monster;
 			 monster = monster->next) {
 			if (race == monster->race)
 				return false;
 		}
 	}
 
-	if (dun->pit_type->bases) {
+	if (pit_hook_type->bases) {
 		struct pit_monster_profile *bases;
 		match_base = false;
 
-		for (bases = dun->pit_type->bases; bases; bases = bases->next) {
+		for (bases = pit_hook_type->bases; bases; bases = bases->next) {
 			if (race->base == bases->base)
 				match_base = true;
 		}
 	}
 	
-	if (dun->pit_type->colors) {
+	if (pit_hook_type->colors) {
 		struct pit_color_profile *colors;
 		match_color = false;
 
-		for (colors = dun->pit_type->colors; colors; colors = colors->next) {
+		for (colors = pit_hook_type->colors; colors; colors = colors->next) {
 			if (race->d_attr == colors->color)
 				match_color = true;
 		}
@@ -798,6 +803,16 @@ bool mon_pit_hook(struct monster_race *race)
 	return (match_base && match_color);
 }
 
+/**
+ * Restrict monster generation to those appropriate to a nest/pit or region
+ * \param pit the pit profile to match
+ */
+void pit_mon_num_prep(const struct pit_profile *pit)
+{
+	pit_hook_type = pit;
+	get_mon_num_prep(mon_pit_hook);
+}
+
 /**
  * Pick a type of monster for pits (or other purposes), based on the level.
  * 
@@ -806,12 +821,14 @@ bool mon_pit_hook(struct monster_race *race)
  * standard deviation of 10. Then we pick the profile that gave us a depth that
  * is closest to the player's actual depth.
  *
- * Sets dun->pit_type, which is required for mon_pit_hook.
+ * Sets the generation's pit_type, which pit_mon_num_prep() takes.
+ * \param c is the chunk being generated
  * \param depth is the pit profile depth to aim for in selection
  * \param type is 1 for pits, 2 for nests, 0 for any profile
  */
-void set_pit_type(int depth, int type)
+void set_pit_type(struct chunk *c, int depth, int type)
 {
+	struct dun_data *dun = c->gen->dun;
 	int i;
 	int pit_idx = 0;
 
@@ -841,6 +858,7 @@ void set_pit_type(int depth, int type)
 /**
  * Find a good spot for the next room.
  *
+ * \param c the chunk the room is going in
  * \param y centre of the room
  * \param x centre of the room
  * \param height dimensions of the room
@@ -857,8 +875,10 @@ void set_pit_type(int depth, int type)
  * Return true and values for the center of the room if all went well.
  * Otherwise, return false.
  */
-static bool find_space(struct loc *centre, int height, int width)
+static bool find_space(struct chunk *c, struct loc *centre, int height,
+					   int width)
 {
+	struct dun_data *dun = c->gen->dun;
 	int i;
 	int by, bx, by1, bx1, by2, bx2;
 
@@ -869,7 +889,7 @@ static bool find_space(struct loc *centre, int height, int width)
 	int blocks_wide = 1 + ((width - 1) / dun->block_wid);
 
 	/* Deal with staircase "rooms" */
-	if (OPT(player, birth_levels_persist) && (height * width == 1)) {
+	if (OPT(c->gen->p, birth_levels_persist) && (height * width == 1)) {
 		struct connector *join = dun->join;
 		bool found = false;
 
@@ -991,7 +1011,7 @@ static bool build_room_template(struct chunk *c, struct loc centre, int ymax,
 
 	/* Find and reserve some space in the dungeon.  Get center of room. */
 	if ((centre.y >= c->height) || (centre.x >= c->width)) {
-		if (!find_space(&centre, ymax + 2, xmax + 2))
+		if (!find_space(c, &centre, ymax + 2, xmax + 2))
 			return (false);
 	}
 
@@ -1043,7 +1063,7 @@ static bool build_room_template(struct chunk *c, struct loc centre, int ymax,
 
 				/* Put something nice in this square
 				 * Object (80%) or Stairs (20%) */
-				if ((randint0(100) < 80) || OPT(player, birth_levels_persist))
+				if ((randint0(100) < 80) || OPT(c->gen->p, birth_levels_persist))
 					place_object(c, grid, c->depth, false, false,
 								 ORIGIN_SPECIAL, 0);
 				else
@@ -1103,9 +1123,9 @@ static bool build_room_template(struct chunk *c, struct loc centre, int ymax,
 			}
 
 			/* Part of a room */
-			sqinfo_on(square(c, grid).info, SQUARE_ROOM);
+			sqinfo_on(square_info(c, grid), SQUARE_ROOM);
 			if (light)
-				sqinfo_on(square(c, grid).info, SQUARE_GLOW);
+				sqinfo_on(square_info(c, grid), SQUARE_GLOW);
 		}
 	}
 
@@ -1132,7 +1152,7 @@ static bool build_room_template_type(struct chunk *c, struct loc centre,
 							 room->text, room->tval))
 		return false;
 
-	ROOM_LOG("Room template (%s)", room->name);
+	ROOM_LOG(c, "Room template (%s)", room->name);
 
 	return true;
 }
@@ -1157,7 +1177,7 @@ bool build_vault(struct chunk *c, struct loc centre, struct vault *v)
 
 	/* Find and reserve some space in the dungeon.  Get center of room. */
 	if ((centre.y >= c->height) || (centre.x >= c->width)) {
-		if (!find_space(&centre, v->hgt + 2, v->wid + 2))
+		if (!find_space(c, &centre, v->hgt + 2, v->wid + 2))
 			return (false);
 	}
 
@@ -1229,13 +1249,13 @@ bool build_vault(struct chunk *c, struct loc centre, struct vault *v)
 			}
 				/* Stairs */
 			case '<': {
-				if (OPT(player, birth_levels_persist)) break;
+				if (OPT(c->gen->p, birth_levels_persist)) break;
 				square_set_feat(c, grid, FEAT_LESS); break;
 			}
 			case '>': {
-				if (OPT(player, birth_levels_persist)) break;
+				if (OPT(c->gen->p, birth_levels_persist)) break;
 				/* No down stairs at bottom or on quests */
-				if (is_quest(c->depth) || c->depth >= z_info->max_depth - 1)
+				if (is_quest(c->gen->p, c->depth) || c->depth >= z_info->max_depth - 1)
 					square_set_feat(c, grid, FEAT_LESS);
 				else
 					square_set_feat(c, grid, FEAT_MORE);
@@ -1249,8 +1269,8 @@ bool build_vault(struct chunk *c, struct loc centre, struct vault *v)
 			}
 
 			/* Part of a vault */
-			sqinfo_on(square(c, grid).info, SQUARE_ROOM);
-			if (icky) sqinfo_on(square(c, grid).info, SQUARE_VAULT);
+			sqinfo_on(square_info(c, grid), SQUARE_ROOM);
+			if (icky) sqinfo_on(square_info(c, grid), SQUARE_VAULT);
 		}
 	}
 
@@ -1426,7 +1446,7 @@ static bool build_vault_type(struct chunk *c, struct loc centre,
 	if (!build_vault(c, centre, v))
 		return false;
 
-	ROOM_LOG("%s (%s)", typ, v->name);
+	ROOM_LOG(c, "%s (%s)", typ, v->name);
 
 	/* Boost the rating */
 	c->mon_rating += v->rat;
@@ -1443,8 +1463,8 @@ static bool build_vault_type(struct chunk *c, struct loc centre,
 static void make_inner_chamber_wall(struct chunk *c, int y, int x)
 {
 	struct loc grid = loc(x, y);
-	if ((square(c, grid).feat != FEAT_GRANITE) &&
-		(square(c, grid).feat != FEAT_MAGMA))
+	if ((square_fidx(c, grid) != FEAT_GRANITE) &&
+		(square_fidx(c, grid) != FEAT_MAGMA))
 		return;
 	if (square_iswall_outer(c, grid)) return;
 	if (square_iswall_solid(c, grid)) return;
@@ -1518,7 +1538,7 @@ static void make_chamber(struct chunk *c, int y1, int x1, int y2, int x2)
 			int xx = x + ddx_ddd[d];
 
 			/* No doors beside doors. */
-			if (square(c, loc(xx, yy)).feat == FEAT_OPEN)
+			if (square_fidx(c, loc(xx, yy)) == FEAT_OPEN)
 				break;
 
 			/* Count the inner walls. */
@@ -1557,14 +1577,14 @@ static void hollow_out_room(struct chunk *c, struct loc grid)
 		struct loc grid1 = loc_sum(grid, ddgrid_ddd[d]);
 
 		/* Change magma to floor. */
-		if (square(c, grid1).feat == FEAT_MAGMA) {
+		if (square_fidx(c, grid1) == FEAT_MAGMA) {
 			square_set_feat(c, grid1, FEAT_FLOOR);
 
 			/* Hollow out the room. */
 			hollow_out_room(c, grid1);
 		}
 		/* Change open door to broken door. */
-		else if (square(c, grid1).feat == FEAT_OPEN) {
+		else if (square_fidx(c, grid1) == FEAT_OPEN) {
 			square_set_feat(c, grid1, FEAT_BROKEN);
 
 			/* Hollow out the (new) room. */
@@ -1585,10 +1605,11 @@ static void hollow_out_room(struct chunk *c, struct loc grid)
  */
 bool build_staircase(struct chunk *c, struct loc centre, int rating)
 {
+	struct dun_data *dun = c->gen->dun;
 	struct connector *join = dun->join;
 
 	/* Find and reserve one grid in the dungeon */
-	if (!find_space(&centre, 1, 1))
+	if (!find_space(c, &centre, 1, 1))
 		return false;
 
 	/* Generate new room and outer walls */
@@ -1629,7 +1650,7 @@ bool build_circular(struct chunk *c, struct loc centre, int rating)
 
 	/* Find and reserve lots of space in the dungeon.  Get center of room. */
 	if ((centre.y >= c->height) || (centre.x >= c->width)) {
-		if (!find_space(&centre, 2 * radius + 10, 2 * radius + 10))
+		if (!find_space(c, &centre, 2 * radius + 10, 2 * radius + 10))
 			return (false);
 	}
 
@@ -1679,7 +1700,7 @@ bool build_simple(struct chunk *c, struct loc centre, int rating)
 
 	/* Find and reserve some space in the dungeon.  Get center of room. */
 	if ((centre.y >= c->height) || (centre.x >= c->width)) {
-		if (!find_space(&centre, height + 2, width + 2))
+		if (!find_space(c, &centre, height + 2, width + 2))
 			return (false);
 	}
 
@@ -1756,7 +1777,7 @@ bool build_overlap(struct chunk *c, struct loc centre, int rating)
 
 	/* Find and reserve some space in the dungeon.  Get center of room. */
 	if ((centre.y >= c->height) || (centre.x >= c->width)) {
-		if (!find_space(&centre, height + 2, width + 2))
+		if (!find_space(c, &centre, height + 2, width + 2))
 			return (false);
 	}
 
@@ -1850,7 +1871,7 @@ bool build_crossed(struct chunk *c, struct loc centre, int rating)
 
 	/* Find and reserve some space in the dungeon.  Get center of room. */
 	if ((centre.y >= c->height) || (centre.x >= c->width)) {
-		if (!find_space(&centre, height + 2, width + 2))
+		if (!find_space(c, &centre, height + 2, width + 2))
 			return (false);
 	}
 
@@ -1985,7 +2006,7 @@ bool build_large(struct chunk *c, struct loc centre, int rating)
 
 	/* Find and reserve some space in the dungeon.  Get center of room. */
 	if ((centre.y >= c->height) || (centre.x >= c->width)) {
-		if (!find_space(&centre, height + 2, width + 2))
+		if (!find_space(c, &centre, height + 2, width + 2))
 			return (false);
 	}
 
@@ -2051,7 +2072,7 @@ bool build_large(struct chunk *c, struct loc centre, int rating)
 		vault_monsters(c, centre, c->depth + 2, randint1(3) + 2);
 
 		/* Object (80%) or Stairs (20%) */
-		if ((randint0(100) < 80) || OPT(player, birth_levels_persist))
+		if ((randint0(100) < 80) || OPT(c->gen->p, birth_levels_persist))
 			place_object(c, centre, c->depth, false, false, ORIGIN_SPECIAL, 0);
 		else
 			place_random_stairs(c, centre);
@@ -2212,6 +2233,7 @@ bool build_large(struct chunk *c, struct loc centre, int rating)
  */
 bool build_nest(struct chunk *c, struct loc centre, int rating)
 {
+	struct dun_data *dun = c->gen->dun;
 	struct loc grid;
 	int y1, x1, y2, x2;
 	int i;
@@ -2226,7 +2248,7 @@ bool build_nest(struct chunk *c, struct loc centre, int rating)
 
 	/* Find and reserve some space in the dungeon.  Get center of room. */
 	if ((centre.y >= c->height) || (centre.x >= c->width)) {
-		if (!find_space(&centre, height + 2, width + 2))
+		if (!find_space(c, &centre, height + 2, width + 2))
 			return (false);
 	}
 
@@ -2260,18 +2282,18 @@ bool build_nest(struct chunk *c, struct loc centre, int rating)
 	generate_hole(c, y1 - 1, x1 - 1, y2 + 1, x2 + 1, FEAT_CLOSED);
 
 	/* Decide on the pit type */
-	set_pit_type(c->depth, 2);
+	set_pit_type(c, c->depth, 2);
 
 	/* Chance of objects on the floor */
 	alloc_obj = dun->pit_type->obj_rarity;
 	
 	/* Prepare allocation table */
-	get_mon_num_prep(mon_pit_hook);
+	pit_mon_num_prep(dun->pit_type);
 
 	/* Pick some monster types */
 	for (i = 0; i < 64; i++) {
 		/* Get a (hard) monster type */
-		what[i] = get_mon_num(c->depth + 10);
+		what[i] = get_mon_num(c, c->depth + 10);
 
 		/* Notice failure */
 		if (!what[i]) empty = true;
@@ -2284,7 +2306,7 @@ bool build_nest(struct chunk *c, struct loc centre, int rating)
 	if (empty) return false;
 
 	/* Describe */
-	ROOM_LOG("Monster nest (%s)", dun->pit_type->name);
+	ROOM_LOG(c, "Monster nest (%s)", dun->pit_type->name);
 
 	/* Increase the level rating */
 	c->mon_rating += (size_vary + dun->pit_type->ave / 20);
@@ -2343,6 +2365,7 @@ bool build_nest(struct chunk *c, struct loc centre, int rating)
  */
 bool build_pit(struct chunk *c, struct loc centre, int rating)
 {
+	struct dun_data *dun = c->gen->dun;
 	struct monster_race *what[16];
 	int i, j, y, x, y1, x1, y2, x2;
 	bool empty = false;
@@ -2355,7 +2378,7 @@ bool build_pit(struct chunk *c, struct loc centre, int rating)
 
 	/* Find and reserve some space in the dungeon.  Get center of room. */
 	if ((centre.y >= c->height) || (centre.x >= c->width)) {
-		if (!find_space(&centre, height + 2, width + 2))
+		if (!find_space(c, &centre, height + 2, width + 2))
 			return (false);
 	}
 
@@ -2383,18 +2406,18 @@ bool build_pit(struct chunk *c, struct loc centre, int rating)
 	generate_hole(c, y1 - 1, x1 - 1, y2 + 1, x2 + 1, FEAT_CLOSED);
 
 	/* Decide on the pit type */
-	set_pit_type(c->depth, 1);
+	set_pit_type(c, c->depth, 1);
 
 	/* Chance of objects on the floor */
 	alloc_obj = dun->pit_type->obj_rarity;
 	
 	/* Prepare allocation table */
-	get_mon_num_prep(mon_pit_hook);
+	pit_mon_num_prep(dun->pit_type);
 
 	/* Pick some monster types */
 	for (i = 0; i < 16; i++) {
 		/* Get a (hard) monster type */
-		what[i] = get_mon_num(c->depth + 10);
+		what[i] = get_mon_num(c, c->depth + 10);
 
 		/* Notice failure */
 		if (!what[i]) empty = true;
@@ -2407,7 +2430,7 @@ bool build_pit(struct chunk *c, struct loc centre, int rating)
 	if (empty)
 		return false;
 
-	ROOM_LOG("Monster pit (%s)", dun->pit_type->name);
+	ROOM_LOG(c, "Monster pit (%s)", dun->pit_type->name);
 
 	/* Sort the entries XXX XXX XXX */
 	for (i = 0; i < 16 - 1; i++) {
@@ -2566,6 +2589,8 @@ bool build_interesting(struct chunk *c, struct loc centre, int rating)
  */
 bool build_lesser_vault(struct chunk *c, struct loc centre, int rating)
 {
+	struct dun_data *dun = c->gen->dun;
+
 	if (!streq(dun->profile->name, "classic") && (one_in_(2)))
 		return build_vault_type(c, centre, "Lesser vault (new)");
 	return build_vault_type(c, centre, "Lesser vault");
@@ -2580,6 +2605,8 @@ bool build_lesser_vault(struct chunk *c, struct loc centre, int rating)
  */
 bool build_medium_vault(struct chunk *c, struct loc centre, int rating)
 {
+	struct dun_data *dun = c->gen->dun;
+
 	if (!streq(dun->profile->name, "classic") && (one_in_(2)))
 		return build_vault_type(c, centre, "Medium vault (new)");
 	return build_vault_type(c, centre, "Medium vault");
@@ -2615,6 +2642,7 @@ bool build_medium_vault(struct chunk *c, struct loc centre, int rating)
  */
 bool build_greater_vault(struct chunk *c, struct loc centre, int rating)
 {
+	struct dun_data *dun = c->gen->dun;
 	int i;
 	int numerator   = 1;
 	int denominator = 3;
@@ -2678,7 +2706,7 @@ bool build_moria(struct chunk *c, struct loc centre, int rating)
 
 		/* Find and reserve some space in the dungeon.  Get center of room. */
 		if ((centre.y >= c->height) || (centre.x >= c->width)) {
-			if (!find_space(&centre, height, width)) {
+			if (!find_space(c, &centre, height, width)) {
 				if (i == 0) continue;  /* Failed first attempt */
 				if (i == 1) return (false);  /* Failed second attempt */
 			} else break;  /* Success */
@@ -2754,7 +2782,7 @@ bool build_room_of_chambers(struct chunk *c, struct loc centre, int rating)
 
 	/* Find and reserve some space in the dungeon.  Get center of room. */
 	if ((centre.y >= c->height) || (centre.x >= c->width)) {
-		if (!find_space(&centre, height, width))
+		if (!find_space(c, &centre, height, width))
 			return (false);
 	}
 
@@ -2815,14 +2843,14 @@ bool build_room_of_chambers(struct chunk *c, struct loc centre, int rating)
 				struct loc grid1 = loc_sum(grid, ddgrid_ddd[d]);
 
 				/* Count the walls and dungeon granite. */
-				if ((square(c, grid1).feat == FEAT_GRANITE) &&
+				if ((square_fidx(c, grid1) == FEAT_GRANITE) &&
 					(!square_iswall_outer(c, grid1)) &&
 					(!square_iswall_solid(c, grid1)))
 					count++;
 			}
 
 			/* Five adjacent walls: Change non-chamber to wall. */
-			if ((count == 5) && (square(c, grid).feat != FEAT_MAGMA))
+			if ((count == 5) && (square_fidx(c, grid) != FEAT_MAGMA))
 				set_marked_granite(c, grid, SQUARE_WALL_INNER);
 
 			/* More than five adjacent walls: Change anything to wall. */
@@ -2835,7 +2863,7 @@ bool build_room_of_chambers(struct chunk *c, struct loc centre, int rating)
 	for (i = 0; i < 50; i++) {
 		grid = loc(x1 + ABS(x2 - x1) / 4 + randint0(ABS(x2 - x1) / 2),
 				   y1 + ABS(y2 - y1) / 4 + randint0(ABS(y2 - y1) / 2));
-		if (square(c, grid).feat == FEAT_MAGMA)
+		if (square_fidx(c, grid) == FEAT_MAGMA)
 			break;
 	}
 
@@ -2852,7 +2880,7 @@ bool build_room_of_chambers(struct chunk *c, struct loc centre, int rating)
 		for (grid.y = y1; grid.y < y2; grid.y++) {
 			for (grid.x = x1; grid.x < x2; grid.x++) {
 				/* Current grid must be magma. */
-				if (square(c, grid).feat != FEAT_MAGMA) continue;
+				if (square_fidx(c, grid) != FEAT_MAGMA) continue;
 
 				/* Stay legal. */
 				if (!square_in_bounds_fully(c, grid)) continue;
@@ -2873,7 +2901,7 @@ bool build_room_of_chambers(struct chunk *c, struct loc centre, int rating)
 					if (!square_in_bounds(c, grid2)) continue;
 
 					/* If we find open floor, place a door. */
-					if (square(c, grid2).feat == FEAT_FLOOR) {
+					if (square_fidx(c, grid2) == FEAT_FLOOR) {
 						joy = true;
 
 						/* Make a broken door in the wall grid. */
@@ -2893,7 +2921,7 @@ bool build_room_of_chambers(struct chunk *c, struct loc centre, int rating)
 						if (!square_in_bounds(c, grid3)) continue;
 
 						/* If we /now/ find floor, make a tunnel. */
-						if (square(c, grid3).feat == FEAT_FLOOR) {
+						if (square_fidx(c, grid3) == FEAT_FLOOR) {
 							joy = true;
 
 							/* Turn both wall grids into floor. */
@@ -2919,9 +2947,9 @@ bool build_room_of_chambers(struct chunk *c, struct loc centre, int rating)
 	/* Turn broken doors into a random kind of door, remove open doors. */
 	for (grid.y = y1; grid.y <= y2; grid.y++) {
 		for (grid.x = x1; grid.x <= x2; grid.x++) {
-			if (square(c, grid).feat == FEAT_OPEN)
+			if (square_fidx(c, grid) == FEAT_OPEN)
 				set_marked_granite(c, grid, SQUARE_WALL_INNER);
-			else if (square(c, grid).feat == FEAT_BROKEN)
+			else if (square_fidx(c, grid) == FEAT_BROKEN)
 				place_random_door(c, grid);
 		}
 	}
@@ -2935,7 +2963,7 @@ bool build_room_of_chambers(struct chunk *c, struct loc centre, int rating)
 			 grid.x < (x2 + 2 < c->width ? x2 + 2 : c->width); grid.x++) {
 
 			if (square_iswall_inner(c, grid)
-				|| (square(c, grid).feat == FEAT_MAGMA)) {
+				|| (square_fidx(c, grid) == FEAT_MAGMA)) {
 				for (d = 0; d < 9; d++) {
 					/* Extract adjacent location */
 					struct loc grid1 = loc_sum(grid, ddgrid_ddd[d]);
@@ -2944,7 +2972,7 @@ bool build_room_of_chambers(struct chunk *c, struct loc centre, int rating)
 					if (!square_in_bounds(c, grid1)) continue;
 
 					/* No floors allowed */
-					if (square(c, grid1).feat == FEAT_FLOOR) break;
+					if (square_fidx(c, grid1) == FEAT_FLOOR) break;
 
 					/* Turn me into dungeon granite. */
 					if (d == 8)
@@ -2960,11 +2988,11 @@ bool build_room_of_chambers(struct chunk *c, struct loc centre, int rating)
 					if (!square_in_bounds(c, grid1)) continue;
 
 					/* Turn into room, forbid stairs. */
-					sqinfo_on(square(c, grid1).info, SQUARE_ROOM);
-					sqinfo_on(square(c, grid1).info, SQUARE_NO_STAIRS);
+					sqinfo_on(square_info(c, grid1), SQUARE_ROOM);
+					sqinfo_on(square_info(c, grid1), SQUARE_NO_STAIRS);
 
 					/* Illuminate if requested. */
-					if (light) sqinfo_on(square(c, grid1).info, SQUARE_GLOW);
+					if (light) sqinfo_on(square_info(c, grid1), SQUARE_GLOW);
 				}
 			}
 		}
@@ -2986,7 +3014,7 @@ bool build_room_of_chambers(struct chunk *c, struct loc centre, int rating)
 					struct loc grid1 = loc_sum(grid, ddgrid_ddd[d]);
 
 					/* Look for dungeon granite */
-					if ((square(c, grid1).feat == FEAT_GRANITE) && 
+					if ((square_fidx(c, grid1) == FEAT_GRANITE) && 
 						(!square_iswall_inner(c, grid)) &&
 						(!square_iswall_outer(c, grid)) &&
 						(!square_iswall_solid(c, grid)))
@@ -3009,7 +3037,7 @@ bool build_room_of_chambers(struct chunk *c, struct loc centre, int rating)
 	c->mon_rating += 10;
 
 	/* Describe */
-	ROOM_LOG("Room of chambers (%s)", strlen(name) ? name : "empty");
+	ROOM_LOG(c, "Room of chambers (%s)", strlen(name) ? name : "empty");
 
 	/* Success. */
 	return (true);
@@ -3029,6 +3057,7 @@ bool build_room_of_chambers(struct chunk *c, struct loc centre, int rating)
  */
 bool build_huge(struct chunk *c, struct loc centre, int rating)
 {
+	struct dun_data *dun = c->gen->dun;
 	bool light;
 
 	int i, count;
@@ -3051,7 +3080,7 @@ bool build_huge(struct chunk *c, struct loc centre, int rating)
 
 	/* Find and reserve some space.  Get center of room. */
 	if ((centre.y >= c->height) || (centre.x >= c->width)) {
-		if (!find_space(&centre, height, width))
+		if (!find_space(c, &centre, height, width))
 			return (false);
 	}
 
@@ -3088,7 +3117,7 @@ bool build_huge(struct chunk *c, struct loc centre, int rating)
 	}
 
 	/* Describe */
-	ROOM_LOG("Huge room");
+	ROOM_LOG(c, "Huge room");
 
 	/* Success. */
 	return (true);
@@ -3114,6 +3143,8 @@ bool build_huge(struct chunk *c, struct loc centre, int rating)
 bool room_build(struct chunk *c, int by0, int bx0, struct room_profile profile,
 	bool finds_own_space)
 {
+	struct dun_data *dun = c->gen->dun;
+
 	/* Extract blocks */
 	int by1 = by0;
 	int bx1 = bx0;
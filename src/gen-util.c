@@ -147,6 +147,49 @@ void shuffle(int *arr, int n)
 }
 
 
+/**
+ * True if a predicate can only hold for floor squares, so that squares
+ * satisfying it can be sought in the chunk's floor list
+ */
+static bool pred_needs_floor(square_predicate pred)
+{
+	return (pred == square_isempty) || (pred == square_isopen) ||
+		(pred == square_isfloor) || (pred == square_suits_stairs_well) ||
+		(pred == square_suits_stairs_ok);
+}
+
+/**
+ * Locate a floor square in a rectangle which satisfies the given predicate,
+ * by testing the floor squares in random order.
+ *
+ * The untested squares are kept at the end of the floor list, so shuffling
+ * them as we go leaves the list valid (if reordered).
+ */
+static bool cave_find_floor(struct chunk *c, struct loc *grid,
+							struct loc top_left, struct loc bottom_right,
+							square_predicate pred)
+{
+	struct floor_list *floor = &c->floor;
+	int i;
+
+	for (i = 0; i < floor->count; i++) {
+		int j = randint0(floor->count - i) + i;
+		int k = floor->grids[j];
+		floor->grids[j] = floor->grids[i];
+		floor->place[floor->grids[j]] = j;
+		floor->grids[i] = k;
+		floor->place[k] = i;
+
+		*grid = loc(k % c->width, k / c->width);
+		if ((grid->x < top_left.x) || (grid->y < top_left.y) ||
+			(grid->x >= bottom_right.x) || (grid->y >= bottom_right.y))
+			continue;
+		if (pred(c, *grid)) return true;
+	}
+
+	return false;
+}
+
 /**
  * Locate a square in a rectangle which satisfies the given predicate.
  *
@@ -164,9 +207,15 @@ static bool cave_find_in_range(struct chunk *c, struct loc *grid,
     struct loc diff = loc_diff(bottom_right, top_left);
     int i, n = diff.y * diff.x;
     bool found = false;
+	int *squares;
+
+	/* Unless the rectangle is small, only look at floor squares if those
+	 * are all that will do */
+	if (pred_needs_floor(pred) && c->floor.count && (n >= c->floor.count))
+		return cave_find_floor(c, grid, top_left, bottom_right, pred);
 
     /* Allocate the squares, and randomize their order */
-    int *squares = mem_alloc(n * sizeof(int));
+    squares = mem_alloc(n * sizeof(int));
     for (i = 0; i < n; i++) squares[i] = i;
 
     /* Test each square in (random) order for openness */
@@ -386,7 +435,8 @@ static void place_stairs(struct chunk *c, struct loc grid, int feat)
 {
     if (!c->depth)
 		square_set_feat(c, grid, FEAT_MORE);
-    else if (is_quest(c->depth) || c->depth >= z_info->max_depth - 1)
+    else if (is_quest(gen_player(c), c->depth) ||
+			 c->depth >= z_info->max_depth - 1)
 		square_set_feat(c, grid, FEAT_LESS);
     else
 		square_set_feat(c, grid, feat);
@@ -435,7 +485,7 @@ void place_object(struct chunk *c, struct loc grid, int level, bool good,
     /* Give it to the floor */
     if (!floor_carry(c, grid, new_obj, &dummy)) {
 		if (new_obj->artifact) {
-			new_obj->artifact->created = false;
+			*gen_created(c, new_obj->artifact) = false;
 		}
 		object_delete(&new_obj);
 		return;
@@ -468,7 +518,7 @@ void place_gold(struct chunk *c, struct loc grid, int level, byte origin)
     if (!square_in_bounds(c, grid)) return;
     if (!square_canputitem(c, grid)) return;
 
-    money = make_gold(level, "any");
+    money = make_gold(c, level, "any");
     money->origin = origin;
     money->origin_depth = level;
 
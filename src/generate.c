@@ -36,6 +36,7 @@
 #include "generate.h"
 #include "init.h"
 #include "math.h"
+#include "mon-lore.h"
 #include "mon-make.h"
 #include "mon-move.h"
 #include "mon-spell.h"
@@ -45,9 +46,14 @@
 #include "object.h"
 #include "player-history.h"
 #include "player-util.h"
+#include "profile.h"
 #include "trap.h"
+#include "z-pool.h"
 #include "z-queue.h"
 #include "z-type.h"
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 /*
  * Array of pit types
@@ -55,7 +61,6 @@
 struct pit_profile *pit_info;
 struct vault *vaults;
 static struct cave_profile *cave_profiles;
-struct dun_data *dun;
 struct room_template *room_templates;
 
 static const struct {
@@ -649,7 +654,7 @@ static void place_feeling(struct chunk *c)
 				continue;
 
 			/* Set the cave square appropriately */
-			sqinfo_on(square(c, grid).info, SQUARE_FEEL);
+			sqinfo_on(square_info(c, grid), SQUARE_FEEL);
 			
 			break;
 		}
@@ -718,9 +723,10 @@ static int calc_mon_feeling(struct chunk *c)
 
 /**
  * Do d_m's prime check for labyrinths
+ * \param p is the player the level is for
  * \param depth is the depth where we're trying to generate a labyrinth
  */
-bool labyrinth_check(int depth)
+bool labyrinth_check(const struct player *p, int depth)
 {
 	/* There's a base 2 in 100 to accept the labyrinth */
 	int chance = 2;
@@ -729,7 +735,7 @@ bool labyrinth_check(int depth)
 	if (depth < 13) return false;
 
 	/* Don't try this on quest levels, kids... */
-	if (is_quest(depth)) return false;
+	if (is_quest(p, depth)) return false;
 
 	/* Certain numbers increase the chance of having a labyrinth */
 	if (depth % 3 == 0) chance += 1;
@@ -767,34 +773,26 @@ const struct cave_profile *find_cave_profile(char *name)
 
 /**
  * Choose a cave profile
- * \param p is the player
+ * \param g is the generation context
  */
-const struct cave_profile *choose_profile(struct player *p)
+const struct cave_profile *choose_profile(struct gen_context *g)
 {
-	const struct cave_profile *profile = NULL;
+	struct player *p = g->p;
+	const struct cave_profile *profile = g->profile;
 
-	/* A bit of a hack, but worth it for now NRM */
-	if (player->noscore & NOSCORE_JUMPING) {
-		char name[30] = "";
-
-		/* Cancel the query */
-		player->noscore &= ~(NOSCORE_JUMPING);
-
-		/* Ask debug players for the profile they want */
-		if (get_string("Profile name (eg classic): ", name, sizeof(name)))
-			profile = find_cave_profile(name);
-
-		/* If no valid profile name given, fall through */
-		if (profile) return profile;
+	/* The profile a debug player asked for gets the first try */
+	if (profile) {
+		g->profile = NULL;
+		return profile;
 	}
 
 	/* Make the profile choice */
 	if (p->depth == 0) {
 		profile = find_cave_profile("town");
-	} else if (is_quest(p->depth) && !OPT(p, birth_levels_persist)) {
+	} else if (is_quest(p, p->depth) && !OPT(p, birth_levels_persist)) {
 		/* Quest levels must be normal levels */
 		profile = find_cave_profile("classic");
-	} else if (labyrinth_check(p->depth)) {
+	} else if (labyrinth_check(p, p->depth)) {
 		profile = find_cave_profile("labyrinth");
 	} else if ((p->depth >= 10) && (p->depth < 40) && one_in_(40)) {
 		profile = find_cave_profile("moria");
@@ -819,47 +817,41 @@ const struct cave_profile *choose_profile(struct player *p)
 /**
  * Get information for constructing stairs in the correct places
  */
-static void get_join_info(struct player *p, struct dun_data *dun)
+static void get_join_info(struct player *p, struct gen_context *g)
 {
 	struct level *lev = NULL;
 
 	/* Check level above */
 	lev = level_by_depth(p->depth - 1);
 	if (lev) {
-		struct chunk *check = chunk_find_name(lev->name);
-		if (check) {
-			struct connector *join = check->join;
-			while (join) {
-				if (join->feat == FEAT_MORE) {
-					struct connector *new = mem_zalloc(sizeof *new);
-					new->grid.y = join->grid.y;
-					new->grid.x = join->grid.x;
-					new->feat = FEAT_LESS;
-					new->next = dun->join;
-					dun->join = new;
-				}
-				join = join->next;
+		struct connector *join = chunk_find_join(lev->name);
+		while (join) {
+			if (join->feat == FEAT_MORE) {
+				struct connector *new = mem_zalloc(sizeof *new);
+				new->grid.y = join->grid.y;
+				new->grid.x = join->grid.x;
+				new->feat = FEAT_LESS;
+				new->next = g->join;
+				g->join = new;
 			}
+			join = join->next;
 		}
 	}
 
 	/* Check level below */
 	lev = level_by_depth(p->depth + 1);
 	if (lev) {
-		struct chunk *check = chunk_find_name(lev->name);
-		if (check) {
-			struct connector *join = check->join;
-			while (join) {
-				if (join->feat == FEAT_LESS) {
-					struct connector *new = mem_zalloc(sizeof *new);
-					new->grid.y = join->grid.y;
-					new->grid.x = join->grid.x;
-					new->feat = FEAT_MORE;
-					new->next = dun->join;
-					dun->join = new;
-				}
-				join = join->next;
+		struct connector *join = chunk_find_join(lev->name);
+		while (join) {
+			if (join->feat == FEAT_LESS) {
+				struct connector *new = mem_zalloc(sizeof *new);
+				new->grid.y = join->grid.y;
+				new->grid.x = join->grid.x;
+				new->feat = FEAT_MORE;
+				new->next = g->join;
+				g->join = new;
 			}
+			join = join->next;
 		}
 	}
 }
@@ -868,11 +860,9 @@ static void get_join_info(struct player *p, struct dun_data *dun)
  * Check the size of the level above or below the next level to be generated
  * to make sure stairs can connect
  */
-static void	get_min_level_size(struct chunk *check, int *min_height,
+static void	get_min_level_size(struct connector *join, int *min_height,
 							   int *min_width, bool above)
 {
-	struct connector *join = check->join;
-
 	while (join) {
 		if ((above && (join->feat == FEAT_MORE)) ||
 			(!above && (join->feat == FEAT_LESS))) {
@@ -920,38 +910,234 @@ static void cave_clear(struct chunk *c, struct player *p)
 }
 
 
+/**
+ * ------------------------------------------------------------------------
+ * Generation contexts
+ * ------------------------------------------------------------------------ */
+/**
+ * Make a chunk belonging to the level being generated
+ */
+struct chunk *gen_cave_new(struct gen_context *g, int height, int width)
+{
+	struct chunk *c = cave_new(height, width);
+	c->gen = g;
+	return c;
+}
+
+/**
+ * The player a level is for - the generator's own copy while it's being
+ * generated
+ */
+struct player *gen_player(const struct chunk *c)
+{
+	return c->gen ? c->gen->p : player;
+}
+
+/**
+ * The number of monsters of a race alive, counting the level `c`
+ */
+int *gen_cur_num(const struct chunk *c, const struct monster_race *race)
+{
+	return c->gen ? &c->gen->now.cur_num[race->ridx] :
+		&r_info[race->ridx].cur_num;
+}
+
+/**
+ * The number of monsters of a race allowed alive at once
+ */
+byte gen_max_num(const struct chunk *c, const struct monster_race *race)
+{
+	return c->gen ? c->gen->max_num[race->ridx] : race->max_num;
+}
+
+/**
+ * The number of objects monsters of a race have stolen
+ */
+u16b gen_thefts(const struct chunk *c, const struct monster_race *race)
+{
+	return c->gen ? c->gen->thefts[race->ridx] : get_lore(race)->thefts;
+}
+
+/**
+ * Whether an artifact has been made, counting the level `c`
+ */
+bool *gen_created(const struct chunk *c, const struct artifact *art)
+{
+	return c->gen ? &c->gen->now.created[art->aidx] :
+		&a_info[art->aidx].created;
+}
+
+/**
+ * Whether it's the season for seasonal monsters
+ */
+static bool is_season(void)
+{
+	time_t cur_time = time(NULL);
+	struct tm *date = localtime(&cur_time);
+
+	return date->tm_mon == 11 && date->tm_mday >= 24 && date->tm_mday <= 26;
+}
+
+/**
+ * Whether seasonal monsters can appear on the level `c`
+ */
+bool gen_seasonal(const struct chunk *c)
+{
+	return c->gen ? c->gen->seasonal : is_season();
+}
+
+/**
+ * Give a message about the level `c`, or hold it back while it's generated
+ */
+static void gen_vmsg(const struct chunk *c, const char *fmt, va_list vp)
+{
+	struct gen_context *g = c->gen;
+	char buf[1024];
+
+	(void)vstrnfmt(buf, sizeof(buf), fmt, vp);
+
+	/* Hold messages back until the player gets to the level */
+	if (g) {
+		g->msgs = mem_realloc(g->msgs, (g->msg_num + 1) * sizeof(*g->msgs));
+		g->msgs[g->msg_num++] = string_make(buf);
+	} else {
+		msg("%s", buf);
+	}
+}
+
+/**
+ * Give the player a message about the level `c`
+ */
+void gen_msg(const struct chunk *c, const char *fmt, ...)
+{
+	va_list vp;
+
+	va_start(vp, fmt);
+	gen_vmsg(c, fmt, vp);
+	va_end(vp);
+}
+
+/**
+ * Note a room being built, for players cheating to see them
+ */
+void gen_room_log(const struct chunk *c, const char *fmt, ...)
+{
+	va_list vp;
+
+	if (!OPT(gen_player(c), cheat_room)) return;
+
+	va_start(vp, fmt);
+	gen_vmsg(c, fmt, vp);
+	va_end(vp);
+}
+
+/**
+ * Start a generation context for the level the player `p` is going to, from
+ * the game as it stands
+ */
+static struct gen_context *gen_context_new(struct player *p, int min_height,
+										   int min_width)
+{
+	struct gen_context *g = mem_zalloc(sizeof(*g));
+	int i;
+
+	g->depth = p->depth;
+	g->min_height = min_height;
+	g->min_width = min_width;
+	g->rng_start = level_rng;
+	g->p = p;
+	g->create_down_stair = p->upkeep->create_down_stair;
+	g->create_up_stair = p->upkeep->create_up_stair;
+
+	g->start.cur_num = mem_zalloc(z_info->r_max * sizeof(int));
+	g->now.cur_num = mem_zalloc(z_info->r_max * sizeof(int));
+	g->max_num = mem_zalloc(z_info->r_max * sizeof(byte));
+	g->thefts = mem_zalloc(z_info->r_max * sizeof(u16b));
+	for (i = 0; i < z_info->r_max; i++) {
+		g->start.cur_num[i] = r_info[i].cur_num;
+		g->max_num[i] = r_info[i].max_num;
+		g->thefts[i] = l_list[i].thefts;
+	}
+	g->start.created = mem_zalloc(z_info->a_max * sizeof(bool));
+	g->now.created = mem_zalloc(z_info->a_max * sizeof(bool));
+	for (i = 0; i < z_info->a_max; i++)
+		g->start.created[i] = a_info[i].created;
+
+	g->seasonal = is_season();
+	g->daytime = is_daytime();
+
+	return g;
+}
+
+/**
+ * Free a generation context, and any level still in it
+ */
+static void gen_context_free(struct gen_context *g)
+{
+	int i;
+
+	if (g->chunk) {
+		/* Nothing on a level never played is listed for the player */
+		for (i = 1; i < g->chunk->obj_max; i++)
+			if (g->chunk->objects[i])
+				g->chunk->objects[i]->oidx = 0;
+
+		cave_clear(g->chunk, g->p);
+	}
+	if (g->town) cave_free(g->town);
+	while (g->join) {
+		struct connector *next = g->join->next;
+		mem_free(g->join);
+		g->join = next;
+	}
+	for (i = 0; i < g->msg_num; i++)
+		string_free(g->msgs[i]);
+	mem_free(g->msgs);
+	mem_free(g->start.cur_num);
+	mem_free(g->now.cur_num);
+	mem_free(g->start.created);
+	mem_free(g->now.created);
+	mem_free(g->max_num);
+	mem_free(g->thefts);
+	if (g->ahead) {
+		mem_free(g->p->quests);
+		mem_free(g->p->upkeep);
+		mem_free(g->p);
+	}
+	mem_free(g);
+}
+
 /**
  * Generate a random level.
  *
  * Confusingly, this function also generates the town level (level 0).
- * \param p is the current player struct, in practice the global player
- * \return a pointer to the new level
+ * Generation reads and changes nothing but the context `g`, so can be done
+ * on any thread; the level is left in g->chunk.
+ * \param g is the generation context
  */
-static struct chunk *cave_generate(struct player *p, int height, int width)
+static void gen_level(struct gen_context *g)
 {
+	struct player *p = g->p;
 	const char *error = "no generation";
-	int i, tries = 0;
+	int tries = 0;
 	struct chunk *chunk = NULL;
 
-	/* Arena levels handled separately */
-	if (p->upkeep->arena_level) {
-		/* Generate level */
-		chunk = arena_gen(p, height, width);
-
-		/* Allocate new known level, light it if requested */
-		p->cave = cave_new(chunk->height, chunk->width);
-		p->cave->depth = chunk->depth;
-		p->cave->objects = mem_realloc(p->cave->objects, (chunk->obj_max + 1)
-									   * sizeof(struct object*));
-		p->cave->obj_max = chunk->obj_max;
-		for (i = 0; i <= p->cave->obj_max; i++) {
-			p->cave->objects[i] = NULL;
-		}
+	/* Draw on the level stream of random numbers */
+	g->rng = g->rng_start;
+	Rand_state_swap(&g->rng);
 
-		wiz_light(chunk, p, false);
-		chunk->turn = turn;
+	/* Start from the counts the level is generated against */
+	memcpy(g->now.cur_num, g->start.cur_num, z_info->r_max * sizeof(int));
+	memcpy(g->now.created, g->start.created, z_info->a_max * sizeof(bool));
+
+	/* Monsters are weighed the same way wherever the level is generated */
+	get_mon_num_prep(NULL);
 
-		return chunk;
+	/* Arena levels handled separately */
+	if (p->upkeep->arena_level) {
+		g->chunk = arena_gen(g, g->min_height, g->min_width);
+		Rand_state_swap(&g->rng);
+		return;
 	}
 
 	/* Generate */
@@ -961,37 +1147,29 @@ static struct chunk *cave_generate(struct player *p, int height, int width)
 
 		error = NULL;
 
-		/* Mark the dungeon as being unready (to avoid artifact loss, etc) */
-		character_dungeon = false;
-
-		/* Allocate global data (will be freed when we leave the loop) */
-		dun = &dun_body;
-		dun->cent = mem_zalloc(z_info->level_room_max * sizeof(struct loc));
-		dun->door = mem_zalloc(z_info->level_door_max * sizeof(struct loc));
-		dun->wall = mem_zalloc(z_info->wall_pierce_max * sizeof(struct loc));
-		dun->tunn = mem_zalloc(z_info->tunn_grid_max * sizeof(struct loc));
-		dun->join = NULL;
-
-		/* Get connector info for persistent levels */
-		if (OPT(p, birth_levels_persist)) {
-			get_join_info(p, dun);
-		}
+		/* Allocate scratch data (will be freed when we leave the loop) */
+		g->dun = &dun_body;
+		memset(&dun_body, 0, sizeof(dun_body));
+		g->dun->cent = mem_zalloc(z_info->level_room_max * sizeof(struct loc));
+		g->dun->door = mem_zalloc(z_info->level_door_max * sizeof(struct loc));
+		g->dun->wall = mem_zalloc(z_info->wall_pierce_max * sizeof(struct loc));
+		g->dun->tunn = mem_zalloc(z_info->tunn_grid_max * sizeof(struct loc));
+		g->dun->join = g->join;
 
 		/* Choose a profile and build the level */
-		dun->profile = choose_profile(p);
-		chunk = dun->profile->builder(p, height, width);
+		g->dun->profile = choose_profile(g);
+		chunk = g->dun->profile->builder(g, g->min_height, g->min_width);
 		if (!chunk) {
 			error = "Failed to find builder";
-			mem_free(dun->join);
-			mem_free(dun->cent);
-			mem_free(dun->door);
-			mem_free(dun->wall);
-			mem_free(dun->tunn);
+			mem_free(g->dun->cent);
+			mem_free(g->dun->door);
+			mem_free(g->dun->wall);
+			mem_free(g->dun->tunn);
 			continue;
 		}
 
 		/* Ensure quest monsters */
-		if (is_quest(chunk->depth)) {
+		if (is_quest(p, chunk->depth)) {
 			int i2;
 			for (i2 = 1; i2 < z_info->r_max; i2++) {
 				struct monster_race *race = &r_info[i2];
@@ -999,10 +1177,10 @@ static struct chunk *cave_generate(struct player *p, int height, int width)
 				struct loc grid;
 
 				/* The monster must be an unseen quest monster of this depth. */
-				if (race->cur_num > 0) continue;
+				if (*gen_cur_num(chunk, race) > 0) continue;
 				if (!rf_has(race->flags, RF_QUESTOR)) continue;
 				if (race->level != chunk->depth) continue;
-	
+
 				/* Pick a location and place the monster */
 				find_empty(chunk, &grid);
 				place_new_monster(chunk, grid, race, true, true, info,
@@ -1015,19 +1193,21 @@ static struct chunk *cave_generate(struct player *p, int height, int width)
 			for (x = 0; x < chunk->width; x++) {
 				struct loc grid = loc(x, y);
 
-				sqinfo_off(square(chunk, grid).info, SQUARE_WALL_INNER);
-				sqinfo_off(square(chunk, grid).info, SQUARE_WALL_OUTER);
-				sqinfo_off(square(chunk, grid).info, SQUARE_WALL_SOLID);
-				sqinfo_off(square(chunk, grid).info, SQUARE_MON_RESTRICT);
+				sqinfo_off(square_info(chunk, grid), SQUARE_WALL_INNER);
+				sqinfo_off(square_info(chunk, grid), SQUARE_WALL_OUTER);
+				sqinfo_off(square_info(chunk, grid), SQUARE_WALL_SOLID);
+				sqinfo_off(square_info(chunk, grid), SQUARE_MON_RESTRICT);
 
 				if (square_isstairs(chunk, grid)) {
 					size_t n;
-					struct connector *new = mem_zalloc(sizeof *new);
+					struct connector *new =
+						mem_arena_alloc(chunk->arena, sizeof *new);
 					new->grid = grid;
 					new->feat = square_feat(chunk, grid)->fidx;
-					new->info = mem_zalloc(SQUARE_SIZE * sizeof(bitflag));
+					new->info = mem_arena_alloc(chunk->arena,
+												SQUARE_SIZE * sizeof(bitflag));
 					for (n = 0; n < SQUARE_SIZE; n++) {
-						new->info[n] = square(chunk, grid).info[n];
+						new->info[n] = square_info(chunk, grid)[n];
 					}
 					new->next = chunk->join;
 					chunk->join = new;
@@ -1041,17 +1221,17 @@ static struct chunk *cave_generate(struct player *p, int height, int width)
 
 		if (error) {
 			if (OPT(p, cheat_room)) {
-				msg("Generation restarted: %s.", error);
+				gen_msg(chunk, "Generation restarted: %s.", error);
 			}
 			cave_clear(chunk, p);
 		}
 
-		mem_free(dun->join);
-		mem_free(dun->cent);
-		mem_free(dun->door);
-		mem_free(dun->wall);
-		mem_free(dun->tunn);
+		mem_free(g->dun->cent);
+		mem_free(g->dun->door);
+		mem_free(g->dun->wall);
+		mem_free(g->dun->tunn);
 	}
+	g->dun = NULL;
 
 	if (error) quit_fmt("cave_generate() failed 100 times!");
 
@@ -1065,6 +1245,41 @@ static struct chunk *cave_generate(struct player *p, int height, int width)
 	/* Validate the dungeon (we could use more checks here) */
 	chunk_validate_objects(chunk);
 
+	g->chunk = chunk;
+	Rand_state_swap(&g->rng);
+}
+
+/**
+ * Make a generated level the game's current one
+ * \param g is the generation context the level was generated in
+ * \param p is the current player struct, in practice the global player
+ * \return the level, taken out of the context
+ */
+static struct chunk *gen_adopt(struct gen_context *g, struct player *p)
+{
+	struct chunk *chunk = g->chunk;
+	int i;
+
+	/* What generating the level changed is now the game's */
+	level_rng = g->rng;
+	for (i = 0; i < z_info->r_max; i++)
+		r_info[i].cur_num = g->now.cur_num[i];
+	for (i = 0; i < z_info->a_max; i++)
+		a_info[i].created = g->now.created[i];
+	if (g->p != p) {
+		p->grid = g->p->grid;
+		p->upkeep->create_down_stair = g->p->upkeep->create_down_stair;
+		p->upkeep->create_up_stair = g->p->upkeep->create_up_stair;
+		if (g->p->upkeep->light_level)
+			p->upkeep->light_level = true;
+	}
+	for (i = 0; i < g->msg_num; i++)
+		msg("%s", g->msgs[i]);
+
+	/* The level is the game's now */
+	chunk->gen = NULL;
+	g->chunk = NULL;
+
 	/* Allocate new known level, light it if requested */
 	p->cave = cave_new(chunk->height, chunk->width);
 	p->cave->depth = chunk->depth;
@@ -1074,7 +1289,9 @@ static struct chunk *cave_generate(struct player *p, int height, int width)
 	for (i = 0; i <= p->cave->obj_max; i++) {
 		p->cave->objects[i] = NULL;
 	}
-	if (p->upkeep->light_level) {
+	if (p->upkeep->arena_level) {
+		wiz_light(chunk, p, false);
+	} else if (p->upkeep->light_level) {
 		wiz_light(chunk, p, false);
 		p->upkeep->light_level = false;
 	}
@@ -1084,6 +1301,276 @@ static struct chunk *cave_generate(struct player *p, int height, int width)
 	return chunk;
 }
 
+/**
+ * ------------------------------------------------------------------------
+ * Generating the next level ahead of time
+ * ------------------------------------------------------------------------ */
+static struct gen_ahead_stats ahead_stats;
+
+#ifdef HAVE_PTHREAD
+/**
+ * The level being generated ahead of time, and the thread generating it
+ */
+static struct gen_context *ahead;
+static pthread_t ahead_thread;
+
+/**
+ * Copy what generating a level reads from the player, and nothing else, for
+ * generating on another thread
+ */
+static struct player *gen_player_copy(const struct player *p)
+{
+	struct player *copy = mem_zalloc(sizeof(*copy));
+
+	copy->depth = p->depth;
+	copy->max_depth = p->max_depth;
+	copy->grid = p->grid;
+	copy->opts = p->opts;
+	copy->quests = mem_zalloc(z_info->quest_max * sizeof(*copy->quests));
+	memcpy(copy->quests, p->quests, z_info->quest_max * sizeof(*p->quests));
+	copy->upkeep = mem_zalloc(sizeof(*copy->upkeep));
+	copy->upkeep->create_down_stair = p->upkeep->create_down_stair;
+	copy->upkeep->create_up_stair = p->upkeep->create_up_stair;
+
+	return copy;
+}
+
+/**
+ * Check whether two contexts would generate the same level
+ */
+static bool gen_context_same(const struct gen_context *g1,
+							 const struct gen_context *g2)
+{
+	int i;
+
+	if (g1->depth != g2->depth) return false;
+	if (g1->min_height != g2->min_height) return false;
+	if (g1->min_width != g2->min_width) return false;
+	if (memcmp(&g1->rng_start, &g2->rng_start, sizeof(g1->rng_start)))
+		return false;
+	if (memcmp(g1->start.cur_num, g2->start.cur_num,
+			   z_info->r_max * sizeof(int)))
+		return false;
+	if (memcmp(g1->start.created, g2->start.created,
+			   z_info->a_max * sizeof(bool)))
+		return false;
+	if (memcmp(g1->max_num, g2->max_num, z_info->r_max * sizeof(byte)))
+		return false;
+	if (memcmp(g1->thefts, g2->thefts, z_info->r_max * sizeof(u16b)))
+		return false;
+	if (g1->create_down_stair != g2->create_down_stair) return false;
+	if (g1->create_up_stair != g2->create_up_stair) return false;
+	if (g1->seasonal != g2->seasonal) return false;
+	if (g1->daytime != g2->daytime) return false;
+
+	/* Stored levels and debug requests stay with the game */
+	if (g1->join || g2->join) return false;
+	if (g1->town || g2->town) return false;
+	if (g1->profile || g2->profile) return false;
+
+	/* The player as far as generation goes */
+	if (memcmp(&g1->p->opts, &g2->p->opts, sizeof(g1->p->opts)))
+		return false;
+	for (i = 0; i < z_info->quest_max; i++)
+		if (g1->p->quests[i].level != g2->p->quests[i].level) return false;
+	if (g1->p->upkeep->arena_level || g2->p->upkeep->arena_level)
+		return false;
+
+	return true;
+}
+
+static void *gen_ahead_run(void *arg)
+{
+	struct gen_context *g = arg;
+
+	/* This thread's game is the generator's player, with no level */
+	Rand_quick = false;
+	player = g->p;
+	cave = NULL;
+
+	gen_level(g);
+
+	mon_alloc_table_free();
+	vformat_kill();
+	return NULL;
+}
+
+/**
+ * Adjust the counts a level is generated against for leaving the level `c`
+ * unkept, as prepare_next_level() will
+ */
+static void gen_counts_leave(struct gen_counts *counts, struct chunk *c,
+							 struct player *p)
+{
+	int i;
+
+	/* Floor artifacts the player doesn't know about can turn up again */
+	for (i = 1; i < c->obj_max; i++) {
+		struct object *obj = c->objects[i];
+		if (!obj || !obj->artifact || obj->held_m_idx) continue;
+		if (loc_is_zero(obj->grid)) continue;
+		if (OPT(p, birth_lose_arts) || (obj->known && obj->known->artifact))
+			continue;
+		counts->created[obj->artifact->aidx] = false;
+	}
+
+	/* So can the monsters, and the unknown artifacts they hold */
+	for (i = 1; i < cave_monster_max(c); i++) {
+		struct monster *mon = cave_monster(c, i);
+		struct object *obj;
+
+		if (!mon->race) continue;
+		counts->cur_num[mon->race->ridx]--;
+		for (obj = mon->held_obj; obj; obj = obj->next)
+			if (obj->artifact && !(obj->known && obj->known->artifact))
+				counts->created[obj->artifact->aidx] = false;
+	}
+}
+#endif
+
+/**
+ * Start generating the level below on another thread, if the player is on a
+ * staircase down, so that it's ready if they take it.
+ *
+ * The level is only used if the game, when the player takes the stairs, is
+ * as it was predicted to be, so it is just the level that would have been
+ * generated then.  Persistent levels, arenas and the town are always
+ * generated when the player gets to them.
+ * \param p is the current player struct, in practice the global player
+ */
+void gen_ahead(struct player *p)
+{
+#ifdef HAVE_PTHREAD
+	struct player *copy;
+	struct gen_context *g;
+
+	if (ahead || !character_dungeon || p->upkeep->generate_level) return;
+	if (OPT(p, birth_levels_persist) || p->upkeep->arena_level) return;
+	if (!p->depth || p->depth >= z_info->max_depth - 1) return;
+	if (!square_isdownstairs(cave, p->grid)) return;
+
+	/* Predict the player's state after taking the stairs */
+	copy = gen_player_copy(p);
+	copy->depth = dungeon_get_next_level(OPT(p, birth_force_descend) ?
+										 p->max_depth : p->depth, 1);
+	copy->upkeep->create_up_stair = true;
+	copy->upkeep->create_down_stair = false;
+
+	/* Predict the game's state after leaving this level */
+	g = gen_context_new(copy, 0, 0);
+	g->ahead = true;
+	gen_counts_leave(&g->start, cave, p);
+
+	if (pthread_create(&ahead_thread, NULL, gen_ahead_run, g)) {
+		gen_context_free(g);
+		return;
+	}
+	ahead = g;
+	ahead_stats.started++;
+#endif
+}
+
+/**
+ * Wait for the level being generated ahead of time, and take it if it's the
+ * one the context `g` would generate
+ */
+static struct gen_context *gen_ahead_take(const struct gen_context *g)
+{
+#ifdef HAVE_PTHREAD
+	struct gen_context *taken = ahead;
+
+	if (!taken) return NULL;
+	pthread_join(ahead_thread, NULL);
+	ahead = NULL;
+
+	if (gen_context_same(taken, g)) {
+		ahead_stats.taken++;
+		return taken;
+	}
+	gen_context_free(taken);
+#endif
+	return NULL;
+}
+
+/**
+ * Stop generating ahead of time, and throw away the level
+ */
+void gen_ahead_cancel(void)
+{
+#ifdef HAVE_PTHREAD
+	if (!ahead) return;
+	pthread_join(ahead_thread, NULL);
+	gen_context_free(ahead);
+	ahead = NULL;
+#endif
+}
+
+/**
+ * How generating ahead of time has gone
+ */
+const struct gen_ahead_stats *gen_ahead_get_stats(void)
+{
+	return &ahead_stats;
+}
+
+
+/**
+ * Generate a random level, or take the one generated ahead of time if it's
+ * the same.
+ * \param p is the current player struct, in practice the global player
+ * \return a pointer to the new level
+ */
+static struct chunk *cave_generate(struct player *p, int min_height,
+								   int min_width)
+{
+	struct gen_context *g = gen_context_new(p, min_height, min_width);
+	struct gen_context *taken;
+	struct chunk *chunk;
+
+	/* Mark the dungeon as being unready (to avoid artifact loss, etc) */
+	character_dungeon = false;
+
+	if (!p->upkeep->arena_level) {
+		/* Get connector info for persistent levels */
+		if (OPT(p, birth_levels_persist)) {
+			get_join_info(p, g);
+		}
+
+		/* The town is rebuilt from the stored one */
+		if (!p->depth) {
+			g->town = chunk_find_name("Town");
+			if (g->town) chunk_list_remove("Town");
+		}
+
+		/* A bit of a hack, but worth it for now NRM */
+		if (p->noscore & NOSCORE_JUMPING) {
+			char name[30] = "";
+
+			/* Cancel the query */
+			p->noscore &= ~(NOSCORE_JUMPING);
+
+			/* Ask debug players for the profile they want */
+			if (get_string("Profile name (eg classic): ", name, sizeof(name)))
+				g->profile = find_cave_profile(name);
+		}
+	}
+
+	taken = gen_ahead_take(g);
+	if (taken) {
+		gen_context_free(g);
+		g = taken;
+	} else {
+		PROFILE_START(GENERATE);
+		gen_level(g);
+		PROFILE_STOP(GENERATE);
+	}
+
+	chunk = gen_adopt(g, p);
+	gen_context_free(g);
+
+	return chunk;
+}
+
 static void sanitize_player_loc(struct chunk *c, struct player *p)
 {
 	/* TODO potential problem: stairs in vaults? */
@@ -1171,6 +1658,9 @@ void prepare_next_level(struct chunk **c, struct player *p)
 {
 	bool persist = OPT(p, birth_levels_persist) || p->upkeep->arena_level;
 
+	/* Making the new level counts towards it */
+	PROFILE_LEVEL(p->depth, turn);
+
 	/* Deal with any existing current level */
 	if (character_dungeon) {
 		assert (p->cave && (*c == cave));
@@ -1179,6 +1669,7 @@ void prepare_next_level(struct chunk **c, struct player *p)
 			/* Arenas don't get stored */
 			if (!(*c)->name || !streq((*c)->name, "arena")) {
 				/* Tidy up */
+				settle_monsters(*c);
 				compact_monsters(0);
 				if (!p->upkeep->arena_level) {
 					/* Leave the player marker if going to an arena */
@@ -1191,7 +1682,7 @@ void prepare_next_level(struct chunk **c, struct player *p)
 			}
 		} else {
 			/* Save the town */
-			if (!((*c)->depth) && !chunk_find_name("Town")) {
+			if (!((*c)->depth) && !chunk_is_stored("Town")) {
 				cave_store(*c, false, false);
 			}
 
@@ -1267,7 +1758,7 @@ void prepare_next_level(struct chunk **c, struct player *p)
 				for (y = 0; y < (*c)->height; y++) {
 					for (x = 0; x < (*c)->width; x++) {
 						struct loc grid = loc(x, y);
-						if (square(*c, grid).mon == -1) {
+						if (square_midx(*c, grid) == -1) {
 							p->grid = grid;
 							found = true;
 							break;
@@ -1328,19 +1819,15 @@ void prepare_next_level(struct chunk **c, struct player *p)
 			/* Check level above */
 			lev = level_by_depth(p->depth - 1);
 			if (lev) {
-				struct chunk *check = chunk_find_name(lev->name);
-				if (check) {
-					get_min_level_size(check, &min_height, &min_width, true);
-				}
+				get_min_level_size(chunk_find_join(lev->name), &min_height,
+								   &min_width, true);
 			}
 
 			/* Check level below */
 			lev = level_by_depth(p->depth + 1);
 			if (lev) {
-				struct chunk *check = chunk_find_name(lev->name);
-				if (check) {
-					get_min_level_size(check, &min_height, &min_width, false);
-				}
+				get_min_level_size(chunk_find_join(lev->name), &min_height,
+								   &min_width, false);
 			}
 
 			/* Generate a new level */
@@ -1356,6 +1843,12 @@ void prepare_next_level(struct chunk **c, struct player *p)
 		cave_known(p);
 	}
 
+	/* Pack away the levels just left, unless they're waiting for the player
+	 * to come back from an arena */
+	if (!p->upkeep->arena_level) {
+		chunk_list_pack();
+	}
+
 	/* The dungeon is ready */
 	character_dungeon = true;
 }
@@ -10,9 +10,9 @@
 #include "monster.h"
 
 #if  __STDC_VERSION__ < 199901L
-#define ROOM_LOG  if (OPT(player, cheat_room)) msg
+#define ROOM_LOG  gen_room_log
 #else
-#define ROOM_LOG(...) if (OPT(player, cheat_room)) msg(__VA_ARGS__);
+#define ROOM_LOG(c, ...) if (OPT(gen_player(c), cheat_room)) gen_msg((c), __VA_ARGS__);
 #endif
 
 /**
@@ -133,6 +133,58 @@ struct dun_data {
 	struct connector *join;
 };
 
+/**
+ * The monster and artifact counts a level is generated against
+ */
+struct gen_counts {
+	int *cur_num;		/*!< Monster population, by race */
+	bool *created;		/*!< Whether each artifact has been made */
+};
+
+/**
+ * Everything generating a level reads from the game or changes in it,
+ * other than the game data, so that a level can be generated away from the
+ * game - ahead of time, on another thread.  Every chunk made while
+ * generating points to it.
+ */
+struct gen_context {
+	/* What the level is generated from */
+	int depth;
+	int min_height;				/*!< Smallest size to fit connecting stairs */
+	int min_width;
+	struct rand_state rng_start;	/*!< The level stream at the start */
+	struct player *p;			/*!< The generator's own copy of the player */
+	bool create_down_stair;		/*!< Stairs the player arrives on, if any */
+	bool create_up_stair;
+	struct gen_counts start;	/*!< The counts at the start */
+	byte *max_num;				/*!< Monster population limit, by race */
+	u16b *thefts;				/*!< Objects stolen, by race */
+	bool seasonal;				/*!< Whether seasonal monsters appear */
+	bool daytime;				/*!< Whether the town is lit */
+	struct connector *join;		/*!< Stairs to connect to persistent levels */
+	struct chunk *town;			/*!< The stored town, until it's copied */
+	const struct cave_profile *profile;	/*!< Profile asked for, if any */
+	bool ahead;					/*!< Whether generating ahead of time */
+
+	/* What generating it changes */
+	struct rand_state rng;		/*!< The level stream */
+	struct gen_counts now;
+	struct dun_data *dun;		/*!< Scratch for the attempt in progress */
+	char **msgs;				/*!< Messages for the player, held back */
+	int msg_num;
+
+	/* The level */
+	struct chunk *chunk;
+};
+
+/**
+ * How generating the next level ahead of time has gone
+ */
+struct gen_ahead_stats {
+	u32b started;		/*!< Levels started ahead of time */
+	u32b taken;			/*!< Levels the player went on to */
+};
+
 
 struct tunnel_profile {
     const char *name;
@@ -156,7 +208,7 @@ struct streamer_profile {
 /*
  * cave_builder is a function pointer which builds a level.
  */
-typedef struct chunk * (*cave_builder) (struct player *p, int h, int w);
+typedef struct chunk * (*cave_builder) (struct gen_context *g, int h, int w);
 
 
 struct cave_profile {
@@ -242,30 +294,54 @@ struct room_template {
     byte tval;			/*!< tval for objects in this room */
 };
 
-extern struct dun_data *dun;
 extern struct vault *vaults;
 extern struct room_template *room_templates;
 
+/* generate.c */
+const struct cave_profile *find_cave_profile(char *name);
+struct chunk *gen_cave_new(struct gen_context *g, int height, int width);
+struct player *gen_player(const struct chunk *c);
+int *gen_cur_num(const struct chunk *c, const struct monster_race *race);
+byte gen_max_num(const struct chunk *c, const struct monster_race *race);
+u16b gen_thefts(const struct chunk *c, const struct monster_race *race);
+bool *gen_created(const struct chunk *c, const struct artifact *art);
+bool gen_seasonal(const struct chunk *c);
+void gen_msg(const struct chunk *c, const char *fmt, ...);
+void gen_room_log(const struct chunk *c, const char *fmt, ...);
+void gen_ahead(struct player *p);
+void gen_ahead_cancel(void);
+const struct gen_ahead_stats *gen_ahead_get_stats(void);
+
 /* gen-cave.c */
-struct chunk *town_gen(struct player *p, int min_height, int min_width);
-struct chunk *classic_gen(struct player *p, int min_height, int min_width);
-struct chunk *labyrinth_gen(struct player *p, int min_height, int min_width);
+struct chunk *town_gen(struct gen_context *g, int min_height, int min_width);
+struct chunk *classic_gen(struct gen_context *g, int min_height, int min_width);
+struct chunk *labyrinth_gen(struct gen_context *g, int min_height,
+							int min_width);
 void ensure_connectedness(struct chunk *c);
-struct chunk *cavern_gen(struct player *p, int min_height, int min_width);
-struct chunk *modified_gen(struct player *p, int min_height, int min_width);
-struct chunk *moria_gen(struct player *p, int min_height, int min_width);
-struct chunk *hard_centre_gen(struct player *p, int min_height, int min_width);
-struct chunk *lair_gen(struct player *p, int min_height, int min_width);
-struct chunk *gauntlet_gen(struct player *p, int min_height, int min_width);
-struct chunk *arena_gen(struct player *p, int min_height, int min_width);
+struct chunk *cavern_gen(struct gen_context *g, int min_height, int min_width);
+struct chunk *modified_gen(struct gen_context *g, int min_height,
+						   int min_width);
+struct chunk *moria_gen(struct gen_context *g, int min_height, int min_width);
+struct chunk *hard_centre_gen(struct gen_context *g, int min_height,
+							  int min_width);
+struct chunk *lair_gen(struct gen_context *g, int min_height, int min_width);
+struct chunk *gauntlet_gen(struct gen_context *g, int min_height,
+						   int min_width);
+struct chunk *arena_gen(struct gen_context *g, int min_height, int min_width);
 
 /* gen-chunk.c */
 struct chunk *chunk_write(struct chunk *c);
 void chunk_list_add(struct chunk *c);
-bool chunk_list_remove(char *name);
-struct chunk *chunk_find_name(char *name);
+void chunk_list_pack(void);
+bool chunk_list_remove(const char *name);
+void chunk_list_free(void);
+const byte *chunk_list_packed(int index, u32b *size);
+bool chunk_is_stored(const char *name);
+struct chunk *chunk_find_name(const char *name);
+struct connector *chunk_find_join(const char *name);
 bool chunk_find(struct chunk *c);
-struct chunk *chunk_find_adjacent(struct player *p, bool above);
+bool chunk_find_depth(int depth);
+bool chunk_find_adjacent(struct player *p, bool above);
 bool chunk_copy(struct chunk *dest, struct chunk *source, int y0, int x0,
 				int rotate, bool reflect);
 
@@ -292,8 +368,8 @@ bool build_circular(struct chunk *c, struct loc centre, int rating);
 bool build_overlap(struct chunk *c, struct loc centre, int rating);
 bool build_crossed(struct chunk *c, struct loc centre, int rating);
 bool build_large(struct chunk *c, struct loc centre, int rating);
-bool mon_pit_hook(struct monster_race *race);
-void set_pit_type(int depth, int type);
+void pit_mon_num_prep(const struct pit_profile *pit);
+void set_pit_type(struct chunk *c, int depth, int type);
 bool build_nest(struct chunk *c, struct loc centre, int rating);
 bool build_pit(struct chunk *c, struct loc centre, int rating);
 bool build_template(struct chunk *c, struct loc centre, int rating);
@@ -338,7 +414,8 @@ void alloc_objects(struct chunk *c, int set, int typ, int num, int depth, byte o
 bool alloc_object(struct chunk *c, int set, int typ, int depth, byte origin);
 
 /* gen-monster.c */
-bool mon_restrict(const char *monster_type, int depth, bool unique_ok);
+bool mon_restrict(struct chunk *c, const char *monster_type, int depth,
+				  bool unique_ok);
 void spread_monsters(struct chunk *c, const char *type, int depth, int num, 
 					 int y0, int x0, int dy, int dx, byte origin);
 void get_vault_monsters(struct chunk *c, char racial_symbol[], char *vault_type,
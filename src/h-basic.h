@@ -176,6 +176,17 @@ typedef uint64_t u64b;
 typedef int64_t s64b;
 
 
+/**
+ * Thread-local storage, for state that a background thread needs its own
+ * copy of; without threads there is only one copy anyway
+ */
+#ifdef HAVE_PTHREAD
+# define THREAD_LOCAL __thread
+#else
+# define THREAD_LOCAL
+#endif
+
+
 /** Debugging macros ***/
 
 #define DSTRINGIFY(x) #x
@@ -35,6 +35,7 @@
 #include "generate.h"
 #include "hint.h"
 #include "init.h"
+#include "mon-group.h"
 #include "mon-init.h"
 #include "mon-list.h"
 #include "mon-lore.h"
@@ -3515,6 +3516,8 @@ static struct init_module arrays_module = {
 
 extern struct init_module z_quark_module;
 extern struct init_module generate_module;
+extern struct init_module view_module;
+extern struct init_module pathfind_module;
 extern struct init_module rune_module;
 extern struct init_module obj_make_module;
 extern struct init_module ignore_module;
@@ -3530,6 +3533,8 @@ static struct init_module *modules[] = {
 	&arrays_module,
 	&player_module,
 	&generate_module,
+	&view_module,
+	&pathfind_module,
 	&rune_module,
 	&obj_make_module,
 	&ignore_module,
@@ -3586,6 +3591,10 @@ bool init_angband(void)
 void cleanup_angband(void)
 {
 	int i;
+
+	/* Nothing may be generating while the game is freed */
+	gen_ahead_cancel();
+
 	for (i = 0; modules[i]; i++)
 		if (modules[i]->cleanup)
 			modules[i]->cleanup();
@@ -3593,10 +3602,7 @@ void cleanup_angband(void)
 	event_remove_all_handlers();
 
 	/* Free the chunk list */
-	for (i = 0; i < chunk_list_max; i++)
-		cave_free(chunk_list[i]);
-	mem_free(chunk_list);
-	chunk_list = NULL;
+	chunk_list_free();
 
 	/* Free the main cave */
 	if (cave) {
@@ -3611,6 +3617,11 @@ void cleanup_angband(void)
 
 	cmdq_flush();
 
+	/* Everything pooled has been freed by now */
+	object_pool_destroy();
+	trap_pool_destroy();
+	monster_group_pools_destroy();
+
 	if (play_again) return;
 
 	/* Free the format() buffer */
@@ -0,0 +1,1328 @@
+/**
+ * \file journal.c
+ * \brief Record the input to a session of play, and play it back
+ *
+ * Copyright (c) 2026 Angband developers
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ *
+ * A journal starts with the savefile the session began from and the state
+ * of the random number generator, followed by a record of everything the UI
+ * did to the game: the commands it queued, its answers to questions from the
+ * game, and the targets and disturbances it caused.  Given the same start,
+ * the game does the same thing with the same input, so playing the records
+ * back reproduces the session without any UI at all.
+ *
+ * Each record belongs to one of three streams, according to when the UI
+ * made it:
+ * - while getting the next command; replayed each time the game asks for
+ *   the next command, and headed by a check that the game is in step
+ * - while handling an event the game signalled, like entering a store;
+ *   replayed when the game signals the same event, counting from the start
+ * - while answering a question from the game; replayed as the answers are
+ *   asked for
+ * so each stream can be replayed in order, independently of the others.
+ */
+
+#include "angband.h"
+#include "cave.h"
+#include "cmd-core.h"
+#include "game-input.h"
+#include "game-world.h"
+#include "journal.h"
+#include "monster.h"
+#include "obj-gear.h"
+#include "player-calcs.h"
+#include "player-util.h"
+#include "store.h"
+#include "target.h"
+
+/**
+ * Increase this when the format changes
+ */
+#define JOURNAL_VERSION		1
+static const char journal_magic[8] = "ANGJRNL";
+
+enum journal_mode {
+	JOURNAL_OFF = 0,
+	JOURNAL_RECORD,
+	JOURNAL_REPLAY
+};
+
+enum journal_stream {
+	STREAM_GET = 0,
+	STREAM_EVENT,
+	STREAM_INPUT,
+	STREAM_MAX,
+	STREAM_NONE = STREAM_MAX	/* Not recorded */
+};
+
+enum journal_record {
+	REC_PHASE = 'P',	/* The next command was asked for */
+	REC_COMMAND = 'C',	/* A command was queued */
+	REC_TARGET = 'T',	/* The target was changed */
+	REC_DISTURB = 'D',	/* The player was disturbed */
+	REC_ANSWER = 'A',	/* A question was answered */
+	REC_BROKEN = 'X'	/* Recording stopped here, as something went wrong */
+};
+
+/**
+ * Longest record the format allows
+ */
+#define REC_MAX		0xFFFF
+
+enum journal_question {
+	ASK_STRING = 0,
+	ASK_QUANTITY,
+	ASK_CHECK,
+	ASK_COM,
+	ASK_REP_DIR,
+	ASK_AIM_DIR,
+	ASK_SPELL_FROM_BOOK,
+	ASK_SPELL,
+	ASK_ITEM,
+	ASK_CURSE,
+	ASK_PANEL,
+	ASK_PANEL_CONTAINS,
+	ASK_MAP_IS_VISIBLE
+};
+
+/**
+ * The journal file name, if the session is to be recorded
+ */
+char *journal_file;
+
+static enum journal_mode mode;
+
+/**
+ * Who has control, with the event serial number the UI is handling if it
+ * has control because of an event
+ */
+static struct {
+	enum journal_control control;
+	u32b at;
+} stack[64];
+static int depth;
+
+static u32b phase;		/* Times the next command has been asked for */
+static u32b serial;		/* Events the game has signalled */
+
+/**
+ * Where each command in the queue came from
+ */
+static struct {
+	enum journal_stream stream;
+	u32b at;
+} queued[CMD_QUEUE_SIZE];
+
+/**
+ * The UI functions a recording passes questions on to
+ */
+static struct {
+	errr (*get_cmd)(cmd_context c);
+	bool (*get_string)(const char *prompt, char *buf, size_t len);
+	int (*get_quantity)(const char *prompt, int max);
+	bool (*get_check)(const char *prompt);
+	bool (*get_com)(const char *prompt, char *command);
+	bool (*get_rep_dir)(int *dir, bool allow_none);
+	bool (*get_aim_dir)(int *dir);
+	int (*get_spell_from_book)(const char *verb, struct object *book,
+							   const char *error,
+							   bool (*spell_filter)(int spell));
+	int (*get_spell)(const char *verb, item_tester book_filter, cmd_code cmd,
+					 const char *error, bool (*spell_filter)(int spell));
+	bool (*get_item)(struct object **choice, const char *pmt, const char *str,
+					 cmd_code cmd, item_tester tester, int mode);
+	bool (*get_curse)(int *choice, struct object *obj, char *dice_string);
+	void (*get_panel)(int *min_y, int *min_x, int *max_y, int *max_x);
+	bool (*panel_contains)(unsigned int y, unsigned int x);
+	bool (*map_is_visible)(void);
+} ui;
+
+/**
+ * Recording; a record too long to write breaks the journal, and nothing more
+ * is written to it
+ */
+static ang_file *out;
+static byte *rec_buf;
+static size_t rec_size;
+static size_t rec_len;
+static bool rec_broken;
+
+/**
+ * Replaying
+ */
+static byte *data;
+static size_t data_len;
+static size_t start;				/* Offset of the first record */
+static size_t cursor[STREAM_MAX];	/* Offset of the next record to look at */
+static const byte *rd_pos, *rd_end;	/* Payload being read */
+static struct journal_stats stats;
+
+/**
+ * ------------------------------------------------------------------------
+ * Writing records
+ * ------------------------------------------------------------------------ */
+static void put_byte(byte b)
+{
+	if (rec_len == REC_MAX) {
+		rec_broken = true;
+		return;
+	}
+	if (rec_len == rec_size) {
+		rec_size = rec_size ? MIN(2 * rec_size, REC_MAX) : 256;
+		rec_buf = mem_realloc(rec_buf, rec_size);
+	}
+	rec_buf[rec_len++] = b;
+}
+
+static void put_u16(u16b v)
+{
+	put_byte((byte)(v & 0xFF));
+	put_byte((byte)(v >> 8));
+}
+
+static void put_u32(u32b v)
+{
+	put_u16((u16b)(v & 0xFFFF));
+	put_u16((u16b)(v >> 16));
+}
+
+static void put_string(const char *s)
+{
+	size_t len = s ? strlen(s) : 0;
+	put_u16((u16b)len);
+	while (len--)
+		put_byte((byte)*s++);
+}
+
+/**
+ * Record the object as where it can be found
+ */
+static void put_object(const struct object *obj)
+{
+	const struct object *o;
+	u16b i;
+	int s;
+
+	if (!obj) {
+		put_byte('n');
+		return;
+	}
+
+	for (o = player->gear, i = 0; o; o = o->next, i++) {
+		if (o != obj) continue;
+		put_byte('g');
+		put_u16(i);
+		return;
+	}
+
+	if (square_in_bounds(cave, obj->grid)) {
+		for (o = square_object(cave, obj->grid), i = 0; o; o = o->next, i++) {
+			if (o != obj) continue;
+			put_byte('f');
+			put_u16((u16b)obj->grid.x);
+			put_u16((u16b)obj->grid.y);
+			put_u16(i);
+			return;
+		}
+	}
+
+	for (s = 0; s < MAX_STORES; s++) {
+		for (o = stores[s].stock, i = 0; o; o = o->next, i++) {
+			if (o != obj) continue;
+			put_byte('s');
+			put_byte((byte)s);
+			put_u16(i);
+			return;
+		}
+	}
+
+	put_byte('n');
+}
+
+/**
+ * Start a record
+ */
+static void rec_begin(void)
+{
+	rec_len = 0;
+}
+
+/**
+ * Write a record to a stream, with the event it belongs to
+ */
+static void rec_write(enum journal_record kind, enum journal_stream stream,
+					  u32b at)
+{
+	byte head[8];
+	size_t n = 0;
+
+	if (!out) return;
+
+	/* Mark where the journal stops being a true record of the session */
+	if (rec_broken) {
+		head[n++] = (byte)REC_BROKEN;
+		head[n++] = (byte)STREAM_GET;
+		head[n++] = 0;
+		head[n++] = 0;
+		file_write(out, (const char *)head, n);
+		file_close(out);
+		out = NULL;
+		msg("The journal could not record that, and has been stopped.");
+		return;
+	}
+
+	head[n++] = (byte)kind;
+	head[n++] = (byte)stream;
+	if (stream == STREAM_EVENT) {
+		head[n++] = (byte)(at & 0xFF);
+		head[n++] = (byte)((at >> 8) & 0xFF);
+		head[n++] = (byte)((at >> 16) & 0xFF);
+		head[n++] = (byte)(at >> 24);
+	}
+	head[n++] = (byte)(rec_len & 0xFF);
+	head[n++] = (byte)(rec_len >> 8);
+
+	file_write(out, (const char *)head, n);
+	file_write(out, (const char *)rec_buf, rec_len);
+}
+
+/**
+ * Write a record to the stream for whatever the UI is doing
+ */
+static void rec_write_ui(enum journal_record kind)
+{
+	switch (stack[depth].control) {
+		case JOURNAL_GET: rec_write(kind, STREAM_GET, 0); break;
+		case JOURNAL_EVENT: rec_write(kind, STREAM_EVENT, stack[depth].at);
+			break;
+		default: rec_write(kind, STREAM_INPUT, 0); break;
+	}
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * Reading records
+ * ------------------------------------------------------------------------ */
+struct record {
+	enum journal_record kind;
+	enum journal_stream stream;
+	u32b at;
+	const byte *payload;
+	size_t len;
+	size_t end;
+};
+
+static bool rec_parse(size_t pos, struct record *rec)
+{
+	const byte *p = data + pos;
+	size_t head = 4;
+
+	if (pos + 2 > data_len) return false;
+	rec->kind = p[0];
+	rec->stream = p[1];
+	if (rec->stream >= STREAM_MAX) return false;
+	rec->at = 0;
+	if (rec->stream == STREAM_EVENT) {
+		if (pos + 6 > data_len) return false;
+		rec->at = p[2] | (p[3] << 8) | (p[4] << 16) | ((u32b)p[5] << 24);
+		head += 4;
+	}
+	if (pos + head > data_len) return false;
+	rec->len = p[head - 2] | (p[head - 1] << 8);
+	rec->payload = p + head;
+	rec->end = pos + head + rec->len;
+	return rec->end <= data_len;
+}
+
+static void replay_fail(const char *why);
+
+/**
+ * Find the next record in a stream, without using it up
+ */
+static bool rec_next(enum journal_stream stream, struct record *rec)
+{
+	size_t pos = cursor[stream];
+
+	while (rec_parse(pos, rec)) {
+		if (rec->kind == REC_BROKEN) {
+			replay_fail("the journal was broken off while recording");
+			break;
+		}
+		if (rec->stream == stream) {
+			cursor[stream] = pos;
+			rd_pos = rec->payload;
+			rd_end = rec->payload + rec->len;
+			return true;
+		}
+		pos = rec->end;
+	}
+
+	cursor[stream] = data_len;
+	return false;
+}
+
+static void rec_used(const struct record *rec)
+{
+	cursor[rec->stream] = rec->end;
+}
+
+static byte rd_byte(void)
+{
+	return (rd_pos < rd_end) ? *rd_pos++ : 0;
+}
+
+static u16b rd_u16(void)
+{
+	u16b v = rd_byte();
+	return v | (rd_byte() << 8);
+}
+
+static u32b rd_u32(void)
+{
+	u32b v = rd_u16();
+	return v | ((u32b)rd_u16() << 16);
+}
+
+static void rd_string(char *buf, size_t len)
+{
+	size_t n = rd_u16(), i;
+
+	for (i = 0; i < n; i++) {
+		byte b = rd_byte();
+		if (i + 1 < len) buf[i] = (char)b;
+	}
+	if (len) buf[MIN(n, len - 1)] = '\0';
+}
+
+static struct object *rd_object(void)
+{
+	struct object *obj = NULL;
+	int i;
+
+	switch (rd_byte()) {
+		case 'g': {
+			obj = player->gear;
+			break;
+		}
+		case 'f': {
+			struct loc grid;
+			grid.x = (s16b)rd_u16();
+			grid.y = (s16b)rd_u16();
+			if (square_in_bounds(cave, grid))
+				obj = square_object(cave, grid);
+			break;
+		}
+		case 's': {
+			int s = rd_byte();
+			if (s < MAX_STORES)
+				obj = stores[s].stock;
+			break;
+		}
+		default: return NULL;
+	}
+
+	for (i = rd_u16(); obj && i; i--)
+		obj = obj->next;
+	return obj;
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * Who has control
+ * ------------------------------------------------------------------------ */
+/**
+ * Note that control has passed to the game or the UI, until journal_leave()
+ */
+void journal_enter(enum journal_control control)
+{
+	assert(depth + 1 < (int)N_ELEMENTS(stack));
+	depth++;
+	stack[depth].control = control;
+	stack[depth].at = stack[depth - 1].at;
+}
+
+/**
+ * Hand control back to whoever had it before journal_enter()
+ */
+void journal_leave(void)
+{
+	assert(depth > 0);
+	depth--;
+}
+
+/**
+ * Stop the replay, as the game has gone out of step with the journal
+ */
+static void replay_fail(const char *why)
+{
+	if (!stats.error)
+		stats.error = why;
+	player->upkeep->playing = false;
+}
+
+static void replay_command(enum journal_stream stream);
+static void replay_other(const struct record *rec);
+
+/**
+ * Note that the game is signalling an event, and pass control to whatever
+ * handles it until journal_leave()
+ */
+void journal_event(void)
+{
+	if ((mode == JOURNAL_OFF) || (stack[depth].control != JOURNAL_GAME)) {
+		journal_enter(stack[depth].control);
+		return;
+	}
+
+	serial++;
+	journal_enter(JOURNAL_EVENT);
+	stack[depth].at = serial;
+
+	/* Do whatever the UI did when it saw this event */
+	if (mode == JOURNAL_REPLAY) {
+		struct record rec;
+		u32b at = serial;
+		while (!stats.error && rec_next(STREAM_EVENT, &rec) && (rec.at == at)) {
+			if (rec.kind == REC_COMMAND)
+				replay_command(STREAM_EVENT);
+			else
+				replay_other(&rec);
+		}
+	}
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * Commands, targets and disturbance
+ * ------------------------------------------------------------------------ */
+/**
+ * Note where the command in queue slot 'slot' came from
+ */
+void journal_note_push(int slot)
+{
+	queued[slot].stream = STREAM_NONE;
+	if (mode != JOURNAL_RECORD) return;
+
+	switch (stack[depth].control) {
+		case JOURNAL_GET: queued[slot].stream = STREAM_GET; break;
+		case JOURNAL_EVENT: queued[slot].stream = STREAM_EVENT; break;
+		default: return;
+	}
+	queued[slot].at = stack[depth].at;
+}
+
+/**
+ * Record a command from queue slot 'slot' as it is about to be carried out,
+ * if the UI queued it
+ */
+void journal_note_pop(int slot, struct command *cmd, cmd_context ctx)
+{
+	int i, n = 0;
+
+	if ((mode != JOURNAL_RECORD) || (queued[slot].stream == STREAM_NONE))
+		return;
+
+	rec_begin();
+
+	/* Whether the UI carried it out straight away, and in what context */
+	put_byte((stack[depth].control == JOURNAL_GAME) ? 0 : (byte)(ctx + 1));
+	put_u16((u16b)cmd->code);
+	put_u16((u16b)cmd->nrepeats);
+
+	for (i = 0; i < CMD_MAX_ARGS; i++)
+		if (cmd->arg[i].name[0]) n++;
+	put_byte((byte)n);
+
+	for (i = 0; i < CMD_MAX_ARGS; i++) {
+		struct cmd_arg *arg = &cmd->arg[i];
+		if (!arg->name[0]) continue;
+
+		put_string(arg->name);
+		put_byte((byte)arg->type);
+		switch (arg->type) {
+			case arg_STRING: put_string(arg->data.string); break;
+			case arg_CHOICE: put_u32((u32b)arg->data.choice); break;
+			case arg_ITEM: put_object(arg->data.obj); break;
+			case arg_NUMBER: put_u32((u32b)arg->data.number); break;
+			case arg_DIRECTION:
+			case arg_TARGET: put_u32((u32b)arg->data.direction); break;
+			case arg_POINT: {
+				put_u16((u16b)arg->data.point.x);
+				put_u16((u16b)arg->data.point.y);
+				break;
+			}
+			default: break;
+		}
+	}
+
+	rec_write(REC_COMMAND, queued[slot].stream, queued[slot].at);
+	queued[slot].stream = STREAM_NONE;
+}
+
+/**
+ * Queue the next command in a stream, and carry it out if the UI did
+ */
+static void replay_command(enum journal_stream stream)
+{
+	struct command cmd;
+	struct record rec;
+	byte now;
+	int i, n;
+
+	if (!rec_next(stream, &rec)) return;
+	rec_used(&rec);
+
+	memset(&cmd, 0, sizeof(cmd));
+	now = rd_byte();
+	cmd.code = rd_u16();
+	cmd.nrepeats = (s16b)rd_u16();
+
+	n = rd_byte();
+	for (i = 0; i < n; i++) {
+		char name[20], str[1024];
+		enum cmd_arg_type type;
+
+		rd_string(name, sizeof(name));
+		type = rd_byte();
+		switch (type) {
+			case arg_STRING: {
+				rd_string(str, sizeof(str));
+				cmd_set_arg_string(&cmd, name, str);
+				break;
+			}
+			case arg_CHOICE:
+				cmd_set_arg_choice(&cmd, name, (s32b)rd_u32());
+				break;
+			case arg_ITEM: cmd_set_arg_item(&cmd, name, rd_object()); break;
+			case arg_NUMBER:
+				cmd_set_arg_number(&cmd, name, (s32b)rd_u32());
+				break;
+			case arg_DIRECTION:
+				cmd_set_arg_direction(&cmd, name, (s32b)rd_u32());
+				break;
+			case arg_TARGET:
+				cmd_set_arg_target(&cmd, name, (s32b)rd_u32());
+				break;
+			case arg_POINT: {
+				int x = (s16b)rd_u16();
+				cmd_set_arg_point(&cmd, name, x, (s16b)rd_u16());
+				break;
+			}
+			default: break;
+		}
+	}
+
+	stats.commands++;
+	if (cmdq_push_copy(&cmd)) {
+		replay_fail("command queue full");
+		return;
+	}
+	if (now)
+		cmdq_pop(now - 1);
+}
+
+/**
+ * Record a change of target made by the UI
+ */
+void journal_note_target(void)
+{
+	struct monster *mon;
+	struct loc grid;
+
+	if ((mode != JOURNAL_RECORD) || (stack[depth].control == JOURNAL_GAME))
+		return;
+
+	mon = target_get_monster();
+	target_get(&grid);
+	rec_begin();
+	put_byte(target_is_set() ? 1 : 0);
+	put_u16(mon ? (u16b)mon->midx : 0);
+	put_u16((u16b)grid.x);
+	put_u16((u16b)grid.y);
+	rec_write_ui(REC_TARGET);
+}
+
+/**
+ * Record disturbance caused by the UI
+ */
+void journal_note_disturb(int stop_search)
+{
+	if ((mode != JOURNAL_RECORD) || (stack[depth].control == JOURNAL_GAME))
+		return;
+
+	rec_begin();
+	put_u32((u32b)stop_search);
+	rec_write_ui(REC_DISTURB);
+}
+
+/**
+ * Replay a change of target or a disturbance
+ */
+static void replay_other(const struct record *rec)
+{
+	rec_used(rec);
+	if (rec->kind == REC_TARGET) {
+		bool set = rd_byte();
+		int midx = rd_u16();
+		int x = (s16b)rd_u16();
+		int y = (s16b)rd_u16();
+
+		if (!set)
+			target_set_monster(NULL);
+		else if (midx > 0 && midx < cave_monster_max(cave))
+			target_set_monster(cave_monster(cave, midx));
+		else
+			target_set_location(y, x);
+	} else if (rec->kind == REC_DISTURB) {
+		disturb(player, (s32b)rd_u32());
+	} else {
+		replay_fail("unexpected record");
+	}
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * Getting the next command
+ * ------------------------------------------------------------------------ */
+/**
+ * Record how things stand when the next command is asked for, so a replay
+ * can tell if it has gone out of step
+ */
+static void put_phase(void)
+{
+	put_u32((u32b)turn);
+	put_u16((u16b)player->grid.x);
+	put_u16((u16b)player->grid.y);
+	put_u16((u16b)player->chp);
+	put_u32(state_i);
+	put_u32(STATE[state_i]);
+}
+
+static errr record_get_cmd(cmd_context c)
+{
+	errr result;
+
+	phase++;
+	rec_begin();
+	put_phase();
+	rec_write(REC_PHASE, STREAM_GET, 0);
+
+	journal_enter(JOURNAL_GET);
+	result = ui.get_cmd(c);
+	journal_leave();
+
+	return result;
+}
+
+static errr replay_get_cmd(cmd_context c)
+{
+	struct record rec;
+
+	if (stats.error) return 1;
+
+	phase++;
+	if (!rec_next(STREAM_GET, &rec)) {
+		stats.finished = true;
+		player->upkeep->playing = false;
+		return 1;
+	}
+
+	/* Check the game is where it was */
+	rec_begin();
+	put_phase();
+	if ((rec.kind != REC_PHASE) || (rec.len != rec_len) ||
+		memcmp(rec.payload, rec_buf, rec_len)) {
+		replay_fail(format("out of step when asked for command %lu",
+						   (unsigned long)phase));
+		return 1;
+	}
+	rec_used(&rec);
+	stats.phases++;
+
+	/* The UI stopped the game here */
+	if (!rec_next(STREAM_GET, &rec)) {
+		stats.finished = true;
+		player->upkeep->playing = false;
+		return 1;
+	}
+
+	/* Do what the UI did */
+	journal_enter(JOURNAL_GET);
+	while (!stats.error && rec_next(STREAM_GET, &rec) &&
+		   (rec.kind != REC_PHASE)) {
+		if (rec.kind == REC_COMMAND)
+			replay_command(STREAM_GET);
+		else
+			replay_other(&rec);
+	}
+	journal_leave();
+
+	return 0;
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * Questions from the game
+ * ------------------------------------------------------------------------ */
+/**
+ * Pass a question on to the UI if recording.  Questions the UI asks itself
+ * go straight through.
+ */
+#define RECORD_QUESTION(result, call) \
+	do { \
+		if (stack[depth].control != JOURNAL_GAME) return call; \
+		journal_enter(JOURNAL_INPUT); \
+		result = call; \
+		journal_leave(); \
+		rec_begin(); \
+	} while (0)
+
+static void record_answer(enum journal_question question)
+{
+	size_t len = rec_len;
+
+	/* Put the question first */
+	put_byte((byte)question);
+	if (!rec_broken) {
+		memmove(rec_buf + 1, rec_buf, len);
+		rec_buf[0] = (byte)question;
+	}
+	rec_write(REC_ANSWER, STREAM_INPUT, 0);
+}
+
+/**
+ * Get ready to read the answer to a question, after replaying any changes
+ * of target or disturbance the UI made while answering
+ */
+static bool replay_answer(enum journal_question question)
+{
+	struct record rec;
+
+	while (!stats.error && rec_next(STREAM_INPUT, &rec)) {
+		if (rec.kind != REC_ANSWER) {
+			replay_other(&rec);
+			continue;
+		}
+		if (rd_byte() != question) break;
+		rec_used(&rec);
+		return true;
+	}
+
+	replay_fail("unexpected question");
+	return false;
+}
+
+static bool record_get_string(const char *prompt, char *buf, size_t len)
+{
+	bool result;
+	RECORD_QUESTION(result, ui.get_string ?
+							 ui.get_string(prompt, buf, len) : false);
+	put_byte(result);
+	put_string(result ? buf : "");
+	record_answer(ASK_STRING);
+	return result;
+}
+
+static bool replay_get_string(const char *prompt, char *buf, size_t len)
+{
+	bool result;
+	if (!replay_answer(ASK_STRING)) return false;
+	result = rd_byte();
+	rd_string(buf, len);
+	return result;
+}
+
+static int record_get_quantity(const char *prompt, int max)
+{
+	int result;
+	RECORD_QUESTION(result, ui.get_quantity ?
+							 ui.get_quantity(prompt, max) : 0);
+	put_u32((u32b)result);
+	record_answer(ASK_QUANTITY);
+	return result;
+}
+
+static int replay_get_quantity(const char *prompt, int max)
+{
+	return replay_answer(ASK_QUANTITY) ? (s32b)rd_u32() : 0;
+}
+
+static bool record_get_check(const char *prompt)
+{
+	bool result;
+	RECORD_QUESTION(result, ui.get_check ? ui.get_check(prompt) : false);
+	put_byte(result);
+	record_answer(ASK_CHECK);
+	return result;
+}
+
+static bool replay_get_check(const char *prompt)
+{
+	return replay_answer(ASK_CHECK) ? rd_byte() : false;
+}
+
+static bool record_get_com(const char *prompt, char *command)
+{
+	bool result;
+	RECORD_QUESTION(result, ui.get_com ?
+							 ui.get_com(prompt, command) : false);
+	put_byte(result);
+	put_byte((byte)*command);
+	record_answer(ASK_COM);
+	return result;
+}
+
+static bool replay_get_com(const char *prompt, char *command)
+{
+	bool result;
+	if (!replay_answer(ASK_COM)) return false;
+	result = rd_byte();
+	*command = (char)rd_byte();
+	return result;
+}
+
+static bool record_get_rep_dir(int *dir, bool allow_none)
+{
+	bool result;
+	RECORD_QUESTION(result, ui.get_rep_dir ?
+							 ui.get_rep_dir(dir, allow_none) : false);
+	put_byte(result);
+	put_u32((u32b)*dir);
+	record_answer(ASK_REP_DIR);
+	return result;
+}
+
+static bool replay_get_rep_dir(int *dir, bool allow_none)
+{
+	bool result;
+	if (!replay_answer(ASK_REP_DIR)) return false;
+	result = rd_byte();
+	*dir = (s32b)rd_u32();
+	return result;
+}
+
+static bool record_get_aim_dir(int *dir)
+{
+	bool result;
+	RECORD_QUESTION(result, ui.get_aim_dir ? ui.get_aim_dir(dir) : false);
+	put_byte(result);
+	put_u32((u32b)*dir);
+	record_answer(ASK_AIM_DIR);
+	return result;
+}
+
+static bool replay_get_aim_dir(int *dir)
+{
+	bool result;
+	if (!replay_answer(ASK_AIM_DIR)) return false;
+	result = rd_byte();
+	*dir = (s32b)rd_u32();
+	return result;
+}
+
+static int record_get_spell_from_book(const char *verb, struct object *book,
+									  const char *error,
+									  bool (*spell_filter)(int spell))
+{
+	int result;
+	RECORD_QUESTION(result, ui.get_spell_from_book ?
+							 ui.get_spell_from_book(verb, book, error,
+													spell_filter) : -1);
+	put_u32((u32b)result);
+	record_answer(ASK_SPELL_FROM_BOOK);
+	return result;
+}
+
+static int replay_get_spell_from_book(const char *verb, struct object *book,
+									  const char *error,
+									  bool (*spell_filter)(int spell))
+{
+	return replay_answer(ASK_SPELL_FROM_BOOK) ? (s32b)rd_u32() : -1;
+}
+
+static int record_get_spell(const char *verb, item_tester book_filter,
+							cmd_code cmd, const char *error,
+							bool (*spell_filter)(int spell))
+{
+	int result;
+	RECORD_QUESTION(result, ui.get_spell ?
+							 ui.get_spell(verb, book_filter, cmd, error,
+										  spell_filter) : -1);
+	put_u32((u32b)result);
+	record_answer(ASK_SPELL);
+	return result;
+}
+
+static int replay_get_spell(const char *verb, item_tester book_filter,
+							cmd_code cmd, const char *error,
+							bool (*spell_filter)(int spell))
+{
+	return replay_answer(ASK_SPELL) ? (s32b)rd_u32() : -1;
+}
+
+static bool record_get_item(struct object **choice, const char *pmt,
+							const char *str, cmd_code cmd, item_tester tester,
+							int mode)
+{
+	bool result;
+	RECORD_QUESTION(result, ui.get_item ?
+							 ui.get_item(choice, pmt, str, cmd, tester, mode) :
+							 false);
+	put_byte(result);
+	put_object(result ? *choice : NULL);
+	record_answer(ASK_ITEM);
+	return result;
+}
+
+static bool replay_get_item(struct object **choice, const char *pmt,
+							const char *str, cmd_code cmd, item_tester tester,
+							int mode)
+{
+	bool result;
+	if (!replay_answer(ASK_ITEM)) return false;
+	result = rd_byte();
+	*choice = rd_object();
+	return result;
+}
+
+static bool record_get_curse(int *choice, struct object *obj,
+							 char *dice_string)
+{
+	bool result;
+	RECORD_QUESTION(result, ui.get_curse ?
+							 ui.get_curse(choice, obj, dice_string) : false);
+	put_byte(result);
+	put_u32((u32b)*choice);
+	record_answer(ASK_CURSE);
+	return result;
+}
+
+static bool replay_get_curse(int *choice, struct object *obj,
+							 char *dice_string)
+{
+	bool result;
+	if (!replay_answer(ASK_CURSE)) return false;
+	result = rd_byte();
+	*choice = (s32b)rd_u32();
+	return result;
+}
+
+static void record_get_panel(int *min_y, int *min_x, int *max_y, int *max_x)
+{
+	if (stack[depth].control != JOURNAL_GAME) {
+		if (ui.get_panel) ui.get_panel(min_y, min_x, max_y, max_x);
+		return;
+	}
+	journal_enter(JOURNAL_INPUT);
+	if (ui.get_panel) ui.get_panel(min_y, min_x, max_y, max_x);
+	journal_leave();
+	rec_begin();
+	put_u32((u32b)*min_y);
+	put_u32((u32b)*min_x);
+	put_u32((u32b)*max_y);
+	put_u32((u32b)*max_x);
+	record_answer(ASK_PANEL);
+}
+
+static void replay_get_panel(int *min_y, int *min_x, int *max_y, int *max_x)
+{
+	if (!replay_answer(ASK_PANEL)) return;
+	*min_y = (s32b)rd_u32();
+	*min_x = (s32b)rd_u32();
+	*max_y = (s32b)rd_u32();
+	*max_x = (s32b)rd_u32();
+}
+
+static bool record_panel_contains(unsigned int y, unsigned int x)
+{
+	bool result;
+	RECORD_QUESTION(result, ui.panel_contains ?
+							 ui.panel_contains(y, x) : true);
+	put_byte(result);
+	record_answer(ASK_PANEL_CONTAINS);
+	return result;
+}
+
+static bool replay_panel_contains(unsigned int y, unsigned int x)
+{
+	return replay_answer(ASK_PANEL_CONTAINS) ? rd_byte() : false;
+}
+
+static bool record_map_is_visible(void)
+{
+	bool result;
+	RECORD_QUESTION(result, ui.map_is_visible ?
+							 ui.map_is_visible() : true);
+	put_byte(result);
+	record_answer(ASK_MAP_IS_VISIBLE);
+	return result;
+}
+
+static bool replay_map_is_visible(void)
+{
+	return replay_answer(ASK_MAP_IS_VISIBLE) ? rd_byte() : false;
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * Starting and stopping
+ * ------------------------------------------------------------------------ */
+static void save_hooks(void)
+{
+	ui.get_cmd = cmd_get_hook;
+	ui.get_string = get_string_hook;
+	ui.get_quantity = get_quantity_hook;
+	ui.get_check = get_check_hook;
+	ui.get_com = get_com_hook;
+	ui.get_rep_dir = get_rep_dir_hook;
+	ui.get_aim_dir = get_aim_dir_hook;
+	ui.get_spell_from_book = get_spell_from_book_hook;
+	ui.get_spell = get_spell_hook;
+	ui.get_item = get_item_hook;
+	ui.get_curse = get_curse_hook;
+	ui.get_panel = get_panel_hook;
+	ui.panel_contains = panel_contains_hook;
+	ui.map_is_visible = map_is_visible_hook;
+}
+
+static void restore_hooks(void)
+{
+	cmd_get_hook = ui.get_cmd;
+	get_string_hook = ui.get_string;
+	get_quantity_hook = ui.get_quantity;
+	get_check_hook = ui.get_check;
+	get_com_hook = ui.get_com;
+	get_rep_dir_hook = ui.get_rep_dir;
+	get_aim_dir_hook = ui.get_aim_dir;
+	get_spell_from_book_hook = ui.get_spell_from_book;
+	get_spell_hook = ui.get_spell;
+	get_item_hook = ui.get_item;
+	get_curse_hook = ui.get_curse;
+	get_panel_hook = ui.get_panel;
+	panel_contains_hook = ui.panel_contains;
+	map_is_visible_hook = ui.map_is_visible;
+}
+
+/**
+ * Bring the player up to date, so a replay starts from the same place as the
+ * recording whatever was pending when the savefile was loaded, and whatever
+ * the UI is showing
+ */
+static void settle(void)
+{
+	bool (*visible)(void) = map_is_visible_hook;
+
+	map_is_visible_hook = NULL;
+	notice_stuff(player);
+	handle_stuff(player);
+	map_is_visible_hook = visible;
+}
+
+static void reset(enum journal_mode new_mode)
+{
+	mode = new_mode;
+	depth = 0;
+	stack[0].control = JOURNAL_GAME;
+	stack[0].at = 0;
+	phase = 0;
+	serial = 0;
+	memset(queued, 0, sizeof(queued));
+	memset(&stats, 0, sizeof(stats));
+}
+
+/**
+ * Start recording to the journal 'path', from the savefile at 'save_path'
+ * as it was when the session started and the random number generator as
+ * it is now.
+ */
+bool journal_record_start(const char *path, const char *save_path)
+{
+	ang_file *save = file_open(save_path, MODE_READ, FTYPE_SAVE);
+	char buf[4096];
+	u32b save_len = 0;
+	int i, n;
+
+	if (!save) return false;
+	while ((n = file_read(save, buf, sizeof(buf))) > 0)
+		save_len += n;
+	file_close(save);
+
+	settle();
+
+	out = file_open(path, MODE_WRITE, FTYPE_RAW);
+	if (!out) return false;
+
+	/* Header */
+	file_write(out, journal_magic, sizeof(journal_magic));
+	rec_broken = false;
+	rec_begin();
+	put_u32(JOURNAL_VERSION);
+	put_u32(Rand_value);
+	put_u32(state_i);
+	put_u32(z0);
+	put_u32(z1);
+	put_u32(z2);
+	for (i = 0; i < RAND_DEG; i++)
+		put_u32(STATE[i]);
+	put_u32(save_len);
+	file_write(out, (const char *)rec_buf, rec_len);
+
+	/* The savefile */
+	save = file_open(save_path, MODE_READ, FTYPE_SAVE);
+	while (save && (n = file_read(save, buf, sizeof(buf))) > 0)
+		file_write(out, buf, n);
+	if (save) file_close(save);
+
+	reset(JOURNAL_RECORD);
+	save_hooks();
+	cmd_get_hook = record_get_cmd;
+	get_string_hook = record_get_string;
+	get_quantity_hook = record_get_quantity;
+	get_check_hook = record_get_check;
+	get_com_hook = record_get_com;
+	get_rep_dir_hook = record_get_rep_dir;
+	get_aim_dir_hook = record_get_aim_dir;
+	get_spell_from_book_hook = record_get_spell_from_book;
+	get_spell_hook = record_get_spell;
+	get_item_hook = record_get_item;
+	get_curse_hook = record_get_curse;
+	get_panel_hook = record_get_panel;
+	panel_contains_hook = record_panel_contains;
+	map_is_visible_hook = record_map_is_visible;
+
+	return true;
+}
+
+/**
+ * Read the journal 'path', and write the savefile it starts from to
+ * 'save_path'
+ */
+bool journal_replay_open(const char *path, const char *save_path)
+{
+	ang_file *f = file_open(path, MODE_READ, FTYPE_RAW);
+	ang_file *save;
+	size_t size = 0;
+	u32b save_len;
+	int n;
+
+	if (!f) return false;
+
+	/* Read it all */
+	mem_free(data);
+	data_len = 0;
+	data = NULL;
+	do {
+		if (data_len == size) {
+			size = size ? 2 * size : 65536;
+			data = mem_realloc(data, size);
+		}
+		n = file_read(f, (char *)data + data_len, size - data_len);
+		if (n > 0) data_len += n;
+	} while (n > 0);
+	file_close(f);
+
+	/* Check the header */
+	start = sizeof(journal_magic) + 4 * (7 + RAND_DEG);
+	if ((data_len < start) ||
+		memcmp(data, journal_magic, sizeof(journal_magic)))
+		return false;
+	rd_pos = data + sizeof(journal_magic);
+	rd_end = data + start;
+	if (rd_u32() != JOURNAL_VERSION) return false;
+	rd_pos = data + start - 4;
+	save_len = rd_u32();
+	if (start + save_len > data_len) return false;
+
+	if (file_exists(save_path))
+		file_delete(save_path);
+	save = file_open(save_path, MODE_WRITE, FTYPE_SAVE);
+	if (!save) return false;
+	file_write(save, (const char *)data + start, save_len);
+	file_close(save);
+	start += save_len;
+
+	return true;
+}
+
+/**
+ * Start replaying the journal read by journal_replay_open(), once the
+ * savefile has been loaded and the level entered
+ */
+void journal_replay_start(void)
+{
+	int i;
+
+	settle();
+	reset(JOURNAL_REPLAY);
+	for (i = 0; i < STREAM_MAX; i++)
+		cursor[i] = start;
+
+	/* Put the random number generator as it was */
+	rd_pos = data + sizeof(journal_magic) + 4;
+	rd_end = data + start;
+	Rand_quick = false;
+	Rand_value = rd_u32();
+	state_i = rd_u32();
+	z0 = rd_u32();
+	z1 = rd_u32();
+	z2 = rd_u32();
+	for (i = 0; i < RAND_DEG; i++)
+		STATE[i] = rd_u32();
+
+	save_hooks();
+	cmd_get_hook = replay_get_cmd;
+	get_string_hook = replay_get_string;
+	get_quantity_hook = replay_get_quantity;
+	get_check_hook = replay_get_check;
+	get_com_hook = replay_get_com;
+	get_rep_dir_hook = replay_get_rep_dir;
+	get_aim_dir_hook = replay_get_aim_dir;
+	get_spell_from_book_hook = replay_get_spell_from_book;
+	get_spell_hook = replay_get_spell;
+	get_item_hook = replay_get_item;
+	get_curse_hook = replay_get_curse;
+	get_panel_hook = replay_get_panel;
+	panel_contains_hook = replay_panel_contains;
+	map_is_visible_hook = replay_map_is_visible;
+}
+
+/**
+ * Stop recording or replaying
+ */
+void journal_stop(void)
+{
+	if (mode == JOURNAL_OFF) return;
+
+	restore_hooks();
+	if (out) {
+		file_close(out);
+		out = NULL;
+	}
+	mem_free(rec_buf);
+	rec_buf = NULL;
+	rec_size = 0;
+	rec_broken = false;
+	mem_free(data);
+	data = NULL;
+	data_len = 0;
+	mode = JOURNAL_OFF;
+}
+
+/**
+ * What has happened in the replay so far
+ */
+const struct journal_stats *journal_replay_stats(void)
+{
+	return &stats;
+}
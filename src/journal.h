@@ -0,0 +1,62 @@
+/**
+ * \file journal.h
+ * \brief Record the input to a session of play, and play it back
+ *
+ * Copyright (c) 2026 Angband developers
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+
+#ifndef INCLUDED_JOURNAL_H
+#define INCLUDED_JOURNAL_H
+
+#include "cmd-core.h"
+
+/**
+ * Who has control, as far as the journal is concerned.  Whatever the UI
+ * does to the game while it has control is recorded; what the game does on
+ * its own follows from that and the random number generator.
+ */
+enum journal_control {
+	JOURNAL_GAME = 0,	/* Game code */
+	JOURNAL_GET,		/* The UI, getting the next command */
+	JOURNAL_EVENT,		/* The UI, handling an event the game signalled */
+	JOURNAL_INPUT		/* The UI, answering a question from the game */
+};
+
+/**
+ * What happened in a replay
+ */
+struct journal_stats {
+	u32b phases;		/* Times the next command was asked for */
+	u32b commands;		/* Commands replayed */
+	bool finished;		/* Whether the whole journal was replayed */
+	const char *error;	/* Why the replay stopped early, or NULL */
+};
+
+extern char *journal_file;
+
+bool journal_record_start(const char *path, const char *save_path);
+bool journal_replay_open(const char *path, const char *save_path);
+void journal_replay_start(void);
+void journal_stop(void);
+const struct journal_stats *journal_replay_stats(void);
+
+void journal_enter(enum journal_control control);
+void journal_leave(void);
+void journal_event(void);
+void journal_note_push(int slot);
+void journal_note_pop(int slot, struct command *cmd, cmd_context ctx);
+void journal_note_target(void);
+void journal_note_disturb(int stop_search);
+
+#endif /* !INCLUDED_JOURNAL_H */
@@ -0,0 +1,19 @@
+/**
+ * \file src/list-profile.h
+ * \brief Sections of the game timed by the profiler
+ *
+ * Fields:
+ * name - section name, for the debug display and the CSV dump
+ * description - what is being timed
+ */
+PROF(WORLD,			"world",		"process_world()")
+PROF(MONSTERS,		"monsters",		"process_monsters()")
+PROF(PLAYER,		"player",		"process_player()")
+PROF(VIEW,			"view",			"update_view()")
+PROF(NOISE,			"noise",		"make_noise()")
+PROF(SCENT,			"scent",		"update_scent()")
+PROF(HANDLE,		"handle",		"handle_stuff()")
+PROF(UPDATE,		"update",		"update_stuff()")
+PROF(PROJECT,		"project",		"project()")
+PROF(GENERATE,		"generate",		"Level generation")
+PROF(FRESH,			"fresh",		"Term_fresh()")
@@ -49,6 +49,7 @@
 #include "savefile.h"
 #include "store.h"
 #include "trap.h"
+#include "z-pool.h"
 
 /**
  * Dungeon constants
@@ -368,13 +369,13 @@ static void rd_trap(struct trap *trap)
 }
 
 /**
- * Read RNG state
+ * Read the state of the RNG used in play
  *
  * There were originally 64 bytes of randomizer saved. Now we only need
  * 32 + 5 bytes saved, so we'll read an extra 27 bytes at the end which won't
  * be used.
  */
-int rd_randomizer(void)
+static void rd_play_randomizer(void)
 {
 	int i;
 	u32b noop;
@@ -402,6 +403,33 @@ int rd_randomizer(void)
 		rd_u32b(&noop);
 
 	Rand_quick = false;
+}
+
+/**
+ * Read RNG state from savefiles which only kept one stream; the stream for
+ * level generation is seeded from the other
+ */
+int rd_randomizer_1(void)
+{
+	rd_play_randomizer();
+	Rand_state_seed(&level_rng, STATE[state_i]);
+	return 0;
+}
+
+/**
+ * Read RNG state
+ */
+int rd_randomizer(void)
+{
+	int i;
+
+	rd_play_randomizer();
+
+	/* Level generation RNG state */
+	rd_u32b(&level_rng.state_i);
+	level_rng.state_i %= RAND_DEG;
+	for (i = 0; i < RAND_DEG; i++)
+		rd_u32b(&level_rng.STATE[i]);
 
 	return 0;
 }
@@ -872,6 +900,7 @@ int rd_ignore(void)
 	rd_u16b(&inscriptions);
 
 	/* Read the aware object autoinscriptions array */
+	quarks_reserve(inscriptions);
 	for (i = 0; i < inscriptions; i++) {
 		char tmp[80];
 		byte tval, sval;
@@ -892,6 +921,7 @@ int rd_ignore(void)
 	rd_u16b(&inscriptions);
 
 	/* Read the unaware object autoinscriptions array */
+	quarks_reserve(inscriptions);
 	for (i = 0; i < inscriptions; i++) {
 		char tmp[80];
 		byte tval, sval;
@@ -1236,14 +1266,30 @@ int rd_stores(void) { return rd_stores_aux(rd_item); }
  * After loading the monsters, the objects being held by monsters are
  * linked directly into those monsters.
  */
+/**
+ * Decode (count, byte) pairs into n bytes, placed every stride bytes in data
+ */
+static void rd_rle(byte *data, size_t n, size_t stride)
+{
+	size_t i = 0;
+
+	while (i < n) {
+		byte run[2];
+
+		rd_bytes(run, 2);
+		for (; run[0] && (i < n); run[0]--)
+			data[stride * i++] = run[1];
+	}
+}
+
 static int rd_dungeon_aux(struct chunk **c)
 {
 	struct chunk *c1 = *c;
-	int i, n, y, x;
+	int i, n;
 
 	u16b height, width;
 
-	byte count;
+	byte *feat;
 	byte tmp8u;
 	u16b tmp16u;
 	char name[100];
@@ -1260,53 +1306,16 @@ static int rd_dungeon_aux(struct chunk **c)
 	c1 = cave_new(height, width);
 	c1->name = string_make(name);
 
-    /* Run length decoding of cave->squares[y][x].info */
-	for (n = 0; n < square_size; n++) {
-		/* Load the dungeon data */
-		for (x = y = 0; y < c1->height; ) {
-			/* Grab RLE info */
-			rd_byte(&count);
-			rd_byte(&tmp8u);
-
-			/* Apply the RLE info */
-			for (i = count; i > 0; i--) {
-				/* Extract "info" */
-				c1->squares[y][x].info[n] = tmp8u;
-
-				/* Advance/Wrap */
-				if (++x >= c1->width) {
-					/* Wrap */
-					x = 0;
-
-					/* Advance/Wrap */
-					if (++y >= c1->height) break;
-				}
-			}
-		}
-	}
+	/* Run length decoding of cave->squares.info */
+	for (n = 0; n < square_size; n++)
+		rd_rle(c1->squares.info + n, height * width, SQUARE_SIZE);
 
 	/* Run length decoding of dungeon data */
-	for (x = y = 0; y < c1->height; ) {
-		/* Grab RLE info */
-		rd_byte(&count);
-		rd_byte(&tmp8u);
-
-		/* Apply the RLE info */
-		for (i = count; i > 0; i--) {
-			/* Extract "feat" */
-			square_set_feat(c1, loc(x, y), tmp8u);
-
-			/* Advance/Wrap */
-			if (++x >= c1->width) {
-				/* Wrap */
-				x = 0;
-
-				/* Advance/Wrap */
-				if (++y >= c1->height) break;
-			}
-		}
-	}
-
+	feat = mem_zalloc(height * width);
+	rd_rle(feat, height * width, 1);
+	for (i = 0; i < height * width; i++)
+		square_set_feat(c1, loc(i % width, i / width), feat[i]);
+	mem_free(feat);
 
 	/* Read "feeling" */
 	rd_byte(&tmp8u);
@@ -1319,16 +1328,15 @@ static int rd_dungeon_aux(struct chunk **c)
 	if (OPT(player, birth_levels_persist)) {
 		rd_byte(&tmp8u);
 		while (tmp8u != 0xff) {
-			size_t n;
-			struct connector *current = mem_zalloc(sizeof *current);
-			current->info = mem_zalloc(square_size * sizeof(bitflag));
+			struct connector *current =
+				mem_arena_alloc(c1->arena, sizeof *current);
+			current->info = mem_arena_alloc(c1->arena,
+											square_size * sizeof(bitflag));
 			current->grid.x = tmp8u;
 			rd_byte(&tmp8u);
 			current->grid.y = tmp8u;
 			rd_byte(&current->feat);
-			for (n = 0; n < square_size; n++) {
-				rd_byte(&current->info[n]);
-			}
+			rd_bytes(current->info, square_size);
 			current->next = c1->join;
 			c1->join = current;
 			rd_byte(&tmp8u);
@@ -1366,7 +1374,7 @@ static int rd_objects_aux(rd_item_t rd_item_version, struct chunk *c)
 			break;
 
 		if (square_in_bounds_fully(c, obj->grid)) {
-			pile_insert_end(&c->squares[obj->grid.y][obj->grid.x].obj, obj);
+			pile_insert_end(&c->squares.obj[square_idx(c, obj->grid)], obj);
 		}
 		assert(obj->oidx);
 		assert(c->objects[obj->oidx] == NULL);
@@ -1433,7 +1441,7 @@ static int rd_traps_aux(struct chunk *c)
 
 	/* Read traps until one has no location */
 	while (true) {
-		trap = mem_zalloc(sizeof(*trap));
+		trap = trap_new();
 		rd_trap(trap);
 		grid = trap->grid;
 		if (loc_is_zero(grid))
@@ -1451,7 +1459,7 @@ static int rd_traps_aux(struct chunk *c)
 		}
 	}
 
-	mem_free(trap);
+	trap_free(trap);
 	return 0;
 }
 
@@ -1556,13 +1564,101 @@ int rd_traps(void)
 }
 
 /**
- * Read the chunk list
+ * Read a stored level, as it appears in the chunk list
+ */
+static int rd_chunk(struct chunk **c)
+{
+	/* Read the dungeon */
+	if (rd_dungeon_aux(c))
+		return -1;
+
+	/* Read the objects */
+	if (rd_objects_aux(rd_item, *c))
+		return -1;
+
+	/* Read the monsters */
+	if (rd_monsters_aux(*c))
+		return -1;
+
+	/* Read traps */
+	if (rd_traps_aux(*c))
+		return -1;
+
+	/* Read other chunk info */
+	if (OPT(player, birth_levels_persist)) {
+		char buf[80];
+		int i;
+		byte tmp8u;
+		u16b tmp16u;
+
+		rd_string(buf, sizeof(buf));
+		(*c)->name = string_make(buf);
+		rd_s32b(&(*c)->turn);
+		rd_u16b(&tmp16u);
+		(*c)->depth = tmp16u;
+		rd_byte(&(*c)->feeling);
+		rd_u32b(&(*c)->obj_rating);
+		rd_u32b(&(*c)->mon_rating);
+		rd_byte(&tmp8u);
+		(*c)->good_item  = tmp8u ? true : false;
+		rd_u16b(&tmp16u);
+		(*c)->height = tmp16u;
+		rd_u16b(&tmp16u);
+		(*c)->width = tmp16u;
+		rd_u16b(&(*c)->feeling_squares);
+		for (i = 0; i < z_info->f_max + 1; i++) {
+			rd_u16b(&tmp16u);
+			(*c)->feat_count[i] = tmp16u;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Read a level packed by wr_chunk() during this game, so laid out for this
+ * version rather than for whatever savefile was loaded
+ */
+int rd_packed_chunk(struct chunk **c)
+{
+	byte sizes[] = { square_size, obj_mod_max, of_size, elem_max, brand_max,
+					 slay_max, curse_max, mflag_size };
+	int result;
+
+	square_size = SQUARE_SIZE;
+	obj_mod_max = OBJ_MOD_MAX;
+	of_size = OF_SIZE;
+	elem_max = ELEM_MAX;
+	brand_max = z_info->brand_max;
+	slay_max = z_info->slay_max;
+	curse_max = z_info->curse_max;
+	mflag_size = MFLAG_SIZE;
+
+	result = rd_chunk(c);
+
+	square_size = sizes[0];
+	obj_mod_max = sizes[1];
+	of_size = sizes[2];
+	elem_max = sizes[3];
+	brand_max = sizes[4];
+	slay_max = sizes[5];
+	curse_max = sizes[6];
+	mflag_size = sizes[7];
+
+	return result;
+}
+
+/**
+ * Read the chunk list, packing each level as it is read
  */
 int rd_chunks(void)
 {
 	int j;
 	u16b chunk_max;
 
+	/* The levels in the savefile replace any already stored */
+	chunk_list_free();
+
 	if (player->is_dead)
 		return 0;
 
@@ -1570,52 +1666,11 @@ int rd_chunks(void)
 	for (j = 0; j < chunk_max; j++) {
 		struct chunk *c;
 
-		/* Read the dungeon */
-		if (rd_dungeon_aux(&c))
-			return -1;
-
-		/* Read the objects */
-		if (rd_objects_aux(rd_item, c))
-			return -1;
-
-		/* Read the monsters */
-		if (rd_monsters_aux(c))
+		if (rd_chunk(&c))
 			return -1;
 
-		/* Read traps */
-		if (rd_traps_aux(c))
-			return -1;
-
-
-		/* Read other chunk info */
-		if (OPT(player, birth_levels_persist)) {
-			char buf[80];
-			int i;
-			byte tmp8u;
-			u16b tmp16u;
-
-			rd_string(buf, sizeof(buf));
-			c->name = string_make(buf);
-			rd_s32b(&c->turn);
-			rd_u16b(&tmp16u);
-			c->depth = tmp16u;
-			rd_byte(&c->feeling);
-			rd_u32b(&c->obj_rating);
-			rd_u32b(&c->mon_rating);
-			rd_byte(&tmp8u);
-			c->good_item  = tmp8u ? true : false;
-			rd_u16b(&tmp16u);
-			c->height = tmp16u;
-			rd_u16b(&tmp16u);
-			c->width = tmp16u;
-			rd_u16b(&c->feeling_squares);
-			for (i = 0; i < z_info->f_max + 1; i++) {
-				rd_u16b(&tmp16u);
-				c->feat_count[i] = tmp16u;
-			}
-		}
-
 		chunk_list_add(c);
+		chunk_list_pack();
 	}
 
 	return 0;
@@ -0,0 +1,418 @@
+/**
+ * \file main-bench.c
+ * \brief Pseudo-UI that times the game engine on a fixed set of workloads
+ *
+ * Copyright (c) 2026 Angband developers
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+
+#include "angband.h"
+
+#ifdef USE_BENCH
+
+#include "buildid.h"
+#include "cave.h"
+#include "cmd-core.h"
+#include "game-event.h"
+#include "game-input.h"
+#include "game-world.h"
+#include "generate.h"
+#include "init.h"
+#include "main.h"
+#include "mon-make.h"
+#include "mon-util.h"
+#include "player.h"
+#include "player-calcs.h"
+#include "player-timed.h"
+#include "player-util.h"
+#include "project.h"
+#include "savefile.h"
+#include <time.h>
+
+#define BENCH_DEPTH			30		/* Depth of the crowded level */
+#define BENCH_CROWD			300		/* Extra monsters on the crowded level */
+#define BENCH_REST_TURNS	10000	/* Game turns to rest for */
+#define BENCH_VIEWS			100000	/* Calls to update_view() */
+#define BENCH_VIEW_GRIDS	64		/* Grids to call update_view() from */
+#define BENCH_MAX_RADIUS	10		/* Largest ball to fire */
+#define BENCH_BALLS			1000	/* Balls fired of each radius */
+#define BENCH_SAVES			20		/* Times to save and load */
+
+static u32b seed = 42;
+static int num_levels = 20;
+static int running_bench = 0;
+static bool first_result = true;
+static const char *forced_profile;
+
+/**
+ * Start each workload from the same random state, whatever ran before it
+ */
+static void bench_seed(void)
+{
+	Rand_quick = false;
+	Rand_state_init(seed);
+}
+
+static double bench_seconds(clock_t start)
+{
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/**
+ * Print one result; 'fields' is any extra JSON members, starting with a comma
+ */
+static void bench_result(const char *name, const char *fields, double seconds)
+{
+	printf("%s\n    { \"name\": \"%s\"%s, \"seconds\": %.4f }",
+		   first_result ? "" : ",", name, fields, seconds);
+	first_result = false;
+	fflush(stdout);
+}
+
+/**
+ * Answer the level generator's question about which profile to use
+ */
+static bool bench_get_string(const char *prompt, char *buf, size_t len)
+{
+	my_strcpy(buf, forced_profile, len);
+	return true;
+}
+
+/**
+ * Move to a new level at 'depth'
+ */
+static void bench_new_level(int depth)
+{
+	dungeon_change_level(player, depth);
+	prepare_next_level(&cave, player);
+	on_new_level();
+	player->upkeep->generate_level = false;
+}
+
+/**
+ * Generate levels with each cave profile in turn
+ */
+static void bench_generate(void)
+{
+	bool (*get_string_ui)(const char *, char *, size_t) = get_string_hook;
+	const struct cave_profile *profile;
+
+	get_string_hook = bench_get_string;
+	for (profile = find_cave_profile("town"); profile;
+		 profile = profile->next) {
+		bool town = streq(profile->name, "town");
+		char fields[80];
+		clock_t start;
+		int i;
+
+		bench_seed();
+		forced_profile = profile->name;
+		start = clock();
+		for (i = 0; i < num_levels; i++) {
+			player->noscore |= NOSCORE_JUMPING;
+			bench_new_level(town ? 0 : 20 + (i % 4) * 10);
+		}
+		strnfmt(fields, sizeof(fields), ", \"profile\": \"%s\", \"levels\": %d",
+				profile->name, num_levels);
+		bench_result("generate", fields, bench_seconds(start));
+	}
+	player->noscore &= ~(NOSCORE_JUMPING);
+	get_string_hook = get_string_ui;
+}
+
+/**
+ * Make a level with plenty of monsters on it
+ */
+static void bench_crowd(void)
+{
+	int i;
+
+	bench_seed();
+	bench_new_level(BENCH_DEPTH);
+	for (i = 0; i < BENCH_CROWD; i++)
+		pick_and_place_distant_monster(cave, player, 5, true, BENCH_DEPTH);
+}
+
+/**
+ * Rest on the crowded level, without letting anything kill the player
+ */
+static void bench_rest(void)
+{
+	s32b end;
+	clock_t start;
+	char fields[80];
+
+	bench_crowd();
+	end = turn + BENCH_REST_TURNS;
+	start = clock();
+	while (turn < end && !player->is_dead) {
+		s32b before = turn;
+
+		player->timed[TMD_INVULN] = BENCH_REST_TURNS;
+		player->timed[TMD_FOOD] = PY_FOOD_FULL - 1;
+		player->chp = player->mhp;
+
+		cmdq_push(CMD_REST);
+		cmd_set_arg_choice(cmdq_peek(), "choice", end - turn);
+		run_game_loop();
+
+		/* Wait a turn if resting isn't possible */
+		if (turn == before) {
+			cmdq_push(CMD_HOLD);
+			run_game_loop();
+		}
+	}
+	strnfmt(fields, sizeof(fields), ", \"turns\": %d, \"monsters\": %d",
+			BENCH_REST_TURNS, cave_monster_count(cave));
+	bench_result("rest", fields, bench_seconds(start));
+}
+
+/**
+ * Update the view from a spread of grids on the crowded level
+ */
+static void bench_view(void)
+{
+	struct loc grids[BENCH_VIEW_GRIDS + 1];
+	clock_t start;
+	char fields[80];
+	int i, n = 0;
+
+	bench_crowd();
+	for (i = 0; i < BENCH_VIEW_GRIDS; i++)
+		if (cave_find(cave, &grids[n], square_isempty)) n++;
+	grids[n++] = player->grid;
+
+	start = clock();
+	for (i = 0; i < BENCH_VIEWS; i++) {
+		int stay = BENCH_VIEWS / BENCH_VIEW_GRIDS;
+		if (i % stay == 0)
+			monster_swap(player->grid, grids[(i / stay) % n]);
+		update_view(cave, player);
+	}
+	strnfmt(fields, sizeof(fields), ", \"calls\": %d", BENCH_VIEWS);
+	bench_result("update_view", fields, bench_seconds(start));
+}
+
+/**
+ * Set off harmless balls of each radius at random floor grids on the crowded
+ * level
+ */
+static void bench_project(void)
+{
+	int flg = PROJECT_JUMP | PROJECT_GRID | PROJECT_ITEM | PROJECT_KILL;
+	static struct loc targets[BENCH_BALLS];
+	int rad, i, n = 0;
+
+	bench_crowd();
+	for (i = 0; i < BENCH_BALLS; i++)
+		if (cave_find(cave, &targets[n], square_isfloor)) n++;
+
+	for (rad = 0; rad <= BENCH_MAX_RADIUS; rad++) {
+		clock_t start = clock();
+		char fields[80];
+
+		for (i = 0; i < n; i++)
+			project(source_player(), rad, targets[i], 0, PROJ_MISSILE, flg, 0,
+					0, NULL);
+		strnfmt(fields, sizeof(fields), ", \"radius\": %d, \"balls\": %d",
+				rad, n);
+		bench_result("project", fields, bench_seconds(start));
+	}
+}
+
+/**
+ * Save the crowded level and load it back
+ */
+static void bench_savefile(void)
+{
+	char path[1024], fields[80];
+	clock_t start;
+	double save = 0.0, load = 0.0;
+	int i;
+
+	bench_crowd();
+	path_build(path, sizeof(path), ANGBAND_DIR_USER, "bench.sav");
+	for (i = 0; i < BENCH_SAVES; i++) {
+		start = clock();
+		if (!savefile_save(path)) quit("Couldn't save the benchmark game");
+		save += bench_seconds(start);
+
+		start = clock();
+		if (!savefile_load(path, false))
+			quit("Couldn't load the benchmark game");
+		load += bench_seconds(start);
+	}
+	file_delete(path);
+
+	strnfmt(fields, sizeof(fields), ", \"times\": %d", BENCH_SAVES);
+	bench_result("save", fields, save);
+	bench_result("load", fields, load);
+}
+
+static errr run_bench(void)
+{
+	/* Nothing is watching */
+	event_remove_all_handlers();
+
+	/* Make a new character */
+	bench_seed();
+	cmdq_push(CMD_BIRTH_INIT);
+	cmdq_push(CMD_BIRTH_RESET);
+	cmdq_push(CMD_CHOOSE_RACE);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_CHOOSE_CLASS);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_ROLL_STATS);
+	cmdq_push(CMD_NAME_CHOICE);
+	cmd_set_arg_string(cmdq_peek(), "name", "Bench");
+	cmdq_push(CMD_ACCEPT_CHARACTER);
+	cmdq_execute(CTX_BIRTH);
+	player->upkeep->playing = true;
+	player->upkeep->autosave = false;
+
+	printf("{\n  \"version\": \"%s\",\n  \"seed\": %lu,\n  \"results\": [",
+		   buildid, (unsigned long)seed);
+	bench_generate();
+	bench_rest();
+	bench_view();
+	bench_project();
+	bench_savefile();
+	printf("\n  ]\n}\n");
+
+	quit(NULL);
+	exit(0);
+}
+
+typedef struct term_data term_data;
+struct term_data {
+	term t;
+};
+
+static term_data td;
+typedef struct {
+	int key;
+	errr (*func)(int v);
+} term_xtra_func;
+
+static void term_init_bench(term *t) {
+	return;
+}
+
+static void term_nuke_bench(term *t) {
+	return;
+}
+
+static errr term_xtra_nothing(int v) {
+	return 0;
+}
+
+static errr term_xtra_event(int v) {
+	if (running_bench) {
+		return 0;
+	}
+	running_bench = 1;
+	return run_bench();
+}
+
+static term_xtra_func xtras[] = {
+	{ TERM_XTRA_CLEAR, term_xtra_nothing },
+	{ TERM_XTRA_NOISE, term_xtra_nothing },
+	{ TERM_XTRA_FRESH, term_xtra_nothing },
+	{ TERM_XTRA_SHAPE, term_xtra_nothing },
+	{ TERM_XTRA_ALIVE, term_xtra_nothing },
+	{ TERM_XTRA_EVENT, term_xtra_event },
+	{ TERM_XTRA_FLUSH, term_xtra_nothing },
+	{ TERM_XTRA_DELAY, term_xtra_nothing },
+	{ TERM_XTRA_REACT, term_xtra_nothing },
+	{ 0, NULL },
+};
+
+static errr term_xtra_bench(int n, int v) {
+	int i;
+	for (i = 0; xtras[i].func; i++) {
+		if (xtras[i].key == n) {
+			return xtras[i].func(v);
+		}
+	}
+	return 0;
+}
+
+static errr term_curs_bench(int x, int y) {
+	return 0;
+}
+
+static errr term_wipe_bench(int x, int y, int n) {
+	return 0;
+}
+
+static errr term_text_bench(int x, int y, int n, int a, const wchar_t *s) {
+	return 0;
+}
+
+static void term_data_link(int i) {
+	term *t = &td.t;
+
+	term_init(t, 80, 24, 256);
+
+	/* Ignore some actions for efficiency and safety */
+	t->never_bored = true;
+	t->never_frosh = true;
+
+	t->init_hook = term_init_bench;
+	t->nuke_hook = term_nuke_bench;
+
+	t->xtra_hook = term_xtra_bench;
+	t->curs_hook = term_curs_bench;
+	t->wipe_hook = term_wipe_bench;
+	t->text_hook = term_text_bench;
+
+	t->data = &td;
+
+	Term_activate(t);
+
+	angband_term[i] = t;
+}
+
+const char help_bench[] = "Benchmark mode, subopts -n(# of levels per profile) -s(seed)";
+
+/**
+ * Usage:
+ *
+ * angband -mbench -- [-nNN] [-sNNNN]
+ *
+ *   -nNN    Generate NN levels with each cave profile (default: 20)
+ *   -sNNNN  Seed the random number generator with NNNN (default: 42)
+ *
+ * Results are written to standard output as JSON.
+ */
+errr init_bench(int argc, char *argv[]) {
+	int i;
+
+	/* Skip over argv[0] */
+	for (i = 1; i < argc; i++) {
+		if (prefix(argv[i], "-n")) {
+			num_levels = MAX(atoi(&argv[i][2]), 1);
+			continue;
+		}
+		if (prefix(argv[i], "-s")) {
+			seed = (u32b)strtoul(&argv[i][2], NULL, 10);
+			continue;
+		}
+		printf("init-bench: bad argument '%s'\n", argv[i]);
+	}
+
+	term_data_link(0);
+	return 0;
+}
+
+#endif /* USE_BENCH */
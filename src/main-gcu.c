@@ -314,7 +314,7 @@ static errr Term_xtra_gcu_alive(int v) {
 	return 0;
 }
 
-const char help_gcu[] = "Text mode, subopts\n              -a     Use ASCII walls\n              -B     Use brighter bold characters\n              -nN    Use N terminals (up to 6)";
+const char help_gcu[] = "Text mode, subopts\n              -a     Use ASCII walls\n              -B     Use brighter bold characters\n              -nN    Use N terminals (up to 6)\n              -fN    Redraw at most N times a second while busy (0: only for input)";
 
 /**
  * Usage:
@@ -983,6 +983,8 @@ errr init_gcu(int argc, char **argv) {
 			term_count = atoi(&argv[i][2]);
 			if (term_count > MAX_TERM_DATA) term_count = MAX_TERM_DATA;
 			else if (term_count < 1) term_count = 1;
+		} else if (prefix(argv[i], "-f")) {
+			term_frame_rate = MAX(atoi(&argv[i][2]), 0);
 		}
 	}
 
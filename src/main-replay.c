@@ -0,0 +1,208 @@
+/**
+ * \file main-replay.c
+ * \brief Pseudo-UI that plays back a journal as fast as it can
+ *
+ * Copyright (c) 2026 Angband developers
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+
+#include "angband.h"
+
+#ifdef USE_TEST
+
+#include "game-world.h"
+#include "journal.h"
+#include "main.h"
+#include "player.h"
+#include "savefile.h"
+#include "ui-game.h"
+#include <time.h>
+
+static char *replay_file;
+static bool quiet = false;
+static int running_replay = 0;
+
+/**
+ * Load the savefile the journal starts from and play the journal through,
+ * with nothing listening to the game but the journal
+ */
+static errr run_replay(void)
+{
+	const struct journal_stats *stats;
+	s32b start_turn;
+	clock_t start;
+
+	if (!replay_file)
+		quit("No journal to replay; use -f<file>");
+
+	/* Play on a copy of the savefile, so autosaves go there */
+	strnfmt(savefile, sizeof(savefile), "%s.sav", replay_file);
+	if (!journal_replay_open(replay_file, savefile))
+		quit_fmt("Couldn't read the journal %s", replay_file);
+	if (!savefile_load(savefile, false) || player->is_dead)
+		quit("Couldn't load the savefile from the journal");
+
+	event_remove_all_handlers();
+	on_new_level();
+
+	start_turn = turn;
+	start = clock();
+
+	journal_replay_start();
+	while (!player->is_dead && player->upkeep->playing) {
+		cmd_get_hook(CTX_GAME);
+		run_game_loop();
+	}
+	stats = journal_replay_stats();
+
+	if (!quiet) {
+		printf("Replayed %lu commands at %lu prompts, %lu game turns, in "
+			   "%.3fs\n", (unsigned long)stats->commands,
+			   (unsigned long)stats->phases,
+			   (unsigned long)(turn - start_turn),
+			   (double)(clock() - start) / CLOCKS_PER_SEC);
+	}
+	if (stats->error)
+		printf("Replay stopped: %s\n", stats->error);
+	else if (!stats->finished && !player->is_dead)
+		printf("Replay stopped: the game ended before the journal\n");
+
+	journal_stop();
+	quit(NULL);
+	exit(0);
+}
+
+typedef struct term_data term_data;
+struct term_data {
+	term t;
+};
+
+static term_data td;
+typedef struct {
+	int key;
+	errr (*func)(int v);
+} term_xtra_func;
+
+static void term_init_replay(term *t) {
+	return;
+}
+
+static void term_nuke_replay(term *t) {
+	return;
+}
+
+static errr term_xtra_nothing(int v) {
+	return 0;
+}
+
+static errr term_xtra_event(int v) {
+	if (running_replay) {
+		return 0;
+	}
+	running_replay = 1;
+	return run_replay();
+}
+
+static term_xtra_func xtras[] = {
+	{ TERM_XTRA_CLEAR, term_xtra_nothing },
+	{ TERM_XTRA_NOISE, term_xtra_nothing },
+	{ TERM_XTRA_FRESH, term_xtra_nothing },
+	{ TERM_XTRA_SHAPE, term_xtra_nothing },
+	{ TERM_XTRA_ALIVE, term_xtra_nothing },
+	{ TERM_XTRA_EVENT, term_xtra_event },
+	{ TERM_XTRA_FLUSH, term_xtra_nothing },
+	{ TERM_XTRA_DELAY, term_xtra_nothing },
+	{ TERM_XTRA_REACT, term_xtra_nothing },
+	{ 0, NULL },
+};
+
+static errr term_xtra_replay(int n, int v) {
+	int i;
+	for (i = 0; xtras[i].func; i++) {
+		if (xtras[i].key == n) {
+			return xtras[i].func(v);
+		}
+	}
+	return 0;
+}
+
+static errr term_curs_replay(int x, int y) {
+	return 0;
+}
+
+static errr term_wipe_replay(int x, int y, int n) {
+	return 0;
+}
+
+static errr term_text_replay(int x, int y, int n, int a, const wchar_t *s) {
+	return 0;
+}
+
+static void term_data_link(int i) {
+	term *t = &td.t;
+
+	term_init(t, 80, 24, 256);
+
+	/* Ignore some actions for efficiency and safety */
+	t->never_bored = true;
+	t->never_frosh = true;
+
+	t->init_hook = term_init_replay;
+	t->nuke_hook = term_nuke_replay;
+
+	t->xtra_hook = term_xtra_replay;
+	t->curs_hook = term_curs_replay;
+	t->wipe_hook = term_wipe_replay;
+	t->text_hook = term_text_replay;
+
+	t->data = &td;
+
+	Term_activate(t);
+
+	angband_term[i] = t;
+}
+
+const char help_replay[] = "Replay mode, subopts -f<journal> -q(uiet)";
+
+/**
+ * Usage:
+ *
+ * angband -mreplay -- -f<journal> [-q]
+ *
+ *   -f<journal>  The journal to replay, as recorded with angband -j<journal>
+ *   -q           Quiet mode (only report errors)
+ */
+errr init_replay(int argc, char *argv[]) {
+	int i;
+
+	/* Skip over argv[0] */
+	for (i = 1; i < argc; i++) {
+		if (prefix(argv[i], "-f")) {
+			replay_file = &argv[i][2];
+			continue;
+		}
+		if (streq(argv[i], "-q")) {
+			quiet = true;
+			continue;
+		}
+		printf("init-replay: bad argument '%s'\n", argv[i]);
+	}
+
+	/* Only run when asked for */
+	if (!replay_file) return 1;
+
+	term_data_link(0);
+	return 0;
+}
+
+#endif /* USE_TEST */
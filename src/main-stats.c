@@ -42,6 +42,9 @@
 #include "store.h"
 #include <stddef.h>
 #include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #define OBJ_FEEL_MAX	 11
 #define MON_FEEL_MAX 	 10
@@ -66,6 +69,8 @@
 static int randarts = 0;
 static int no_selling = 0;
 static u32b num_runs = 1;
+static int num_workers = 1;
+static u32b seed_base;
 static bool quiet = false;
 static int nextkey = 0;
 static int running_stats = 0;
@@ -213,24 +218,31 @@ static void generate_player_for_stats()
 	player->history = get_history(player->race->history);
 }
 
-static void initialize_character(void)
+/**
+ * With -j, each run is seeded from its own number, so that runs made in
+ * parallel by different workers never share a seed; otherwise runs are
+ * seeded from the clock as they always have been
+ */
+static void initialize_character(u32b run)
 {
-	u32b seed;
-
 	if (!quiet) {
 		printf(" [I  ]\b\b\b\b\b\b");
 		fflush(stdout);
 	}
 
-	seed = (time(NULL));
 	Rand_quick = false;
-	Rand_state_init(seed);
+	if (num_workers > 1) {
+		Rand_state_init(seed_base + run);
+	} else {
+		Rand_state_init((u32b) time(NULL));
+	}
 
 	player_init(player);
 	generate_player_for_stats();
 
 	seed_flavor = randint0(0x10000000);
 	seed_randart = randint0(0x10000000);
+	Rand_state_seed(&level_rng, randint0(0x10000000));
 
 	if (randarts) {
 		do_randart(seed_randart, false);
@@ -1420,6 +1432,156 @@ static int stats_write_db(u32b run)
 	return SQLITE_OK;
 }
 
+/**
+ * Worker processes pass their counts back to the parent as a stream of pairs:
+ * the number of zero counts skipped, then the next non-zero count.  Counts
+ * are visited in the order of stats_stream_level_data(), and the last pair
+ * has a zero count and skips any trailing zeros.  Most counts are zero, so
+ * this is far smaller than the level data itself.
+ */
+enum stats_stream_mode {
+	STATS_SEND,
+	STATS_MERGE,
+	STATS_CLEAR
+};
+
+struct stats_stream {
+	FILE *f;
+	enum stats_stream_mode mode;
+	u32b skip;
+	long long value;
+	bool ok;
+};
+
+static void stats_stream_put(struct stats_stream *st)
+{
+	if (fwrite(&st->skip, sizeof(st->skip), 1, st->f) != 1 ||
+		fwrite(&st->value, sizeof(st->value), 1, st->f) != 1)
+		st->ok = false;
+}
+
+static void stats_stream_get(struct stats_stream *st)
+{
+	if (fread(&st->skip, sizeof(st->skip), 1, st->f) != 1 ||
+		fread(&st->value, sizeof(st->value), 1, st->f) != 1)
+		st->ok = false;
+}
+
+/**
+ * Send, merge or clear one array of counts; wide arrays hold long longs
+ * rather than u32bs
+ */
+static void stats_stream_array(struct stats_stream *st, void *data, size_t n,
+							   bool wide)
+{
+	u32b *counts = data;
+	long long *gold = data;
+	size_t i = 0;
+
+	if (!st->ok) return;
+
+	switch (st->mode) {
+		case STATS_CLEAR: {
+			/* Leave pages shared with the parent alone if we can */
+			for (i = 0; i < n; i++) {
+				if (wide ? gold[i] : counts[i]) {
+					memset(data, 0, n * (wide ? sizeof(*gold) :
+										 sizeof(*counts)));
+					break;
+				}
+			}
+			break;
+		}
+		case STATS_SEND: {
+			for (i = 0; i < n && st->ok; i++) {
+				st->value = wide ? gold[i] : counts[i];
+				if (!st->value) {
+					st->skip++;
+					continue;
+				}
+				stats_stream_put(st);
+				st->skip = 0;
+			}
+			break;
+		}
+		case STATS_MERGE: {
+			while (st->ok) {
+				if (st->skip >= n - i) {
+					st->skip -= n - i;
+					break;
+				}
+				i += st->skip;
+
+				/* Only the last pair has a zero count */
+				if (!st->value) {
+					st->ok = false;
+					break;
+				}
+
+				if (wide)
+					gold[i] += st->value;
+				else
+					counts[i] += st->value;
+				i++;
+				stats_stream_get(st);
+			}
+			break;
+		}
+	}
+}
+
+/**
+ * Visit every count in level_data[]
+ */
+static bool stats_stream_level_data(struct stats_stream *st)
+{
+	int i, j, k, l;
+
+	if (st->mode == STATS_MERGE)
+		stats_stream_get(st);
+
+	for (i = 0; i < LEVEL_MAX; i++) {
+		struct level_data *ld = &level_data[i];
+
+		stats_stream_array(st, ld->monsters, z_info->r_max, false);
+		stats_stream_array(st, ld->obj_feelings, OBJ_FEEL_MAX, false);
+		stats_stream_array(st, ld->mon_feelings, MON_FEEL_MAX, false);
+		stats_stream_array(st, ld->gold, ORIGIN_STATS, true);
+
+		for (j = 0; j < ORIGIN_STATS; j++) {
+			stats_stream_array(st, ld->artifacts[j], z_info->a_max, false);
+			stats_stream_array(st, ld->consumables[j], consumable_count + 1,
+							   false);
+
+			for (k = 0; k < wearable_count + 1; k++) {
+				struct wearables_data *w = &ld->wearables[j][k];
+
+				stats_stream_array(st, &w->count, 1, false);
+				stats_stream_array(st, w->dice, TOP_DICE * TOP_SIDES, false);
+				stats_stream_array(st, w->ac, TOP_AC, false);
+				stats_stream_array(st, w->hit, TOP_PLUS, false);
+				stats_stream_array(st, w->dam, TOP_PLUS, false);
+				stats_stream_array(st, w->egos, z_info->e_max, false);
+				stats_stream_array(st, w->flags, OF_MAX, false);
+				for (l = 0; l < TOP_MOD; l++)
+					stats_stream_array(st, w->modifiers[l], OBJ_MOD_MAX + 1,
+									   false);
+			}
+		}
+	}
+
+	/* Finish with the trailing zeros */
+	if (st->mode == STATS_SEND) {
+		st->value = 0;
+		stats_stream_put(st);
+		if (fflush(st->f)) st->ok = false;
+	} else if (st->mode == STATS_MERGE) {
+		if (st->skip || st->value) st->ok = false;
+	}
+
+	return st->ok;
+}
+
 /**
  * Call with the number of runs that have been completed.
  */
@@ -1459,10 +1621,121 @@ static void stats_cleanup_angband_run(void)
 	if (player->history) mem_free(player->history);
 }
 
+/**
+ * Make one run through the dungeon
+ */
+static void stats_run_once(u32b run, struct artifact *a_info_save)
+{
+	unsigned int i;
+
+	if (randarts)
+		for (i = 0; i < z_info->a_max; i++)
+			memcpy(&a_info[i], &a_info_save[i], sizeof(struct artifact));
+
+	initialize_character(run);
+	unkill_uniques();
+	reset_artifacts();
+	descend_dungeon();
+	stats_cleanup_angband_run();
+}
+
+/**
+ * Make runs first to last between num_workers child processes, and add what
+ * they find to level_data[].  Worker w makes every num_workers-th run
+ * starting from first + w, and the results are merged in worker order.
+ * Each worker sends a byte down a shared pipe as it finishes each run, so
+ * progress is shown run by run as it is for a single process.
+ */
+static void stats_run_workers(u32b first, u32b last,
+							  struct artifact *a_info_save, time_t start)
+{
+	pid_t *pids = mem_zalloc(num_workers * sizeof(*pids));
+	int *fds = mem_zalloc(num_workers * sizeof(*fds));
+	int progress[2];
+	u32b done = first - 1;
+	char buf[256];
+	int w;
+
+	fflush(stdout);
+	if (pipe(progress)) quit("Couldn't create a pipe for progress!");
+	for (w = 0; w < num_workers; w++) {
+		int pipe_fds[2];
+
+		if (pipe(pipe_fds)) quit("Couldn't create a pipe for a worker!");
+		pids[w] = fork();
+		if (pids[w] < 0) quit("Couldn't start a worker!");
+
+		if (pids[w] == 0) {
+			struct stats_stream st = { NULL, STATS_CLEAR, 0, 0, true };
+			u32b run;
+			int i;
+
+			/* Close our copies of the other workers' pipes */
+			close(pipe_fds[0]);
+			close(progress[0]);
+			for (i = 0; i < w; i++)
+				close(fds[i]);
+
+			/* Count only our own runs */
+			quiet = true;
+			stats_stream_level_data(&st);
+			for (run = first + w; run <= last; run += num_workers) {
+				stats_run_once(run, a_info_save);
+				if (write(progress[1], "", 1) != 1)
+					_exit(1);
+			}
+			close(progress[1]);
+
+			st.f = fdopen(pipe_fds[1], "wb");
+			st.mode = STATS_SEND;
+			st.skip = 0;
+			_exit((st.f && stats_stream_level_data(&st)) ? 0 : 1);
+		}
+
+		close(pipe_fds[1]);
+		fds[w] = pipe_fds[0];
+	}
+
+	/* Follow the runs as they finish, until every worker is done with them */
+	close(progress[1]);
+	while (done < last) {
+		ssize_t n = read(progress[0], buf, sizeof(buf));
+
+		if (n <= 0) break;
+		while (n--) {
+			done++;
+			if (!quiet) {
+				progress_bar(done, start);
+			} else if (done % 1000 == 0) {
+				printf("Finished %d runs.\n", done);
+				fflush(stdout);
+			}
+		}
+	}
+	close(progress[0]);
+
+	for (w = 0; w < num_workers; w++) {
+		struct stats_stream st = { NULL, STATS_MERGE, 0, 0, true };
+		int status;
+
+		st.f = fdopen(fds[w], "rb");
+		if (!st.f || !stats_stream_level_data(&st))
+			quit_fmt("Couldn't read the results of worker %d!", w + 1);
+		fclose(st.f);
+
+		if (waitpid(pids[w], &status, 0) != pids[w] || !WIFEXITED(status) ||
+			WEXITSTATUS(status))
+			quit_fmt("Worker %d failed!", w + 1);
+	}
+
+	mem_free(fds);
+	mem_free(pids);
+}
+
 static errr run_stats(void)
 {
 	u32b run;
-	struct artifact *a_info_save;
+	struct artifact *a_info_save = NULL;
 	unsigned int i;
 	int err;
 	bool status; 
@@ -1486,26 +1759,35 @@ static errr run_stats(void)
 	if (!status) quit("Couldn't prepare database!");
 
 	if (!quiet) {
-		printf("Beginning %d runs...\n", num_runs);
+		if (num_workers > 1)
+			printf("Beginning %d runs with %d workers...\n", num_runs,
+				   num_workers);
+		else
+			printf("Beginning %d runs...\n", num_runs);
 		fflush(stdout);
 	}
 
 	start = time(NULL);
+	seed_base = (u32b) start;
 	for (run = 1; run <= num_runs; run++) {
+		bool checkpoint;
+
 		if (!quiet) progress_bar(run - 1, start);
 
-		if (randarts)
-			for (i = 0; i < z_info->a_max; i++)
-				memcpy(&a_info[i], &a_info_save[i], sizeof(struct artifact));
+		if (num_workers > 1) {
+			/* Hand a checkpoint's worth of runs to the workers */
+			u32b last = MIN(run + RUNS_PER_CHECKPOINT - 1, num_runs);
 
-		initialize_character();
-		unkill_uniques();
-		reset_artifacts();
-		descend_dungeon();
-		stats_cleanup_angband_run();
+			stats_run_workers(run, last, a_info_save, start);
+			run = last;
+			checkpoint = (run < num_runs);
+		} else {
+			stats_run_once(run, a_info_save);
+			checkpoint = (run % RUNS_PER_CHECKPOINT == 0);
+		}
 
 		/* Checkpoint every so many runs */
-		if (run % RUNS_PER_CHECKPOINT == 0) {
+		if (checkpoint) {
 			err = stats_write_db(run);
 			if (err) {
 				stats_db_close();
@@ -1514,7 +1796,7 @@ static errr run_stats(void)
 			}
 		}
 
-		if (quiet && run % 1000 == 0) {
+		if (quiet && (num_workers == 1) && (run % 1000 == 0)) {
 			printf("Finished %d runs.\n", run);
 			fflush(stdout);
 		}
@@ -1661,17 +1943,18 @@ static void term_data_link(int i) {
 	angband_term[i] = t;
 }
 
-const char help_stats[] = "Stats mode, subopts -q(uiet) -r(andarts) -n(# of runs) -s(no selling)";
+const char help_stats[] = "Stats mode, subopts -q(uiet) -r(andarts) -n(# of runs) -s(no selling) -j(# of workers)";
 
 /**
  * Usage:
  *
- * angband -mstats -- [-q] [-r] [-nNNNN] [-s]
+ * angband -mstats -- [-q] [-r] [-nNNNN] [-s] [-jNN]
  *
  *   -q      Quiet mode (turn off progress messages)
  *   -r      Turn on randarts
  *   -nNNNN  Make NNNN runs through the dungeon (default: 1)
  *   -s      Turn on no-selling
+ *   -jNN    Share the runs between NN worker processes (default: 1)
  */
 
 errr init_stats(int argc, char *argv[]) {
@@ -1695,6 +1978,10 @@ errr init_stats(int argc, char *argv[]) {
 			no_selling = 1;
 			continue;
 		}
+		if (prefix(argv[i], "-j")) {
+			num_workers = MAX(atoi(&argv[i][2]), 1);
+			continue;
+		}
 		printf("init-stats: bad argument '%s'\n", argv[i]);
 	}
 
@@ -18,6 +18,7 @@
 
 #include "angband.h"
 #include "init.h"
+#include "journal.h"
 #include "savefile.h"
 #include "ui-command.h"
 #include "ui-display.h"
@@ -69,11 +70,16 @@ static const struct module modules[] =
 
 #ifdef USE_TEST
 	{ "test", help_test, init_test },
+	{ "replay", help_replay, init_replay },
 #endif /* !USE_TEST */
 
 #ifdef USE_STATS
 	{ "stats", help_stats, init_stats },
 #endif /* USE_STATS */
+
+#ifdef USE_BENCH
+	{ "bench", help_bench, init_bench },
+#endif /* USE_BENCH */
 };
 
 /**
@@ -398,6 +404,11 @@ int main(int argc, char *argv[])
 				arg_force_name = true;
 				break;
 
+			case 'j':
+				if (!*arg) goto usage;
+				journal_file = string_make(arg);
+				continue;
+
 			case 'm':
 				if (!*arg) goto usage;
 				mstr = arg;
@@ -432,6 +443,7 @@ int main(int argc, char *argv[])
 				puts("  -g             Request graphics mode");
 				puts("  -x<opt>        Debug options; see -xhelp");
 				puts("  -u<who>        Use your <who> savefile");
+				puts("  -j<file>       Record a journal of the session to <file>");
 				puts("  -d<dir>=<path> Override a specific directory with <path>. <path> can be:");
 				for (i = 0; i < (int)N_ELEMENTS(change_path_values); i++) {
 #ifdef SETGID
@@ -39,7 +39,9 @@ extern errr init_vcs(int argc, char **argv);
 extern errr init_sdl(int argc, char **argv);
 extern errr init_sdl2(int argc, char **argv);
 extern errr init_test(int argc, char **argv);
+extern errr init_replay(int argc, char **argv);
 extern errr init_stats(int argc, char **argv);
+extern errr init_bench(int argc, char **argv);
 
 
 extern const char help_lfb[];
@@ -59,7 +61,9 @@ extern const char help_dos[];
 extern const char help_sdl[];
 extern const char help_sdl2[];
 extern const char help_test[];
+extern const char help_replay[];
 extern const char help_stats[];
+extern const char help_bench[];
 
 //phantom server play
 extern bool arg_force_name;
@@ -24,15 +24,30 @@
 #include "init.h"
 #include "player.h"
 
+/**
+ * Messages are kept in a ring, newest at 'head', so a message of any age can
+ * be found at once.  Their text is interned: each distinct text is stored
+ * once in an arena, and found through a hash table of text slots which
+ * counts the messages using it.  Text which no message uses any more is
+ * left where it is until the arena or the table fills up, when the texts
+ * still in use are copied into a fresh arena and table.
+ */
 typedef struct _message_t
 {
-	char *str;
-	struct _message_t *newer;
-	struct _message_t *older;
+	u32b text;
 	u16b type;
 	u16b count;
 } message_t;
 
+typedef struct _msgtext_t
+{
+	u32b hash;
+	u32b offset;
+	u16b len;
+	u16b refs;
+	bool used;
+} msgtext_t;
+
 typedef struct _msgcolor_t
 {
 	u16b type;
@@ -42,13 +57,36 @@ typedef struct _msgcolor_t
 
 typedef struct _msgqueue_t
 {
-	message_t *head;
-	message_t *tail;
+	message_t *ring;
+	u32b head;
 	msgcolor_t *colors;
 	u32b count;
 	u32b max;
+
+	char *arena;
+	size_t arena_size;
+	size_t arena_used;		/* Bytes handed out, in use or not */
+	size_t arena_live;		/* Bytes of text in use */
+
+	msgtext_t *texts;
+	u32b text_slots;		/* Always a power of two */
+	u32b text_used;			/* Slots which have ever held text */
+
+	char *find;				/* The last text searched for */
+	byte *found;			/* Whether each text slot contains it */
 } msgqueue_t;
 
+/**
+ * Search results for a text slot
+ */
+enum {
+	FIND_UNKNOWN = 0,
+	FIND_YES,
+	FIND_NO
+};
+
+#define MESSAGE_ARENA	(32 * 1024)
+
 static msgqueue_t *messages = NULL;
 
 /**
@@ -62,7 +100,19 @@ static msgqueue_t *messages = NULL;
 void messages_init(void)
 {
 	messages = mem_zalloc(sizeof(msgqueue_t));
-	messages->max = 2048;
+	messages->max = MESSAGES_MAX;
+	messages->ring = mem_zalloc(messages->max * sizeof(message_t));
+	messages->head = messages->max - 1;
+
+	messages->arena_size = MESSAGE_ARENA;
+	messages->arena = mem_alloc(messages->arena_size);
+
+	/* At most half the slots are in use just after the table is rebuilt */
+	messages->text_slots = 1;
+	while (messages->text_slots < messages->max * 2)
+		messages->text_slots <<= 1;
+	messages->texts = mem_zalloc(messages->text_slots * sizeof(msgtext_t));
+	messages->found = mem_zalloc(messages->text_slots);
 }
 
 /**
@@ -72,15 +122,6 @@ void messages_free(void)
 {
 	msgcolor_t *c = messages->colors;
 	msgcolor_t *nextc;
-	message_t *m = messages->head;
-	message_t *nextm;
-
-	while (m) {
-		nextm = m->older;
-		mem_free(m->str);
-		mem_free(m);
-		m = nextm;
-	}
 
 	while (c) {
 		nextc = c->next;
@@ -88,7 +129,13 @@ void messages_free(void)
 		c = nextc;
 	}
 
+	string_free(messages->find);
+	mem_free(messages->found);
+	mem_free(messages->texts);
+	mem_free(messages->arena);
+	mem_free(messages->ring);
 	mem_free(messages);
+	messages = NULL;
 }
 
 /**
@@ -101,64 +148,147 @@ u16b messages_num(void)
 
 /**
  * ------------------------------------------------------------------------
- * Functions for individual messages
+ * Message text
  * ------------------------------------------------------------------------ */
+static u32b message_intern(const char *str, u32b hash);
+
 /**
- * Save a new message into the memory buffer, with text `str` and type `type`.
- * The type should be one of the MSG_ constants defined in message.h.
- *
- * The new message may not be saved if it is identical to the one saved before
- * it, in which case the "count" of the message will be increased instead.
- * This count can be fetched using the message_count() function.
+ * Copy the text in use into a fresh arena and table, with room for at least
+ * `need` more bytes of text
  */
-void message_add(const char *str, u16b type)
+static void messages_compact(size_t need)
 {
-	message_t *m;
-
-	if (messages->head &&
-	    messages->head->type == type &&
-	    !strcmp(messages->head->str, str)) {
-		messages->head->count++;
-		return;
+	char *old_arena = messages->arena;
+	msgtext_t *old_texts = messages->texts;
+	u32b age;
+
+	/* Leave the new arena at most half full */
+	messages->arena_size = MAX(messages->arena_size,
+							   2 * (messages->arena_live + need));
+	messages->arena = mem_alloc(messages->arena_size);
+	messages->arena_used = 0;
+	messages->arena_live = 0;
+
+	messages->texts = mem_zalloc(messages->text_slots * sizeof(msgtext_t));
+	messages->text_used = 0;
+	memset(messages->found, FIND_UNKNOWN, messages->text_slots);
+
+	/* Re-intern the text of every message, oldest first */
+	for (age = messages->count; age > 0; age--) {
+		u32b n = (messages->head + messages->max - (age - 1)) % messages->max;
+		msgtext_t *t = &old_texts[messages->ring[n].text];
+
+		messages->ring[n].text = message_intern(old_arena + t->offset, t->hash);
 	}
 
-	m = mem_zalloc(sizeof(message_t));
-	m->str = string_make(str);
-	m->type = type;
-	m->count = 1;
-	m->older = messages->head;
+	mem_free(old_texts);
+	mem_free(old_arena);
+}
 
-	if (messages->head)
-		messages->head->newer = m;
+/**
+ * Return the text slot holding `str`, whose hash is `hash`, adding it if it
+ * isn't there, and count one more message using it
+ */
+static u32b message_intern(const char *str, u32b hash)
+{
+	u32b mask = messages->text_slots - 1;
+	u32b i = hash & mask;
+	size_t len = strlen(str);
+	msgtext_t *t;
+
+	for (t = &messages->texts[i]; t->used; t = &messages->texts[i]) {
+		if (t->hash == hash && t->len == len &&
+			!memcmp(messages->arena + t->offset, str, len)) {
+			/* Text which has fallen out of use is still there to reuse */
+			if (!t->refs++) messages->arena_live += len + 1;
+			return i;
+		}
+		i = (i + 1) & mask;
+	}
 
-	messages->head = m;
-	messages->count++;
+	/* Make room if the arena or the table is full */
+	if (messages->arena_used + len + 1 > messages->arena_size ||
+		messages->text_used >= messages->text_slots / 4 * 3) {
+		messages_compact(len + 1);
+		return message_intern(str, hash);
+	}
 
-	if (!messages->tail)
-		messages->tail = m;
+	t->used = true;
+	t->hash = hash;
+	t->offset = messages->arena_used;
+	t->len = len;
+	t->refs = 1;
+	memcpy(messages->arena + t->offset, str, len + 1);
+	messages->arena_used += len + 1;
+	messages->arena_live += len + 1;
+	messages->text_used++;
+	messages->found[i] = FIND_UNKNOWN;
+
+	return i;
+}
 
-	if (messages->count > messages->max) {
-		message_t *old_tail = messages->tail;
+/**
+ * Count one fewer message using a text slot
+ */
+static void message_release(u32b text)
+{
+	msgtext_t *t = &messages->texts[text];
 
-		messages->tail = old_tail->newer;
-		messages->tail->older = NULL;
-		mem_free(old_tail->str);
-		mem_free(old_tail);
-		messages->count--;
-	}
+	if (!--t->refs) messages->arena_live -= t->len + 1;
 }
 
+/**
+ * ------------------------------------------------------------------------
+ * Functions for individual messages
+ * ------------------------------------------------------------------------ */
 /**
  * Returns the message of age `age`.
  */
 static message_t *message_get(u16b age)
 {
-	message_t *m = messages->head;
+	if (age >= messages->count) return NULL;
+	return &messages->ring[(messages->head + messages->max - age) %
+						   messages->max];
+}
 
-	while (m && age--)
-		m = m->older;
+/**
+ * Returns the text of a message
+ */
+static const char *message_text(const message_t *m)
+{
+	return messages->arena + messages->texts[m->text].offset;
+}
 
-	return m;
+/**
+ * Save a new message into the memory buffer, with text `str` and type `type`.
+ * The type should be one of the MSG_ constants defined in message.h.
+ *
+ * The new message may not be saved if it is identical to the one saved before
+ * it, in which case the "count" of the message will be increased instead.
+ * This count can be fetched using the message_count() function.
+ */
+void message_add(const char *str, u16b type)
+{
+	message_t *m = message_get(0);
+
+	if (m && m->type == type && !strcmp(message_text(m), str)) {
+		m->count++;
+		return;
+	}
+
+	/* Forget the oldest message if there's no room */
+	if (messages->count == messages->max) {
+		message_release(message_get(messages->count - 1)->text);
+		messages->count--;
+	}
+
+	m = &messages->ring[(messages->head + 1) % messages->max];
+	m->text = message_intern(str, djb2_hash(str));
+	m->type = type;
+	m->count = 1;
+
+	messages->head = (messages->head + 1) % messages->max;
+	messages->count++;
 }
 
 
@@ -172,7 +302,7 @@ static message_t *message_get(u16b age)
 const char *message_str(u16b age)
 {
 	message_t *m = message_get(age);
-	return (m ? m->str : "");
+	return (m ? message_text(m) : "");
 }
 
 /**
@@ -212,6 +342,34 @@ byte message_color(u16b age)
 	return (m ? message_type_color(m->type) : COLOUR_WHITE);
 }
 
+/**
+ * Returns the age of the newest message of age `age` or older whose text
+ * contains `str`, ignoring case, or -1 if there is none.
+ *
+ * Each distinct text is only searched once for the same `str`, however many
+ * messages use it, so stepping through the matches one at a time is cheap.
+ */
+int message_search(const char *str, u16b age)
+{
+	if (!messages->find || !streq(messages->find, str)) {
+		string_free(messages->find);
+		messages->find = string_make(str);
+		memset(messages->found, FIND_UNKNOWN, messages->text_slots);
+	}
+
+	for (; age < messages->count; age++) {
+		message_t *m = message_get(age);
+		byte *found = &messages->found[m->text];
+
+		if (*found == FIND_UNKNOWN)
+			*found = my_stristr(message_text(m), str) ? FIND_YES : FIND_NO;
+		if (*found == FIND_YES)
+			return age;
+	}
+
+	return -1;
+}
+
 
 /**
  * ------------------------------------------------------------------------
@@ -30,6 +30,11 @@ enum {
 	SOUND_MAX = MSG_MAX,
 };
 
+/**
+ * The number of messages remembered
+ */
+#define MESSAGES_MAX	2048
+
 
 /* Functions */
 void messages_init(void);
@@ -40,6 +45,7 @@ const char *message_str(u16b age);
 u16b message_count(u16b age);
 u16b message_type(u16b age);
 byte message_color(u16b age);
+int message_search(const char *str, u16b age);
 byte message_type_color(u16b type);
 void message_color_define(u16b type, byte color);
 int message_lookup_by_name(const char *name);
@@ -23,14 +23,35 @@
 #include "mon-make.h"
 #include "mon-util.h"
 #include "monster.h"
+#include "z-pool.h"
+
+/**
+ * Groups and their member lists change with every monster placed or killed,
+ * so they come from pools
+ */
+static struct mem_pool *group_pool;
+static struct mem_pool *entry_pool;
+
+/**
+ * Allocate a new entry for a group's member list
+ */
+static struct mon_group_list_entry *monster_group_entry_new(void)
+{
+	if (!entry_pool)
+		entry_pool = mem_pool_new("monster group members",
+								  sizeof(struct mon_group_list_entry), 256);
+	return mem_pool_alloc(entry_pool);
+}
 
 /**
  * Allocate a new monster group
  */
 struct monster_group *monster_group_new(void)
 {
-	struct monster_group *group = mem_zalloc(sizeof(struct monster_group));
-	return group;
+	if (!group_pool)
+		group_pool = mem_pool_new("monster groups",
+								  sizeof(struct monster_group), 64);
+	return mem_pool_alloc(group_pool);
 }
 
 /**
@@ -41,11 +62,22 @@ void monster_group_free(struct chunk *c, struct monster_group *group)
 	/* Free the member list */
 	while (group->member_list) {
 		struct mon_group_list_entry *next = group->member_list->next;
-		mem_free(group->member_list);
+		mem_pool_free(entry_pool, group->member_list);
 		group->member_list = next;
 	}
 
-	mem_free(group);
+	mem_pool_free(group_pool, group);
+}
+
+/**
+ * Release the memory of the group pools, once every group has been freed
+ */
+void monster_group_pools_destroy(void)
+{
+	mem_pool_destroy(entry_pool);
+	entry_pool = NULL;
+	mem_pool_destroy(group_pool);
+	group_pool = NULL;
 }
 
 /**
@@ -167,7 +199,7 @@ void monster_remove_from_groups(struct chunk *c, struct monster *mon)
 			} else {
 				/* Otherwise remove the first entry */
 				group->member_list = list_entry->next;
-				mem_free(list_entry);
+				mem_pool_free(entry_pool, list_entry);
 				if (group->leader == mon->midx) {
 					monster_group_remove_leader(c, mon, group);
 				}
@@ -186,7 +218,7 @@ void monster_remove_from_groups(struct chunk *c, struct monster *mon)
 			if (list_entry->next->midx == mon->midx) {
 				struct mon_group_list_entry *remove = list_entry->next;
 				list_entry->next = list_entry->next->next;
-				mem_free(remove);
+				mem_pool_free(entry_pool, remove);
 				if (group->leader == mon->midx) {
 					monster_group_remove_leader(c, mon, group);
 				}
@@ -225,7 +257,7 @@ void monster_add_to_group(struct chunk *c, struct monster *mon,
 	assert(mon->group_info[PRIMARY_GROUP].index == group->index);
 
 	/* Make a new list entry and add it to the start of the list */
-	list_entry = mem_zalloc(sizeof(struct mon_group_list_entry));
+	list_entry = monster_group_entry_new();
 	list_entry->midx = mon->midx;
 	list_entry->next = group->member_list;
 	group->member_list = list_entry;
@@ -248,7 +280,7 @@ void monster_group_start(struct chunk *c, struct monster *mon, int which)
 	/* Fill out the group */
 	group->index = index;
 	group->leader = mon->midx;
-	group->member_list = mem_zalloc(sizeof(struct mon_group_list_entry));
+	group->member_list = monster_group_entry_new();
 	group->member_list->midx = mon->midx;
 
 	/* Write the index to the monster's group info, make it leader */
@@ -277,7 +309,7 @@ void monster_group_assign(struct chunk *c, struct monster *mon,
 		int i;
 
 		for (i = 0; i < GROUP_MAX; i++) {
-			struct mon_group_list_entry *entry = mem_zalloc(sizeof(*entry));
+			struct mon_group_list_entry *entry = monster_group_entry_new();
 
 			/* Check the index */
 			index = info[i].index;
@@ -287,7 +319,7 @@ void monster_group_assign(struct chunk *c, struct monster *mon,
 					quit_fmt("Monster %d has no group", mon->midx);
 				} else {
 					/* Plenty of things have no summon group */
-					mem_free(entry);
+					mem_pool_free(entry_pool, entry);
 					return;
 				}
 			}
@@ -33,6 +33,7 @@ struct monster_group {
 
 struct monster_group *monster_group_new(void);
 void monster_group_free(struct chunk *c, struct monster_group *group);
+void monster_group_pools_destroy(void);
 void monster_remove_from_groups(struct chunk *c, struct monster *mon);
 int monster_group_index_new(struct chunk *c);
 void monster_add_to_group(struct chunk *c, struct monster *mon,
@@ -1756,6 +1756,7 @@ static void cleanup_monster(void)
 	}
 
 	mem_free(r_info);
+	lookup_monster_cleanup();
 }
 
 struct file_parser monster_parser = {
@@ -19,10 +19,12 @@
 #include "angband.h"
 #include "alloc.h"
 #include "game-world.h"
+#include "generate.h"
 #include "init.h"
 #include "mon-group.h"
 #include "mon-lore.h"
 #include "mon-make.h"
+#include "mon-move.h"
 #include "mon-predicate.h"
 #include "mon-timed.h"
 #include "mon-util.h"
@@ -50,7 +52,23 @@
  *         once on a given level); prob3 is always either prob2 or 0.
  * ------------------------------------------------------------------------ */
 static s16b alloc_race_size;
-static struct alloc_entry *alloc_race_table;
+static struct alloc_entry *alloc_race_init;
+
+/**
+ * Each thread picking monsters restricts and weighs its own copy of the
+ * table, taken from alloc_race_init when it first needs one
+ */
+static THREAD_LOCAL struct alloc_entry *alloc_race_table;
+
+static struct alloc_entry *race_alloc_table(void)
+{
+	if (!alloc_race_table) {
+		size_t size = alloc_race_size * sizeof(alloc_entry);
+		alloc_race_table = mem_alloc(size);
+		memcpy(alloc_race_table, alloc_race_init, size);
+	}
+	return alloc_race_table;
+}
 
 /**
  * Initialize monster allocation info
@@ -89,11 +107,11 @@ static void init_race_allocs(void) {
 	/* Paranoia */
 	if (!num[0]) quit("No town monsters!");
 
-	/* Allocate the alloc_race_table */
-	alloc_race_table = mem_zalloc(alloc_race_size * sizeof(alloc_entry));
+	/* Allocate the alloc_race_init */
+	alloc_race_init = mem_zalloc(alloc_race_size * sizeof(alloc_entry));
 
 	/* Get the table entry */
-	table = alloc_race_table;
+	table = alloc_race_init;
 
 	/* Scan the monsters (not the ghost) */
 	for (i = 1; i < z_info->r_max - 1; i++) {
@@ -134,8 +152,18 @@ static void init_race_allocs(void) {
 	mem_free(num);
 }
 
-static void cleanup_race_allocs(void) {
+/**
+ * Free this thread's copy of the monster allocation table
+ */
+void mon_alloc_table_free(void)
+{
 	mem_free(alloc_race_table);
+	alloc_race_table = NULL;
+}
+
+static void cleanup_race_allocs(void) {
+	mon_alloc_table_free();
+	mem_free(alloc_race_init);
 }
 
 
@@ -148,10 +176,11 @@ static void cleanup_race_allocs(void) {
 void get_mon_num_prep(bool (*get_mon_num_hook)(struct monster_race *race))
 {
 	int i;
+	alloc_entry *table = race_alloc_table();
 
 	/* Scan the allocation table */
 	for (i = 0; i < alloc_race_size; i++) {
-		alloc_entry *entry = &alloc_race_table[i];
+		alloc_entry *entry = &table[i];
 
 		/* Check the restriction, if any */
 		if (!get_mon_num_hook || (*get_mon_num_hook)(&r_info[entry->index])) {
@@ -211,13 +240,17 @@ static struct monster_race *get_mon_race_aux(long total,
  *
  * Note that if no monsters are appropriate, then this function will
  * fail, and return zero, but this should *almost* never happen.
+ *
+ * The monster is for the level `c`, which may still be being generated.
  */
-struct monster_race *get_mon_num(int level)
+struct monster_race *get_mon_num(struct chunk *c, int level)
 {
 	int i, p;
 	long total;
 	struct monster_race *race;
-	alloc_entry *table = alloc_race_table;
+	alloc_entry *table = race_alloc_table();
+	bool seasonal = gen_seasonal(c);
+	int depth = gen_player(c)->depth;
 
 	/* Occasionally produce a nastier monster in the dungeon */
 	if (level > 0 && one_in_(z_info->ood_monster_chance))
@@ -227,9 +260,6 @@ struct monster_race *get_mon_num(int level)
 
 	/* Process probabilities */
 	for (i = 0; i < alloc_race_size; i++) {
-		time_t cur_time = time(NULL);
-		struct tm *date = localtime(&cur_time);
-
 		/* Monsters are sorted by depth */
 		if (table[i].level > level) break;
 
@@ -243,16 +273,16 @@ struct monster_race *get_mon_num(int level)
 		race = &r_info[table[i].index];
 
 		/* No seasonal monsters outside of Christmas */
-		if (rf_has(race->flags, RF_SEASONAL) &&
-			!(date->tm_mon == 11 && date->tm_mday >= 24 && date->tm_mday <= 26))
+		if (rf_has(race->flags, RF_SEASONAL) && !seasonal)
 			continue;
 
 		/* Only one copy of a a unique must be around at the same time */
-		if (rf_has(race->flags, RF_UNIQUE) && race->cur_num >= race->max_num)
+		if (rf_has(race->flags, RF_UNIQUE) &&
+			*gen_cur_num(c, race) >= gen_max_num(c, race))
 			continue;
 
 		/* Some monsters never appear out of depth */
-		if (rf_has(race->flags, RF_FORCE_DEPTH) && race->level > player->depth)
+		if (rf_has(race->flags, RF_FORCE_DEPTH) && race->level > depth)
 			continue;
 
 		/* Accept */
@@ -377,8 +407,8 @@ void delete_monster(struct loc grid)
 	assert(square_in_bounds(cave, grid));
 
 	/* Delete the monster (if any) */
-	if (square(cave, grid).mon > 0)
-		delete_monster_idx(square(cave, grid).mon);
+	if (square_midx(cave, grid) > 0)
+		delete_monster_idx(square_midx(cave, grid));
 }
 
 
@@ -433,6 +463,9 @@ void monster_index_move(int i1, int i2)
 
 	/* Wipe hole */
 	memset(cave_monster(cave, i1), 0, sizeof(struct monster));
+
+	/* Requeue under the new index */
+	monster_schedule(cave, cave_monster(cave, i2));
 }
 
 
@@ -548,14 +581,14 @@ void wipe_mon_list(struct chunk *c, struct player *p)
 			struct object *obj = held_obj;
 			while (obj) {
 				if (obj->artifact && !(obj->known && obj->known->artifact))
-					obj->artifact->created = false;
+					*gen_created(c, obj->artifact) = false;
 				obj = obj->next;
 			}
 			object_pile_free(held_obj);
 		}
 
 		/* Reduce the racial counter */
-		mon->race->cur_num--;
+		(*gen_cur_num(c, mon->race))--;
 
 		/* Monster is gone from square */
 		square_set_mon(c, mon->grid, 0);
@@ -568,6 +601,7 @@ void wipe_mon_list(struct chunk *c, struct player *p)
 	for (i = 1; i < z_info->level_monster_max; i++) {
 		if (c->monster_groups[i]) {
 			monster_group_free(c, c->monster_groups[i]);
+			c->monster_groups[i] = NULL;
 		}
 	}
 
@@ -580,6 +614,9 @@ void wipe_mon_list(struct chunk *c, struct player *p)
 	/* Reset "reproducer" count */
 	c->num_repro = 0;
 
+	/* A level still being generated was never targeted or tracked */
+	if (c->gen) return;
+
 	/* Hack -- no more target */
 	target_set_monster(0);
 
@@ -685,7 +722,7 @@ int mon_create_drop_count(const struct monster_race *race, bool maximize)
 static bool mon_create_drop(struct chunk *c, struct monster *mon, byte origin)
 {
 	struct monster_drop *drop;
-	struct monster_lore *lore = get_lore(mon->race);
+	int depth = gen_player(c)->depth;
 
 	bool great, good, gold_ok, item_ok;
     bool extra_roll = false;
@@ -707,7 +744,7 @@ static bool mon_create_drop(struct chunk *c, struct monster *mon, byte origin)
 
 	/* Uniques that have been stolen from get their quantity reduced */
     if (rf_has(mon->race->flags, RF_UNIQUE)) {
-		number = MAX(0, number - lore->thefts);
+		number = MAX(0, number - gen_thefts(c, mon->race));
 	}
 
     /* Give added bonus for unique monsters */
@@ -719,7 +756,7 @@ static bool mon_create_drop(struct chunk *c, struct monster *mon, byte origin)
 
 	/* Take the best of (average of monster level and current depth)
 	   and (monster level) - to reward fighting OOD monsters */
-	level = MAX((monlevel + player->depth) / 2, monlevel);
+	level = MAX((monlevel + depth) / 2, monlevel);
     level = MIN(level, 100);
 
 	/* Morgoth currently drops all artifacts with the QUEST_ART flag */
@@ -733,15 +770,15 @@ static bool mon_create_drop(struct chunk *c, struct monster *mon, byte origin)
 			}
 
 			/* Allocate by hand, prep, apply magic */
-			obj = mem_zalloc(sizeof(*obj));
+			obj = object_new();
 			object_prep(obj, kind, 100, RANDOMISE);
 			obj->artifact = art;
 			copy_artifact_data(obj, obj->artifact);
-			obj->artifact->created = true;
+			*gen_created(c, obj->artifact) = true;
 
 			/* Set origin details */
 			obj->origin = origin;
-			obj->origin_depth = player->depth;
+			obj->origin_depth = depth;
 			obj->origin_race = mon->race;
 			obj->number = 1;
 
@@ -749,9 +786,8 @@ static bool mon_create_drop(struct chunk *c, struct monster *mon, byte origin)
 			if (monster_carry(c, mon, obj)) {
 				any = true;
 			} else {
-				obj->artifact->created = false;
-				object_wipe(obj);
-				mem_free(obj);
+				*gen_created(c, obj->artifact) = false;
+				object_free(obj);
 			}
 		}
 	}
@@ -764,9 +800,9 @@ static bool mon_create_drop(struct chunk *c, struct monster *mon, byte origin)
 		/* Specified by tval or by kind */
 		if (drop->kind) {
 			/* Allocate by hand, prep, apply magic */
-			obj = mem_zalloc(sizeof(*obj));
+			obj = object_new();
 			object_prep(obj, drop->kind, level, RANDOMISE);
-			apply_magic(obj, level, true, good, great, extra_roll);
+			apply_magic(c, obj, level, true, good, great, extra_roll);
 		} else {
 			/* Choose by set tval */
 			assert(drop->tval);
@@ -779,7 +815,7 @@ static bool mon_create_drop(struct chunk *c, struct monster *mon, byte origin)
 
 		/* Set origin details */
 		obj->origin = origin;
-		obj->origin_depth = player->depth;
+		obj->origin_depth = depth;
 		obj->origin_race = mon->race;
 		obj->number = randint0(drop->max - drop->min) + drop->min;
 
@@ -787,15 +823,14 @@ static bool mon_create_drop(struct chunk *c, struct monster *mon, byte origin)
 		if (monster_carry(c, mon, obj)) {
 			any = true;
 		} else {
-			object_wipe(obj);
-			mem_free(obj);
+			object_free(obj);
 		}
 	}
 
 	/* Make some objects */
 	for (j = 0; j < number; j++) {
 		if (gold_ok && (!item_ok || (randint0(100) < 50))) {
-			obj = make_gold(level, "any");
+			obj = make_gold(c, level, "any");
 		} else {
 			obj = make_object(c, level, good, great, extra_roll, NULL, 0);
 			if (!obj) continue;
@@ -803,16 +838,15 @@ static bool mon_create_drop(struct chunk *c, struct monster *mon, byte origin)
 
 		/* Set origin details */
 		obj->origin = origin;
-		obj->origin_depth = player->depth;
+		obj->origin_depth = depth;
 		obj->origin_race = mon->race;
 
 		/* Try to carry */
 		if (monster_carry(c, mon, obj)) {
 			any = true;
 		} else {
-			obj->artifact->created = false;
-			object_wipe(obj);
-			mem_free(obj);
+			if (obj->artifact) *gen_created(c, obj->artifact) = false;
+			object_free(obj);
 		}
 	}
 
@@ -841,14 +875,14 @@ void mon_create_mimicked_object(struct chunk *c, struct monster *mon, int index)
 	}
 
 	if (tval_is_money_k(kind)) {
-		obj = make_gold(player->depth, kind->name);
+		obj = make_gold(c, gen_player(c)->depth, kind->name);
 	} else {
 		obj = object_new();
 		object_prep(obj, kind, mon->race->level, RANDOMISE);
-		apply_magic(obj, mon->race->level, true, false, false, false);
+		apply_magic(c, obj, mon->race->level, true, false, false, false);
 		obj->number = 1;
 		obj->origin = ORIGIN_DROP_MIMIC;
-		obj->origin_depth = player->depth;
+		obj->origin_depth = gen_player(c)->depth;
 	}
 
 	obj->mimicking_m_idx = index;
@@ -959,13 +993,16 @@ s16b place_monster(struct chunk *c, struct loc grid, struct monster *mon,
 	/* Assign monster to its monster group */
 	monster_group_assign(c, new_mon, info, loading);
 
+	/* Start counting its energy */
+	monster_set_energy(c, new_mon, new_mon->energy);
+
 	update_mon(new_mon, c, true);
 
 	/* Count the number of "reproducers" */
 	if (rf_has(new_mon->race->flags, RF_MULTIPLY)) c->num_repro++;
 
 	/* Count racial occurrences */
-	new_mon->race->cur_num++;
+	(*gen_cur_num(c, new_mon->race))++;
 
 	/* Create the monster's drop, if any */
 	if (origin)
@@ -1010,6 +1047,7 @@ static bool place_new_monster_one(struct chunk *c, struct loc grid,
 	int i;
 	struct monster *mon;
 	struct monster monster_body;
+	struct player *p = gen_player(c);
 
 	assert(square_in_bounds(c, grid));
 	assert(race && race->name);
@@ -1018,7 +1056,7 @@ static bool place_new_monster_one(struct chunk *c, struct loc grid,
 	if (square_monster(c, grid)) return false;
 
 	/* Not where the player already is */
-	if (loc_eq(player->grid, grid)) return false;
+	if (loc_eq(p->grid, grid)) return false;
 
 	/* Prevent monsters from being placed where they cannot walk, but allow
 	 * other feature types */
@@ -1028,11 +1066,12 @@ static bool place_new_monster_one(struct chunk *c, struct loc grid,
 	if (square_iswarded(c, grid) || square_isdecoyed(c, grid)) return false;
 
 	/* "unique" monsters must be "unique" */
-	if (rf_has(race->flags, RF_UNIQUE) && race->cur_num >= race->max_num)
+	if (rf_has(race->flags, RF_UNIQUE) &&
+		*gen_cur_num(c, race) >= gen_max_num(c, race))
 		return false;
 
 	/* Depth monsters may NOT be created out of depth */
-	if (rf_has(race->flags, RF_FORCE_DEPTH) && player->depth < race->level)
+	if (rf_has(race->flags, RF_FORCE_DEPTH) && p->depth < race->level)
 		return false;
 
 	/* Add to level feeling, note uniques for cheaters */
@@ -1041,16 +1080,16 @@ static bool place_new_monster_one(struct chunk *c, struct loc grid,
 	/* Check out-of-depth-ness */
 	if (race->level > c->depth) {
 		if (rf_has(race->flags, RF_UNIQUE)) { /* OOD unique */
-			if (OPT(player, cheat_hear))
-				msg("Deep unique (%s).", race->name);
+			if (OPT(p, cheat_hear))
+				gen_msg(c, "Deep unique (%s).", race->name);
 		} else { /* Normal monsters but OOD */
-			if (OPT(player, cheat_hear))
-				msg("Deep monster (%s).", race->name);
+			if (OPT(p, cheat_hear))
+				gen_msg(c, "Deep monster (%s).", race->name);
 		}
 		/* Boost rating by power per 10 levels OOD */
 		c->mon_rating += (race->level - c->depth) * race->level * race->level;
-	} else if (rf_has(race->flags, RF_UNIQUE) && OPT(player, cheat_hear)) {
-		msg("Unique (%s).", race->name);
+	} else if (rf_has(race->flags, RF_UNIQUE) && OPT(p, cheat_hear)) {
+		gen_msg(c, "Unique (%s).", race->name);
 	}
 
 	/* Get local monster */
@@ -1098,7 +1137,7 @@ static bool place_new_monster_one(struct chunk *c, struct loc grid,
 
 	/* Affect light? */
 	if (mon->race->light != 0)
-		player->upkeep->update |= PU_UPDATE_VIEW;
+		p->upkeep->update |= PU_UPDATE_VIEW;
 
 	/* Is this obviously a monster? (Mimics etc. aren't) */
 	if (rf_has(race->flags, RF_UNAWARE))
@@ -1181,7 +1220,7 @@ static bool place_new_monster_group(struct chunk *c, struct loc grid,
 	return (true);
 }
 
-static struct monster_base *place_monster_base = NULL;
+static THREAD_LOCAL struct monster_base *place_monster_base = NULL;
 
 /**
  * Predicate function for get_mon_num_prep()
@@ -1212,14 +1251,15 @@ bool place_friends(struct chunk *c, struct loc grid, struct monster_race *race,
 	int extra_chance;
 
 	/* Find the difference between current dungeon depth and monster level */
-	int level_difference = player->depth - friends_race->level + 5;
+	int level_difference = gen_player(c)->depth - friends_race->level + 5;
 
 	/* Handle unique monsters */
 	bool is_unique = rf_has(friends_race->flags, RF_UNIQUE);
 
 	/* Make sure the unique hasn't been killed already */
 	if (is_unique) {
-		total = friends_race->cur_num < friends_race->max_num ? 1 : 0;
+		total = *gen_cur_num(c, friends_race) < gen_max_num(c, friends_race) ?
+			1 : 0;
 	}
 
 	/* More than 4 levels OoD, no groups allowed */
@@ -1344,7 +1384,7 @@ bool place_new_monster(struct chunk *c, struct loc grid,
 		get_mon_num_prep(place_monster_base_okay);
 
 		/* Pick a random race */
-		friends_race = get_mon_num(race->level);
+		friends_race = get_mon_num(c, race->level);
 
 		/* Reset allocation table */
 		get_mon_num_prep(NULL);
@@ -1385,7 +1425,7 @@ bool pick_and_place_monster(struct chunk *c, struct loc grid, int depth,
 							bool sleep, bool group_okay, byte origin)
 {
 	/* Pick a monster race, no specified group */
-	struct monster_race *race = get_mon_num(depth);
+	struct monster_race *race = get_mon_num(c, depth);
 	struct monster_group_info info = { 0, 0 };
 
 	if (race) {
@@ -1433,7 +1473,7 @@ bool pick_and_place_distant_monster(struct chunk *c, struct player *p, int dis,
 
 	if (!attempts_left) {
 		if (OPT(p, cheat_xtra) || OPT(p, cheat_hear))
-			msg("Warning! Could not allocate a new monster.");
+			gen_msg(c, "Warning! Could not allocate a new monster.");
 
 		return false;
 	}
@@ -28,7 +28,8 @@ void compact_monsters(int num_to_compact);
 void wipe_mon_list(struct chunk *c, struct player *p);
 s16b mon_pop(struct chunk *c);
 void get_mon_num_prep(bool (*get_mon_num_hook)(struct monster_race *race));
-struct monster_race *get_mon_num(int level);
+struct monster_race *get_mon_num(struct chunk *c, int level);
+void mon_alloc_table_free(void);
 int mon_create_drop_count(const struct monster_race *race, bool maximize);
 void mon_create_mimicked_object(struct chunk *c, struct monster *mon,
 								int index);
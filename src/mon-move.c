@@ -44,6 +44,7 @@
 #include "obj-util.h"
 #include "player-calcs.h"
 #include "player-util.h"
+#include "profile.h"
 #include "project.h"
 #include "trap.h"
 
@@ -959,7 +960,7 @@ static bool monster_turn_multiply(struct chunk *c, struct monster *mon)
 	/* Count the adjacent monsters */
 	for (y = mon->grid.y - 1; y <= mon->grid.y + 1; y++)
 		for (x = mon->grid.x - 1; x <= mon->grid.x + 1; x++)
-			if (square(c, loc(x, y)).mon > 0) k++;
+			if (square_midx(c, loc(x, y)) > 0) k++;
 
 	/* Multiply slower in crowded areas */
 	if ((k < 4) && (k == 0 || one_in_(k * z_info->repro_monster_rate))) {
@@ -1686,6 +1687,399 @@ static void regen_monster(struct monster *mon, int num)
 }
 
 
+/**
+ * ------------------------------------------------------------------------
+ * Monster scheduling
+ *
+ * Monsters gain energy every game turn, but can only do anything once they
+ * have move_energy of it.  Rather than visit every monster every turn, we
+ * keep a monster's energy as it was at the start of a given turn
+ * (energy_turn), work out from its speed the turn when it will next be able
+ * to move (ready_turn), and queue it for that turn.  Each turn's queued
+ * monsters are kept in a list, highest index first, which process_monsters()
+ * works through in the same order as a scan of the whole monster list.
+ *
+ * Energy that is owed is added in by monster_energy_settle(), which must be
+ * called before anything that changes a monster's speed, or that reads its
+ * energy.  To get the same result as visiting every monster, we record how
+ * far through the monster list the last end of turn pass got; monsters
+ * above that point have been given energy for that turn, and those below it
+ * haven't.
+ * ------------------------------------------------------------------------ */
+/**
+ * A monster index waiting for a given turn
+ */
+struct queued_monster {
+	s32b turn;
+	s16b midx;
+};
+
+struct monster_queue {
+	struct queued_monster *heap;	/**< Monsters waiting for later turns */
+	size_t heap_count;
+	size_t heap_size;
+
+	s16b *ready;		/**< Monsters ready or handled, highest first */
+	int ready_count;
+	s32b ready_turn;	/**< The turn the ready list is for */
+	bool full_pass;		/**< Every monster has been handled this turn */
+
+	s32b pass_turn;		/**< Turn of the last end of turn pass */
+	int pass_midx;		/**< Where that pass had got to */
+};
+
+/**
+ * Energy a monster gains each game turn at its current speed
+ */
+static int monster_turn_energy(struct monster *mon)
+{
+	int mspeed = mon->mspeed;
+
+	if (mon->m_timed[MON_TMD_FAST])
+		mspeed += 10;
+	if (mon->m_timed[MON_TMD_SLOW]) {
+		int slow_level = monster_effect_level(mon, MON_TMD_SLOW);
+		mspeed -= (2 * slow_level);
+	}
+
+	return turn_energy(mspeed);
+}
+
+/**
+ * The first turn for which a monster has not yet been given energy
+ */
+static s32b monster_energy_due(const struct monster_queue *q,
+							   const struct monster *mon)
+{
+	s32b due = q->pass_turn + (mon->midx > q->pass_midx ? 1 : 0);
+	return MAX(due, mon->energy_turn);
+}
+
+static void queue_heap_push(struct monster_queue *q, s32b turn, int midx)
+{
+	size_t i = q->heap_count++;
+
+	if (q->heap_count > q->heap_size) {
+		q->heap_size = q->heap_size ? q->heap_size * 2 : 64;
+		q->heap = mem_realloc(q->heap, q->heap_size * sizeof(*q->heap));
+	}
+
+	/* Sift up */
+	while (i > 0 && q->heap[(i - 1) / 2].turn > turn) {
+		q->heap[i] = q->heap[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+	q->heap[i].turn = turn;
+	q->heap[i].midx = midx;
+}
+
+static struct queued_monster queue_heap_pop(struct monster_queue *q)
+{
+	struct queued_monster top = q->heap[0];
+	struct queued_monster last = q->heap[--q->heap_count];
+	size_t i = 0;
+
+	/* Sift the last entry down from the top */
+	while (2 * i + 1 < q->heap_count) {
+		size_t child = 2 * i + 1;
+		if (child + 1 < q->heap_count &&
+			q->heap[child + 1].turn < q->heap[child].turn)
+			child++;
+		if (q->heap[child].turn >= last.turn) break;
+		q->heap[i] = q->heap[child];
+		i = child;
+	}
+	q->heap[i] = last;
+
+	return top;
+}
+
+/**
+ * Find the position of the first monster in the ready list with an index
+ * no higher than midx
+ */
+static int queue_ready_find(const struct monster_queue *q, int midx)
+{
+	int lo = 0, hi = q->ready_count;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (q->ready[mid] > midx)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static void queue_ready_add(struct monster_queue *q, int midx)
+{
+	int i = queue_ready_find(q, midx);
+
+	if (i < q->ready_count && q->ready[i] == midx) return;
+	memmove(&q->ready[i + 1], &q->ready[i],
+			(q->ready_count - i) * sizeof(*q->ready));
+	q->ready[i] = midx;
+	q->ready_count++;
+}
+
+/**
+ * Start the ready list for the given turn, keeping any monsters which
+ * missed their turn, then add the monsters which have come due
+ */
+static void queue_ready_update(struct chunk *c, s32b turn)
+{
+	struct monster_queue *q = c->mon_queue;
+
+	if (q->ready_turn != turn) {
+		int i, n = 0;
+
+		for (i = 0; i < q->ready_count; i++) {
+			struct monster *mon = cave_monster(c, q->ready[i]);
+			if (!mon->race || mon->ready_turn != q->ready_turn) continue;
+			mon->ready_turn = turn;
+			q->ready[n++] = q->ready[i];
+		}
+		q->ready_count = n;
+		q->ready_turn = turn;
+		q->full_pass = false;
+	}
+
+	while (q->heap_count && q->heap[0].turn <= turn) {
+		struct queued_monster next = queue_heap_pop(q);
+		struct monster *mon = cave_monster(c, next.midx);
+
+		/* Ignore monsters that have died or been requeued since */
+		if (!mon->race || mon->ready_turn != next.turn) continue;
+
+		mon->ready_turn = turn;
+		queue_ready_add(q, next.midx);
+	}
+}
+
+/**
+ * Bring a monster's energy up to date
+ */
+void monster_energy_settle(struct chunk *c, struct monster *mon)
+{
+	s32b due;
+
+	if (!c->mon_queue || !mon->race) return;
+
+	due = monster_energy_due(c->mon_queue, mon);
+	if (due > mon->energy_turn) {
+		mon->energy += (due - mon->energy_turn) * monster_turn_energy(mon);
+		mon->energy_turn = due;
+	}
+}
+
+/**
+ * Work out when a monster can next move, and queue it for that turn.
+ *
+ * This needs to be called whenever a monster's energy or speed changes,
+ * after its energy has been settled.
+ */
+void monster_schedule(struct chunk *c, struct monster *mon)
+{
+	struct monster_queue *q = c->mon_queue;
+	int need, gain;
+
+	if (!q || !mon->race) return;
+
+	/* Handled monsters are listed so that reset_monsters() finds them;
+	 * those ready this turn are listed already */
+	if (mflag_has(mon->mflag, MFLAG_HANDLED) &&
+		mon->ready_turn != q->ready_turn)
+		queue_ready_add(q, mon->midx);
+
+	need = z_info->move_energy - mon->energy;
+	gain = monster_turn_energy(mon);
+	if (need <= 0) {
+		mon->ready_turn = mon->energy_turn;
+	} else if (gain > 0) {
+		mon->ready_turn = mon->energy_turn + (need + gain - 1) / gain;
+	} else {
+		/* Never going to move at this speed */
+		mon->ready_turn = -1;
+		return;
+	}
+
+	if (mon->ready_turn <= q->ready_turn) {
+		mon->ready_turn = q->ready_turn;
+		queue_ready_add(q, mon->midx);
+	} else {
+		queue_heap_push(q, mon->ready_turn, mon->midx);
+	}
+}
+
+/**
+ * Set a monster's energy, and reschedule it
+ */
+void monster_set_energy(struct chunk *c, struct monster *mon, int energy)
+{
+	mon->energy = energy;
+	if (c->mon_queue)
+		mon->energy_turn = monster_energy_due(c->mon_queue, mon);
+	monster_schedule(c, mon);
+}
+
+/**
+ * Bring the energy of every monster on a level up to date, as for saving
+ * or storing the level
+ */
+void settle_monsters(struct chunk *c)
+{
+	int i;
+
+	for (i = cave_monster_max(c) - 1; i >= 1; i--)
+		monster_energy_settle(c, cave_monster(c, i));
+}
+
+/**
+ * Free a level's monster queue
+ */
+void free_monster_queue(struct chunk *c)
+{
+	if (!c->mon_queue) return;
+
+	mem_free(c->mon_queue->heap);
+	mem_free(c->mon_queue->ready);
+	mem_free(c->mon_queue);
+	c->mon_queue = NULL;
+}
+
+/**
+ * Queue all the monsters on a level the player is entering, which keep
+ * the energy they had when the level was saved, stored or generated
+ */
+void schedule_monsters(struct chunk *c)
+{
+	struct monster_queue *q;
+	int i;
+
+	free_monster_queue(c);
+	q = c->mon_queue = mem_zalloc(sizeof(*q));
+	q->ready = mem_zalloc(z_info->level_monster_max * sizeof(*q->ready));
+	q->ready_turn = turn;
+	q->pass_turn = turn - 1;
+
+	for (i = cave_monster_max(c) - 1; i >= 1; i--) {
+		struct monster *mon = cave_monster(c, i);
+		if (!mon->race) continue;
+
+		/* Monsters already handled have had this turn's energy */
+		mon->energy_turn = turn;
+		if (mflag_has(mon->mflag, MFLAG_HANDLED))
+			mon->energy_turn++;
+		monster_schedule(c, mon);
+	}
+}
+
+/**
+ * Monsters not reached by an end of turn pass that was cut short never get
+ * that turn's energy
+ */
+static void skip_missed_energy(struct chunk *c)
+{
+	struct monster_queue *q = c->mon_queue;
+	int i;
+
+	for (i = cave_monster_max(c) - 1; i >= 1; i--) {
+		struct monster *mon = cave_monster(c, i);
+		if (!mon->race) continue;
+
+		monster_energy_settle(c, mon);
+		if (mon->energy_turn == q->pass_turn) {
+			mon->energy_turn++;
+			monster_schedule(c, mon);
+		}
+	}
+	q->pass_midx = 0;
+}
+
+/**
+ * Whether a level has terrain which hurts the monsters on it at the end of
+ * every turn
+ */
+static bool level_hurts_monsters(struct chunk *c)
+{
+	int i;
+
+	if (!cave_monster_count(c)) return false;
+	for (i = 0; i < z_info->f_max; i++)
+		if (c->feat_count[i] && feat_is_fiery(i))
+			return true;
+
+	return false;
+}
+
+/**
+ * The first turn, from the current one on, on which any monster may need
+ * handling at the end of the turn; -1 if none ever will.  Until that turn,
+ * process_monsters() and reset_monsters() would do nothing but hand out
+ * energy.
+ */
+s32b next_monster_turn(struct chunk *c)
+{
+	struct monster_queue *q = c->mon_queue;
+	int i;
+
+	/* Monsters are queued the first time they are processed */
+	if (!q || q->pass_midx || level_hurts_monsters(c)) return turn;
+
+	/* Monsters which were ready this turn, but missed it, go again */
+	if (q->ready_turn == turn) return turn;
+	for (i = 0; i < q->ready_count; i++) {
+		struct monster *mon = cave_monster(c, q->ready[i]);
+		if (mon->race && mon->ready_turn == q->ready_turn) return turn;
+	}
+
+	/* Drop monsters which have died or been requeued since */
+	while (q->heap_count) {
+		struct monster *mon = cave_monster(c, q->heap[0].midx);
+		if (mon->race && mon->ready_turn == q->heap[0].turn) break;
+		queue_heap_pop(q);
+	}
+
+	if (!q->heap_count) return -1;
+	return MAX(q->heap[0].turn, turn);
+}
+
+/**
+ * Pass over the game turns from the current one up to (but not including)
+ * `to`, as process_monsters() and reset_monsters() would if no monster were
+ * ready to move on any of them; next_monster_turn() must not come before
+ * `to`.
+ */
+void skip_monster_turns(struct chunk *c, s32b to)
+{
+	struct monster_queue *q = c->mon_queue;
+
+	assert(q && !q->pass_midx);
+	if (to <= turn) return;
+
+	/* Every monster has been given energy for the skipped turns */
+	queue_ready_update(c, to - 1);
+	assert(!q->ready_count);
+	q->pass_turn = to - 1;
+}
+
+/**
+ * The next monster below index midx to look at in this pass through the
+ * monsters - all of them when `all` is set, otherwise just those ready to
+ * move this turn
+ */
+static int next_monster(const struct monster_queue *q, int midx, bool all)
+{
+	int i;
+
+	if (all) return midx - 1;
+
+	i = queue_ready_find(q, midx - 1);
+	return (i < q->ready_count) ? q->ready[i] : 0;
+}
+
 /**
  * ------------------------------------------------------------------------
  * Monster processing routines to be called by the main game loop
@@ -1697,24 +2091,51 @@ static void regen_monster(struct monster *mon, int num)
  * (backwards, so we can excise any "freshly dead" monsters), energizing each
  * monster, and allowing fully energized monsters to move, attack, pass, etc.
  *
+ * Only monsters with enough energy to move are visited (see "Monster
+ * scheduling" above); the others are given their energy when they are next
+ * looked at.  Every monster is still visited at the end of a turn when
+ * monsters regenerate.
+ *
  * This function and its children are responsible for a considerable fraction
  * of the processor time in normal situations, greater if the character is
  * resting.
  */
 void process_monsters(struct chunk *c, int minimum_energy)
 {
+	struct monster_queue *q;
 	int i;
-	int mspeed;
 
 	/* Only process some things every so often */
 	bool regen = false;
+	bool all;
 
 	/* Regenerate hitpoints and mana every 100 game turns */
 	if (turn % 100 == 0)
 		regen = true;
 
+	/* Regeneration needs every monster, at the end of the turn */
+	all = regen && !minimum_energy;
+
+	PROFILE_START(MONSTERS);
+
+	/* Find out who is ready to move */
+	if (!c->mon_queue)
+		schedule_monsters(c);
+	q = c->mon_queue;
+	queue_ready_update(c, turn);
+
+	/* Start the end of turn pass */
+	if (!minimum_energy) {
+		if (q->pass_midx)
+			skip_missed_energy(c);
+		q->pass_turn = turn;
+		q->pass_midx = cave_monster_max(c);
+		if (all) q->full_pass = true;
+	}
+
 	/* Process the monsters (backwards) */
-	for (i = cave_monster_max(c) - 1; i >= 1; i--) {
+	for (i = next_monster(q, cave_monster_max(c), all); i >= 1;
+		 i = next_monster(q, i, all)) {
 		struct monster *mon;
 		bool moving;
 
@@ -1729,6 +2150,15 @@ void process_monsters(struct chunk *c, int minimum_energy)
 		if (mflag_has(mon->mflag, MFLAG_HANDLED))
 			continue;
 
+		/* Ignore monsters that have been requeued for a later turn */
+		if (!all && mon->ready_turn != turn)
+			continue;
+
+		/* Catch up with the energy gained since it was last handled */
+		if (!minimum_energy)
+			q->pass_midx = i;
+		monster_energy_settle(c, mon);
+
 		/* Not enough energy to move yet */
 		if (mon->energy < minimum_energy) continue;
 
@@ -1742,24 +2172,17 @@ void process_monsters(struct chunk *c, int minimum_energy)
 		if (regen)
 			regen_monster(mon, 1);
 
-		/* Calculate the net speed */
-		mspeed = mon->mspeed;
-		if (mon->m_timed[MON_TMD_FAST])
-			mspeed += 10;
-		if (mon->m_timed[MON_TMD_SLOW]) {
-			int slow_level = monster_effect_level(mon, MON_TMD_SLOW);
-			mspeed -= (2 * slow_level);
-		}
-
 		/* Give this monster some energy */
-		mon->energy += turn_energy(mspeed);
+		mon->energy += monster_turn_energy(mon);
+		mon->energy_turn = turn + 1;
 
 		/* End the turn of monsters without enough energy to move */
 		if (!moving)
 			continue;
 
-		/* Use up "some" energy */
+		/* Use up "some" energy, and queue for the next move */
 		mon->energy -= z_info->move_energy;
+		monster_schedule(c, mon);
 
 		/* Mimics lie in wait */
 		if (monster_is_mimicking(mon)) continue;
@@ -1781,9 +2204,16 @@ void process_monsters(struct chunk *c, int minimum_energy)
 		}
 	}
 
+	/* The end of turn pass got all the way through */
+	if (!minimum_energy && !player->is_dead &&
+		!player->upkeep->generate_level)
+		q->pass_midx = 0;
+
 	/* Update monster visibility after this */
 	/* XXX This may not be necessary */
 	player->upkeep->update |= PU_MONSTERS;
+
+	PROFILE_STOP(MONSTERS);
 }
 
 /**
@@ -1793,19 +2223,21 @@ void process_monsters(struct chunk *c, int minimum_energy)
  */
 void reset_monsters(void)
 {
+	struct monster_queue *q = cave->mon_queue;
 	int i;
-	struct monster *mon;
 
-	/* Process the monsters (backwards) */
-	for (i = cave_monster_max(cave) - 1; i >= 1; i--) {
-		/* Access the monster */
-		mon = cave_monster(cave, i);
+	/* Dungeon hurts monsters */
+	if (level_hurts_monsters(cave))
+		for (i = cave_monster_max(cave) - 1; i >= 1; i--)
+			monster_take_terrain_damage(cave_monster(cave, i));
 
-		/* Dungeon hurts monsters */
-		monster_take_terrain_damage(mon);
-
-		/* Monster is ready to go again */
-		mflag_off(mon->mflag, MFLAG_HANDLED);
+	/* Monster is ready to go again */
+	if (!q || q->full_pass) {
+		for (i = cave_monster_max(cave) - 1; i >= 1; i--)
+			mflag_off(cave_monster(cave, i)->mflag, MFLAG_HANDLED);
+	} else {
+		for (i = 0; i < q->ready_count; i++)
+			mflag_off(cave_monster(cave, q->ready[i])->mflag, MFLAG_HANDLED);
 	}
 }
 
@@ -20,6 +20,14 @@
 
 
 bool multiply_monster(struct chunk *c, const struct monster *mon);
+void monster_energy_settle(struct chunk *c, struct monster *mon);
+void monster_schedule(struct chunk *c, struct monster *mon);
+void monster_set_energy(struct chunk *c, struct monster *mon, int energy);
+void settle_monsters(struct chunk *c);
+void schedule_monsters(struct chunk *c);
+s32b next_monster_turn(struct chunk *c);
+void skip_monster_turns(struct chunk *c, s32b to);
+void free_monster_queue(struct chunk *c);
 void process_monsters(struct chunk *c, int minimum_energy);
 void reset_monsters(void);
 void restore_monsters(void);
@@ -21,6 +21,7 @@
 #include "datafile.h"
 #include "mon-group.h"
 #include "mon-make.h"
+#include "mon-move.h"
 #include "mon-summon.h"
 #include "mon-util.h"
 #include "parser.h"
@@ -369,7 +370,7 @@ static int call_monster(struct loc grid)
 	monster_wake(mon, false, 100);
 
 	/* Set it's energy to 0 */
-	mon->energy = 0;
+	monster_set_energy(cave, mon, 0);
 
 	return (mon->race->level);
 }
@@ -440,7 +441,7 @@ int summon_specific(struct loc grid, int lev, int type, bool delay, bool call)
 	get_mon_num_prep(summon_specific_okay);
 
 	/* Pick a monster, using the level calculation */
-	race = get_mon_num((player->depth + lev) / 2 + 5);
+	race = get_mon_num(cave, (player->depth + lev) / 2 + 5);
 
 	/* Prepare allocation table */
 	get_mon_num_prep(NULL);
@@ -468,7 +469,7 @@ int summon_specific(struct loc grid, int lev, int type, bool delay, bool call)
 	 * including holding faster monsters for the required number of turns */
 	if (delay) {
 		int turns = (mon->race->speed + 9 - player->state.speed) / 10;
-		mon->energy = 0;
+		monster_set_energy(cave, mon, 0);
 		if (turns) {
 			/* Set timer directly to avoid resistance */
 			mon->m_timed[MON_TMD_HOLD] = turns;
@@ -492,7 +493,7 @@ struct monster_race *select_shape(struct monster *mon, int type)
 	get_mon_num_prep(summon_specific_okay);
 
 	/* Pick a monster */
-	race = get_mon_num(player->depth + 5);
+	race = get_mon_num(cave, player->depth + 5);
 
 	/* Prepare allocation table */
 	get_mon_num_prep(NULL);
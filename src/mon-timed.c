@@ -19,6 +19,7 @@
 #include "angband.h"
 #include "mon-desc.h"
 #include "mon-lore.h"
+#include "mon-move.h"
 #include "mon-msg.h"
 #include "mon-predicate.h"
 #include "mon-spell.h"
@@ -147,6 +148,8 @@ static bool mon_set_timed(struct monster *mon,
 	bool check_resist;
 	bool resisted = false;
 	bool update = false;
+	bool speed = effect_type == MON_TMD_FAST || effect_type == MON_TMD_SLOW ||
+		effect_type == MON_TMD_CHANGED;
 
 	int m_note = 0;
 	int old_timer = mon->m_timed[effect_type];
@@ -183,6 +186,9 @@ static bool mon_set_timed(struct monster *mon,
 		resisted = true;
 		m_note = MON_MSG_UNAFFECTED;
 	} else {
+		/* Energy gained so far is at the old speed */
+		if (speed)
+			monster_energy_settle(cave, mon);
 		mon->m_timed[effect_type] = timer;
 		update = true;
 	}
@@ -201,6 +207,10 @@ static bool mon_set_timed(struct monster *mon,
 		}
 	}
 
+	/* Speed changes change when the monster can next move */
+	if (update && speed)
+		monster_schedule(cave, mon);
+
 	/* Print a message if there is one, if the effect allows for it, and if
 	 * either the monster is visible, or we're trying to ID something */
 	if (m_note &&
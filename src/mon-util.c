@@ -45,6 +45,7 @@
 #include "player-util.h"
 #include "project.h"
 #include "trap.h"
+#include "z-names.h"
 #include "z-set.h"
 
 static const struct monster_flag monster_flag_table[] =
@@ -103,6 +104,11 @@ void create_mon_flag_mask(bitflag *f, ...)
 }
 
 
+/**
+ * Index of r_info by race name, built on first use
+ */
+static struct name_map *race_names;
+
 /**
  * Returns the monster with the given name. If no monster has the exact name
  * given, returns the first monster with the given name as a (case-insensitive)
@@ -111,25 +117,39 @@ void create_mon_flag_mask(bitflag *f, ...)
 struct monster_race *lookup_monster(const char *name)
 {
 	int i;
-	struct monster_race *closest = NULL;
 
-	/* Look for it */
+	if (!r_info) return NULL;
+
+	/* Index the races the first time through */
+	if (!race_names) {
+		race_names = name_map_new(z_info->r_max);
+		for (i = 0; i < z_info->r_max; i++) {
+			if (r_info[i].name)
+				name_map_add(race_names, r_info[i].name, i);
+		}
+	}
+
+	/* Look for an exact match */
+	i = name_map_find(race_names, name);
+	if (i >= 0) return &r_info[i];
+
+	/* Fall back to the first close match */
 	for (i = 0; i < z_info->r_max; i++) {
 		struct monster_race *race = &r_info[i];
-		if (!race->name)
-			continue;
-
-		/* Test for equality */
-		if (my_stricmp(name, race->name) == 0)
+		if (race->name && my_stristr(race->name, name))
 			return race;
-
-		/* Test for close matches */
-		if (!closest && my_stristr(race->name, name))
-			closest = race;
 	}
 
-	/* Return our best match */
-	return closest;
+	return NULL;
+}
+
+/**
+ * Forget the race name index, for when r_info goes away
+ */
+void lookup_monster_cleanup(void)
+{
+	name_map_free(race_names);
+	race_names = NULL;
 }
 
 /**
@@ -190,7 +210,7 @@ static void path_analyse(struct chunk *c, struct loc grid)
 	for (i = 0; i < path_n - 1; ++i) {
 		/* Forget grids which would block los */
 		if (square_iswall(player->cave, path_g[i])) {
-			sqinfo_off(square(c, path_g[i]).info, SQUARE_SEEN);
+			sqinfo_off(square_info(c, path_g[i]), SQUARE_SEEN);
 			square_forget(c, path_g[i]);
 			square_light_spot(c, path_g[i]);
 		}
@@ -261,9 +281,8 @@ void update_mon(struct monster *mon, struct chunk *c, bool full)
 
 	int d;
 
-	/* If still generating the level, measure distances from the middle */
-	struct loc pgrid = character_dungeon ? player->grid :
-		loc(c->width / 2, c->height / 2);
+	/* Where distances are measured from */
+	struct loc pgrid;
 
 	/* Seen at all */
 	bool flag = false;
@@ -272,7 +291,7 @@ void update_mon(struct monster *mon, struct chunk *c, bool full)
 	bool easy = false;
 
 	/* ESP permitted */
-	bool telepathy_ok = player_of_has(player, OF_TELEPATHY);
+	bool telepathy_ok;
 
 	assert(mon != NULL);
 
@@ -281,6 +300,11 @@ void update_mon(struct monster *mon, struct chunk *c, bool full)
 		return;
 	}
 
+	/* If still generating the level, measure distances from the middle */
+	pgrid = character_dungeon ? player->grid :
+		loc(c->width / 2, c->height / 2);
+	telepathy_ok = player_of_has(player, OF_TELEPATHY);
+
 	lore = get_lore(mon->race);
 	
 	/* Compute distance, or just use the current one */
@@ -525,8 +549,8 @@ void monster_swap(struct loc grid1, struct loc grid2)
 	struct loc pgrid = player->grid;
 
 	/* Monsters */
-	m1 = cave->squares[grid1.y][grid1.x].mon;
-	m2 = cave->squares[grid2.y][grid2.x].mon;
+	m1 = square_midx(cave, grid1);
+	m2 = square_midx(cave, grid2);
 
 	/* Update grids */
 	square_set_mon(cave, grid1, m2);
@@ -725,7 +749,6 @@ void update_smart_learn(struct monster *mon, struct player *p, int flag,
 			= player->state.el_info[element].res_level;
 }
 
-#define MAX_KIN_RADIUS			5
 #define MAX_KIN_DISTANCE		5
 
 /**
@@ -771,14 +794,13 @@ static struct monster *get_injured_kin(struct chunk *c,
  */
 bool find_any_nearby_injured_kin(struct chunk *c, const struct monster *mon)
 {
-	struct loc grid;
-	for (grid.y = mon->grid.y - MAX_KIN_RADIUS;
-		 grid.y <= mon->grid.y + MAX_KIN_RADIUS; grid.y++) {
-		for (grid.x = mon->grid.x - MAX_KIN_RADIUS;
-			 grid.x <= mon->grid.x + MAX_KIN_RADIUS; grid.x++) {
-			if (get_injured_kin(c, mon, grid) != NULL) {
-				return true;
-			}
+	struct monster_iter iter;
+	struct monster *kin;
+
+	monster_iter_near(&iter, c, mon->grid, MAX_KIN_DISTANCE);
+	while ((kin = monster_iter_next(&iter))) {
+		if (get_injured_kin(c, mon, kin->grid) != NULL) {
+			return true;
 		}
 	}
 
@@ -788,23 +810,20 @@ bool find_any_nearby_injured_kin(struct chunk *c, const struct monster *mon)
 /**
  * Choose one injured monster of the same base in LOS of the provided monster.
  *
- * Scan MAX_KIN_RADIUS grids around the monster to find potential grids,
- * make a list of kin, and choose a random one.
+ * Look at the monsters within MAX_KIN_DISTANCE of the monster, make a list
+ * of kin, and choose a random one.
  */
 struct monster *choose_nearby_injured_kin(struct chunk *c,
 										  const struct monster *mon)
 {
 	struct set *set = set_new();
-	struct loc grid;
-
-	for (grid.y = mon->grid.y - MAX_KIN_RADIUS;
-		 grid.y <= mon->grid.y + MAX_KIN_RADIUS; grid.y++) {
-		for (grid.x = mon->grid.x - MAX_KIN_RADIUS;
-			 grid.x <= mon->grid.x + MAX_KIN_RADIUS; grid.x++) {
-			struct monster *kin = get_injured_kin(c, mon, grid);
-			if (kin != NULL) {
-				set_add(set, kin);
-			}
+	struct monster_iter iter;
+	struct monster *kin;
+
+	monster_iter_near(&iter, c, mon->grid, MAX_KIN_DISTANCE);
+	while ((kin = monster_iter_next(&iter))) {
+		if (get_injured_kin(c, mon, kin->grid) != NULL) {
+			set_add(set, kin);
 		}
 	}
 
@@ -1461,7 +1480,7 @@ bool monster_change_shape(struct monster *mon)
 			get_mon_num_prep(monster_base_shape_okay);
 
 			/* Pick a random race */
-			race = get_mon_num(player->depth + 5);
+			race = get_mon_num(cave, player->depth + 5);
 
 			/* Reset allocation table */
 			get_mon_num_prep(NULL);
@@ -380,6 +380,8 @@ struct monster {
 
 	byte mspeed;						/* Monster "speed" */
 	byte energy;						/* Monster "energy" */
+	s32b energy_turn;					/* First turn not yet in "energy" */
+	s32b ready_turn;					/* Turn it can next move, or -1 */
 
 	byte cdis;							/* Current dis from player */
 
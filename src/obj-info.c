@@ -628,20 +628,16 @@ static int obj_known_blows(const struct object *obj, int max_num,
 	struct player_state state;
 
 	int weapon_slot = slot_by_name(player, "weapon");
-	struct object *current_weapon = slot_object(player, weapon_slot);
 	int num = 0;
 
 	/* Not a weapon - no blows! */
 	if (!tval_is_melee_weapon(obj)) return 0;
 
-	/* Pretend we're wielding the object */
-	player->body.slots[weapon_slot].obj = (struct object *) obj;
-
-	/* Calculate the player's hypothetical state */
+	/* Calculate the player's hypothetical state, wielding the object */
 	memcpy(&state, &player->state, sizeof(state));
 	state.stat_ind[STAT_STR] = 0; //Hack - NRM
 	state.stat_ind[STAT_DEX] = 0; //Hack - NRM
-	calc_bonuses(player, &state, true, false);
+	calc_bonuses_swap(player, &state, weapon_slot, (struct object *) obj);
 
 	/* First entry is always the current num of blows. */
 	possible_blows[num].str_plus = 0;
@@ -660,14 +656,12 @@ static int obj_known_blows(const struct object *obj, int max_num,
 			int new_blows = 0;
 
 			/* Unlikely */
-			if (num == max_num) {
-				player->body.slots[weapon_slot].obj = current_weapon;
-				return num;
-			}
+			if (num == max_num) return num;
 
 			state.stat_ind[STAT_STR] = str_plus; //Hack - NRM
 			state.stat_ind[STAT_DEX] = dex_plus; //Hack - NRM
-			calc_bonuses(player, &state, true, false);
+			calc_bonuses_swap(player, &state, weapon_slot,
+							  (struct object *) obj);
 			new_blows = state.num_blows;
 
 			/* Test to make sure that this extra blow is a
@@ -700,9 +694,6 @@ static int obj_known_blows(const struct object *obj, int max_num,
 		}
 	}
 
-	/* Stop pretending */
-	player->body.slots[weapon_slot].obj = current_weapon;
-
 	return num;
 }
 
@@ -783,20 +774,14 @@ static bool obj_known_damage(const struct object *obj, int *normal_damage,
 
 	struct player_state state;
 	int weapon_slot = slot_by_name(player, "weapon");
-	struct object *current_weapon = slot_object(player, weapon_slot);
 
-	/* Pretend we're wielding the object if it's a weapon */
-	if (weapon)
-		player->body.slots[weapon_slot].obj = (struct object *) obj;
-
-	/* Calculate the player's hypothetical state */
+	/* Calculate the player's hypothetical state, wielding the object if
+	 * it's a weapon */
 	memcpy(&state, &player->state, sizeof(state));
 	state.stat_ind[STAT_STR] = 0; //Hack - NRM
 	state.stat_ind[STAT_DEX] = 0; //Hack - NRM
-	calc_bonuses(player, &state, true, false);
-
-	/* Stop pretending */
-	player->body.slots[weapon_slot].obj = current_weapon;
+	calc_bonuses_swap(player, &state, weapon_slot, weapon ?
+					  (struct object *) obj : slot_object(player, weapon_slot));
 
 	/* Finish if dice not known */
 	dice = obj->known->dd;
@@ -973,20 +958,14 @@ static bool o_obj_known_damage(const struct object *obj, int *normal_damage,
 
 	struct player_state state;
 	int weapon_slot = slot_by_name(player, "weapon");
-	struct object *current_weapon = slot_object(player, weapon_slot);
-
-	/* Pretend we're wielding the object if it's a weapon */
-	if (weapon)
-		player->body.slots[weapon_slot].obj = (struct object *) obj;
 
-	/* Calculate the player's hypothetical state */
+	/* Calculate the player's hypothetical state, wielding the object if
+	 * it's a weapon */
 	memcpy(&state, &player->state, sizeof(state));
 	state.stat_ind[STAT_STR] = 0; //Hack - NRM
 	state.stat_ind[STAT_DEX] = 0; //Hack - NRM
-	calc_bonuses(player, &state, true, false);
-
-	/* Stop pretending */
-	player->body.slots[weapon_slot].obj = current_weapon;
+	calc_bonuses_swap(player, &state, weapon_slot, weapon ?
+					  (struct object *) obj : slot_object(player, weapon_slot));
 
 	/* Finish if dice not known */
 	dice = obj->known->dd * 100;
@@ -1243,19 +1222,12 @@ static void obj_known_misc_combat(const struct object *obj, bool *thrown_effect,
 	if (weapon) {
 		struct player_state state;
 		int weapon_slot = slot_by_name(player, "weapon");
-		struct object *current = equipped_item_by_slot_name(player, "weapon");
-
-		/* Pretend we're wielding the object */
-		player->body.slots[weapon_slot].obj = (struct object *) obj;
 
-		/* Calculate the player's hypothetical state */
+		/* Calculate the player's hypothetical state, wielding the object */
 		memcpy(&state, &player->state, sizeof(state));
 		state.stat_ind[STAT_STR] = 0; //Hack - NRM
 		state.stat_ind[STAT_DEX] = 0; //Hack - NRM
-		calc_bonuses(player, &state, true, false);
-
-		/* Stop pretending */
-		player->body.slots[weapon_slot].obj = current;
+		calc_bonuses_swap(player, &state, weapon_slot, (struct object *) obj);
 
 		/* Warn about heavy weapons */
 		*heavy = state.heavy_wield;
@@ -1330,7 +1302,6 @@ static bool obj_known_digging(struct object *obj, int deciturns[])
 	int i;
 	int chances[DIGGING_MAX];
 	int slot = wield_slot(obj);
-	struct object *current = slot_object(player, slot);
 
 	/* Doesn't remotely resemble a digger */
 	if (!tval_is_wearable(obj) ||
@@ -1341,17 +1312,11 @@ static bool obj_known_digging(struct object *obj, int deciturns[])
 	if (!tval_is_melee_weapon(obj) && !obj->known->modifiers[OBJ_MOD_TUNNEL])
 		return false;
 
-	/* Pretend we're wielding the object */
-	player->body.slots[slot].obj = obj;
-
-	/* Calculate the player's hypothetical state */
+	/* Calculate the player's hypothetical state, wielding the object */
 	memcpy(&state, &player->state, sizeof(state));
 	state.stat_ind[STAT_STR] = 0; //Hack - NRM
 	state.stat_ind[STAT_DEX] = 0; //Hack - NRM
-	calc_bonuses(player, &state, true, false);
-
-	/* Stop pretending */
-	player->body.slots[slot].obj = current;
+	calc_bonuses_swap(player, &state, slot, obj);
 
 	calc_digging_chances(&state, chances);
 
@@ -2000,6 +2000,7 @@ static void cleanup_object(void)
 		free_effect(kind->effect);
 	}
 	mem_free(k_info);
+	lookup_sval_cleanup();
 }
 
 struct file_parser object_parser = {
@@ -853,7 +853,7 @@ void object_sense(struct player *p, struct object *obj)
 
 		/* Attach it to the current floor pile */
 		new_obj->grid = grid;
-		pile_insert_end(&p->cave->squares[grid.y][grid.x].obj, new_obj);
+		pile_insert_end(&p->cave->squares.obj[square_idx(p->cave, grid)], new_obj);
 	}
 }
 
@@ -890,7 +890,7 @@ void object_see(struct player *p, struct object *obj)
 		new_obj->grid = grid;
 		new_obj->number = obj->number;
 		if (!square_holds_object(p->cave, grid, new_obj)) {
-			pile_insert_end(&p->cave->squares[grid.y][grid.x].obj, new_obj);
+			pile_insert_end(&p->cave->squares.obj[square_idx(p->cave, grid)], new_obj);
 		}
 	} else if (known_obj->kind != obj->kind) {
 		struct loc old = known_obj->grid;
@@ -910,7 +910,7 @@ void object_see(struct player *p, struct object *obj)
 		known_obj->grid = grid;
 		known_obj->held_m_idx = 0;
 		if (!square_holds_object(p->cave, grid, known_obj)) {
-			pile_insert_end(&p->cave->squares[grid.y][grid.x].obj, known_obj);
+			pile_insert_end(&p->cave->squares.obj[square_idx(p->cave, grid)], known_obj);
 		}
 	} else if (!square_holds_object(p->cave, grid, known_obj)) {
 		struct loc old = known_obj->grid;
@@ -927,7 +927,7 @@ void object_see(struct player *p, struct object *obj)
 		/* Attach it to the current floor pile */
 		known_obj->grid = grid;
 		known_obj->held_m_idx = 0;
-		pile_insert_end(&p->cave->squares[grid.y][grid.x].obj, known_obj);
+		pile_insert_end(&p->cave->squares.obj[square_idx(p->cave, grid)], known_obj);
 	}
 }
 
@@ -1173,6 +1173,7 @@ void update_player_object_knowledge(struct player *p)
 	if (cave)
 		autoinscribe_ground();
 	autoinscribe_pack();
+	p->upkeep->update |= (PU_BONUS);
 	event_signal(EVENT_INVENTORY);
 	event_signal(EVENT_EQUIPMENT);
 }
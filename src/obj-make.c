@@ -20,6 +20,7 @@
 #include "alloc.h"
 #include "cave.h"
 #include "effects.h"
+#include "generate.h"
 #include "init.h"
 #include "obj-curse.h"
 #include "obj-gear.h"
@@ -179,6 +180,9 @@ static void init_obj_make(void) {
 	alloc_init_objects();
 	alloc_init_egos();
 	init_money_svals();
+
+	/* Index the kind names now, rather than on a generator's first lookup */
+	(void) lookup_sval(TV_NULL, "");
 }
 
 static void cleanup_obj_make(void) {
@@ -286,16 +290,17 @@ static struct ego_item *ego_find_random(struct object *obj, int level)
 {
 	int i;
 	long total = 0L;
+	struct ego_item *pick = NULL;
+
+	const alloc_entry *table = alloc_ego_table;
 
-	alloc_entry *table = alloc_ego_table;
+	/* The chances for this object, kept apart from the shared table */
+	int *prob = mem_zalloc(alloc_ego_size * sizeof(*prob));
 
 	/* Go through all possible ego items and find ones which fit this item */
 	for (i = 0; i < alloc_ego_size; i++) {
 		struct ego_item *ego = &e_info[table[i].index];
 
-		/* Reset any previous probability of this type being picked */
-		table[i].prob3 = 0;
-
 		if (level <= ego->alloc_max) {
 			int ood_chance = MAX(2, (ego->alloc_min - level) / 3);
 			if (level >= ego->alloc_min || one_in_(ood_chance)) {
@@ -303,12 +308,12 @@ static struct ego_item *ego_find_random(struct object *obj, int level)
 
 				for (poss = ego->poss_items; poss; poss = poss->next)
 					if (poss->kidx == obj->kind->kidx) {
-						table[i].prob3 = table[i].prob2;
+						prob[i] = table[i].prob2;
 						break;
 					}
 
 				/* Total */
-				total += table[i].prob3;
+				total += prob[i];
 			}
 		}
 	}
@@ -317,16 +322,18 @@ static struct ego_item *ego_find_random(struct object *obj, int level)
 		long value = randint0(total);
 		for (i = 0; i < alloc_ego_size; i++) {
 			/* Found the entry */
-			if (value < table[i].prob3) {
-				return &e_info[table[i].index];
+			if (value < prob[i]) {
+				pick = &e_info[table[i].index];
+				break;
 			} else {
 				/* Decrement */
-				value = value - table[i].prob3;
+				value = value - prob[i];
 			}
 		}
 	}
 
-	return NULL;
+	mem_free(prob);
+	return pick;
 }
 
 
@@ -519,17 +526,18 @@ void copy_artifact_data(struct object *obj, const struct artifact *art)
  * We *prefer* to create the special artifacts in order, but this is
  * normally outweighed by the "rarity" rolls for those artifacts.
  */
-static struct object *make_artifact_special(int level)
+static struct object *make_artifact_special(struct chunk *c, int level)
 {
 	int i;
 	struct object *new_obj;
+	struct player *p = gen_player(c);
 
 	/* No artifacts, do nothing */
-	if (OPT(player, birth_no_artifacts))
+	if (OPT(p, birth_no_artifacts))
 		return NULL;
 
 	/* No artifacts in the town */
-	if (!player->depth)
+	if (!p->depth)
 		return NULL;
 
 	/* Check the special artifacts */
@@ -547,19 +555,19 @@ static struct object *make_artifact_special(int level)
 		if (!kf_has(kind->kind_flags, KF_INSTA_ART)) continue;
 
 		/* Cannot make an artifact twice */
-		if (art->created) continue;
+		if (*gen_created(c, art)) continue;
 
 		/* Enforce minimum "depth" (loosely) */
-		if (art->alloc_min > player->depth) {
+		if (art->alloc_min > p->depth) {
 			/* Get the "out-of-depth factor" */
-			int d = (art->alloc_min - player->depth) * 2;
+			int d = (art->alloc_min - p->depth) * 2;
 
 			/* Roll for out-of-depth creation */
 			if (randint0(d) != 0) continue;
 		}
 
 		/* Enforce maximum depth (strictly) */
-		if (art->alloc_max < player->depth) continue;
+		if (art->alloc_max < p->depth) continue;
 
 		/* Artifact "rarity roll" */
 		if (randint1(100) > art->alloc_prob) continue;
@@ -584,7 +592,7 @@ static struct object *make_artifact_special(int level)
 		copy_artifact_data(new_obj, art);
 
 		/* Mark the artifact as "created" */
-		art->created = true;
+		*gen_created(c, art) = true;
 
 		/* Success */
 		return new_obj;
@@ -604,18 +612,19 @@ static struct object *make_artifact_special(int level)
  *
  * Note -- see "make_artifact_special()" and "apply_magic()"
  */
-static bool make_artifact(struct object *obj)
+static bool make_artifact(struct chunk *c, struct object *obj)
 {
 	int i;
 	bool art_ok = true;
+	struct player *p = gen_player(c);
 
 	/* Make sure birth no artifacts isn't set */
-	if (OPT(player, birth_no_artifacts)) art_ok = false;
+	if (OPT(p, birth_no_artifacts)) art_ok = false;
 
 	if (!art_ok) return (false);
 
 	/* No artifacts in the town */
-	if (!player->depth) return (false);
+	if (!p->depth) return (false);
 
 	/* Paranoia -- no "plural" artifacts */
 	if (obj->number != 1) return (false);
@@ -635,24 +644,24 @@ static bool make_artifact(struct object *obj)
 		if (kf_has(kind->kind_flags, KF_INSTA_ART)) continue;
 
 		/* Cannot make an artifact twice */
-		if (art->created) continue;
+		if (*gen_created(c, art)) continue;
 
 		/* Must have the correct fields */
 		if (art->tval != obj->tval) continue;
 		if (art->sval != obj->sval) continue;
 
 		/* XXX XXX Enforce minimum "depth" (loosely) */
-		if (art->alloc_min > player->depth)
+		if (art->alloc_min > p->depth)
 		{
 			/* Get the "out-of-depth factor" */
-			int d = (art->alloc_min - player->depth) * 2;
+			int d = (art->alloc_min - p->depth) * 2;
 
 			/* Roll for out-of-depth creation */
 			if (randint0(d) != 0) continue;
 		}
 
 		/* Enforce maximum depth (strictly) */
-		if (art->alloc_max < player->depth) continue;
+		if (art->alloc_max < p->depth) continue;
 
 		/* We must make the "rarity roll" */
 		if (randint1(100) > art->alloc_prob) continue;
@@ -663,7 +672,7 @@ static bool make_artifact(struct object *obj)
 
 	if (obj->artifact) {
 		copy_artifact_data(obj, obj->artifact);
-		obj->artifact->created = true;
+		*gen_created(c, obj->artifact) = true;
 		return true;
 	}
 
@@ -870,7 +879,7 @@ static int apply_curse(struct object *obj, int lev)
  *
  * The `good` argument forces the item to be at least `good`, and the `great`
  * argument does likewise.  Setting `allow_artifacts` to true allows artifacts
- * to be created here.
+ * to be created here, for the level `c`.
  *
  * If `good` or `great` are not set, then the `lev` argument controls the
  * quality of item.
@@ -878,8 +887,8 @@ static int apply_curse(struct object *obj, int lev)
  * Returns 0 if a normal object, 1 if a good object, 2 if an ego item, 3 if an
  * artifact.
  */
-int apply_magic(struct object *obj, int lev, bool allow_artifacts, bool good,
-				bool great, bool extra_roll)
+int apply_magic(struct chunk *c, struct object *obj, int lev,
+				bool allow_artifacts, bool good, bool great, bool extra_roll)
 {
 	int i;
 	s16b power = 0;
@@ -923,7 +932,7 @@ int apply_magic(struct object *obj, int lev, bool allow_artifacts, bool good,
 
 		/* Roll for artifacts if allowed */
 		for (i = 0; i < rolls; i++)
-			if (make_artifact(obj)) return 3;
+			if (make_artifact(c, obj)) return 3;
 	}
 
 	/* Try to make an ego item */
@@ -1132,7 +1141,7 @@ struct object *make_object(struct chunk *c, int lev, bool good, bool great,
 
 	/* Try to make a special artifact */
 	if (one_in_(good ? 10 : 1000)) {
-		new_obj = make_artifact_special(lev);
+		new_obj = make_artifact_special(c, lev);
 		if (new_obj) {
 			if (value) *value = object_value_real(new_obj, 1);
 			return new_obj;
@@ -1153,7 +1162,7 @@ struct object *make_object(struct chunk *c, int lev, bool good, bool great,
 	/* Make the object, prep it and apply magic */
 	new_obj = object_new();
 	object_prep(new_obj, kind, lev, RANDOMISE);
-	apply_magic(new_obj, lev, true, good, great, extra_roll);
+	apply_magic(c, new_obj, lev, true, good, great, extra_roll);
 
 	/* Generate multiple items */
 	if (kind->gen_mult_prob >= randint1(100))
@@ -1232,13 +1241,13 @@ struct object_kind *money_kind(const char *name, int value)
  * \param coin_type the name of the type of money object to make
  * \return a pointer to the newly minted cash (cannot fail)
  */
-struct object *make_gold(int lev, char *coin_type)
+struct object *make_gold(struct chunk *c, int lev, char *coin_type)
 {
 	/* This average is 16 at dlev0, 80 at dlev40, 176 at dlev100. */
 	int avg = (16 * lev)/10 + 16;
 	int spread = lev + 10;
 	int value = rand_spread(avg, spread);
-	struct object *new_gold = mem_zalloc(sizeof(*new_gold)); 
+	struct object *new_gold = object_new();
 
 	/* Increase the range to infinite, moving the average to 110% */
 	while (one_in_(100) && value * 10 <= SHRT_MAX)
@@ -1248,7 +1257,7 @@ struct object *make_gold(int lev, char *coin_type)
 	object_prep(new_gold, money_kind(coin_type, value), lev, RANDOMISE);
 
 	/* If we're playing with no_selling, increase the value */
-	if (OPT(player, birth_no_selling) && player->depth)	{
+	if (OPT(gen_player(c), birth_no_selling) && gen_player(c)->depth)	{
 		value *= 5;
 	}
 
@@ -32,14 +32,14 @@ void copy_artifact_data(struct object *obj, const struct artifact *art);
 bool make_fake_artifact(struct object *obj, const struct artifact *artifact);
 void object_prep(struct object *obj, struct object_kind *kind, int lev,
 				 aspect rand_aspect);
-int apply_magic(struct object *obj, int lev, bool okay, bool good,
-				bool great, bool extra_roll);
+int apply_magic(struct chunk *c, struct object *obj, int lev, bool okay,
+				bool good, bool great, bool extra_roll);
 bool kind_is_good(const struct object_kind *kind);
 struct object_kind *get_obj_num(int level, bool good, int tval);
 struct object *make_object(struct chunk *c, int lev, bool good, bool great,
 						   bool extra_roll, s32b *value, int tval);
 void acquirement(struct loc grid, int level, int num, bool great);
 struct object_kind *money_kind(const char *name, int value);
-struct object *make_gold(int lev, char *coin_type);
+struct object *make_gold(struct chunk *c, int lev, char *coin_type);
 
 #endif /* OBJECT_MAKE_H */
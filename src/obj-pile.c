@@ -44,6 +44,7 @@
 #include "player-util.h"
 #include "randname.h"
 #include "trap.h"
+#include "z-pool.h"
 #include "z-queue.h"
 
 /* #define LIST_DEBUG */
@@ -277,12 +278,20 @@ bool pile_contains(const struct object *top, const struct object *obj)
 	return false;
 }
 
+/**
+ * Objects are made and thrown away in large numbers by level generation and
+ * store turnover, so they come from a pool
+ */
+static struct mem_pool *object_pool;
+
 /**
  * Create a new object and return it
  */
 struct object *object_new(void)
 {
-	return mem_zalloc(sizeof(struct object));
+	if (!object_pool)
+		object_pool = mem_pool_new("objects", sizeof(struct object), 256);
+	return mem_pool_alloc(object_pool);
 }
 
 /**
@@ -295,7 +304,16 @@ void object_free(struct object *obj)
 	mem_free(obj->slays);
 	mem_free(obj->brands);
 	mem_free(obj->curses);
-	mem_free(obj);
+	mem_pool_free(object_pool, obj);
+}
+
+/**
+ * Release the memory of the object pool, once every object has been freed
+ */
+void object_pool_destroy(void)
+{
+	mem_pool_destroy(object_pool);
+	object_pool = NULL;
 }
 
 /**
@@ -882,7 +900,7 @@ bool floor_carry(struct chunk *c, struct loc grid, struct object *drop,
 	drop->held_m_idx = 0;
 
 	/* Link to the first object in the pile */
-	pile_insert(&c->squares[grid.y][grid.x].obj, drop);
+	pile_insert(&c->squares.obj[square_idx(c, grid)], drop);
 
 	/* Record in the level list */
 	list_object(c, drop);
@@ -1051,7 +1069,7 @@ void drop_near(struct chunk *c, struct object **dropped, int chance,
 	drop_find_grid(*dropped, &best);
 	if (floor_carry(c, best, *dropped, &dont_ignore)) {
 		sound(MSG_DROP);
-		if (dont_ignore && (square(c, best).mon < 0)) {
+		if (dont_ignore && (square_midx(c, best) < 0)) {
 			msg("You feel something roll beneath your feet.");
 		}
 	} else {
@@ -50,6 +50,7 @@ typedef enum
 
 struct object *object_new(void);
 void object_free(struct object *obj);
+void object_pool_destroy(void);
 void object_delete(struct object **obj_address);
 void object_pile_free(struct object *obj);
 
@@ -41,6 +41,7 @@
 #include "player-spell.h"
 #include "player-util.h"
 #include "randname.h"
+#include "z-names.h"
 #include "z-queue.h"
 
 struct object_base *kb_info;
@@ -444,6 +445,14 @@ struct ego_item *lookup_ego_item(const char *name, int tval, int sval)
 	return NULL;
 }
 
+/**
+ * Per-tval index of k_info by formatted kind name, and how many kinds have
+ * been indexed; kinds are only ever added to the end of k_info, so the index
+ * is extended as k_info grows
+ */
+static struct name_map *kind_names[TV_MAX];
+static int kind_names_count;
+
 /**
  * Return the numeric sval of the object kind with the given `tval` and
  * name `name`.
@@ -456,22 +465,39 @@ int lookup_sval(int tval, const char *name)
 	if (sscanf(name, "%u", &r) == 1)
 		return r;
 
-	/* Look for it */
-	for (k = 0; k < z_info->k_max; k++) {
-		struct object_kind *kind = &k_info[k];
+	if (tval < 0 || tval >= TV_MAX) return -1;
+
+	/* Index any kinds added since the last lookup */
+	for (; kind_names_count < z_info->k_max; kind_names_count++) {
+		struct object_kind *kind = &k_info[kind_names_count];
 		char cmp_name[1024];
 
-		if (!kind || !kind->name) continue;
+		if (!kind->name) continue;
 
 		obj_desc_name_format(cmp_name, sizeof cmp_name, 0, kind->name, 0,
 							 false);
-
-		/* Found a match */
-		if (kind->tval == tval && !my_stricmp(cmp_name, name))
-			return kind->sval;
+		if (!kind_names[kind->tval])
+			kind_names[kind->tval] = name_map_new(0);
+		name_map_add(kind_names[kind->tval], cmp_name, kind_names_count);
 	}
 
-	return -1;
+	if (!kind_names[tval]) return -1;
+	k = name_map_find(kind_names[tval], name);
+	return (k >= 0) ? k_info[k].sval : -1;
+}
+
+/**
+ * Forget the kind name index, for when k_info goes away
+ */
+void lookup_sval_cleanup(void)
+{
+	int i;
+
+	for (i = 0; i < TV_MAX; i++) {
+		name_map_free(kind_names[i]);
+		kind_names[i] = NULL;
+	}
+	kind_names_count = 0;
 }
 
 void object_short_name(char *buf, size_t max, const char *name)
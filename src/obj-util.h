@@ -38,6 +38,7 @@ struct object_kind *objkind_byid(int kidx);
 struct artifact *lookup_artifact_name(const char *name);
 struct ego_item *lookup_ego_item(const char *name, int tval, int sval);
 int lookup_sval(int tval, const char *name);
+void lookup_sval_cleanup(void);
 void object_short_name(char *buf, size_t max, const char *name);
 int compare_items(const struct object *o1, const struct object *o2);
 bool obj_has_charges(const struct object *obj);
@@ -53,32 +53,58 @@ struct parser_spec {
 };
 
 struct parser_value {
-	struct parser_spec spec;
+	const struct parser_spec *spec;
+	const char *text;
 	union {
 		wchar_t cval;
 		int ival;
 		unsigned int uval;
-		char *sval;
+		const char *sval;
 		random_value rval;
 	} u;
 };
 
 struct parser_hook {
 	struct parser_hook *next;
+	struct parser_hook *chain;
 	enum parser_error (*func)(struct parser *p);
+	char *fmt;
 	char *dir;
 	struct parser_spec *fhead;
 	struct parser_spec *ftail;
+	int nspecs;
+	int snapshot_index;
 };
 
+/**
+ * Growable byte buffer used while recording a snapshot
+ */
+struct parser_buf {
+	char *data;
+	size_t len;
+	size_t size;
+};
+
+/**
+ * Hooks are hashed on their directive; this must be a power of two
+ */
+#define PARSER_HOOK_BUCKETS 64
+
 struct parser {
 	enum parser_error error;
 	unsigned int lineno;
 	unsigned int colno;
 	char errmsg[1024];
 	struct parser_hook *hooks;
-	struct parser_value *fhead;
-	struct parser_value *ftail;
+	struct parser_hook *buckets[PARSER_HOOK_BUCKETS];
+	struct parser_value *vals;
+	int nvals;
+	int maxvals;
+	char *line;
+	bool recording;
+	int nrecorded;
+	struct parser_buf rec_hooks;
+	struct parser_buf rec_lines;
 	void *priv;
 };
 
@@ -91,25 +117,21 @@ struct parser *parser_new(void) {
 }
 
 static struct parser_hook *findhook(struct parser *p, const char *dir) {
-	struct parser_hook *h = p->hooks;
+	struct parser_hook *h;
+
+	h = p->buckets[djb2_hash(dir) & (PARSER_HOOK_BUCKETS - 1)];
 	while (h) {
 		if (!strcmp(h->dir, dir))
 			break;
-		h = h->next;
+		h = h->chain;
 	}
 	return h;
 }
 
 static void parser_freeold(struct parser *p) {
-	struct parser_value *v;
-	while (p->fhead) {
-		int t = p->fhead->spec.type & ~PARSE_T_OPT;
-		v = (struct parser_value *)p->fhead->spec.next;
-		if (t == PARSE_T_SYM || t == PARSE_T_STR)
-			mem_free(p->fhead->u.sval);
-		mem_free(p->fhead);
-		p->fhead = v;
-	}
+	p->nvals = 0;
+	mem_free(p->line);
+	p->line = NULL;
 }
 
 static bool parse_random(const char *str, random_value *bonus) {
@@ -197,13 +219,17 @@ static bool parse_random(const char *str, random_value *bonus) {
 	return true;
 }
 
+/**
+ * Appends the current line, already split into values, to the recording
+ */
+static void record_line(struct parser *p, struct parser_hook *h);
+
 /**
  * Parses the provided line.
  *
  * This runs the first parser hook registered with `p` that matches `line`.
  */
 enum parser_error parser_parse(struct parser *p, const char *line) {
-	char *cline;
 	char *tok;
 	struct parser_hook *h;
 	struct parser_spec *s;
@@ -217,8 +243,6 @@ enum parser_error parser_parse(struct parser *p, const char *line) {
 
 	p->lineno++;
 	p->colno = 1;
-	p->fhead = NULL;
-	p->ftail = NULL;
 
 	/* Ignore empty lines and comments. */
 	while (*line && (isspace(*line)))
@@ -226,11 +250,11 @@ enum parser_error parser_parse(struct parser *p, const char *line) {
 	if (!*line || *line == '#')
 		return PARSE_ERROR_NONE;
 
-	cline = string_make(line);
+	/* Values point into this copy until the next line is parsed */
+	p->line = string_make(line);
 
-	tok = strtok(cline, ":");
+	tok = strtok(p->line, ":");
 	if (!tok) {
-		mem_free(cline);
 		p->error = PARSE_ERROR_MISSING_FIELD;
 		return PARSE_ERROR_MISSING_FIELD;
 	}
@@ -239,7 +263,6 @@ enum parser_error parser_parse(struct parser *p, const char *line) {
 	if (!h) {
 		my_strcpy(p->errmsg, tok, sizeof(p->errmsg));
 		p->error = PARSE_ERROR_UNDEFINED_DIRECTIVE;
-		mem_free(cline);
 		return PARSE_ERROR_UNDEFINED_DIRECTIVE;
 	}
 
@@ -269,25 +292,21 @@ enum parser_error parser_parse(struct parser *p, const char *line) {
 			if (!(s->type & PARSE_T_OPT)) {
 				my_strcpy(p->errmsg, s->name, sizeof(p->errmsg));
 				p->error = PARSE_ERROR_MISSING_FIELD;
-				mem_free(cline);
 				return PARSE_ERROR_MISSING_FIELD;
 			}
 			break;
 		}
 
-		/* Allocate a value node. */
-		v = mem_alloc(sizeof *v);
-		v->spec.next = NULL;
-		v->spec.type = s->type;
-		v->spec.name = s->name;
+		/* Take the next value slot. */
+		v = &p->vals[p->nvals];
+		v->spec = s;
+		v->text = tok;
 
 		/* Parse out its value. */
 		if (t == PARSE_T_INT) {
 			char *z = NULL;
 			v->u.ival = strtol(tok, &z, 0);
 			if (z == tok) {
-				mem_free(v);
-				mem_free(cline);
 				my_strcpy(p->errmsg, s->name, sizeof(p->errmsg));
 				p->error = PARSE_ERROR_NOT_NUMBER;
 				return PARSE_ERROR_NOT_NUMBER;
@@ -296,8 +315,6 @@ enum parser_error parser_parse(struct parser *p, const char *line) {
 			char *z = NULL;
 			v->u.uval = strtoul(tok, &z, 0);
 			if (z == tok || *tok == '-') {
-				mem_free(v);
-				mem_free(cline);
 				my_strcpy(p->errmsg, s->name, sizeof(p->errmsg));
 				p->error = PARSE_ERROR_NOT_NUMBER;
 				return PARSE_ERROR_NOT_NUMBER;
@@ -305,26 +322,19 @@ enum parser_error parser_parse(struct parser *p, const char *line) {
 		} else if (t == PARSE_T_CHAR) {
 			text_mbstowcs(&v->u.cval, tok, 1);
 		} else if (t == PARSE_T_SYM || t == PARSE_T_STR) {
-			v->u.sval = string_make(tok);
+			v->u.sval = tok;
 		} else if (t == PARSE_T_RAND) {
 			if (!parse_random(tok, &v->u.rval)) {
-				mem_free(v);
-				mem_free(cline);
 				my_strcpy(p->errmsg, s->name, sizeof(p->errmsg));
 				p->error = PARSE_ERROR_NOT_RANDOM;
 				return PARSE_ERROR_NOT_RANDOM;
 			}
 		}
-
-		/* Link it into the value list. */
-		if (!p->fhead)
-			p->fhead = v;
-		else
-			p->ftail->spec.next = &v->spec;
-		p->ftail = v;
+		p->nvals++;
 	}
 
-	mem_free(cline);
+	if (p->recording)
+		record_line(p, h);
 
 	p->error = h->func(p);
 	return p->error;
@@ -387,9 +397,13 @@ void parser_destroy(struct parser *p) {
 	while (p->hooks) {
 		h = p->hooks->next;
 		clean_specs(p->hooks);
+		mem_free(p->hooks->fmt);
 		mem_free(p->hooks);
 		p->hooks = h;
 	}
+	mem_free(p->vals);
+	mem_free(p->rec_hooks.data);
+	mem_free(p->rec_lines.data);
 	mem_free(p);
 }
 
@@ -408,6 +422,7 @@ static errr parse_specs(struct parser_hook *h, char *fmt) {
 	h->dir = string_make(name);
 	h->fhead = NULL;
 	h->ftail = NULL;
+	h->nspecs = 0;
 	while (name) {
 		/* Lack of a type is legal; that means we're at the end of the line. */
 		stype = strtok(NULL, " ");
@@ -448,6 +463,7 @@ static errr parse_specs(struct parser_hook *h, char *fmt) {
 		else
 			h->fhead = s;
 		h->ftail = s;
+		h->nspecs++;
 	}
 
 	return 0;
@@ -469,7 +485,7 @@ errr parser_reg(struct parser *p, const char *fmt,
                 enum parser_error (*func)(struct parser *p)) {
 	errr r;
 	char *cfmt;
-	struct parser_hook *h;
+	struct parser_hook *h, **bucket;
 
 	assert(p);
 	assert(fmt);
@@ -479,6 +495,7 @@ errr parser_reg(struct parser *p, const char *fmt,
 	cfmt = string_make(fmt);
 	h->next = p->hooks;
 	h->func = func;
+	h->snapshot_index = -1;
 	r = parse_specs(h, cfmt);
 	if (r)
 	{
@@ -487,6 +504,19 @@ errr parser_reg(struct parser *p, const char *fmt,
 		return r;
 	}
 
+	/* Newer hooks go first in their bucket, so they supersede older ones */
+	bucket = &p->buckets[djb2_hash(h->dir) & (PARSER_HOOK_BUCKETS - 1)];
+	h->chain = *bucket;
+	*bucket = h;
+
+	/* Make room for this hook's values */
+	if (h->nspecs > p->maxvals) {
+		p->maxvals = h->nspecs;
+		p->vals = mem_realloc(p->vals, p->maxvals * sizeof(*p->vals));
+	}
+
+	/* Keep the format as given, to tell snapshots of other formats apart */
+	h->fmt = string_make(fmt);
 	p->hooks = h;
 	mem_free(cfmt);
 	return 0;
@@ -505,19 +535,19 @@ enum parser_error ignored(struct parser *p) {
  * Used to test for presence of optional values.
  */
 bool parser_hasval(struct parser *p, const char *name) {
-	struct parser_value *v;
-	for (v = p->fhead; v; v = (struct parser_value *)v->spec.next) {
-		if (!strcmp(v->spec.name, name))
+	int i;
+	for (i = 0; i < p->nvals; i++) {
+		if (!strcmp(p->vals[i].spec->name, name))
 			return true;
 	}
 	return false;
 }
 
 static struct parser_value *parser_getval(struct parser *p, const char *name) {
-	struct parser_value *v;
-	for (v = p->fhead; v; v = (struct parser_value *)v->spec.next) {
-		if (!strcmp(v->spec.name, name)) {
-			return v;
+	int i;
+	for (i = 0; i < p->nvals; i++) {
+		if (!strcmp(p->vals[i].spec->name, name)) {
+			return &p->vals[i];
 		}
 	}
 	quit_fmt("parser_getval error: name is %s\n", name);
@@ -529,7 +559,7 @@ static struct parser_value *parser_getval(struct parser *p, const char *name) {
  */
 const char *parser_getsym(struct parser *p, const char *name) {
 	struct parser_value *v = parser_getval(p, name);
-	assert((v->spec.type & ~PARSE_T_OPT) == PARSE_T_SYM);
+	assert((v->spec->type & ~PARSE_T_OPT) == PARSE_T_SYM);
 	return v->u.sval;
 }
 
@@ -538,7 +568,7 @@ const char *parser_getsym(struct parser *p, const char *name) {
  */
 int parser_getint(struct parser *p, const char *name) {
 	struct parser_value *v = parser_getval(p, name);
-	assert((v->spec.type & ~PARSE_T_OPT) == PARSE_T_INT);
+	assert((v->spec->type & ~PARSE_T_OPT) == PARSE_T_INT);
 	return v->u.ival;
 }
 
@@ -547,7 +577,7 @@ int parser_getint(struct parser *p, const char *name) {
  */
 unsigned int parser_getuint(struct parser *p, const char *name) {
 	struct parser_value *v = parser_getval(p, name);
-	assert((v->spec.type & ~PARSE_T_OPT) == PARSE_T_UINT);
+	assert((v->spec->type & ~PARSE_T_OPT) == PARSE_T_UINT);
 	return v->u.uval;
 }
 
@@ -556,7 +586,7 @@ unsigned int parser_getuint(struct parser *p, const char *name) {
  */
 const char *parser_getstr(struct parser *p, const char *name) {
 	struct parser_value *v = parser_getval(p, name);
-	assert((v->spec.type & ~PARSE_T_OPT) == PARSE_T_STR);
+	assert((v->spec->type & ~PARSE_T_OPT) == PARSE_T_STR);
 	return v->u.sval;
 }
 
@@ -565,7 +595,7 @@ const char *parser_getstr(struct parser *p, const char *name) {
  */
 struct random parser_getrand(struct parser *p, const char *name) {
 	struct parser_value *v = parser_getval(p, name);
-	assert((v->spec.type & ~PARSE_T_OPT) == PARSE_T_RAND);
+	assert((v->spec->type & ~PARSE_T_OPT) == PARSE_T_RAND);
 	return v->u.rval;
 }
 
@@ -574,7 +604,7 @@ struct random parser_getrand(struct parser *p, const char *name) {
  */
 wchar_t parser_getchar(struct parser *p, const char *name) {
 	struct parser_value *v = parser_getval(p, name);
-	assert((v->spec.type & ~PARSE_T_OPT) == PARSE_T_CHAR);
+	assert((v->spec->type & ~PARSE_T_OPT) == PARSE_T_CHAR);
 	return v->u.cval;
 }
 
@@ -598,3 +628,280 @@ void parser_setstate(struct parser *p, unsigned int col, const char *msg) {
 	my_strcpy(p->errmsg, msg, sizeof(p->errmsg));
 }
 
+
+
+/**
+ * ------------------------------------------------------------------------
+ * Snapshots
+ *
+ * A snapshot is the record of every line a parser has run a hook on, with
+ * the line already split into values.  Replaying it runs the same hooks on
+ * the same values in the same order, without any of the text handling.
+ *
+ * All numbers are stored as four little-endian bytes.  The snapshot opens
+ * with the formats of the hooks it uses, each as a string, and then has one
+ * entry per line: the line number, the index of its hook, the number of
+ * values, and the values.  Integers and random values are stored as
+ * numbers, symbols and strings as strings, and characters as the bytes they
+ * were converted from.  Strings are a length followed by the bytes and a
+ * terminating zero, so replayed values can point straight into the snapshot.
+ * ------------------------------------------------------------------------ */
+
+static void buf_put(struct parser_buf *b, const void *data, size_t n) {
+	if (!n) return;
+	if (b->len + n > b->size) {
+		b->size = MAX(b->size * 2, b->len + n + 1024);
+		b->data = mem_realloc(b->data, b->size);
+	}
+	memcpy(b->data + b->len, data, n);
+	b->len += n;
+}
+
+static void buf_put_u32(struct parser_buf *b, u32b n) {
+	byte bytes[4];
+	bytes[0] = n & 0xFF;
+	bytes[1] = (n >> 8) & 0xFF;
+	bytes[2] = (n >> 16) & 0xFF;
+	bytes[3] = (n >> 24) & 0xFF;
+	buf_put(b, bytes, sizeof(bytes));
+}
+
+static void buf_put_str(struct parser_buf *b, const char *str, size_t n) {
+	buf_put_u32(b, n);
+	buf_put(b, str, n);
+	buf_put(b, "", 1);
+}
+
+static void record_line(struct parser *p, struct parser_hook *h) {
+	int i;
+
+	/* Hooks are numbered in the order they are first used */
+	if (h->snapshot_index < 0) {
+		h->snapshot_index = p->nrecorded++;
+		buf_put_str(&p->rec_hooks, h->fmt, strlen(h->fmt));
+	}
+
+	buf_put_u32(&p->rec_lines, p->lineno);
+	buf_put_u32(&p->rec_lines, h->snapshot_index);
+	buf_put_u32(&p->rec_lines, p->nvals);
+	for (i = 0; i < p->nvals; i++) {
+		struct parser_value *v = &p->vals[i];
+		int t = v->spec->type & ~PARSE_T_OPT;
+
+		if (t == PARSE_T_INT) {
+			buf_put_u32(&p->rec_lines, (u32b)v->u.ival);
+		} else if (t == PARSE_T_UINT) {
+			buf_put_u32(&p->rec_lines, v->u.uval);
+		} else if (t == PARSE_T_CHAR) {
+			/* The conversion never looks further than one character */
+			size_t n = 0;
+			while (n < MB_LEN_MAX && v->text[n]) n++;
+			buf_put_str(&p->rec_lines, v->text, n);
+		} else if (t == PARSE_T_SYM || t == PARSE_T_STR) {
+			buf_put_str(&p->rec_lines, v->u.sval, strlen(v->u.sval));
+		} else if (t == PARSE_T_RAND) {
+			buf_put_u32(&p->rec_lines, (u32b)v->u.rval.base);
+			buf_put_u32(&p->rec_lines, (u32b)v->u.rval.dice);
+			buf_put_u32(&p->rec_lines, (u32b)v->u.rval.sides);
+			buf_put_u32(&p->rec_lines, (u32b)v->u.rval.m_bonus);
+		}
+	}
+}
+
+/**
+ * Starts recording every line the parser runs a hook on.
+ */
+void parser_record(struct parser *p) {
+	struct parser_hook *h;
+
+	for (h = p->hooks; h; h = h->next)
+		h->snapshot_index = -1;
+	p->nrecorded = 0;
+	p->rec_hooks.len = 0;
+	p->rec_lines.len = 0;
+	p->recording = true;
+}
+
+/**
+ * Stops recording, and returns a snapshot of what was recorded.  The
+ * snapshot is `len` bytes long, and should be freed by the caller.
+ */
+char *parser_recording(struct parser *p, size_t *len) {
+	struct parser_buf snap = { NULL, 0, 0 };
+
+	buf_put_u32(&snap, p->nrecorded);
+	buf_put(&snap, p->rec_hooks.data, p->rec_hooks.len);
+	buf_put(&snap, p->rec_lines.data, p->rec_lines.len);
+	p->recording = false;
+
+	*len = snap.len;
+	return snap.data;
+}
+
+/**
+ * Reads a snapshot, checking as it goes that it doesn't run off the end
+ */
+struct snapshot_reader {
+	const byte *pos;
+	const byte *end;
+	bool bad;
+};
+
+static u32b snap_get_u32(struct snapshot_reader *r) {
+	u32b n;
+
+	if (r->bad || r->end - r->pos < 4) {
+		r->bad = true;
+		return 0;
+	}
+	n = r->pos[0] | (r->pos[1] << 8) | (r->pos[2] << 16) |
+		((u32b)r->pos[3] << 24);
+	r->pos += 4;
+	return n;
+}
+
+static const char *snap_get_str(struct snapshot_reader *r) {
+	const char *str;
+	u32b n = snap_get_u32(r);
+
+	if (r->bad || (size_t)(r->end - r->pos) <= n || r->pos[n]) {
+		r->bad = true;
+		return NULL;
+	}
+	str = (const char *)r->pos;
+	r->pos += n + 1;
+	return str;
+}
+
+/**
+ * Reads the hook formats from the start of a snapshot, and matches each one
+ * with a hook of the same format in `p`.  Returns NULL if that can't be done.
+ */
+static struct parser_hook **snapshot_hooks(struct parser *p,
+										   struct snapshot_reader *r,
+										   u32b *count) {
+	u32b i, n = snap_get_u32(r);
+	struct parser_hook **hooks;
+
+	if (r->bad || n > (u32b)(r->end - r->pos) / 5)
+		return NULL;
+
+	hooks = mem_zalloc(MAX(n, 1) * sizeof(*hooks));
+	for (i = 0; i < n; i++) {
+		char dir[1024];
+		const char *fmt = snap_get_str(r);
+		if (!fmt) break;
+
+		my_strcpy(dir, fmt, sizeof(dir));
+		dir[strcspn(dir, " ")] = '\0';
+		hooks[i] = findhook(p, dir);
+		if (!hooks[i] || !streq(hooks[i]->fmt, fmt)) break;
+	}
+	if (i < n) {
+		mem_free(hooks);
+		return NULL;
+	}
+	*count = n;
+	return hooks;
+}
+
+/**
+ * Reads the next line of a snapshot into the parser's values.  Returns its
+ * hook, or NULL at the end of the snapshot or if it's malformed.
+ */
+static struct parser_hook *snapshot_line(struct parser *p,
+										 struct snapshot_reader *r,
+										 struct parser_hook **hooks,
+										 u32b count) {
+	struct parser_hook *h;
+	struct parser_spec *s;
+	u32b i, n, lineno;
+
+	if (r->pos == r->end)
+		return NULL;
+	lineno = snap_get_u32(r);
+	i = snap_get_u32(r);
+	n = snap_get_u32(r);
+	if (r->bad || i >= count || n > (u32b)hooks[i]->nspecs) {
+		r->bad = true;
+		return NULL;
+	}
+	h = hooks[i];
+
+	parser_freeold(p);
+	p->lineno = lineno;
+	p->colno = 1;
+	for (s = h->fhead; s && p->nvals < (int)n; s = s->next) {
+		struct parser_value *v = &p->vals[p->nvals++];
+		int t = s->type & ~PARSE_T_OPT;
+
+		v->spec = s;
+		v->text = NULL;
+		p->colno++;
+		if (t == PARSE_T_INT) {
+			v->u.ival = (s32b)snap_get_u32(r);
+		} else if (t == PARSE_T_UINT) {
+			v->u.uval = snap_get_u32(r);
+		} else if (t == PARSE_T_CHAR) {
+			v->text = snap_get_str(r);
+			if (v->text)
+				text_mbstowcs(&v->u.cval, v->text, 1);
+		} else if (t == PARSE_T_SYM || t == PARSE_T_STR) {
+			v->u.sval = snap_get_str(r);
+		} else if (t == PARSE_T_RAND) {
+			v->u.rval.base = (s32b)snap_get_u32(r);
+			v->u.rval.dice = (s32b)snap_get_u32(r);
+			v->u.rval.sides = (s32b)snap_get_u32(r);
+			v->u.rval.m_bonus = (s32b)snap_get_u32(r);
+		}
+	}
+
+	/* A mandatory value can't be missing */
+	if (s && !(s->type & PARSE_T_OPT))
+		r->bad = true;
+
+	return r->bad ? NULL : h;
+}
+
+/**
+ * Returns whether a snapshot was made with the same hook formats that `p`
+ * has now, and is complete; only such a snapshot can be replayed.
+ */
+bool parser_snapshot_valid(struct parser *p, const char *snap, size_t len) {
+	struct snapshot_reader r = { (const byte *)snap, (const byte *)snap + len,
+								 false };
+	u32b count;
+	struct parser_hook **hooks = snapshot_hooks(p, &r, &count);
+
+	if (!hooks)
+		return false;
+	while (snapshot_line(p, &r, hooks, count))
+		;
+	parser_freeold(p);
+	mem_free(hooks);
+	return !r.bad;
+}
+
+/**
+ * Runs the hooks on each line of a snapshot, as parser_parse() would have
+ * done for the text it was made from.  The snapshot must have been checked
+ * with parser_snapshot_valid().
+ */
+enum parser_error parser_replay(struct parser *p, const char *snap,
+								size_t len) {
+	struct snapshot_reader r = { (const byte *)snap, (const byte *)snap + len,
+								 false };
+	u32b count;
+	struct parser_hook **hooks = snapshot_hooks(p, &r, &count);
+	struct parser_hook *h;
+
+	assert(hooks);
+	p->error = PARSE_ERROR_NONE;
+	while (!p->error && (h = snapshot_line(p, &r, hooks, count)))
+		p->error = h->func(p);
+
+	/* Nothing may point into the snapshot once it's done with */
+	parser_freeold(p);
+	mem_free(hooks);
+	return p->error;
+}
@@ -64,5 +64,11 @@ extern struct random parser_getrand(struct parser *p, const char *name);
 extern wchar_t parser_getchar(struct parser *p, const char *name);
 extern int parser_getstate(struct parser *p, struct parser_state *s);
 extern void parser_setstate(struct parser *p, unsigned int col, const char *msg);
+extern void parser_record(struct parser *p);
+extern char *parser_recording(struct parser *p, size_t *len);
+extern bool parser_snapshot_valid(struct parser *p, const char *snap,
+								  size_t len);
+extern enum parser_error parser_replay(struct parser *p, const char *snap,
+									   size_t len);
 
 #endif /* !PARSER_H */
@@ -21,6 +21,7 @@
 #include "cmds.h"
 #include "game-event.h"
 #include "game-world.h"
+#include "generate.h"
 #include "init.h"
 #include "mon-lore.h"
 #include "monster.h"
@@ -405,12 +406,8 @@ void player_init(struct player *p)
 	}
 	if (p->timed)
 		mem_free(p->timed);
-	if (p->obj_k) {
-		mem_free(p->obj_k->brands);
-		mem_free(p->obj_k->slays);
-		mem_free(p->obj_k->curses);
-		mem_free(p->obj_k);
-	}
+	if (p->obj_k)
+		object_free(p->obj_k);
 	if (p->history) {
 		string_free(p->history);
 	}
@@ -454,7 +451,7 @@ void player_init(struct player *p)
 	p->upkeep->quiver = mem_zalloc(z_info->quiver_size *
 								   sizeof(struct object *));
 	p->timed = mem_zalloc(TMD_MAX * sizeof(s16b));
-	p->obj_k = mem_zalloc(sizeof(struct object));
+	p->obj_k = object_new();
 	p->obj_k->brands = mem_zalloc(z_info->brand_max * sizeof(bool));
 	p->obj_k->slays = mem_zalloc(z_info->slay_max * sizeof(bool));
 	p->obj_k->curses = mem_zalloc(z_info->curse_max *
@@ -1162,7 +1159,8 @@ void do_cmd_accept_character(struct command *cmd)
 
 	/* Initialise the stores, dungeon */
 	store_reset();
-	chunk_list_max = 0;
+	gen_ahead_cancel();
+	chunk_list_free();
 
 	/* Player learns innate runes */
 	player_learn_innate(player);
@@ -1183,6 +1181,9 @@ void do_cmd_accept_character(struct command *cmd)
 	seed_flavor = randint0(0x10000000);
 	flavor_init();
 
+	/* Seed for levels */
+	Rand_state_seed(&level_rng, randint0(0x10000000));
+
 	/* Know all flavors for auto-ID of consumables */
 	if (OPT(player, birth_know_flavors))
 		flavor_set_all_aware();
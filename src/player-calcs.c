@@ -37,6 +37,7 @@
 #include "player-spell.h"
 #include "player-timed.h"
 #include "player-util.h"
+#include "profile.h"
 
 /**
  * Stat Table (INT) -- Magic devices
@@ -1742,6 +1743,201 @@ static void calc_shapechange(struct player_state *state,
 
 }
 
+/**
+ * What the equipment in one slot adds to the player's state
+ */
+struct slot_bonus {
+	const struct object *obj;	/* The object it was worked out for */
+	bool done;					/* Worked out since the cache was reset */
+	bitflag flags[OF_SIZE];
+	int stat_add[STAT_MAX];
+	int stealth, search, infra, digging, speed, dam_red;
+	int blows, shots, might, moves;
+	int res_level[ELEM_MAX];	/* Best resistance to each element */
+	bool vuln;
+	int ac, to_a, to_h, to_d;
+};
+
+/**
+ * The contribution of each equipment slot, as last worked out by
+ * update_bonuses(), with and without only known runes.  Anything which
+ * changes the equipment or what the player knows about it asks for
+ * PU_BONUS, so while that's pending the cache isn't trusted.  Hypothetical
+ * states then only need to work out again the one slot which has a
+ * different object in it.
+ */
+static struct {
+	struct player *p;
+	struct equip_slot *slots;	/* The body the cache was made for */
+	int count;
+	int weapon, launcher;		/* Slot indices */
+	struct slot_bonus *bonus[2];
+} gear_cache;
+
+/**
+ * Forget everything that's been cached
+ */
+void calc_bonuses_free(void)
+{
+	mem_free(gear_cache.bonus[0]);
+	mem_free(gear_cache.bonus[1]);
+	memset(&gear_cache, 0, sizeof(gear_cache));
+}
+
+/**
+ * Make sure the cache belongs to the player's current body
+ */
+static void gear_cache_check(struct player *p)
+{
+	if (gear_cache.p == p && gear_cache.slots == p->body.slots &&
+		gear_cache.count == p->body.count)
+		return;
+
+	calc_bonuses_free();
+	gear_cache.p = p;
+	gear_cache.slots = p->body.slots;
+	gear_cache.count = p->body.count;
+	gear_cache.weapon = slot_by_name(p, "weapon");
+	gear_cache.launcher = slot_by_name(p, "shooting");
+	gear_cache.bonus[0] = mem_zalloc(p->body.count * sizeof(struct slot_bonus));
+	gear_cache.bonus[1] = mem_zalloc(p->body.count * sizeof(struct slot_bonus));
+}
+
+/**
+ * Work out what the equipment in slot `i` adds to the player's state
+ */
+static void calc_slot_bonus(struct player *p, int i, bool known_only,
+							struct slot_bonus *b)
+{
+	int j, index = 0;
+	struct object *obj = slot_object(p, i);
+	struct curse_data *curse = obj ? obj->curses : NULL;
+	bitflag f[OF_SIZE];
+
+	memset(b, 0, sizeof(*b));
+	b->obj = obj;
+	b->done = true;
+
+	while (obj) {
+		int dig = 0;
+
+		/* Extract the item flags */
+		if (known_only) {
+			object_flags_known(obj, f);
+		} else {
+			object_flags(obj, f);
+		}
+		of_union(b->flags, f);
+
+		/* Apply modifiers */
+		b->stat_add[STAT_STR] += obj->modifiers[OBJ_MOD_STR]
+			* p->obj_k->modifiers[OBJ_MOD_STR];
+		b->stat_add[STAT_INT] += obj->modifiers[OBJ_MOD_INT]
+			* p->obj_k->modifiers[OBJ_MOD_INT];
+		b->stat_add[STAT_WIS] += obj->modifiers[OBJ_MOD_WIS]
+			* p->obj_k->modifiers[OBJ_MOD_WIS];
+		b->stat_add[STAT_DEX] += obj->modifiers[OBJ_MOD_DEX]
+			* p->obj_k->modifiers[OBJ_MOD_DEX];
+		b->stat_add[STAT_CON] += obj->modifiers[OBJ_MOD_CON]
+			* p->obj_k->modifiers[OBJ_MOD_CON];
+		b->stealth += obj->modifiers[OBJ_MOD_STEALTH]
+			* p->obj_k->modifiers[OBJ_MOD_STEALTH];
+		b->search += (obj->modifiers[OBJ_MOD_SEARCH] * 5)
+			* p->obj_k->modifiers[OBJ_MOD_SEARCH];
+
+		b->infra += obj->modifiers[OBJ_MOD_INFRA]
+			* p->obj_k->modifiers[OBJ_MOD_INFRA];
+		if (tval_is_digger(obj)) {
+			if (of_has(obj->flags, OF_DIG_1))
+				dig = 1;
+			else if (of_has(obj->flags, OF_DIG_2))
+				dig = 2;
+			else if (of_has(obj->flags, OF_DIG_3))
+				dig = 3;
+		}
+		dig += obj->modifiers[OBJ_MOD_TUNNEL]
+			* p->obj_k->modifiers[OBJ_MOD_TUNNEL];
+		b->digging += (dig * 20);
+		b->speed += obj->modifiers[OBJ_MOD_SPEED]
+			* p->obj_k->modifiers[OBJ_MOD_SPEED];
+		b->dam_red += obj->modifiers[OBJ_MOD_DAM_RED]
+			* p->obj_k->modifiers[OBJ_MOD_DAM_RED];
+		b->blows += obj->modifiers[OBJ_MOD_BLOWS]
+			* p->obj_k->modifiers[OBJ_MOD_BLOWS];
+		b->shots += obj->modifiers[OBJ_MOD_SHOTS]
+			* p->obj_k->modifiers[OBJ_MOD_SHOTS];
+		b->might += obj->modifiers[OBJ_MOD_MIGHT]
+			* p->obj_k->modifiers[OBJ_MOD_MIGHT];
+		b->moves += obj->modifiers[OBJ_MOD_MOVES]
+			* p->obj_k->modifiers[OBJ_MOD_MOVES];
+
+		/* Apply element info, noting vulnerabilites for later processing */
+		for (j = 0; j < ELEM_MAX; j++) {
+			if (!known_only || obj->known->el_info[j].res_level) {
+				if (obj->el_info[j].res_level == -1)
+					b->vuln = true;
+
+				/* OK because res_level hasn't included vulnerability yet */
+				if (obj->el_info[j].res_level > b->res_level[j])
+					b->res_level[j] = obj->el_info[j].res_level;
+			}
+		}
+
+		/* Apply combat bonuses */
+		b->ac += obj->ac;
+		if (!known_only || obj->known->to_a)
+			b->to_a += obj->to_a;
+		if (!slot_type_is(i, EQUIP_WEAPON) && !slot_type_is(i, EQUIP_BOW)) {
+			if (!known_only || obj->known->to_h) {
+				b->to_h += obj->to_h;
+			}
+			if (!known_only || obj->known->to_d) {
+				b->to_d += obj->to_d;
+			}
+		}
+
+		/* Move to any unprocessed curse object */
+		if (curse) {
+			index++;
+			obj = NULL;
+			while (index < z_info->curse_max) {
+				if (curse[index].power) {
+					obj = curses[index].obj;
+					break;
+				} else {
+					index++;
+				}
+			}
+		} else {
+			obj = NULL;
+		}
+	}
+}
+
+/**
+ * What the equipment in slot `i` adds to the player's state; `update` is
+ * true if the cache is to be brought up to date, and `scratch` is used if
+ * the cached value can't be
+ */
+static const struct slot_bonus *slot_bonus(struct player *p, int i,
+										   bool known_only, bool update,
+										   struct slot_bonus *scratch)
+{
+	struct slot_bonus *b = &gear_cache.bonus[known_only ? 1 : 0][i];
+
+	if (update) {
+		calc_slot_bonus(p, i, known_only, b);
+		return b;
+	}
+
+	if (b->done && b->obj == slot_object(p, i) &&
+		!(p->upkeep->update & (PU_BONUS)))
+		return b;
+
+	calc_slot_bonus(p, i, known_only, scratch);
+	return scratch;
+}
+
 /**
  * Calculate the players current "state", taking into account
  * not only race/class intrinsics, but also objects being worn
@@ -1763,6 +1959,9 @@ static void calc_shapechange(struct player_state *state,
  * If known_only is true, calc_bonuses() will only use the known
  * information of objects; thus it returns what the player _knows_
  * the character state to be.
+ *
+ * What each piece of equipment adds is cached when update is true, and
+ * reused by later hypothetical calls; see slot_bonus().
  */
 void calc_bonuses(struct player *p, struct player_state *state, bool known_only,
 				  bool update)
@@ -1772,9 +1971,8 @@ void calc_bonuses(struct player *p, struct player_state *state, bool known_only,
 	int extra_shots = 0;
 	int extra_might = 0;
 	int extra_moves = 0;
-	struct object *launcher = equipped_item_by_slot_name(p, "shooting");
-	struct object *weapon = equipped_item_by_slot_name(p, "weapon");
-	bitflag f[OF_SIZE];
+	struct object *launcher, *weapon;
+	struct slot_bonus scratch;
 	bitflag collect_f[OF_SIZE];
 	bool vuln[ELEM_MAX];
 
@@ -1812,105 +2010,39 @@ void calc_bonuses(struct player *p, struct player_state *state, bool known_only,
 	player_flags(p, collect_f);
 
 	/* Analyze equipment */
+	gear_cache_check(p);
+	launcher = slot_object(p, gear_cache.launcher);
+	weapon = slot_object(p, gear_cache.weapon);
 	for (i = 0; i < p->body.count; i++) {
-		int index = 0;
-		struct object *obj = slot_object(p, i);
-		struct curse_data *curse = obj ? obj->curses : NULL;
-
-		while (obj) {
-			int dig = 0;
-
-			/* Extract the item flags */
-			if (known_only) {
-				object_flags_known(obj, f);
-			} else {
-				object_flags(obj, f);
-			}
-			of_union(collect_f, f);
-
-			/* Apply modifiers */
-			state->stat_add[STAT_STR] += obj->modifiers[OBJ_MOD_STR]
-				* p->obj_k->modifiers[OBJ_MOD_STR];
-			state->stat_add[STAT_INT] += obj->modifiers[OBJ_MOD_INT]
-				* p->obj_k->modifiers[OBJ_MOD_INT];
-			state->stat_add[STAT_WIS] += obj->modifiers[OBJ_MOD_WIS]
-				* p->obj_k->modifiers[OBJ_MOD_WIS];
-			state->stat_add[STAT_DEX] += obj->modifiers[OBJ_MOD_DEX]
-				* p->obj_k->modifiers[OBJ_MOD_DEX];
-			state->stat_add[STAT_CON] += obj->modifiers[OBJ_MOD_CON]
-				* p->obj_k->modifiers[OBJ_MOD_CON];
-			state->skills[SKILL_STEALTH] += obj->modifiers[OBJ_MOD_STEALTH]
-				* p->obj_k->modifiers[OBJ_MOD_STEALTH];
-			state->skills[SKILL_SEARCH] += (obj->modifiers[OBJ_MOD_SEARCH] * 5)
-				* p->obj_k->modifiers[OBJ_MOD_SEARCH];
-
-			state->see_infra += obj->modifiers[OBJ_MOD_INFRA]
-				* p->obj_k->modifiers[OBJ_MOD_INFRA];
-			if (tval_is_digger(obj)) {
-				if (of_has(obj->flags, OF_DIG_1))
-					dig = 1;
-				else if (of_has(obj->flags, OF_DIG_2))
-					dig = 2;
-				else if (of_has(obj->flags, OF_DIG_3))
-					dig = 3;
-			}
-			dig += obj->modifiers[OBJ_MOD_TUNNEL]
-				* p->obj_k->modifiers[OBJ_MOD_TUNNEL];
-			state->skills[SKILL_DIGGING] += (dig * 20);
-			state->speed += obj->modifiers[OBJ_MOD_SPEED]
-				* p->obj_k->modifiers[OBJ_MOD_SPEED];
-			state->dam_red += obj->modifiers[OBJ_MOD_DAM_RED]
-				* p->obj_k->modifiers[OBJ_MOD_DAM_RED];
-			extra_blows += obj->modifiers[OBJ_MOD_BLOWS]
-				* p->obj_k->modifiers[OBJ_MOD_BLOWS];
-			extra_shots += obj->modifiers[OBJ_MOD_SHOTS]
-				* p->obj_k->modifiers[OBJ_MOD_SHOTS];
-			extra_might += obj->modifiers[OBJ_MOD_MIGHT]
-				* p->obj_k->modifiers[OBJ_MOD_MIGHT];
-			extra_moves += obj->modifiers[OBJ_MOD_MOVES]
-				* p->obj_k->modifiers[OBJ_MOD_MOVES];
-
-			/* Apply element info, noting vulnerabilites for later processing */
-			for (j = 0; j < ELEM_MAX; j++) {
-				if (!known_only || obj->known->el_info[j].res_level) {
-					if (obj->el_info[j].res_level == -1)
-						vuln[i] = true;
-
-					/* OK because res_level hasn't included vulnerability yet */
-					if (obj->el_info[j].res_level > state->el_info[j].res_level)
-						state->el_info[j].res_level = obj->el_info[j].res_level;
-				}
-			}
-
-			/* Apply combat bonuses */
-			state->ac += obj->ac;
-			if (!known_only || obj->known->to_a)
-				state->to_a += obj->to_a;
-			if (!slot_type_is(i, EQUIP_WEAPON) && !slot_type_is(i, EQUIP_BOW)) {
-				if (!known_only || obj->known->to_h) {
-					state->to_h += obj->to_h;
-				}
-				if (!known_only || obj->known->to_d) {
-					state->to_d += obj->to_d;
-				}
-			}
+		const struct slot_bonus *b = slot_bonus(p, i, known_only, update,
+												&scratch);
+
+		of_union(collect_f, b->flags);
+		for (j = 0; j < STAT_MAX; j++)
+			state->stat_add[j] += b->stat_add[j];
+		state->skills[SKILL_STEALTH] += b->stealth;
+		state->skills[SKILL_SEARCH] += b->search;
+		state->see_infra += b->infra;
+		state->skills[SKILL_DIGGING] += b->digging;
+		state->speed += b->speed;
+		state->dam_red += b->dam_red;
+		extra_blows += b->blows;
+		extra_shots += b->shots;
+		extra_might += b->might;
+		extra_moves += b->moves;
+
+		/* Apply element info, noting vulnerabilites for later processing */
+		if (b->vuln)
+			vuln[i] = true;
+		for (j = 0; j < ELEM_MAX; j++)
+			if (b->res_level[j] > state->el_info[j].res_level)
+				state->el_info[j].res_level = b->res_level[j];
 
-			/* Move to any unprocessed curse object */
-			if (curse) {
-				index++;
-				obj = NULL;
-				while (index < z_info->curse_max) {
-					if (curse[index].power) {
-						obj = curses[index].obj;
-						break;
-					} else {
-						index++;
-					}
-				}
-			} else {
-				obj = NULL;
-			}
-		}
+		/* Apply combat bonuses */
+		state->ac += b->ac;
+		state->to_a += b->to_a;
+		state->to_h += b->to_h;
+		state->to_d += b->to_d;
 	}
 
 	/* Apply the collected flags */
@@ -2236,6 +2368,26 @@ void calc_bonuses(struct player *p, struct player_state *state, bool known_only,
 	return;
 }
 
+/**
+ * Work out what the player would know of their state with `obj` in
+ * equipment slot `slot` instead of what's there now; `obj` may be NULL for
+ * an empty slot.  As for calc_bonuses() with update false, the STR and DEX
+ * indices in `state` are added to the real ones.
+ *
+ * Only the one slot is worked out again; the rest of the equipment comes
+ * from the cache.
+ */
+void calc_bonuses_swap(struct player *p, struct player_state *state, int slot,
+					   struct object *obj)
+{
+	struct object *current = slot_object(p, slot);
+
+	/* Pretend we're wielding the object */
+	p->body.slots[slot].obj = obj;
+	calc_bonuses(p, state, true, false);
+	p->body.slots[slot].obj = current;
+}
+
 /**
  * Calculate bonuses, and print various things on changes.
  */
@@ -2468,6 +2620,7 @@ void update_stuff(struct player *p)
 	/* Update stuff */
 	if (!p->upkeep->update) return;
 
+	PROFILE_START(UPDATE);
 
 	if (p->upkeep->update & (PU_INVEN)) {
 		p->upkeep->update &= ~(PU_INVEN);
@@ -2502,10 +2655,16 @@ void update_stuff(struct player *p)
 	}
 
 	/* Character is not ready yet, no map updates */
-	if (!character_generated) return;
+	if (!character_generated) {
+		PROFILE_STOP(UPDATE);
+		return;
+	}
 
 	/* Map is not shown, no map updates */
-	if (!map_is_visible()) return;
+	if (!map_is_visible()) {
+		PROFILE_STOP(UPDATE);
+		return;
+	}
 
 	if (p->upkeep->update & (PU_UPDATE_VIEW)) {
 		p->upkeep->update &= ~(PU_UPDATE_VIEW);
@@ -2528,6 +2687,8 @@ void update_stuff(struct player *p)
 		p->upkeep->update &= ~(PU_PANEL);
 		event_signal(EVENT_PLAYERMOVED);
 	}
+
+	PROFILE_STOP(UPDATE);
 }
 
 
@@ -2628,7 +2789,9 @@ void redraw_stuff(struct player *p)
  */
 void handle_stuff(struct player *p)
 {
+	PROFILE_START(HANDLE);
 	if (p->upkeep->update) update_stuff(p);
 	if (p->upkeep->redraw) redraw_stuff(p);
+	PROFILE_STOP(HANDLE);
 }
 
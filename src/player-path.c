@@ -35,21 +35,35 @@
  * ------------------------------------------------------------------------ */
 
 /**
- * Maximum size around the player to consider in the pathfinder
- */
-#define MAX_PF_RADIUS 100
-
-/**
- * Maximum distance to consider in the pathfinder
+ * Pathfinding is A* over the whole level, with every step costing the same.
+ *
+ * Once the target is reached the search carries on until every grid which
+ * could lie on a shortest path has its exact distance.  The path is then
+ * traced back from the target, taking the first direction in dir_search[]
+ * which leads one step closer to the player, so that ties between equally
+ * short paths are always broken the same way.
+ *
+ * The scratch space is kept between calls.  A grid's distance only counts
+ * if its stamp is that of the current search, so nothing has to be cleared.
  */
-#define MAX_PF_LENGTH 500
-
-
-static int terrain[MAX_PF_RADIUS][MAX_PF_RADIUS];
-static char pf_result[MAX_PF_LENGTH];
+struct pf_node {
+	int f;		/* Distance so far plus estimate of distance to go */
+	int g;		/* Distance so far */
+	int idx;	/* Grid index */
+};
+
+static int *pf_dist;
+static u32b *pf_stamp;
+static u32b pf_search;
+static int pf_size;
+
+static struct pf_node *pf_heap;
+static int pf_heap_count;
+static int pf_heap_size;
+
+static char *pf_result;
 static int pf_result_index;
 
-static int ox, oy, ex, ey;
 static int dir_search[8] = {2,4,6,8,1,3,7,9};
 
 
@@ -70,110 +84,179 @@ static bool is_valid_pf(int y, int x)
 	return (square_ispassable(cave, grid));
 }
 
-static void fill_terrain_info(void)
+/**
+ * Make room for a search of 'n' grids and start a new one
+ */
+static void path_prepare(int n)
 {
-	int i, j;
+	if (n > pf_size) {
+		mem_free(pf_dist);
+		mem_free(pf_stamp);
+		mem_free(pf_result);
+		pf_dist = mem_alloc(n * sizeof(int));
+		pf_stamp = mem_zalloc(n * sizeof(u32b));
+		pf_result = mem_alloc(n);
+		pf_size = n;
+		pf_search = 0;
+	}
 
-	ox = MAX(player->grid.x - MAX_PF_RADIUS / 2, 0);
-	oy = MAX(player->grid.y - MAX_PF_RADIUS / 2, 0);
+	/* Start again from scratch if the stamps wrap */
+	if (++pf_search == 0) {
+		memset(pf_stamp, 0, pf_size * sizeof(u32b));
+		pf_search = 1;
+	}
 
-	ex = MIN(player->grid.x + MAX_PF_RADIUS / 2 - 1, cave->width);
-	ey = MIN(player->grid.y + MAX_PF_RADIUS / 2 - 1, cave->height);
+	pf_heap_count = 0;
+}
+
+/**
+ * Distance of a grid from the player found by the current search, or -1 if
+ * the grid has not been reached or can't be entered
+ */
+static int path_distance(int idx)
+{
+	return (pf_stamp[idx] == pf_search) ? pf_dist[idx] : -1;
+}
 
-	for (i = 0; i < MAX_PF_RADIUS; i++)
-		for (j = 0; j < MAX_PF_RADIUS; j++)
-			terrain[i][j] = -1;
+static void path_push(int f, int g, int idx)
+{
+	int i = pf_heap_count++;
 
-	for (j = oy; j < ey; j++)
-		for (i = ox; i < ex; i++)
-			if (is_valid_pf(j, i))
-				terrain[j - oy][i - ox] = MAX_PF_LENGTH;
+	if (pf_heap_count > pf_heap_size) {
+		pf_heap_size = MAX(2 * pf_heap_size, 256);
+		pf_heap = mem_realloc(pf_heap, pf_heap_size * sizeof(*pf_heap));
+	}
 
-	terrain[player->grid.y - oy][player->grid.x - ox] = 1;
+	while (i > 0) {
+		int parent = (i - 1) / 2;
+		if (pf_heap[parent].f <= f) break;
+		pf_heap[i] = pf_heap[parent];
+		i = parent;
+	}
+	pf_heap[i].f = f;
+	pf_heap[i].g = g;
+	pf_heap[i].idx = idx;
 }
 
-#define MARK_DISTANCE(c,d) if ((c <= MAX_PF_LENGTH) && (c > d)) \
-							{ c = d; try_again = true; }
-
-bool findpath(int y, int x)
+static struct pf_node path_pop(void)
 {
-	int i, j, k;
-	int dir = 10;
-	bool try_again;
-	int cur_distance;
-	struct loc grid = loc(x, y);
+	struct pf_node top = pf_heap[0];
+	struct pf_node last = pf_heap[--pf_heap_count];
+	int i = 0;
+
+	while (2 * i + 1 < pf_heap_count) {
+		int child = 2 * i + 1;
+		if ((child + 1 < pf_heap_count) &&
+			(pf_heap[child + 1].f < pf_heap[child].f))
+			child++;
+		if (last.f <= pf_heap[child].f) break;
+		pf_heap[i] = pf_heap[child];
+		i = child;
+	}
+	pf_heap[i] = last;
 
-	fill_terrain_info();
+	return top;
+}
+
+/**
+ * Estimate of the distance between grids, which is never too high
+ */
+static int path_estimate(struct loc from, struct loc to)
+{
+	return MAX(ABS(to.x - from.x), ABS(to.y - from.y));
+}
 
-	terrain[player->grid.y - oy][player->grid.x - ox] = 1;
+bool findpath(int y, int x)
+{
+	struct loc target = loc(x, y), grid;
+	int goal, length = -1;
 
-	if ((x >= ox) && (x < ex) && (y >= oy) && (y < ey)) {
-		if ((square(cave, grid).mon > 0) &&
-			monster_is_visible(square_monster(cave, grid))) {
-			terrain[y - oy][x - ox] = MAX_PF_LENGTH;
-		}
-	} else {
+	if (!square_in_bounds(cave, target)) {
 		bell("Target out of range.");
 		return false;
 	}
 
-	/* 
-	 * And now starts the very naive and very 
-	 * inefficient pathfinding algorithm
-	 */
-	do {
-		try_again = false;
-
-		for (j = oy + 1; j < ey - 1; j++) {
-			for (i = ox + 1; i < ex - 1; i++) {
-				cur_distance = terrain[j - oy][i - ox] + 1;
-
-				if ((cur_distance > 0) && (cur_distance < MAX_PF_LENGTH)) {
-					for (dir = 1; dir < 10; dir++) {
-						int next_y, next_x;
-						if (dir == 5)
-							dir++;
-						next_y = j - oy + ddy[dir];
-						next_x = i - ox + ddx[dir];
-
-						MARK_DISTANCE(terrain[next_y][next_x], cur_distance);
-					}
-				}
-			}
+	path_prepare(cave->height * cave->width);
+	goal = square_idx(cave, target);
+
+	/* Start from the player */
+	grid = player->grid;
+	pf_stamp[square_idx(cave, grid)] = pf_search;
+	pf_dist[square_idx(cave, grid)] = 0;
+	path_push(path_estimate(grid, target), 0, square_idx(cave, grid));
+
+	while (pf_heap_count) {
+		struct pf_node node = path_pop();
+		int dir;
+
+		/* Skip grids since reached by a shorter path */
+		if (node.g != pf_dist[node.idx]) continue;
+
+		/* Nothing further can be on a shortest path */
+		if ((length >= 0) && (node.f > length)) break;
+
+		/* Reached the target */
+		if (node.idx == goal) {
+			length = node.g;
+			continue;
 		}
 
-		if (terrain[y - oy][x - ox] < MAX_PF_LENGTH)
-			try_again = false;
+		/* Don't step off the edge of the level */
+		grid = loc(node.idx % cave->width, node.idx / cave->width);
+		if (!square_in_bounds_fully(cave, grid)) continue;
+
+		for (dir = 1; dir < 10; dir++) {
+			struct loc next = loc_sum(grid, ddgrid[dir]);
+			int idx = square_idx(cave, next);
+
+			if (dir == 5) continue;
+
+			/* Look at each grid once per search; visible monsters in the
+			 * target grid don't stop it being reached */
+			if (pf_stamp[idx] != pf_search) {
+				pf_stamp[idx] = pf_search;
+				if (is_valid_pf(next.y, next.x) ||
+					((idx == goal) && (square_midx(cave, next) > 0) &&
+					 monster_is_visible(square_monster(cave, next)))) {
+					pf_dist[idx] = INT_MAX;
+				} else {
+					pf_dist[idx] = -1;
+				}
+			}
 
+			if ((pf_dist[idx] < 0) || (pf_dist[idx] <= node.g + 1)) continue;
+			pf_dist[idx] = node.g + 1;
+			path_push(node.g + 1 + path_estimate(next, target), node.g + 1,
+					  idx);
+		}
 	}
-	while (try_again) ;
 
 	/* Failure */
-	if (terrain[y - oy][x - ox] == -1 || terrain[y - oy][x - ox] == MAX_PF_LENGTH) {
+	if (length < 0) {
 		bell("Target space unreachable.");
 		return false;
 	}
 
-	/* Success */
-	i = x;
-	j = y;
-
+	/* Success; record the steps from the target back to the player */
 	pf_result_index = 0;
+	grid = target;
+	while (!loc_eq(grid, player->grid)) {
+		int k, dir = 10, step = path_distance(square_idx(cave, grid)) - 1;
 
-	while ((i != player->grid.x) || (j != player->grid.y)) {
-		cur_distance = terrain[j - oy][i - ox] - 1;
 		for (k = 0; k < 8; k++) {
-			dir = dir_search[k];
-			if (terrain[j - oy + ddy[dir]][i - ox + ddx[dir]] == cur_distance)
+			struct loc next = loc_sum(grid, ddgrid[dir_search[k]]);
+			if (square_in_bounds(cave, next) &&
+				(path_distance(square_idx(cave, next)) == step)) {
+				dir = dir_search[k];
 				break;
+			}
 		}
 
 		/* Should never happen */
-		assert ((dir != 10) && (dir != 5));
+		assert(dir != 10);
 
 		pf_result[pf_result_index++] = '0' + (char)(10 - dir);
-		i += ddx[dir];
-		j += ddy[dir];
+		grid = loc_sum(grid, ddgrid[dir]);
 	}
 
 	pf_result_index--;
@@ -181,6 +264,37 @@ bool findpath(int y, int x)
 	return true;
 }
 
+/**
+ * Number of steps left in the path found by findpath(), with the direction
+ * of the next one in dir (DIR_NONE if there are none)
+ */
+int pathfind_steps(int *dir)
+{
+	*dir = (pf_result_index >= 0) ? pf_result[pf_result_index] - '0' :
+		DIR_NONE;
+	return pf_result_index + 1;
+}
+
+static void pathfind_cleanup(void)
+{
+	mem_free(pf_dist);
+	mem_free(pf_stamp);
+	mem_free(pf_result);
+	mem_free(pf_heap);
+	pf_dist = NULL;
+	pf_stamp = NULL;
+	pf_result = NULL;
+	pf_heap = NULL;
+	pf_size = 0;
+	pf_heap_size = 0;
+}
+
+struct init_module pathfind_module = {
+	.name = "pathfind",
+	.init = NULL,
+	.cleanup = pathfind_cleanup
+};
+
 /**
  * Compute the direction (in the angband 123456789 sense) from a point to a
  * point. We decide to use diagonals if dx and dy are within a factor of two of
@@ -550,7 +664,7 @@ static bool run_test(void)
 		grid = loc_sum(player->grid, ddgrid[new_dir]);
 
 		/* Visible monsters abort running */
-		if (square(cave, grid).mon > 0) {
+		if (square_midx(cave, grid) > 0) {
 			struct monster *mon = square_monster(cave, grid);
 			if (monster_is_visible(mon)) {
 				return true;
@@ -629,7 +743,7 @@ static bool run_test(void)
 		if (!square_in_bounds(cave, grid)) continue;
 
 		/* Obvious monsters abort running */
-		if (square(cave, grid).mon > 0) {
+		if (square_midx(cave, grid) > 0) {
 			struct monster *mon = square_monster(cave, grid);
 			if (monster_is_obvious(mon))
 				return true;
@@ -774,7 +888,7 @@ void run_step(int dir)
 				}
 
 				/* Visible monsters abort running */
-				if (square(cave, grid).mon > 0) {
+				if (square_midx(cave, grid) > 0) {
 					struct monster *mon = square_monster(cave, grid);
 
 					/* Visible monster */
@@ -24,6 +24,7 @@
 
 int pathfind_direction_to(struct loc from, struct loc to);
 bool findpath(int y, int x);
+int pathfind_steps(int *dir);
 void run_step(int dir);
 
 #endif /* !PLAYER_PATH_H */
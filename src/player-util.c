@@ -24,6 +24,7 @@
 #include "game-world.h"
 #include "generate.h"
 #include "init.h"
+#include "journal.h"
 #include "obj-chest.h"
 #include "obj-gear.h"
 #include "obj-knowledge.h"
@@ -63,7 +64,7 @@ int dungeon_get_next_level(int dlev, int added)
 	
 	/* Check intermediate levels for quests */
 	for (i = dlev; i <= target_level; i++) {
-		if (is_quest(i)) return i;
+		if (is_quest(player, i)) return i;
 	}
 	
 	return target_level;
@@ -77,7 +78,7 @@ void player_set_recall_depth(struct player *p)
 	/* Account for forced descent */
 	if (OPT(p, birth_force_descend)) {
 		/* Force descent to a lower level if allowed */
-		if ((p->max_depth < z_info->max_depth - 1) && !is_quest(p->max_depth)) {
+		if ((p->max_depth < z_info->max_depth - 1) && !is_quest(p, p->max_depth)) {
 			p->recall_depth = dungeon_get_next_level(p->max_depth, 1);
 		}
 	}
@@ -98,7 +99,6 @@ bool player_get_recall_depth(struct player *p)
 
 	while (!level_ok) {
 		char *prompt = "Which level do you wish to return to (0 to cancel)? ";
-		int i;
 
 		/* Choose the level */
 		new = get_quantity(prompt, p->max_depth);
@@ -107,12 +107,7 @@ bool player_get_recall_depth(struct player *p)
 		}
 
 		/* Is that level valid? */
-		for (i = 0; i < chunk_list_max; i++) {
-			if (chunk_list[i]->depth == new) {
-				level_ok = true;
-				break;
-			}
-		}
+		level_ok = chunk_find_depth(new);
 		if (!level_ok) {
 			msg("You must choose a level you have previously visited.");
 		}
@@ -1227,6 +1222,9 @@ void player_place(struct chunk *c, struct player *p, struct loc grid)
  */
 void disturb(struct player *p, int stop_search)
 {
+	/* Note it if the UI did it */
+	journal_note_disturb(stop_search);
+
 	/* Cancel repeated commands */
 	cmd_cancel_repeat();
 
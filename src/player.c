@@ -30,9 +30,10 @@
 #include "z-util.h"
 
 /**
- * Pointer to the player struct
+ * Pointer to the player struct; a thread generating a level ahead points
+ * its own at the generator's copy of the player
  */
-struct player *player;
+THREAD_LOCAL struct player *player;
 
 struct player_body *bodies;
 struct player_race *races;
@@ -445,6 +446,7 @@ static void cleanup_player(void) {
 	}
 
 	/* Free the basic player struct */
+	calc_bonuses_free();
 	mem_free(player);
 	player = NULL;
 }
@@ -591,7 +591,7 @@ extern struct player_class *classes;
 extern struct magic_realm *realms;
 
 extern const s32b player_exp[PY_MAX_LEVEL];
-extern struct player *player;
+extern THREAD_LOCAL struct player *player;
 
 /* player-class.c */
 struct player_class *player_id2class(guid id);
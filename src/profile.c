@@ -0,0 +1,340 @@
+/**
+ * \file profile.c
+ * \brief Call counts and timings of the game's busiest code
+ *
+ * Copyright (c) 2026 Angband developers
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ *
+ * Each timed section counts its calls and adds up the time spent in it.
+ * The counts for a game turn are gathered until the turn ends, and then
+ * added to the totals for the level and for the whole session.  The most
+ * recent turns which did anything, and the slowest turns, are kept with
+ * their counts, so a slow turn can be picked apart afterwards.
+ *
+ * Sections nest - update_view() is called from update_stuff(), which is
+ * called from handle_stuff() - so a section's time includes that of any
+ * sections it calls.  The busy time of a turn only counts the outermost
+ * sections.  A section which calls itself is counted on each call but only
+ * timed once.
+ */
+
+#include "h-basic.h"
+#include "profile.h"
+#include "z-file.h"
+#include "z-util.h"
+
+#include <time.h>
+#ifdef WINDOWS
+# include <windows.h>
+#endif
+
+static const char *section_names[] = {
+	#define PROF(a, b, c) b,
+	#include "list-profile.h"
+	#undef PROF
+};
+
+static const char *section_descs[] = {
+	#define PROF(a, b, c) c,
+	#include "list-profile.h"
+	#undef PROF
+};
+
+/**
+ * The sections running now, and when they started
+ */
+static int active[PROF_MAX];
+static u64b started[PROF_MAX];
+static int nesting;
+static u64b busy_started;
+
+/**
+ * The turn in progress, the most recent levels in a ring (level_head is the
+ * current one) and the whole session
+ */
+static struct profile_turn now_turn;
+static struct profile_level levels[PROFILE_LEVELS];
+static int level_head, level_count;
+static struct profile_level session;
+
+/**
+ * Recent busy turns, in a ring, and the slowest turns, slowest first
+ */
+static struct profile_turn recent[PROFILE_TURNS];
+static int recent_head, recent_count;
+static struct profile_turn slowest[PROFILE_SLOWEST];
+static int slowest_count;
+
+/**
+ * Read a monotonic clock, in nanoseconds
+ */
+static u64b profile_clock(void)
+{
+#if defined(WINDOWS)
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER count;
+
+	if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+	return (u64b)(count.QuadPart / freq.QuadPart) * 1000000000 +
+		(u64b)(count.QuadPart % freq.QuadPart) * 1000000000 / freq.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64b)ts.tv_sec * 1000000000 + (u64b)ts.tv_nsec;
+#else
+	return (u64b)clock() * (1000000000 / CLOCKS_PER_SEC);
+#endif
+}
+
+/**
+ * Start timing a section
+ */
+void profile_start(enum profile_section section)
+{
+	u64b now;
+
+	now_turn.count[section].calls++;
+	if (active[section]++) return;
+
+	now = profile_clock();
+	started[section] = now;
+	if (!nesting++) busy_started = now;
+}
+
+/**
+ * Stop timing a section
+ */
+void profile_stop(enum profile_section section)
+{
+	u64b now;
+
+	if (!active[section] || --active[section]) return;
+
+	now = profile_clock();
+	now_turn.count[section].nsecs += now - started[section];
+	if (!--nesting) now_turn.busy += now - busy_started;
+}
+
+/**
+ * Add a turn's counts to a level's totals; 'whole' is false if the rest of
+ * the turn will be counted later
+ */
+static void level_add(struct profile_level *level, const struct profile_turn *t,
+					  bool whole)
+{
+	int i;
+
+	if (whole) level->turns++;
+	level->busy += t->busy;
+	level->worst_busy = MAX(level->worst_busy, t->busy);
+	for (i = 0; i < PROF_MAX; i++) {
+		level->count[i].calls += t->count[i].calls;
+		level->count[i].nsecs += t->count[i].nsecs;
+		level->worst[i] = MAX(level->worst[i], t->count[i].nsecs);
+	}
+}
+
+/**
+ * Put a turn in the list of the slowest turns, if it belongs there
+ */
+static void slowest_add(const struct profile_turn *t)
+{
+	int i = MIN(slowest_count, PROFILE_SLOWEST - 1);
+
+	if (slowest_count == PROFILE_SLOWEST && t->busy <= slowest[i].busy) return;
+	if (slowest_count < PROFILE_SLOWEST) slowest_count++;
+
+	/* Shuffle faster turns down to make room */
+	while (i > 0 && slowest[i - 1].busy < t->busy) {
+		slowest[i] = slowest[i - 1];
+		i--;
+	}
+	slowest[i] = *t;
+}
+
+/**
+ * Add the counts gathered since the last turn ended to the current level
+ */
+static void fold_turn(bool whole)
+{
+	struct profile_level *level = &levels[level_head];
+	u64b now = profile_clock();
+	int i;
+
+	/* Counting can start before the first level */
+	if (!level_count) {
+		level_count = 1;
+		level->first_turn = now_turn.turn;
+	}
+
+	/* Anything still running is counted up to now, and the rest of it in
+	 * the next turn */
+	for (i = 0; i < PROF_MAX; i++) {
+		if (!active[i]) continue;
+		now_turn.count[i].nsecs += now - started[i];
+		started[i] = now;
+	}
+	if (nesting) {
+		now_turn.busy += now - busy_started;
+		busy_started = now;
+	}
+
+	now_turn.depth = level->depth;
+	level_add(level, &now_turn, whole);
+	level_add(&session, &now_turn, whole);
+
+	if (now_turn.busy) {
+		recent[recent_head] = now_turn;
+		recent_head = (recent_head + 1) % PROFILE_TURNS;
+		if (recent_count < PROFILE_TURNS) recent_count++;
+		slowest_add(&now_turn);
+	}
+
+	memset(&now_turn, 0, sizeof(now_turn));
+}
+
+/**
+ * End game turn 'turn'
+ */
+void profile_end_turn(s32b turn)
+{
+	now_turn.turn = turn;
+	fold_turn(true);
+	now_turn.turn = turn + 1;
+}
+
+/**
+ * Start counting for a new level at 'depth'; the turn in progress is cut
+ * short, so that the old level keeps what happened on it.  Nothing happens
+ * if the level at 'depth' has only just started.
+ */
+void profile_new_level(int depth, s32b turn)
+{
+	struct profile_level *level;
+
+	if (level_count) {
+		level = &levels[level_head];
+		if (level->depth == depth && !level->turns) return;
+		now_turn.turn = turn;
+		fold_turn(false);
+		level_head = (level_head + 1) % PROFILE_LEVELS;
+	}
+	if (level_count < PROFILE_LEVELS) level_count++;
+
+	level = &levels[level_head];
+	memset(level, 0, sizeof(*level));
+	level->depth = depth;
+	level->first_turn = turn;
+	now_turn.turn = turn;
+}
+
+/**
+ * Forget everything; sections which are running carry on
+ */
+void profile_reset(void)
+{
+	memset(&now_turn, 0, sizeof(now_turn));
+	memset(&session, 0, sizeof(session));
+	memset(levels, 0, sizeof(levels));
+	level_head = level_count = 0;
+	recent_head = recent_count = 0;
+	slowest_count = 0;
+}
+
+const char *profile_name(enum profile_section section)
+{
+	return section_names[section];
+}
+
+const char *profile_desc(enum profile_section section)
+{
+	return section_descs[section];
+}
+
+/**
+ * The totals for the whole session
+ */
+const struct profile_level *profile_session(void)
+{
+	return &session;
+}
+
+/**
+ * The totals for the current level if 'age' is 0, the one before if 'age' is
+ * 1, and so on; NULL if there is no such level
+ */
+const struct profile_level *profile_recent_level(int age)
+{
+	if (age < 0 || age >= level_count) return NULL;
+	return &levels[(level_head + PROFILE_LEVELS - age) % PROFILE_LEVELS];
+}
+
+/**
+ * The slowest turn if 'rank' is 0, the next slowest if it is 1, and so on;
+ * NULL if there is no such turn
+ */
+const struct profile_turn *profile_slowest(int rank)
+{
+	if (rank < 0 || rank >= slowest_count) return NULL;
+	return &slowest[rank];
+}
+
+/**
+ * Write one row of the CSV file
+ */
+static void dump_row(ang_file *f, const char *kind, int depth, s32b turn,
+					 u32b turns, u64b busy, const struct profile_count *count)
+{
+	int i;
+
+	file_putf(f, "%s,%d,%ld,%lu,%lu", kind, depth, (long)turn,
+			  (unsigned long)turns, (unsigned long)(busy / 1000));
+	for (i = 0; i < PROF_MAX; i++)
+		file_putf(f, ",%lu,%lu", (unsigned long)count[i].calls,
+				  (unsigned long)(count[i].nsecs / 1000));
+	file_put(f, "\n");
+}
+
+/**
+ * Write the totals for each level, then the recent busy turns, to a CSV file
+ * at 'path'; times are in microseconds
+ */
+bool profile_dump(const char *path)
+{
+	ang_file *f = file_open(path, MODE_WRITE, FTYPE_TEXT);
+	int i;
+
+	if (!f) return false;
+
+	file_put(f, "kind,depth,turn,turns,busy_us");
+	for (i = 0; i < PROF_MAX; i++)
+		file_putf(f, ",%s_calls,%s_us", section_names[i], section_names[i]);
+	file_put(f, "\n");
+
+	for (i = level_count - 1; i >= 0; i--) {
+		const struct profile_level *level = profile_recent_level(i);
+		dump_row(f, "level", level->depth, level->first_turn, level->turns,
+				 level->busy, level->count);
+	}
+
+	for (i = 0; i < recent_count; i++) {
+		int n = (recent_head + PROFILE_TURNS - recent_count + i) %
+			PROFILE_TURNS;
+		dump_row(f, "turn", recent[n].depth, recent[n].turn, 1,
+				 recent[n].busy, recent[n].count);
+	}
+
+	return file_close(f);
+}
@@ -0,0 +1,101 @@
+/**
+ * \file profile.h
+ * \brief Call counts and timings of the game's busiest code
+ *
+ * Copyright (c) 2026 Angband developers
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+
+#ifndef INCLUDED_PROFILE_H
+#define INCLUDED_PROFILE_H
+
+#include "h-basic.h"
+
+/**
+ * The timed sections of the game
+ */
+enum profile_section {
+	#define PROF(a, b, c) PROF_##a,
+	#include "list-profile.h"
+	#undef PROF
+	PROF_MAX
+};
+
+/**
+ * Calls to a section, and the time spent in them
+ */
+struct profile_count {
+	u32b calls;
+	u64b nsecs;
+};
+
+/**
+ * What happened in one game turn
+ */
+struct profile_turn {
+	s32b turn;
+	int depth;
+	u64b busy;		/* Time spent in any section */
+	struct profile_count count[PROF_MAX];
+};
+
+/**
+ * What happened on one level, or in the whole session
+ */
+struct profile_level {
+	int depth;
+	s32b first_turn;
+	u32b turns;
+	u64b busy;					/* Time spent in any section */
+	u64b worst_busy;			/* The most busy time in one game turn */
+	struct profile_count count[PROF_MAX];
+	u64b worst[PROF_MAX];		/* The most time in one game turn */
+};
+
+/**
+ * The sections are only timed if the profiler is compiled in; the rest of
+ * the interface is always there, and just reports that nothing happened
+ */
+#ifdef USE_PROFILE
+# define PROFILE_START(s)		profile_start(PROF_##s)
+# define PROFILE_STOP(s)		profile_stop(PROF_##s)
+# define PROFILE_TURN(t)		profile_end_turn(t)
+# define PROFILE_LEVEL(d, t)	profile_new_level(d, t)
+#else
+# define PROFILE_START(s)
+# define PROFILE_STOP(s)
+# define PROFILE_TURN(t)
+# define PROFILE_LEVEL(d, t)
+#endif
+
+/**
+ * How many of the most recent levels and busy game turns are kept, and how
+ * many of the slowest turns
+ */
+#define PROFILE_LEVELS		100
+#define PROFILE_TURNS		1000
+#define PROFILE_SLOWEST		10
+
+void profile_start(enum profile_section section);
+void profile_stop(enum profile_section section);
+void profile_end_turn(s32b turn);
+void profile_new_level(int depth, s32b turn);
+void profile_reset(void);
+const char *profile_name(enum profile_section section);
+const char *profile_desc(enum profile_section section);
+const struct profile_level *profile_session(void);
+const struct profile_level *profile_recent_level(int age);
+const struct profile_turn *profile_slowest(int rank);
+bool profile_dump(const char *path);
+
+#endif /* !INCLUDED_PROFILE_H */
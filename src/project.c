@@ -26,6 +26,7 @@
 #include "mon-util.h"
 #include "player-calcs.h"
 #include "player-timed.h"
+#include "profile.h"
 #include "project.h"
 #include "source.h"
 #include "trap.h"
@@ -208,7 +209,7 @@ int project_path(struct loc *gp, int range, struct loc grid1, struct loc grid2,
 
 			/* Sometimes stop at non-initial monsters/players, decoys */
 			if (flg & (PROJECT_STOP)) {
-				if ((n > 0) && (square(cave, loc(x, y)).mon != 0)) break;
+				if ((n > 0) && (square_midx(cave, loc(x, y)) != 0)) break;
 				if (loc_eq(loc(x, y), decoy)) break;
 			}
 
@@ -267,7 +268,7 @@ int project_path(struct loc *gp, int range, struct loc grid1, struct loc grid2,
 
 			/* Sometimes stop at non-initial monsters/players, decoys */
 			if (flg & (PROJECT_STOP)) {
-				if ((n > 0) && (square(cave, loc(x, y)).mon != 0)) break;
+				if ((n > 0) && (square_midx(cave, loc(x, y)) != 0)) break;
 				if (loc_eq(loc(x, y), decoy)) break;
 			}
 
@@ -320,7 +321,7 @@ int project_path(struct loc *gp, int range, struct loc grid1, struct loc grid2,
 
 			/* Sometimes stop at non-initial monsters/players, decoys */
 			if (flg & (PROJECT_STOP)) {
-				if ((n > 0) && (square(cave, loc(x, y)).mon != 0)) break;
+				if ((n > 0) && (square_midx(cave, loc(x, y)) != 0)) break;
 				if (loc_eq(loc(x, y), decoy)) break;
 			}
 
@@ -594,6 +595,8 @@ bool project(struct source origin, int rad, struct loc finish,
 	/* Precalculated damage values for each distance. */
 	int *dam_at_dist = malloc((z_info->max_range + 1) * sizeof(*dam_at_dist));
 
+	PROFILE_START(PROJECT);
+
 	/* Flush any pending output */
 	handle_stuff(player);
 
@@ -637,7 +640,7 @@ bool project(struct source origin, int rad, struct loc finish,
 		blast_grid[num_grids] =  finish;
 		centre = finish;
 		distance_to_grid[num_grids] = 0;
-		sqinfo_on(square(cave, finish).info, SQUARE_PROJECT);
+		sqinfo_on(square_info(cave, finish), SQUARE_PROJECT);
 		num_grids++;
 	} else {
 		/* Start from caster */
@@ -680,13 +683,13 @@ bool project(struct source origin, int rad, struct loc finish,
 					blast_grid[num_grids].y = y;
 					blast_grid[num_grids].x = x;
 					distance_to_grid[num_grids] = 0;
-					sqinfo_on(square(cave, loc(x, y)).info, SQUARE_PROJECT);
+					sqinfo_on(square_info(cave, loc(x, y)), SQUARE_PROJECT);
 					num_grids++;
 				} else if (i == num_path_grids - 1) {
 					blast_grid[num_grids].y = y;
 					blast_grid[num_grids].x = x;
 					distance_to_grid[num_grids] = 0;
-					sqinfo_on(square(cave, loc(x, y)).info, SQUARE_PROJECT);
+					sqinfo_on(square_info(cave, loc(x, y)), SQUARE_PROJECT);
 					num_grids++;
 				}
 
@@ -737,7 +740,7 @@ bool project(struct source origin, int rad, struct loc finish,
 		if (num_grids == 0) {
 			blast_grid[num_grids] = centre;
 			distance_to_grid[num_grids] = 0;
-			sqinfo_on(square(cave, centre).info, SQUARE_PROJECT);
+			sqinfo_on(square_info(cave, centre), SQUARE_PROJECT);
 			num_grids++;
 		}
 
@@ -821,7 +824,7 @@ bool project(struct source origin, int rad, struct loc finish,
 					blast_grid[num_grids].y = y;
 					blast_grid[num_grids].x = x;
 					distance_to_grid[num_grids] = dist_from_centre;
-					sqinfo_on(square(cave, grid).info, SQUARE_PROJECT);
+					sqinfo_on(square_info(cave, grid), SQUARE_PROJECT);
 					num_grids++;
 				}
 			}
@@ -941,7 +944,7 @@ bool project(struct source origin, int rad, struct loc finish,
 			int y = last_hit_grid.y;
 
 			/* Track if possible */
-			if (square(cave, loc(x, y)).mon > 0) {
+			if (square_midx(cave, loc(x, y)) > 0) {
 				struct monster *mon = square_monster(cave, loc(x, y));
 
 				/* Recall and track */
@@ -969,8 +972,10 @@ bool project(struct source origin, int rad, struct loc finish,
 			if (project_p(origin, distance_to_grid[i], blast_grid[i],
 						  dam_at_dist[distance_to_grid[i]], typ, power)) {
 				notice = true;
-				if (player->is_dead)
+				if (player->is_dead) {
+					PROFILE_STOP(PROJECT);
 					return notice;
+				}
 				break;
 			}
 		}
@@ -989,7 +994,7 @@ bool project(struct source origin, int rad, struct loc finish,
 	/* Clear all the processing marks. */
 	for (i = 0; i < num_grids; i++) {
 		/* Clear the mark */
-		sqinfo_off(square(cave, blast_grid[i]).info, SQUARE_PROJECT);
+		sqinfo_off(square_info(cave, blast_grid[i]), SQUARE_PROJECT);
 	}
 
 	/* Update stuff if needed */
@@ -997,6 +1002,8 @@ bool project(struct source origin, int rad, struct loc finish,
 
 	free(dam_at_dist);
 
+	PROFILE_STOP(PROJECT);
+
 	/* Return "something was noticed" */
 	return (notice);
 }
@@ -19,10 +19,12 @@
 #include "angband.h"
 #include "cave.h"
 #include "game-world.h"
+#include "generate.h"
 #include "init.h"
 #include "mon-group.h"
 #include "mon-lore.h"
 #include "mon-make.h"
+#include "mon-move.h"
 #include "monster.h"
 #include "object.h"
 #include "obj-desc.h"
@@ -280,7 +282,7 @@ static void wr_trap(struct trap *trap)
  *
  * There were originally 64 bytes of randomizer saved. Now we only need
  * 32 + 5 bytes saved, so we'll write an extra 27 bytes at the end which won't
- * be used.
+ * be used.  The state of the stream levels are made from follows.
  */
 void wr_randomizer(void)
 {
@@ -304,6 +306,11 @@ void wr_randomizer(void)
 	/* NULL padding */
 	for (i = 0; i < 59 - RAND_DEG; i++)
 		wr_u32b(0);
+
+	/* Level generation RNG state */
+	wr_u32b(level_rng.state_i);
+	for (i = 0; i < RAND_DEG; i++)
+		wr_u32b(level_rng.STATE[i]);
 }
 
 
@@ -760,78 +767,49 @@ void wr_stores(void)
 /**
  * Write the current dungeon terrain features and info flags
  *
- * Note that the cost and when fields of c->squares[y][x] are not saved
+ * Note that the cost and when fields of c->squares are not saved
  */
-static void wr_dungeon_aux(struct chunk *c)
+/**
+ * Run-length encode n bytes, taken every stride bytes from data, as
+ * (count, byte) pairs
+ */
+static void wr_rle(const byte *data, size_t n, size_t stride)
 {
-	int y, x;
+	byte run[2] = { 0, 0 };
 	size_t i;
 
-	byte tmp8u;
+	for (i = 0; i < n; i++) {
+		byte v = data[i * stride];
+
+		/* If the run is broken, or too full, flush it */
+		if ((v != run[1]) || (run[0] == UCHAR_MAX)) {
+			wr_bytes(run, 2);
+			run[0] = 1;
+			run[1] = v;
+		} else /* Continue the run */
+			run[0]++;
+	}
 
-	byte count;
-	byte prev_char;
+	/* Flush the data (if any) */
+	if (run[0])
+		wr_bytes(run, 2);
+}
+
+static void wr_dungeon_aux(struct chunk *c)
+{
+	size_t i, n = c->height * c->width;
 
 	/* Dungeon specific info follows */
 	wr_string(c->name ? c->name : "Blank");
 	wr_u16b(c->height);
 	wr_u16b(c->width);
 
-	/* Run length encoding of c->squares[y][x].info */
-	for (i = 0; i < SQUARE_SIZE; i++) {
-		count = 0;
-		prev_char = 0;
-
-		/* Dump for each grid */
-		for (y = 0; y < c->height; y++) {
-			for (x = 0; x < c->width; x++) {
-				/* Extract the important c->squares[y][x].info flags */
-				tmp8u = square(c, loc(x, y)).info[i];
-
-				/* If the run is broken, or too full, flush it */
-				if ((tmp8u != prev_char) || (count == UCHAR_MAX)) {
-					wr_byte((byte)count);
-					wr_byte((byte)prev_char);
-					prev_char = tmp8u;
-					count = 1;
-				} else /* Continue the run */
-					count++;
-			}
-		}
-
-		/* Flush the data (if any) */
-		if (count) {
-			wr_byte((byte)count);
-			wr_byte((byte)prev_char);
-		}
-	}
+	/* Run length encoding of c->squares.info, one flag byte at a time */
+	for (i = 0; i < SQUARE_SIZE; i++)
+		wr_rle(c->squares.info + i, n, SQUARE_SIZE);
 
 	/* Now the terrain */
-	count = 0;
-	prev_char = 0;
-
-	/* Dump for each grid */
-	for (y = 0; y < c->height; y++) {
-		for (x = 0; x < c->width; x++) {
-			/* Extract a byte */
-			tmp8u = square(c, loc(x, y)).feat;
-
-			/* If the run is broken, or too full, flush it */
-			if ((tmp8u != prev_char) || (count == UCHAR_MAX)) {
-				wr_byte((byte)count);
-				wr_byte((byte)prev_char);
-				prev_char = tmp8u;
-				count = 1;
-			} else /* Continue the run */
-				count++;
-		}
-	}
-
-	/* Flush the data (if any) */
-	if (count) {
-		wr_byte((byte)count);
-		wr_byte((byte)prev_char);
-	}
+	wr_rle(c->squares.feat, n, 1);
 
 	/* Write feeling */
 	wr_byte(c->feeling);
@@ -846,9 +824,7 @@ static void wr_dungeon_aux(struct chunk *c)
 				wr_byte(current->grid.x);
 				wr_byte(current->grid.y);
 				wr_byte(current->feat);
-				for (i = 0; i < SQUARE_SIZE; i++) {
-					wr_byte(current->info[i]);
-				}
+				wr_bytes(current->info, SQUARE_SIZE);
 				current = current->next;
 			}
 		}
@@ -873,7 +849,7 @@ static void wr_objects_aux(struct chunk *c)
 	wr_u16b(c->obj_max);
 	for (y = 0; y < c->height; y++) {
 		for (x = 0; x < c->width; x++) {
-			struct object *obj = square(c, loc(x, y)).obj;
+			struct object *obj = square_object(c, loc(x, y));
 			while (obj) {
 				wr_item(obj);
 				obj = obj->next;
@@ -933,7 +909,7 @@ static void wr_traps_aux(struct chunk *c)
 
 	for (y = 0; y < c->height; y++) {
 		for (x = 0; x < c->width; x++) {
-			struct trap *trap = square(c, loc(x, y)).trap;
+			struct trap *trap = square_trap(c, loc(x, y));
 			while (trap) {
 				wr_trap(trap);
 				trap = trap->next;
@@ -976,6 +952,7 @@ void wr_objects(void)
 
 void wr_monsters(void)
 {
+	settle_monsters(cave);
 	wr_monsters_aux(cave);
 	wr_monsters_aux(player->cave);
 }
@@ -986,8 +963,46 @@ void wr_traps(void)
 	wr_traps_aux(player->cave);
 }
 
+/**
+ * Write a stored level, as it appears in the chunk list
+ */
+void wr_chunk(struct chunk *c)
+{
+	/* Write the terrain and info */
+	wr_dungeon_aux(c);
+
+	/* Write the objects */
+	wr_objects_aux(c);
+
+	/* Write the monsters */
+	wr_monsters_aux(c);
+
+	/* Write the traps */
+	wr_traps_aux(c);
+
+	/* Write other chunk info */
+	if (OPT(player, birth_levels_persist)) {
+		int i;
+
+		wr_string(c->name);
+		wr_s32b(c->turn);
+		wr_u16b(c->depth);
+		wr_byte(c->feeling);
+		wr_u32b(c->obj_rating);
+		wr_u32b(c->mon_rating);
+		wr_byte(c->good_item ? 1 : 0);
+		wr_u16b(c->height);
+		wr_u16b(c->width);
+		wr_u16b(c->feeling_squares);
+		for (i = 0; i < z_info->f_max + 1; i++) {
+			wr_u16b(c->feat_count[i]);
+		}
+	}
+}
+
 /*
- * Write the chunk list
+ * Write the chunk list; the levels are already packed by wr_chunk(), so are
+ * just copied out
  */
 void wr_chunks(void)
 {
@@ -1000,38 +1015,10 @@ void wr_chunks(void)
 
 	/* Now write each chunk */
 	for (j = 0; j < chunk_list_max; j++) {
-		struct chunk *c = chunk_list[j];
-
-		/* Write the terrain and info */
-		wr_dungeon_aux(c);
-
-		/* Write the objects */
-		wr_objects_aux(c);
-
-		/* Write the monsters */
-		wr_monsters_aux(c);
-
-		/* Write the traps */
-		wr_traps_aux(c);
-
-		/* Write other chunk info */
-		if (OPT(player, birth_levels_persist)) {
-			int i;
-
-			wr_string(c->name);
-			wr_s32b(c->turn);
-			wr_u16b(c->depth);
-			wr_byte(c->feeling);
-			wr_u32b(c->obj_rating);
-			wr_u32b(c->mon_rating);
-			wr_byte(c->good_item ? 1 : 0);
-			wr_u16b(c->height);
-			wr_u16b(c->width);
-			wr_u16b(c->feeling_squares);
-			for (i = 0; i < z_info->f_max + 1; i++) {
-				wr_u16b(c->feat_count[i]);
-			}
-		}
+		u32b size;
+		const byte *packed = chunk_list_packed(j, &size);
+
+		wr_bytes(packed, size);
 	}
 }
 
@@ -18,6 +18,7 @@
 #include <errno.h>
 #include "angband.h"
 #include "game-world.h"
+#include "generate.h"
 #include "init.h"
 #include "savefile.h"
 
@@ -48,9 +49,10 @@
  * need simply remove old loaders and you will not have to disentangle
  * lots of code with "if (version > 3)" and its like everywhere.
  *
- * Savefile loading and saving is done by keeping the current block in
- * memory, which is accessed using the wr_* and rd_* functions.  This is
- * then written out, whole, to disk, with the appropriate header.
+ * Savefile loading is done by keeping the current block in memory, which is
+ * accessed using the rd_* functions.  Saving streams the output of the wr_*
+ * functions to disk through a fixed-size buffer, and then goes back to fill
+ * in the block header.
  *
  *
  * So, if you want to make a savefile compat-breaking change, then there are
@@ -103,7 +105,7 @@ static const struct {
 	u32b version;	
 } savers[] = {
 	{ "description", wr_description, 1 },
-	{ "rng", wr_randomizer, 1 },
+	{ "rng", wr_randomizer, 2 },
 	{ "options", wr_options, 1 },
 	{ "messages", wr_messages, 1 },
 	{ "monster memory", wr_monster_memory, 1 },
@@ -130,7 +132,8 @@ static const struct {
  */
 static const struct blockinfo loaders[] = {
 	{ "description", rd_null, 1 },
-	{ "rng", rd_randomizer, 1 },
+	{ "rng", rd_randomizer_1, 1 },
+	{ "rng", rd_randomizer, 2 },
 	{ "options", rd_options, 1 },
 	{ "messages", rd_messages, 1 },
 	{ "monster memory", rd_monster_memory, 1 },
@@ -159,8 +162,22 @@ static u32b buffer_size;
 static u32b buffer_pos;
 static u32b buffer_check;
 
-#define BUFFER_INITIAL_SIZE		1024
-#define BUFFER_BLOCK_INCREMENT	1024
+/* Saving streams each block through the buffer to a file */
+static ang_file *save_file;
+static u32b save_block_size;
+static bool save_failed;
+
+/* Packing writes to, and unpacking reads from, memory of its own */
+static bool packing;
+static struct {
+	byte *buffer;
+	u32b size;
+	u32b pos;
+	u32b check;
+} sf_saved;
+
+#define BUFFER_SAVE_SIZE		65536
+#define BUFFER_PACK_SIZE		16384
 
 #define SAVEFILE_HEAD_SIZE		28
 
@@ -185,23 +202,58 @@ void note(const char *message)
  * Base put/get
  * ------------------------------------------------------------------------ */
 
+/**
+ * Write out what is in the buffer, and count it towards the block size
+ */
+static void sf_flush(void)
+{
+	/* A pack just needs more room */
+	if (packing) {
+		buffer_size *= 2;
+		buffer = mem_realloc(buffer, buffer_size);
+		return;
+	}
+
+	if (buffer_pos && !file_write(save_file, (char *)buffer, buffer_pos))
+		save_failed = true;
+
+	save_block_size += buffer_pos;
+	buffer_pos = 0;
+}
+
 static void sf_put(byte v)
 {
 	assert(buffer != NULL);
 	assert(buffer_size > 0);
 
 	if (buffer_size == buffer_pos)
-	{
-		buffer_size += BUFFER_BLOCK_INCREMENT;
-		buffer = mem_realloc(buffer, buffer_size);
-	}
-
-	assert(buffer_pos < buffer_size);
+		sf_flush();
 
 	buffer[buffer_pos++] = v;
 	buffer_check += v;
 }
 
+static void sf_put_bytes(const byte *v, size_t n)
+{
+	assert(buffer != NULL);
+	assert(buffer_size > 0);
+
+	while (n) {
+		size_t i, chunk;
+
+		if (buffer_size == buffer_pos)
+			sf_flush();
+
+		chunk = MIN(n, buffer_size - buffer_pos);
+		for (i = 0; i < chunk; i++) {
+			buffer[buffer_pos++] = v[i];
+			buffer_check += v[i];
+		}
+		v += chunk;
+		n -= chunk;
+	}
+}
+
 static byte sf_get(void)
 {
 	if ((buffer == NULL) || (buffer_size <= 0) || (buffer_pos >= buffer_size))
@@ -212,6 +264,20 @@ static byte sf_get(void)
 	return buffer[buffer_pos++];
 }
 
+static void sf_get_bytes(byte *v, size_t n)
+{
+	size_t i;
+
+	if ((buffer == NULL) || (buffer_pos > buffer_size) ||
+		(n > buffer_size - buffer_pos))
+		quit("Broken savefile - probably from a development version");
+
+	for (i = 0; i < n; i++) {
+		v[i] = buffer[buffer_pos++];
+		buffer_check += v[i];
+	}
+}
+
 
 /**
  * ------------------------------------------------------------------------
@@ -225,8 +291,11 @@ void wr_byte(byte v)
 
 void wr_u16b(u16b v)
 {
-	sf_put((byte)(v & 0xFF));
-	sf_put((byte)((v >> 8) & 0xFF));
+	byte b[2];
+
+	b[0] = (byte)(v & 0xFF);
+	b[1] = (byte)((v >> 8) & 0xFF);
+	sf_put_bytes(b, 2);
 }
 
 void wr_s16b(s16b v)
@@ -236,10 +305,13 @@ void wr_s16b(s16b v)
 
 void wr_u32b(u32b v)
 {
-	sf_put((byte)(v & 0xFF));
-	sf_put((byte)((v >> 8) & 0xFF));
-	sf_put((byte)((v >> 16) & 0xFF));
-	sf_put((byte)((v >> 24) & 0xFF));
+	byte b[4];
+
+	b[0] = (byte)(v & 0xFF);
+	b[1] = (byte)((v >> 8) & 0xFF);
+	b[2] = (byte)((v >> 16) & 0xFF);
+	b[3] = (byte)((v >> 24) & 0xFF);
+	sf_put_bytes(b, 4);
 }
 
 void wr_s32b(s32b v)
@@ -249,12 +321,13 @@ void wr_s32b(s32b v)
 
 void wr_string(const char *str)
 {
-	while (*str)
-	{
-		wr_byte(*str);
-		str++;
-	}
-	wr_byte(*str);
+	/* Include the terminating nul */
+	sf_put_bytes((const byte *)str, strlen(str) + 1);
+}
+
+void wr_bytes(const byte *v, size_t n)
+{
+	sf_put_bytes(v, n);
 }
 
 
@@ -265,8 +338,11 @@ void rd_byte(byte *ip)
 
 void rd_u16b(u16b *ip)
 {
-	(*ip) = sf_get();
-	(*ip) |= ((u16b)(sf_get()) << 8);
+	byte b[2];
+
+	sf_get_bytes(b, 2);
+	(*ip) = b[0];
+	(*ip) |= ((u16b)(b[1]) << 8);
 }
 
 void rd_s16b(s16b *ip)
@@ -276,10 +352,13 @@ void rd_s16b(s16b *ip)
 
 void rd_u32b(u32b *ip)
 {
-	(*ip) = sf_get();
-	(*ip) |= ((u32b)(sf_get()) << 8);
-	(*ip) |= ((u32b)(sf_get()) << 16);
-	(*ip) |= ((u32b)(sf_get()) << 24);
+	byte b[4];
+
+	sf_get_bytes(b, 4);
+	(*ip) = b[0];
+	(*ip) |= ((u32b)(b[1]) << 8);
+	(*ip) |= ((u32b)(b[2]) << 16);
+	(*ip) |= ((u32b)(b[3]) << 24);
 }
 
 void rd_s32b(s32b *ip)
@@ -302,6 +381,11 @@ void rd_string(char *str, int max)
 	str[max - 1] = '\0';
 }
 
+void rd_bytes(byte *v, size_t n)
+{
+	sf_get_bytes(v, n);
+}
+
 void strip_bytes(int n)
 {
 	byte tmp8u;
@@ -314,26 +398,110 @@ void pad_bytes(int n)
 }
 
 
+/**
+ * ------------------------------------------------------------------------
+ * Packing into memory
+ * ------------------------------------------------------------------------ */
+
+/**
+ * Keep the state of any save or load in progress while the buffer is used
+ * for packing or unpacking
+ */
+static void sf_push(void)
+{
+	assert(!sf_saved.buffer);
+	sf_saved.buffer = buffer;
+	sf_saved.size = buffer_size;
+	sf_saved.pos = buffer_pos;
+	sf_saved.check = buffer_check;
+	buffer_pos = 0;
+	buffer_check = 0;
+}
+
+static void sf_pop(void)
+{
+	buffer = sf_saved.buffer;
+	buffer_size = sf_saved.size;
+	buffer_pos = sf_saved.pos;
+	buffer_check = sf_saved.check;
+	sf_saved.buffer = NULL;
+}
+
+/**
+ * Send the output of the wr_ functions to memory until savefile_pack_end()
+ */
+void savefile_pack_begin(void)
+{
+	sf_push();
+	buffer = mem_alloc(BUFFER_PACK_SIZE);
+	buffer_size = BUFFER_PACK_SIZE;
+	packing = true;
+}
+
+/**
+ * Return what was written since savefile_pack_begin(), in memory which the
+ * caller frees, and its size
+ */
+byte *savefile_pack_end(u32b *size)
+{
+	byte *packed = mem_realloc(buffer, MAX(buffer_pos, 1));
+
+	*size = buffer_pos;
+	packing = false;
+	sf_pop();
+	return packed;
+}
+
+/**
+ * Take the input of the rd_ functions from 'size' bytes at 'data' until
+ * savefile_unpack_end()
+ */
+void savefile_unpack_begin(byte *data, u32b size)
+{
+	sf_push();
+	buffer = data;
+	buffer_size = size;
+}
+
+void savefile_unpack_end(void)
+{
+	sf_pop();
+}
+
+
 /**
  * ------------------------------------------------------------------------
  * Savefile saving functions
  * ------------------------------------------------------------------------ */
 
 
+/**
+ * Each block is streamed to the file after a blank header, which is filled
+ * in once the size and checksum of the block are known.
+ */
 static bool try_save(ang_file *file)
 {
 	byte savefile_head[SAVEFILE_HEAD_SIZE];
 	size_t i, pos;
 
 	/* Start off the buffer */
-	buffer = mem_alloc(BUFFER_INITIAL_SIZE);
-	buffer_size = BUFFER_INITIAL_SIZE;
+	buffer = mem_alloc(BUFFER_SAVE_SIZE);
+	buffer_size = BUFFER_SAVE_SIZE;
+	save_file = file;
+	save_failed = false;
 
-	for (i = 0; i < N_ELEMENTS(savers); i++) {
+	for (i = 0; i < N_ELEMENTS(savers) && !save_failed; i++) {
 		buffer_pos = 0;
 		buffer_check = 0;
+		save_block_size = 0;
+
+		/* Leave room for the header */
+		memset(savefile_head, 0, SAVEFILE_HEAD_SIZE);
+		if (!file_write(file, (char *)savefile_head, SAVEFILE_HEAD_SIZE))
+			save_failed = true;
 
 		savers[i].save();
+		sf_flush();
 
 		/* 16-byte block name */
 		pos = my_strcpy((char *)savefile_head,
@@ -349,22 +517,27 @@ static bool try_save(ang_file *file)
 		savefile_head[pos++] = ((v >> 24) & 0xFF);
 
 		SAVE_U32B(savers[i].version);
-		SAVE_U32B(buffer_pos);
+		SAVE_U32B(save_block_size);
 		SAVE_U32B(buffer_check);
 
 		assert(pos == SAVEFILE_HEAD_SIZE);
 
-		file_write(file, (char *)savefile_head, SAVEFILE_HEAD_SIZE);
-		file_write(file, (char *)buffer, buffer_pos);
+		/* Go back and fill in the header */
+		if (!file_skip(file, -(int)(save_block_size + SAVEFILE_HEAD_SIZE)) ||
+			!file_write(file, (char *)savefile_head, SAVEFILE_HEAD_SIZE) ||
+			!file_skip(file, save_block_size))
+			save_failed = true;
 
 		/* pad to 4 byte multiples */
-		if (buffer_pos % 4)
-			file_write(file, "xxx", 4 - (buffer_pos % 4));
+		if (save_block_size % 4)
+			file_write(file, "xxx", 4 - (save_block_size % 4));
 	}
 
 	mem_free(buffer);
+	buffer = NULL;
+	save_file = NULL;
 
-	return true;
+	return !save_failed;
 }
 
 /**
@@ -626,6 +799,9 @@ bool savefile_load(const char *path, bool cheat_death)
 		return false;
 	}
 
+	/* Nothing may be generating while the game is replaced */
+	gen_ahead_cancel();
+
 	ok = try_load(f, loaders);
 	file_close(f);
 
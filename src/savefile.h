@@ -22,6 +22,8 @@
 #define ITEM_VERSION	5
 #define EGO_ART_KNOWN 0xffffffff
 
+struct chunk;
+
 /**
  * ------------------------------------------------------------------------
  * Savefile API
@@ -47,6 +49,15 @@ bool savefile_load(const char *path, bool cheat_death);
  */
 const char *savefile_get_description(const char *path);
 
+/**
+ * Pack data into memory with the wr_ functions, and read it back with the
+ * rd_ functions; this can be done in the middle of a save or a load.
+ */
+void savefile_pack_begin(void);
+byte *savefile_pack_end(u32b *size);
+void savefile_unpack_begin(byte *data, u32b size);
+void savefile_unpack_end(void);
+
 
 /**
  * ------------------------------------------------------------------------
@@ -64,6 +75,7 @@ void wr_s16b(s16b v);
 void wr_u32b(u32b v);
 void wr_s32b(s32b v);
 void wr_string(const char *str);
+void wr_bytes(const byte *v, size_t n);
 void pad_bytes(int n);
 
 /* Reading bits */
@@ -73,11 +85,13 @@ void rd_s16b(s16b *ip);
 void rd_u32b(u32b *ip);
 void rd_s32b(s32b *ip);
 void rd_string(char *str, int max);
+void rd_bytes(byte *v, size_t n);
 void strip_bytes(int n);
 
 
 
 /* load.c */
+int rd_randomizer_1(void);
 int rd_randomizer(void);
 int rd_options(void);
 int rd_messages(void);
@@ -94,6 +108,7 @@ int rd_gear(void);
 int rd_stores(void);
 int rd_dungeon(void);
 int rd_chunks(void);
+int rd_packed_chunk(struct chunk **c);
 int rd_objects(void);
 int rd_monsters(void);
 int rd_monster_groups(void);
@@ -120,6 +135,7 @@ void wr_gear(void);
 void wr_stores(void);
 void wr_dungeon(void);
 void wr_chunks(void);
+void wr_chunk(struct chunk *c);
 void wr_objects(void);
 void wr_monsters(void);
 void wr_monster_groups(void);
@@ -43,8 +43,11 @@
 #include "target.h"
 #include "debug.h"
 
+#include <math.h>
+
 
 static void store_maint(struct store *s);
+static void store_age(struct store *s, int days);
 
 /**
  * ------------------------------------------------------------------------
@@ -365,7 +368,7 @@ void store_init(void)
 }
 
 void store_reset(void) {
-	int i, j;
+	int i;
 	struct store *s;
 
 	for (i = 0; i < MAX_STORES; i++) {
@@ -374,10 +377,7 @@ void store_reset(void) {
 		store_shuffle(s);
 		object_pile_free(s->stock);
 		s->stock = NULL;
-		if (i == STORE_HOME)
-			continue;
-		for (j = 0; j < 10; j++)
-			store_maint(s);
+		store_age(s, 10);
 	}
 }
 
@@ -1195,7 +1195,7 @@ static bool store_create_random(struct store *store)
 		object_prep(obj, kind, level, RANDOMISE);
 
 		/* Apply some "low-level" magic (no artifacts) */
-		apply_magic(obj, level, false, false, false, false);
+		apply_magic(cave, obj, level, false, false, false, false);
 
 		/* Reject if item is 'damaged' (negative combat mods, curses) */
 		if ((tval_is_weapon(obj) && ((obj->to_h < 0) || (obj->to_d < 0)))
@@ -1277,6 +1277,61 @@ static struct object *store_create_item(struct store *store,
 	return store_carry(store, obj);
 }
 
+/**
+ * Destroy crappy black market items
+ */
+static void store_clean_black_market(struct store *s)
+{
+	struct object *obj = s->stock;
+
+	if (s->sidx != STORE_B_MARKET) return;
+
+	while (obj) {
+		struct object *next = obj->next;
+		if (!black_market_ok(obj))
+			store_delete(s, obj, obj->number);
+		obj = next;
+	}
+}
+
+/**
+ * Make sure a store has a full stack of each of its staple items
+ */
+static void store_make_staples(struct store *s)
+{
+	size_t i;
+
+	for (i = 0; i < s->always_num; i++) {
+		struct object_kind *kind = s->always_table[i];
+		struct object *obj = store_find_kind(s, kind);
+
+		/* Create the item if it doesn't exist */
+		if (!obj)
+			obj = store_create_item(s, kind);
+
+		/* Ensure a full stack */
+		obj->number = obj->kind->base->max_stack;
+		obj->known->number = obj->kind->base->max_stack;
+	}
+}
+
+/**
+ * Buy random items until the store has 'stock' slots filled
+ */
+static void store_fill(struct store *s, int stock)
+{
+	/* The (huge) restock_attempts will only go to zero (otherwise
+	 * infinite loop) if stores don't have enough items they can stock! */
+	int restock_attempts = 100000;
+
+	while (s->stock_num < stock && --restock_attempts)
+		store_create_random(s);
+
+	if (!restock_attempts)
+		quit_fmt("Unable to (re-)stock store %d. Please report this bug",
+				 s->sidx + 1);
+}
+
 /**
  * Maintain the inventory at the stores.
  */
@@ -1286,16 +1341,7 @@ static void store_maint(struct store *s)
 	if (s->sidx == STORE_HOME)
 		return;
 
-	/* Destroy crappy black market items */
-	if (s->sidx == STORE_B_MARKET) {
-		struct object *obj = s->stock;
-		while (obj) {
-			struct object *next = obj->next;
-			if (!black_market_ok(obj))
-				store_delete(s, obj, obj->number);
-			obj = next;
-		}
-	}
+	store_clean_black_market(s);
 
 	/* We want to make sure stores have staple items. If there's
 	 * turnover, we also want to delete a few items, and add a few
@@ -1349,24 +1395,9 @@ static void store_maint(struct store *s)
 	}
 
 	/* Ensure staples are created */
-	if (s->always_num) {
-		size_t i;
-		for (i = 0; i < s->always_num; i++) {
-			struct object_kind *kind = s->always_table[i];
-			struct object *obj = store_find_kind(s, kind);
-
-			/* Create the item if it doesn't exist */
-			if (!obj)
-				obj = store_create_item(s, kind);
-
-			/* Ensure a full stack */
-			obj->number = obj->kind->base->max_stack;
-			obj->known->number = obj->kind->base->max_stack;
-		}
-	}
+	store_make_staples(s);
 
 	if (s->turnover) {
-		int restock_attempts = 100000;
 		int stock = s->stock_num + randint1(s->turnover);
 
 		/* Now that the staples exist, we want to add more
@@ -1384,15 +1415,76 @@ static void store_maint(struct store *s)
 		if (stock < min) stock = min;
 
 		/* For the rest, we just choose items randomlyish */
-		/* The (huge) restock_attempts will only go to zero (otherwise
-		 * infinite loop) if stores don't have enough items they can stock! */
-		while (s->stock_num < stock && --restock_attempts)
-			store_create_random(s);
+		store_fill(s, stock);
+	}
+}
 
-		if (!restock_attempts)
-			quit_fmt("Unable to (re-)stock store %d. Please report this bug",
-					 s->sidx + 1);
+/**
+ * Bring the inventory of a store up to date after 'days' days without the
+ * player, in one pass however many days that is.
+ *
+ * Rather than maintaining the store once a day, only the number of slots
+ * filled is followed from day to day, as store_maint() would change it, for
+ * up to STORE_AGE_DAYS days; any more days than that make no difference.
+ * Along the way we work out the chance of any one item surviving all the
+ * sales.  Each item the player might have seen is then kept with that
+ * chance, the staples are restored, and new items are bought to bring the
+ * store up to the final number of slots.  Items sold and bought in between
+ * would never have been seen, so they are never made.
+ */
+static void store_age(struct store *s, int days)
+{
+	int staples = (int)s->always_num;
+	int slots, i;
+	double keep = 1.0;
+	struct object *obj;
+
+	if (s->sidx == STORE_HOME) return;
+	if (days <= 1) {
+		if (days == 1) store_maint(s);
+		return;
+	}
+
+	store_clean_black_market(s);
+
+	/* Follow the number of slots filled, as store_maint() changes it */
+	slots = s->stock_num;
+	for (i = 0; i < MIN(days, STORE_AGE_DAYS); i++) {
+		int before = slots;
+
+		/* Sell */
+		if (s->turnover) {
+			slots -= randint1(s->turnover);
+			slots = MIN(MAX(slots, 0), s->normal_stock_max);
+		} else if (staples && slots) {
+			slots -= randint1(slots);
+		}
+		if (before) keep *= (double)slots / before;
+
+		/* Restock */
+		slots = MAX(slots, staples);
+		if (s->turnover) {
+			slots += randint1(s->turnover);
+			slots = MIN(MAX(slots, s->normal_stock_min + staples),
+						s->normal_stock_max + staples);
+		}
+	}
+
+	/* Keep the stock that survived the sales */
+	obj = s->stock;
+	while (obj) {
+		struct object *next = obj->next;
+		if (!store_is_staple(s, obj->kind) && Rand_div(10000) >= keep * 10000) {
+			if (obj->artifact)
+				history_lose_artifact(player, obj->artifact);
+			store_delete(s, obj, obj->number);
+		}
+		obj = next;
 	}
+
+	/* Restore the staples, and buy up to the number of slots */
+	store_make_staples(s);
+	store_fill(s, slots);
 }
 
 /**
@@ -1400,33 +1492,27 @@ static void store_maint(struct store *s)
  */
 void store_update(void)
 {
-	if (OPT(player, cheat_xtra)) msg("Updating Shops...");
-	while (daycount--) {
-		int n;
+	int n;
 
-		/* Maintain each shop (except home) */
-		for (n = 0; n < MAX_STORES; n++) {
-			/* Skip the home */
-			if (n == STORE_HOME) continue;
+	/* Each day one shop-keeper in store_shuffle retires, from any shop but
+	 * the home; this is the chance any one shop's has gone */
+	double stay = 1.0 - 1.0 / (z_info->store_shuffle * (MAX_STORES - 1));
+	double shuffle = 1.0 - pow(stay, daycount);
 
-			/* Maintain */
-			store_maint(&stores[n]);
-		}
+	if (OPT(player, cheat_xtra)) msg("Updating Shops...");
+	for (n = 0; n < MAX_STORES; n++) {
+		/* Skip the home */
+		if (n == STORE_HOME || !daycount) continue;
 
-		/* Sometimes, shuffle the shop-keepers */
-		if (one_in_(z_info->store_shuffle)) {
+		/* Sometimes, shuffle the shop-keeper */
+		if (Rand_div(10000) < shuffle * 10000) {
 			/* Message */
 			if (OPT(player, cheat_xtra)) msg("Shuffling a Shopkeeper...");
-
-			/* Pick a random shop (except home) */
-			while (1) {
-				n = randint0(MAX_STORES);
-				if (n != STORE_HOME) break;
-			}
-
-			/* Shuffle it */
 			store_shuffle(&stores[n]);
 		}
+
+		/* Catch up on all the days at once */
+		store_age(&stores[n], daycount);
 	}
 	daycount = 0;
 	if (OPT(player, cheat_xtra)) msg("Done.");
@@ -1722,8 +1808,6 @@ void do_cmd_buy(struct command *cmd)
 
 		/* Store is empty */
 		if (store->stock_num == 0) {
-			int i;
-
 			/* Sometimes shuffle the shopkeeper */
 			if (one_in_(z_info->store_shuffle)) {
 				/* Shuffle */
@@ -1734,8 +1818,7 @@ void do_cmd_buy(struct command *cmd)
 				msg("The shopkeeper brings out some new stock.");
 
 			/* New inventory */
-			for (i = 0; i < 10; ++i)
-				store_maint(store);
+			store_age(store, 10);
 		}
 	}
 
@@ -41,6 +41,11 @@ enum {
 	MAX_STORES	= 8
 };
 
+/**
+ * Days without the player after which a store's stock has all turned over
+ */
+#define STORE_AGE_DAYS	100
+
 struct object_buy {
 	struct object_buy *next;
 	size_t tval;
@@ -20,6 +20,7 @@
 #include "cave.h"
 #include "cmd-core.h"
 #include "game-input.h"
+#include "journal.h"
 #include "mon-desc.h"
 #include "mon-util.h"
 #include "monster.h"
@@ -153,11 +154,13 @@ bool target_set_monster(struct monster *mon)
 		target_set = true;
 		target.midx = mon->midx;
 		target.grid = mon->grid;
+		journal_note_target();
 		return true;
 	} else if (target_fixed) {
 		/* If a monster has died during a spell, this maintains its grid as
 		 * the target in case further effects of the spell need it */
 		target.midx = 0;
+		journal_note_target();
 		return true;
 	}
 
@@ -166,6 +169,7 @@ bool target_set_monster(struct monster *mon)
 	target.midx = 0;
 	target.grid.y = 0;
 	target.grid.x = 0;
+	journal_note_target();
 
 	return false;
 }
@@ -184,6 +188,7 @@ void target_set_location(int y, int x)
 		target_set = true;
 		target.midx = 0;
 		target.grid = grid;
+		journal_note_target();
 		return;
 	}
 
@@ -192,6 +197,7 @@ void target_set_location(int y, int x)
 	target.midx = 0;
 	target.grid.y = 0;
 	target.grid.x = 0;
+	journal_note_target();
 }
 
 /**
@@ -325,13 +331,13 @@ bool target_accept(int y, int x)
 	struct object *obj;
 
 	/* Player grids are always interesting */
-	if (square(cave, grid).mon < 0) return true;
+	if (square_midx(cave, grid) < 0) return true;
 
 	/* Handle hallucination */
 	if (player->timed[TMD_IMAGE]) return false;
 
 	/* Obvious monsters */
-	if (square(cave, grid).mon > 0) {
+	if (square_midx(cave, grid) > 0) {
 		struct monster *mon = square_monster(cave, grid);
 		if (monster_is_obvious(mon)) {
 			return true;
@@ -431,33 +437,44 @@ struct point_set *target_get_monsters(int mode, monster_predicate pred)
 	/* Get the current panel */
 	get_panel(&min_y, &min_x, &max_y, &max_x);
 
-	/* Scan for targets */
-	for (y = min_y; y < max_y; y++) {
-		for (x = min_x; x < max_x; x++) {
-			struct loc grid = loc(x, y);
+	/* Only grids with monsters will do, so just look at the monsters */
+	if (mode & (TARGET_KILL)) {
+		struct monster_iter iter;
+		struct monster *mon;
 
+		monster_iter_rect(&iter, cave, loc(min_x, min_y),
+						  loc(max_x - 1, max_y - 1));
+		while ((mon = monster_iter_next(&iter))) {
 			/* Check bounds */
-			if (!square_in_bounds_fully(cave, grid)) continue;
+			if (!square_in_bounds_fully(cave, mon->grid)) continue;
 
 			/* Require "interesting" contents */
-			if (!target_accept(y, x)) continue;
+			if (!target_accept(mon->grid.y, mon->grid.x)) continue;
 
-			/* Special mode */
-			if (mode & (TARGET_KILL)) {
-				struct monster *mon = square_monster(cave, grid);
+			/* Must be a targettable monster */
+			if (!target_able(mon)) continue;
 
-				/* Must contain a monster */
-				if (mon == NULL) continue;
+			/* Must be the right sort of monster */
+			if (pred && !pred(mon)) continue;
 
-				/* Must be a targettable monster */
-				if (!target_able(mon)) continue;
+			/* Save the location */
+			add_to_point_set(targets, mon->grid);
+		}
+	} else {
+		/* Scan for targets */
+		for (y = min_y; y < max_y; y++) {
+			for (x = min_x; x < max_x; x++) {
+				struct loc grid = loc(x, y);
 
-				/* Must be the right sort of monster */
-				if (pred && !pred(mon)) continue;
-			}
+				/* Check bounds */
+				if (!square_in_bounds_fully(cave, grid)) continue;
 
-			/* Save the location */
-			add_to_point_set(targets, grid);
+				/* Require "interesting" contents */
+				if (!target_accept(y, x)) continue;
+
+				/* Save the location */
+				add_to_point_set(targets, grid);
+			}
 		}
 	}
 
@@ -0,0 +1,114 @@
+/* game/floor.c */
+
+#include "unit-test.h"
+#include "unit-test-data.h"
+#include "test-utils.h"
+
+#include <stdio.h>
+#include "cave.h"
+#include "cmd-core.h"
+#include "game-world.h"
+#include "generate.h"
+#include "init.h"
+#include "mon-make.h"
+#include "player.h"
+#include "player-util.h"
+#include "z-util.h"
+
+static void println(const char *str) {
+	printf("%s\n", str);
+}
+
+int setup_tests(void **state) {
+	/* Register a basic error handler */
+	plog_aux = println;
+
+	/* Init the game */
+	set_file_paths();
+	init_angband();
+
+	/* Make a new character */
+	cmdq_push(CMD_BIRTH_INIT);
+	cmdq_push(CMD_BIRTH_RESET);
+	cmdq_push(CMD_CHOOSE_RACE);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_CHOOSE_CLASS);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_ROLL_STATS);
+	cmdq_push(CMD_NAME_CHOICE);
+	cmd_set_arg_string(cmdq_peek(), "name", "Tester");
+	cmdq_push(CMD_ACCEPT_CHARACTER);
+	cmdq_execute(CTX_BIRTH);
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	wipe_mon_list(cave, player);
+	cleanup_angband();
+	return 0;
+}
+
+static void new_level(int depth)
+{
+	dungeon_change_level(player, depth);
+	prepare_next_level(&cave, player);
+	on_new_level();
+	player->upkeep->generate_level = false;
+}
+
+/**
+ * Check the floor list holds exactly the floor squares of a chunk
+ */
+static bool floor_list_ok(struct chunk *c)
+{
+	int i, floors = 0;
+
+	for (i = 0; i < c->height * c->width; i++) {
+		if (!feat_is_floor(c->squares.feat[i])) continue;
+		floors++;
+		if (c->floor.place[i] < 0 || c->floor.place[i] >= c->floor.count)
+			return false;
+		if (c->floor.grids[c->floor.place[i]] != i) return false;
+	}
+
+	return floors == c->floor.count;
+}
+
+int test_floor_list(void *state) {
+	struct loc grid;
+	int depth;
+
+	for (depth = 1; depth < 100; depth += 14) {
+		new_level(depth);
+		require(floor_list_ok(cave));
+	}
+
+	/* Terrain changes are tracked */
+	require(find_empty(cave, &grid));
+	square_set_feat(cave, grid, FEAT_GRANITE);
+	require(floor_list_ok(cave));
+	square_set_feat(cave, grid, FEAT_FLOOR);
+	require(floor_list_ok(cave));
+	ok;
+}
+
+int test_find_empty(void *state) {
+	struct loc grid;
+	int i;
+
+	new_level(10);
+	for (i = 0; i < 100; i++) {
+		require(find_empty(cave, &grid));
+		require(square_isempty(cave, grid));
+	}
+	require(floor_list_ok(cave));
+	ok;
+}
+
+const char *suite_name = "game/floor";
+struct test tests[] = {
+	{ "floor list", test_floor_list },
+	{ "find empty", test_find_empty },
+	{ NULL, NULL }
+};
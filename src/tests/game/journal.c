@@ -0,0 +1,203 @@
+/* game/journal.c */
+
+#include "unit-test.h"
+#include "unit-test-data.h"
+#include "test-utils.h"
+
+#include <stdio.h>
+#include "cave.h"
+#include "cmd-core.h"
+#include "game-world.h"
+#include "generate.h"
+#include "init.h"
+#include "journal.h"
+#include "mon-make.h"
+#include "player.h"
+#include "player-calcs.h"
+#include "player-timed.h"
+#include "player-util.h"
+#include "savefile.h"
+#include "z-util.h"
+
+static void println(const char *str) {
+	printf("%s\n", str);
+}
+
+int setup_tests(void **state) {
+	/* Register a basic error handler */
+	plog_aux = println;
+
+	/* Init the game */
+	set_file_paths();
+	init_angband();
+
+	/* Make a new character */
+	cmdq_push(CMD_BIRTH_INIT);
+	cmdq_push(CMD_BIRTH_RESET);
+	cmdq_push(CMD_CHOOSE_RACE);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_CHOOSE_CLASS);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_ROLL_STATS);
+	cmdq_push(CMD_NAME_CHOICE);
+	cmd_set_arg_string(cmdq_peek(), "name", "Tester");
+	cmdq_push(CMD_ACCEPT_CHARACTER);
+	cmdq_execute(CTX_BIRTH);
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	wipe_mon_list(cave, player);
+	cleanup_angband();
+	return 0;
+}
+
+static void new_level(int depth)
+{
+	dungeon_change_level(player, depth);
+	prepare_next_level(&cave, player);
+	on_new_level();
+	player->upkeep->generate_level = false;
+}
+
+/**
+ * What a session left behind
+ */
+struct end_state {
+	s32b turn;
+	struct loc grid;
+	s16b chp;
+	byte energy;
+	u32b rand;
+	int monsters;
+	int monster_grids;
+};
+
+static void end_state_get(struct end_state *end)
+{
+	int i;
+
+	end->turn = turn;
+	end->grid = player->grid;
+	end->chp = player->chp;
+	end->energy = player->energy;
+	end->rand = Rand_div(0x10000000);
+	end->monsters = 0;
+	end->monster_grids = 0;
+	for (i = 1; i < cave_monster_max(cave); i++) {
+		struct monster *mon = cave_monster(cave, i);
+		if (!mon->race) continue;
+		end->monsters++;
+		end->monster_grids += mon->grid.y * cave->width + mon->grid.x;
+	}
+}
+
+/**
+ * A UI which walks about for a while, resting now and then, then stops
+ */
+static int script_step;
+
+static errr script_get_cmd(cmd_context c)
+{
+	static const int dirs[] = { 2, 3, 6, 9, 8, 7, 4, 1 };
+
+	if (script_step == 200) {
+		player->upkeep->playing = false;
+		return 1;
+	}
+
+	if (script_step % 7 == 6) {
+		cmdq_push(CMD_HOLD);
+	} else {
+		cmdq_push(CMD_WALK);
+		cmd_set_arg_direction(cmdq_peek(), "direction",
+							  dirs[(script_step / 5) % N_ELEMENTS(dirs)]);
+	}
+	script_step++;
+	return 0;
+}
+
+/**
+ * Load a savefile, starting from scratch the way a new session would
+ */
+static bool load(const char *path)
+{
+	if (!savefile_load(path, false)) return false;
+	health_track(player->upkeep, NULL);
+	monster_race_track(player->upkeep, NULL);
+	track_object_cancel(player->upkeep);
+	on_new_level();
+	return true;
+}
+
+static void play(void)
+{
+	player->upkeep->playing = true;
+	while (!player->is_dead && player->upkeep->playing) {
+		cmd_get_hook(CTX_GAME);
+		run_game_loop();
+	}
+}
+
+int test_round_trip(void *state) {
+	errr (*get_cmd)(cmd_context c) = cmd_get_hook;
+	char save_path[1024], journal_path[1024], replay_path[1024];
+	const struct journal_stats *stats;
+	struct end_state recorded, replayed;
+
+	path_build(save_path, sizeof(save_path), ANGBAND_DIR_USER,
+			   "journal.sav");
+	path_build(journal_path, sizeof(journal_path), ANGBAND_DIR_USER,
+			   "journal.jnl");
+	path_build(replay_path, sizeof(replay_path), ANGBAND_DIR_USER,
+			   "journal-replay.sav");
+
+	Rand_state_init(20260101);
+	new_level(3);
+	player_inc_timed(player, TMD_INVULN, 10000, false, false);
+	require(savefile_save(save_path));
+
+	/* Record a session, from the game as the savefile has it */
+	require(load(save_path));
+	cmd_get_hook = script_get_cmd;
+	script_step = 0;
+	require(journal_record_start(journal_path, save_path));
+	play();
+	journal_stop();
+	end_state_get(&recorded);
+	eq(script_step, 200);
+
+	/* Play it back from the savefile it started from */
+	require(journal_replay_open(journal_path, replay_path));
+	require(load(replay_path));
+	journal_replay_start();
+	play();
+	stats = journal_replay_stats();
+	if (stats->error) printf("Replay stopped: %s\n", stats->error);
+	null(stats->error);
+	eq(stats->finished, true);
+	eq(stats->commands, (u32b)200);
+	journal_stop();
+	end_state_get(&replayed);
+
+	eq(replayed.turn, recorded.turn);
+	require(loc_eq(replayed.grid, recorded.grid));
+	eq(replayed.chp, recorded.chp);
+	eq(replayed.energy, recorded.energy);
+	eq(replayed.rand, recorded.rand);
+	eq(replayed.monsters, recorded.monsters);
+	eq(replayed.monster_grids, recorded.monster_grids);
+
+	cmd_get_hook = get_cmd;
+	file_delete(save_path);
+	file_delete(journal_path);
+	file_delete(replay_path);
+	ok;
+}
+
+const char *suite_name = "game/journal";
+struct test tests[] = {
+	{ "round-trip", test_round_trip },
+	{ NULL, NULL }
+};
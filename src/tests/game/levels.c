@@ -0,0 +1,178 @@
+/* game/levels.c */
+
+#include "unit-test.h"
+#include "unit-test-data.h"
+#include "test-utils.h"
+
+#include <stdio.h>
+#include "cave.h"
+#include "cmd-core.h"
+#include "game-world.h"
+#include "generate.h"
+#include "init.h"
+#include "mon-make.h"
+#include "player.h"
+#include "player-util.h"
+#include "z-rand.h"
+#include "z-util.h"
+
+static void println(const char *str) {
+	printf("%s\n", str);
+}
+
+int setup_tests(void **state) {
+	/* Register a basic error handler */
+	plog_aux = println;
+
+	/* Init the game */
+	set_file_paths();
+	init_angband();
+
+	/* Make a new character */
+	cmdq_push(CMD_BIRTH_INIT);
+	cmdq_push(CMD_BIRTH_RESET);
+	cmdq_push(CMD_CHOOSE_RACE);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_CHOOSE_CLASS);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_ROLL_STATS);
+	cmdq_push(CMD_NAME_CHOICE);
+	cmd_set_arg_string(cmdq_peek(), "name", "Tester");
+	cmdq_push(CMD_ACCEPT_CHARACTER);
+	cmdq_execute(CTX_BIRTH);
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	wipe_mon_list(cave, player);
+	cleanup_angband();
+	return 0;
+}
+
+static void new_level(int depth)
+{
+	dungeon_change_level(player, depth);
+	prepare_next_level(&cave, player);
+	on_new_level();
+	player->upkeep->generate_level = false;
+}
+
+/**
+ * Sum up the layout and population of the current level
+ */
+static u32b level_sum(void)
+{
+	u32b sum = cave->height * 1000 + cave->width;
+	int i;
+
+	for (i = 0; i < cave->height * cave->width; i++)
+		sum = sum * 31 + cave->squares.feat[i];
+	for (i = 1; i < cave_monster_max(cave); i++) {
+		struct monster *mon = cave_monster(cave, i);
+		if (mon->race) sum = sum * 31 + mon->race->ridx;
+	}
+
+	return sum * 31 + cave->obj_max;
+}
+
+int test_seed(void *state) {
+	struct rand_state a, b;
+	s32b first;
+
+	/* Seeding doesn't depend on the RNG's current state */
+	Rand_state_init(1);
+	Rand_state_seed(&a, 42);
+	randint0(100);
+	Rand_state_seed(&b, 42);
+	eq(a.state_i, b.state_i);
+	require(!memcmp(a.STATE, b.STATE, sizeof(a.STATE)));
+
+	/* Swapping streams leaves each where it was */
+	Rand_state_swap(&a);
+	first = randint0(0x10000000);
+	Rand_state_swap(&a);
+	Rand_state_swap(&b);
+	eq(randint0(0x10000000), first);
+	Rand_state_swap(&b);
+	ok;
+}
+
+int test_levels(void *state) {
+	struct rand_state start = level_rng;
+	u32b sums[4];
+	int i;
+
+	/* Make some levels */
+	Rand_state_init(1);
+	for (i = 0; i < 4; i++) {
+		new_level(5 + i * 5);
+		sums[i] = level_sum();
+	}
+
+	/* Play's random numbers make no difference to the levels */
+	level_rng = start;
+	Rand_state_init(2);
+	for (i = 0; i < 4; i++) {
+		randint0(100);
+		new_level(5 + i * 5);
+		eq(level_sum(), sums[i]);
+	}
+	ok;
+}
+
+/**
+ * Take a staircase down from where the player stands, giving the level below
+ * a chance to be generated ahead of time if `ahead` is set
+ */
+static void descend(bool ahead)
+{
+	square_set_feat(cave, player->grid, FEAT_MORE);
+	if (ahead) gen_ahead(player);
+	player->upkeep->create_up_stair = true;
+	player->upkeep->create_down_stair = false;
+	new_level(dungeon_get_next_level(player->depth, 1));
+}
+
+int test_ahead(void *state) {
+	struct rand_state start = level_rng, after[4];
+	u32b sums[4];
+	int i;
+	u32b taken = gen_ahead_get_stats()->taken;
+
+	/* Make some levels ahead of time */
+	new_level(5);
+	for (i = 0; i < 4; i++) {
+		descend(true);
+		sums[i] = level_sum();
+		after[i] = level_rng;
+	}
+#ifdef HAVE_PTHREAD
+	taken += 4;
+#endif
+	eq(gen_ahead_get_stats()->taken, taken);
+
+	/* They're the levels the player would have found anyway */
+	level_rng = start;
+	new_level(5);
+	for (i = 0; i < 4; i++) {
+		descend(false);
+		eq(level_sum(), sums[i]);
+		require(!memcmp(&level_rng, &after[i], sizeof(level_rng)));
+	}
+
+	/* A level made ahead of time isn't used for somewhere else */
+	square_set_feat(cave, player->grid, FEAT_MORE);
+	gen_ahead(player);
+	new_level(5);
+	eq(gen_ahead_get_stats()->taken, taken);
+	ok;
+}
+
+const char *suite_name = "game/levels";
+struct test tests[] = {
+	{ "seed", test_seed },
+	{ "levels", test_levels },
+	{ "ahead", test_ahead },
+	{ NULL, NULL }
+};
@@ -0,0 +1,178 @@
+/* game/nearby.c */
+
+#include "unit-test.h"
+#include "unit-test-data.h"
+#include "test-utils.h"
+
+#include <stdio.h>
+#include "cave.h"
+#include "cmd-core.h"
+#include "game-world.h"
+#include "generate.h"
+#include "init.h"
+#include "mon-make.h"
+#include "mon-util.h"
+#include "monster.h"
+#include "player.h"
+#include "player-util.h"
+#include "z-util.h"
+
+static void println(const char *str) {
+	printf("%s\n", str);
+}
+
+int setup_tests(void **state) {
+	/* Register a basic error handler */
+	plog_aux = println;
+
+	/* Init the game */
+	set_file_paths();
+	init_angband();
+
+	/* Make a new character */
+	cmdq_push(CMD_BIRTH_INIT);
+	cmdq_push(CMD_BIRTH_RESET);
+	cmdq_push(CMD_CHOOSE_RACE);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_CHOOSE_CLASS);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_ROLL_STATS);
+	cmdq_push(CMD_NAME_CHOICE);
+	cmd_set_arg_string(cmdq_peek(), "name", "Tester");
+	cmdq_push(CMD_ACCEPT_CHARACTER);
+	cmdq_execute(CTX_BIRTH);
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	wipe_mon_list(cave, player);
+	cleanup_angband();
+	return 0;
+}
+
+static void new_level(int depth)
+{
+	dungeon_change_level(player, depth);
+	prepare_next_level(&cave, player);
+	on_new_level();
+	player->upkeep->generate_level = false;
+}
+
+/**
+ * Check a monster iterator finds exactly the living monsters in a rectangle
+ * which are within 'dist' of 'centre', if 'dist' isn't negative
+ */
+static bool iter_ok(struct monster_iter *iter, struct loc top_left,
+					struct loc bottom_right, struct loc centre, int dist)
+{
+	bool *seen = mem_zalloc(cave_monster_max(cave) * sizeof(bool));
+	struct monster *mon;
+	int i, found = 0, wanted = 0;
+	bool result = true;
+
+	while ((mon = monster_iter_next(iter))) {
+		if (!mon->race || seen[mon->midx]) result = false;
+		seen[mon->midx] = true;
+		found++;
+	}
+
+	for (i = 1; i < cave_monster_max(cave); i++) {
+		mon = cave_monster(cave, i);
+		if (!mon->race) continue;
+		if (mon->grid.x < top_left.x || mon->grid.x > bottom_right.x) continue;
+		if (mon->grid.y < top_left.y || mon->grid.y > bottom_right.y) continue;
+		if (dist >= 0 && distance(centre, mon->grid) > dist) continue;
+		if (!seen[i]) result = false;
+		wanted++;
+	}
+
+	mem_free(seen);
+	return result && (found == wanted);
+}
+
+int test_rect(void *state) {
+	struct monster_iter iter;
+	struct loc tl, br;
+	int i;
+
+	new_level(30);
+	require(cave_monster_count(cave) > 0);
+
+	tl = loc(0, 0);
+	br = loc(cave->width - 1, cave->height - 1);
+	monster_iter_rect(&iter, cave, tl, br);
+	require(iter_ok(&iter, tl, br, tl, -1));
+
+	for (i = 0; i < 50; i++) {
+		tl = loc(randint0(cave->width), randint0(cave->height));
+		br = loc(tl.x + randint0(30), tl.y + randint0(20));
+		monster_iter_rect(&iter, cave, tl, br);
+		require(iter_ok(&iter, tl, br, tl, -1));
+	}
+	ok;
+}
+
+int test_near(void *state) {
+	struct monster_iter iter;
+	int i;
+
+	new_level(30);
+	for (i = 1; i < cave_monster_max(cave); i++) {
+		struct monster *mon = cave_monster(cave, i);
+		struct loc tl, br;
+		int d = randint0(20);
+
+		if (!mon->race) continue;
+		tl = loc(mon->grid.x - d, mon->grid.y - d);
+		br = loc(mon->grid.x + d, mon->grid.y + d);
+		monster_iter_near(&iter, cave, mon->grid, d);
+		require(iter_ok(&iter, tl, br, mon->grid, d));
+	}
+	ok;
+}
+
+int test_moves(void *state) {
+	struct monster_iter iter;
+	struct loc tl, br;
+	int i;
+
+	new_level(30);
+	tl = loc(0, 0);
+	br = loc(cave->width - 1, cave->height - 1);
+
+	/* Swap monsters with each other and with empty grids; mimics stay with
+	 * the objects they are mimicking */
+	for (i = 1; i < cave_monster_max(cave); i++) {
+		struct monster *mon = cave_monster(cave, i);
+		struct monster *other = cave_monster(cave, randint1(i));
+		struct loc grid;
+
+		if (!mon->race || mon->mimicked_obj) continue;
+		if (other->race && other != mon && !other->mimicked_obj) {
+			monster_swap(mon->grid, other->grid);
+		} else if (find_empty(cave, &grid)) {
+			monster_swap(mon->grid, grid);
+		}
+	}
+	monster_iter_rect(&iter, cave, tl, br);
+	require(iter_ok(&iter, tl, br, tl, -1));
+
+	/* Delete some, and compact the rest */
+	for (i = 1; i < cave_monster_max(cave); i += 3) {
+		if (cave_monster(cave, i)->race)
+			delete_monster_idx(i);
+	}
+	compact_monsters(0);
+	monster_iter_rect(&iter, cave, tl, br);
+	require(iter_ok(&iter, tl, br, tl, -1));
+	ok;
+}
+
+const char *suite_name = "game/nearby";
+struct test tests[] = {
+	{ "rectangle", test_rect },
+	{ "near", test_near },
+	{ "moves", test_moves },
+	{ NULL, NULL }
+};
@@ -0,0 +1,313 @@
+/* game/noise.c */
+
+#include "unit-test.h"
+#include "unit-test-data.h"
+#include "test-utils.h"
+
+#include <stdio.h>
+#include "cave.h"
+#include "cmd-core.h"
+#include "game-world.h"
+#include "generate.h"
+#include "init.h"
+#include "mon-make.h"
+#include "mon-util.h"
+#include "player.h"
+#include "player-util.h"
+#include "z-util.h"
+
+static void println(const char *str) {
+	printf("%s\n", str);
+}
+
+int setup_tests(void **state) {
+	/* Register a basic error handler */
+	plog_aux = println;
+
+	/* Init the game */
+	set_file_paths();
+	init_angband();
+
+	/* Make a new character */
+	cmdq_push(CMD_BIRTH_INIT);
+	cmdq_push(CMD_BIRTH_RESET);
+	cmdq_push(CMD_CHOOSE_RACE);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_CHOOSE_CLASS);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_ROLL_STATS);
+	cmdq_push(CMD_NAME_CHOICE);
+	cmd_set_arg_string(cmdq_peek(), "name", "Tester");
+	cmdq_push(CMD_ACCEPT_CHARACTER);
+	cmdq_execute(CTX_BIRTH);
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	wipe_mon_list(cave, player);
+	cleanup_angband();
+	return 0;
+}
+
+static void new_level(int depth)
+{
+	dungeon_change_level(player, depth);
+	prepare_next_level(&cave, player);
+	on_new_level();
+	player->upkeep->generate_level = false;
+}
+
+/**
+ * Check the noise field against one propagated from scratch, the way
+ * make_noise() always used to
+ */
+static bool noise_ok(struct chunk *c, struct loc source, struct loc player_grid)
+{
+	int n = c->height * c->width;
+	u16b *noise = mem_zalloc(n * sizeof(u16b));
+	int *queue = mem_zalloc((n + 1) * sizeof(int));
+	int i, reached = 1;
+	bool same = true;
+
+	queue[0] = grid_to_i(source, c->width);
+	for (i = 0; i < reached; i++) {
+		struct loc next;
+		int d;
+
+		i_to_grid(queue[i], c->width, &next);
+		for (d = 0; d < 8; d++) {
+			struct loc grid = loc_sum(next, ddgrid_ddd[d]);
+			int idx = grid_to_i(grid, c->width);
+
+			if (!square_in_bounds(c, grid)) continue;
+			if (square_isnoflow(c, grid)) continue;
+			if (noise[idx] != 0) continue;
+			if (loc_eq(grid, player_grid)) continue;
+			noise[idx] = noise[queue[i]] + 1;
+			queue[reached++] = idx;
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		struct loc grid;
+		i_to_grid(i, c->width, &grid);
+		if (c->noise.grids[grid.y][grid.x] != noise[i]) {
+			same = false;
+			break;
+		}
+	}
+
+	mem_free(queue);
+	mem_free(noise);
+	return same;
+}
+
+/**
+ * Pick a random adjacent grid the player could step into
+ */
+static bool random_step(struct chunk *c, struct loc from, struct loc *to)
+{
+	int tries;
+
+	for (tries = 0; tries < 20; tries++) {
+		struct loc grid = loc_sum(from, ddgrid_ddd[randint0(8)]);
+		if (!square_in_bounds_fully(c, grid)) continue;
+		if (!square_isempty(c, grid)) continue;
+		*to = grid;
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * Pick a random grid near another, away from the player and the source
+ */
+static bool random_nearby(struct chunk *c, struct loc near, struct loc source,
+						  struct loc *grid)
+{
+	int tries;
+
+	for (tries = 0; tries < 20; tries++) {
+		*grid = loc(near.x + randint0(11) - 5, near.y + randint0(11) - 5);
+		if (!square_in_bounds_fully(c, *grid)) continue;
+		if (loc_eq(*grid, player->grid) || loc_eq(*grid, source)) continue;
+		if (square_monster(c, *grid) || square_object(c, *grid)) continue;
+		if (square_isfloor(c, *grid) || square_isgranite(c, *grid))
+			return true;
+	}
+
+	return false;
+}
+
+int test_noise_repair(void *state) {
+	int depth;
+
+	for (depth = 1; depth <= 5; depth++) {
+		struct loc decoy = loc(0, 0);
+		int step;
+
+		new_level(depth);
+		cave_update_noise(cave, player->grid, player->grid);
+		require(noise_ok(cave, player->grid, player->grid));
+
+		for (step = 0; step < 400; step++) {
+			struct loc source = loc_is_zero(decoy) ? player->grid : decoy;
+			struct loc grid;
+			int changes = randint1(2);
+
+			switch (randint0(6)) {
+				case 0: case 1: case 2: {
+					/* Step the player */
+					if (random_step(cave, player->grid, &grid))
+						monster_swap(player->grid, grid);
+					break;
+				}
+				case 3: {
+					/* Knock through walls or put them up */
+					while (changes--) {
+						if (!random_nearby(cave, player->grid, source, &grid))
+							continue;
+						square_set_feat(cave, grid, square_isfloor(cave, grid) ?
+										FEAT_GRANITE : FEAT_FLOOR);
+					}
+					break;
+				}
+				case 4: {
+					/* Put down, move or take away a decoy */
+					if (loc_is_zero(decoy)) {
+						if (random_step(cave, player->grid, &grid))
+							decoy = grid;
+					} else if (one_in_(3)) {
+						decoy = loc(0, 0);
+					} else if (random_step(cave, decoy, &grid)) {
+						decoy = grid;
+					}
+					break;
+				}
+				default: {
+					/* Teleport the player */
+					grid = loc(randint1(cave->width - 2),
+							   randint1(cave->height - 2));
+					if (square_isempty(cave, grid))
+						monster_swap(player->grid, grid);
+					break;
+				}
+			}
+
+			source = loc_is_zero(decoy) ? player->grid : decoy;
+			cave_update_noise(cave, source, player->grid);
+			require(noise_ok(cave, source, player->grid));
+		}
+	}
+	ok;
+}
+
+int test_noise_held(void *state) {
+	struct loc grid;
+	int tries = 0;
+
+	new_level(2);
+	cave_update_noise(cave, player->grid, player->grid);
+
+	/* Terrain changes only reach the field at the next update */
+	while (!random_nearby(cave, player->grid, player->grid, &grid) ||
+		   !square_isfloor(cave, grid) ||
+		   !cave->noise.grids[grid.y][grid.x]) {
+		require(++tries < 1000);
+	}
+	square_set_feat(cave, grid, FEAT_GRANITE);
+	eq(cave->noise.grids[grid.y][grid.x] != 0, true);
+	cave_update_noise(cave, player->grid, player->grid);
+	eq(cave->noise.grids[grid.y][grid.x], 0);
+	require(noise_ok(cave, player->grid, player->grid));
+	ok;
+}
+
+/**
+ * Age and lay scent the way update_scent() always used to
+ */
+static void scent_reference(struct chunk *c, u16b *scent)
+{
+	int scent_strength[5][5] = {
+		{2, 2, 2, 2, 2},
+		{2, 1, 1, 1, 2},
+		{2, 1, 0, 1, 2},
+		{2, 1, 1, 1, 2},
+		{2, 2, 2, 2, 2},
+	};
+	int y, x;
+
+	for (y = 1; y < c->height - 1; y++) {
+		for (x = 1; x < c->width - 1; x++) {
+			if (scent[y * c->width + x] > 0) scent[y * c->width + x]++;
+		}
+	}
+
+	for (y = 0; y < 5; y++) {
+		for (x = 0; x < 5; x++) {
+			struct loc grid = loc(x + player->grid.x - 2,
+								  y + player->grid.y - 2);
+			int new_scent = scent_strength[y][x];
+			bool add_scent = false;
+			int d;
+
+			if (!square_in_bounds(c, grid)) continue;
+			if (square_isnoscent(c, grid)) continue;
+			for (d = 0; d < 8; d++) {
+				struct loc adj = loc_sum(grid, ddgrid_ddd[d]);
+				if (!square_in_bounds(c, adj)) continue;
+				if (x == 2 && y == 2) add_scent = true;
+				if (scent[adj.y * c->width + adj.x] == new_scent - 1)
+					add_scent = true;
+			}
+			if (add_scent) scent[grid.y * c->width + grid.x] = new_scent;
+		}
+	}
+}
+
+int test_scent(void *state) {
+	u16b *scent;
+	int step, i;
+
+	new_level(3);
+	scent = mem_zalloc(cave->height * cave->width * sizeof(u16b));
+
+	for (step = 0; step < 300; step++) {
+		struct loc grid;
+
+		if (random_step(cave, player->grid, &grid))
+			monster_swap(player->grid, grid);
+
+		/* Scent about to run out */
+		if (step == 200) {
+			for (i = 0; i < cave->height * cave->width; i++) {
+				i_to_grid(i, cave->width, &grid);
+				if (scent[i] > 10) {
+					scent[i] = 65534;
+					cave->scent.grids[grid.y][grid.x] = 65534;
+				}
+			}
+		}
+
+		process_world(cave);
+		scent_reference(cave, scent);
+		for (i = 0; i < cave->height * cave->width; i++) {
+			i_to_grid(i, cave->width, &grid);
+			eq(cave->scent.grids[grid.y][grid.x], scent[i]);
+		}
+		require(noise_ok(cave, player->grid, player->grid));
+	}
+
+	mem_free(scent);
+	ok;
+}
+
+const char *suite_name = "game/noise";
+struct test tests[] = {
+	{ "noise-repair", test_noise_repair },
+	{ "noise-held", test_noise_held },
+	{ "scent", test_scent },
+	{ NULL, NULL }
+};
@@ -0,0 +1,155 @@
+/* game/persist.c */
+
+#include "unit-test.h"
+#include "unit-test-data.h"
+#include "test-utils.h"
+
+#include <stdio.h>
+#include "cave.h"
+#include "cmd-core.h"
+#include "game-world.h"
+#include "generate.h"
+#include "init.h"
+#include "mon-make.h"
+#include "player.h"
+#include "player-util.h"
+#include "savefile.h"
+#include "z-util.h"
+
+static void println(const char *str) {
+	printf("%s\n", str);
+}
+
+int setup_tests(void **state) {
+	/* Register a basic error handler */
+	plog_aux = println;
+
+	/* Init the game */
+	set_file_paths();
+	init_angband();
+
+	/* Make a new character */
+	cmdq_push(CMD_BIRTH_INIT);
+	cmdq_push(CMD_BIRTH_RESET);
+	cmdq_push(CMD_CHOOSE_RACE);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_CHOOSE_CLASS);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_ROLL_STATS);
+	cmdq_push(CMD_NAME_CHOICE);
+	cmd_set_arg_string(cmdq_peek(), "name", "Tester");
+	cmdq_push(CMD_ACCEPT_CHARACTER);
+	cmdq_execute(CTX_BIRTH);
+	player->opts.opt[OPT_birth_levels_persist] = true;
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	chunk_list_memory = 16 * 1024 * 1024;
+	cleanup_angband();
+	return 0;
+}
+
+static void new_level(int depth)
+{
+	dungeon_change_level(player, depth);
+	prepare_next_level(&cave, player);
+	on_new_level();
+	player->upkeep->generate_level = false;
+}
+
+/**
+ * Sum up the layout and population of the current level
+ */
+static u32b level_sum(void)
+{
+	u32b sum = cave->height * 1000 + cave->width;
+	int i;
+
+	for (i = 0; i < cave->height * cave->width; i++)
+		sum = sum * 31 + cave->squares.feat[i];
+	for (i = 1; i < cave_monster_max(cave); i++) {
+		struct monster *mon = cave_monster(cave, i);
+		if (mon->race) sum = sum * 31 + mon->race->ridx;
+	}
+
+	return sum * 31 + cave->obj_max;
+}
+
+/**
+ * Count every monster the game thinks is alive
+ */
+static int monsters_alive(void)
+{
+	int i, n = 0;
+
+	for (i = 1; i < z_info->r_max; i++)
+		n += r_info[i].cur_num;
+
+	return n;
+}
+
+int test_return(void *state) {
+	u32b sums[4];
+	int i, alive;
+
+	for (i = 1; i <= 3; i++) {
+		new_level(i);
+		sums[i] = level_sum();
+	}
+	require(chunk_is_stored(level_by_depth(1)->name));
+	require(chunk_is_stored(level_by_depth(2)->name));
+	require(!chunk_is_stored(level_by_depth(3)->name));
+	require(chunk_find_depth(2));
+	require(!chunk_find_depth(4));
+	alive = monsters_alive();
+
+	/* Levels come back as they were left, from memory or the spill file */
+	new_level(2);
+	eq(level_sum(), sums[2]);
+	chunk_list_memory = 0;
+	new_level(1);
+	eq(level_sum(), sums[1]);
+	new_level(3);
+	eq(level_sum(), sums[3]);
+	chunk_list_memory = 16 * 1024 * 1024;
+	new_level(2);
+	eq(level_sum(), sums[2]);
+	eq(monsters_alive(), alive);
+	ok;
+}
+
+int test_save(void *state) {
+	char path[1024];
+	u32b sums[3];
+	int i;
+
+	/* Save with one level spilled and one in memory */
+	chunk_list_memory = 0;
+	new_level(1);
+	sums[1] = level_sum();
+	chunk_list_memory = 16 * 1024 * 1024;
+	new_level(3);
+	new_level(2);
+	sums[2] = level_sum();
+	new_level(4);
+
+	path_build(path, sizeof(path), ANGBAND_DIR_USER, "persist.sav");
+	require(savefile_save(path));
+	require(savefile_load(path, false));
+	file_delete(path);
+
+	for (i = 1; i <= 2; i++) {
+		new_level(i);
+		eq(level_sum(), sums[i]);
+	}
+	ok;
+}
+
+const char *suite_name = "game/persist";
+struct test tests[] = {
+	{ "return", test_return },
+	{ "save", test_save },
+	{ NULL, NULL }
+};
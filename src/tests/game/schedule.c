@@ -0,0 +1,375 @@
+/* game/schedule.c */
+
+#include "unit-test.h"
+#include "unit-test-data.h"
+#include "test-utils.h"
+
+#include <stdio.h>
+#include "cave.h"
+#include "cmd-core.h"
+#include "game-event.h"
+#include "game-world.h"
+#include "generate.h"
+#include "init.h"
+#include "mon-make.h"
+#include "mon-move.h"
+#include "mon-timed.h"
+#include "player.h"
+#include "player-timed.h"
+#include "player-util.h"
+#include "z-util.h"
+
+static void println(const char *str) {
+	printf("%s\n", str);
+}
+
+int setup_tests(void **state) {
+	/* Register a basic error handler */
+	plog_aux = println;
+
+	/* Init the game */
+	set_file_paths();
+	init_angband();
+
+	/* Make a new character */
+	cmdq_push(CMD_BIRTH_INIT);
+	cmdq_push(CMD_BIRTH_RESET);
+	cmdq_push(CMD_CHOOSE_RACE);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_CHOOSE_CLASS);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_ROLL_STATS);
+	cmdq_push(CMD_NAME_CHOICE);
+	cmd_set_arg_string(cmdq_peek(), "name", "Tester");
+	cmdq_push(CMD_ACCEPT_CHARACTER);
+	cmdq_execute(CTX_BIRTH);
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	wipe_mon_list(cave, player);
+	cleanup_angband();
+	return 0;
+}
+
+/**
+ * Run game turns the way run_game_loop() does for the monsters, without
+ * letting any of them build up enough energy to move
+ */
+static void run_turns(int n)
+{
+	while (n--) {
+		process_monsters(cave, player->energy + 1);
+		process_monsters(cave, 0);
+		reset_monsters();
+		turn++;
+	}
+}
+
+static void new_level(int depth)
+{
+	dungeon_change_level(player, depth);
+	prepare_next_level(&cave, player);
+	on_new_level();
+	player->upkeep->generate_level = false;
+}
+
+/**
+ * Monsters not yet due to move gain energy as if every turn had been run
+ */
+int test_energy_settles(void *state) {
+	int i, n = z_info->move_energy - 1;
+	s32b start;
+
+	new_level(20);
+	require(cave_monster_count(cave) > 0);
+
+	/* Start every monster from nothing, at its normal speed */
+	for (i = 1; i < cave_monster_max(cave); i++) {
+		struct monster *mon = cave_monster(cave, i);
+		if (!mon->race) continue;
+		mon_clear_timed(mon, MON_TMD_FAST, MON_TMD_FLG_NOTIFY);
+		mon_clear_timed(mon, MON_TMD_SLOW, MON_TMD_FLG_NOTIFY);
+		monster_set_energy(cave, mon, 0);
+		n = MIN(n, (z_info->move_energy - 1) / turn_energy(mon->mspeed));
+	}
+	require(n > 0);
+
+	start = turn;
+	run_turns(n);
+	settle_monsters(cave);
+
+	for (i = 1; i < cave_monster_max(cave); i++) {
+		struct monster *mon = cave_monster(cave, i);
+		int gain;
+		if (!mon->race) continue;
+		gain = turn_energy(mon->mspeed);
+		eq(mon->energy, n * gain);
+		eq(mon->ready_turn, start + (z_info->move_energy + gain - 1) / gain);
+		require(!mflag_has(mon->mflag, MFLAG_HANDLED));
+	}
+	ok;
+}
+
+/**
+ * Energy gained before a change of speed is kept at the old rate
+ */
+int test_speed_change(void *state) {
+	struct monster *mon = NULL;
+	int i, slow, fast;
+
+	/* Find a monster slow enough not to move in four turns at either speed */
+	new_level(20);
+	for (i = 1; i < cave_monster_max(cave) && !mon; i++) {
+		struct monster *check = cave_monster(cave, i);
+		if (!check->race) continue;
+		mon_clear_timed(check, MON_TMD_FAST, MON_TMD_FLG_NOTIFY);
+		mon_clear_timed(check, MON_TMD_SLOW, MON_TMD_FLG_NOTIFY);
+		if (2 * turn_energy(check->mspeed) + 2 * turn_energy(check->mspeed + 10)
+			< z_info->move_energy)
+			mon = check;
+	}
+	require(mon);
+
+	monster_set_energy(cave, mon, 0);
+	slow = turn_energy(mon->mspeed);
+	fast = turn_energy(mon->mspeed + 10);
+
+	run_turns(2);
+	mon_inc_timed(mon, MON_TMD_FAST, 50, MON_TMD_FLG_NOFAIL);
+	run_turns(2);
+	monster_energy_settle(cave, mon);
+	eq(mon->energy, 2 * slow + 2 * fast);
+	ok;
+}
+
+/**
+ * Skipping idle turns gives monsters the same energy as running them
+ */
+int test_skip_turns(void *state) {
+	int i, x, y, n = z_info->move_energy - 1;
+	s32b start, next;
+
+	new_level(20);
+	require(cave_monster_count(cave) > 0);
+
+	/* Fiery terrain makes every turn count, so put it out */
+	for (y = 0; y < cave->height; y++) {
+		for (x = 0; x < cave->width; x++) {
+			if (square_isfiery(cave, loc(x, y)))
+				square_set_feat(cave, loc(x, y), FEAT_FLOOR);
+		}
+	}
+	for (i = 1; i < cave_monster_max(cave); i++) {
+		struct monster *mon = cave_monster(cave, i);
+		if (!mon->race) continue;
+		mon_clear_timed(mon, MON_TMD_FAST, MON_TMD_FLG_NOTIFY);
+		mon_clear_timed(mon, MON_TMD_SLOW, MON_TMD_FLG_NOTIFY);
+		monster_set_energy(cave, mon, 0);
+		n = MIN(n, (z_info->move_energy - 1) / turn_energy(mon->mspeed));
+	}
+	require(n > 1);
+
+	/* Run one turn so the monsters are queued, then skip the rest */
+	start = turn;
+	run_turns(1);
+	next = next_monster_turn(cave);
+	require(next > start + n);
+	skip_monster_turns(cave, start + n);
+	turn = start + n;
+	settle_monsters(cave);
+
+	for (i = 1; i < cave_monster_max(cave); i++) {
+		struct monster *mon = cave_monster(cave, i);
+		int gain;
+		if (!mon->race) continue;
+		gain = turn_energy(mon->mspeed);
+		eq(mon->energy, n * gain);
+		eq(mon->ready_turn, start + (z_info->move_energy + gain - 1) / gain);
+	}
+	ok;
+}
+
+/**
+ * Energy a monster gains each game turn, as process_monsters() always
+ * worked it out
+ */
+static int ref_turn_energy(struct monster *mon)
+{
+	int mspeed = mon->mspeed;
+
+	if (mon->m_timed[MON_TMD_FAST])
+		mspeed += 10;
+	if (mon->m_timed[MON_TMD_SLOW])
+		mspeed -= 2 * monster_effect_level(mon, MON_TMD_SLOW);
+
+	return turn_energy(mspeed);
+}
+
+/**
+ * Turn by turn, with monsters free to act, every monster ends each turn with
+ * the energy the old loop over all monsters would have left it: it gains
+ * energy at its speed at the start of the turn, and pays for a move if it
+ * started the turn with enough energy for one
+ */
+int test_turn_by_turn(void *state) {
+	int depths[] = { 5, 20, 40 };
+	size_t d;
+
+	for (d = 0; d < N_ELEMENTS(depths); d++) {
+		int t;
+
+		new_level(depths[d]);
+		require(cave_monster_count(cave) > 0);
+		player_inc_timed(player, TMD_INVULN, 1000, false, false);
+
+		for (t = 0; t < 300; t++) {
+			int max = cave_monster_max(cave);
+			struct monster_race **race = mem_zalloc(max * sizeof(*race));
+			int *expect = mem_zalloc(max * sizeof(int));
+			int i;
+
+			/* Work out what each monster should have after this turn */
+			settle_monsters(cave);
+			for (i = 1; i < max; i++) {
+				struct monster *mon = cave_monster(cave, i);
+				if (!mon->race) continue;
+				race[i] = mon->race;
+				expect[i] = mon->energy + ref_turn_energy(mon);
+				if (mon->energy >= z_info->move_energy)
+					expect[i] -= z_info->move_energy;
+			}
+
+			process_monsters(cave, player->energy + 1);
+			process_monsters(cave, 0);
+			reset_monsters();
+			turn++;
+			require(!player->is_dead);
+
+			/* Monsters which died, or were born, this turn are skipped */
+			settle_monsters(cave);
+			for (i = 1; i < MIN(max, cave_monster_max(cave)); i++) {
+				struct monster *mon = cave_monster(cave, i);
+				if (!race[i] || (mon->race != race[i])) continue;
+				eq(mon->energy, expect[i]);
+			}
+
+			mem_free(expect);
+			mem_free(race);
+		}
+		player_clear_timed(player, TMD_INVULN, false);
+	}
+	ok;
+}
+
+static int refreshes;
+
+static void count_refresh(game_event_type type, game_event_data *data,
+						  void *user)
+{
+	refreshes++;
+}
+
+/**
+ * The game loop passes over turns on which nothing happens, but the player
+ * ends up with the energy they would have had anyway
+ */
+int test_idle_loop(void *state) {
+	int energy, expect;
+	s32b start, end;
+
+	new_level(5);
+	wipe_mon_list(cave, player);
+	player->energy = z_info->move_energy;
+	energy = turn_energy(player->state.speed);
+
+	/* Work out when the player can next move after holding */
+	expect = 0;
+	end = turn;
+	while (expect < z_info->move_energy) {
+		expect += energy;
+		end++;
+	}
+
+	refreshes = 0;
+	event_add_handler(EVENT_REFRESH, count_refresh, NULL);
+	start = turn;
+	cmdq_push(CMD_HOLD);
+	run_game_loop();
+	event_remove_handler(EVENT_REFRESH, count_refresh, NULL);
+
+	eq(turn, end);
+	eq(player->energy, expect);
+	require(turn - start > 2);
+	require(refreshes < turn - start);
+	ok;
+}
+
+static s32b level_turn;
+static int level_energy;
+
+static void note_new_level(game_event_type type, game_event_data *data,
+						   void *user)
+{
+	level_turn = turn;
+	level_energy = player->energy;
+}
+
+/**
+ * A recall which goes off while turns are being passed over takes the player
+ * to the new level on the turn after, just as when turns are run one at a
+ * time
+ */
+int test_idle_recall(void *state) {
+	int energy, expect;
+	s32b end;
+	bool leave = false;
+
+	new_level(5);
+	wipe_mon_list(cave, player);
+	player->energy = z_info->move_energy;
+	energy = turn_energy(player->state.speed);
+
+	/* Start so the recall goes off well before the player could move */
+	turn = 10 * (turn / 10 + 1) + 2;
+	player->word_recall = 1;
+
+	/* Work out when the level changes, turn by turn, after holding */
+	expect = 0;
+	end = turn;
+	while (!leave) {
+		require(expect < z_info->move_energy);
+		if (!(end % 10) && !--player->word_recall)
+			leave = true;
+		expect += energy;
+		end++;
+	}
+	player->word_recall = 1;
+
+	level_turn = 0;
+	event_add_handler(EVENT_NEW_LEVEL_DISPLAY, note_new_level, NULL);
+	cmdq_push(CMD_HOLD);
+	run_game_loop();
+	event_remove_handler(EVENT_NEW_LEVEL_DISPLAY, note_new_level, NULL);
+
+	eq(player->depth, 0);
+	eq(level_turn, end);
+	eq(level_energy, expect);
+
+	/* Arriving gives the player the energy to move straight away */
+	eq(turn, end);
+	eq(player->energy, z_info->move_energy);
+	ok;
+}
+
+const char *suite_name = "game/schedule";
+struct test tests[] = {
+	{ "energy settles", test_energy_settles },
+	{ "speed change", test_speed_change },
+	{ "skip turns", test_skip_turns },
+	{ "turn by turn", test_turn_by_turn },
+	{ "idle loop", test_idle_loop },
+	{ "idle recall", test_idle_recall },
+	{ NULL, NULL }
+};
@@ -0,0 +1,127 @@
+/* game/stores.c */
+
+#include "unit-test.h"
+#include "unit-test-data.h"
+#include "test-utils.h"
+
+#include <stdio.h>
+#include "cmd-core.h"
+#include "game-world.h"
+#include "init.h"
+#include "player.h"
+#include "store.h"
+#include "z-util.h"
+
+static void println(const char *str) {
+	printf("%s\n", str);
+}
+
+int setup_tests(void **state) {
+	/* Register a basic error handler */
+	plog_aux = println;
+
+	/* Init the game */
+	set_file_paths();
+	init_angband();
+
+	/* Make a new character */
+	cmdq_push(CMD_BIRTH_INIT);
+	cmdq_push(CMD_BIRTH_RESET);
+	cmdq_push(CMD_CHOOSE_RACE);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_CHOOSE_CLASS);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_ROLL_STATS);
+	cmdq_push(CMD_NAME_CHOICE);
+	cmd_set_arg_string(cmdq_peek(), "name", "Tester");
+	cmdq_push(CMD_ACCEPT_CHARACTER);
+	cmdq_execute(CTX_BIRTH);
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	cleanup_angband();
+	return 0;
+}
+
+/**
+ * Check a store holds full stacks of its staples and a sensible number of
+ * other items
+ */
+static bool store_ok(struct store *s)
+{
+	int staples = (int)s->always_num;
+	size_t i;
+
+	for (i = 0; i < s->always_num; i++) {
+		struct object *obj;
+
+		for (obj = s->stock; obj; obj = obj->next)
+			if (obj->kind == s->always_table[i] && !obj->ego) break;
+		if (!obj || obj->number != obj->kind->base->max_stack) return false;
+	}
+
+	if (!s->turnover) return s->stock_num >= staples;
+	return s->stock_num >= s->normal_stock_min + staples &&
+		s->stock_num <= s->normal_stock_max + staples;
+}
+
+/**
+ * Check whether an object is one of a store's staples
+ */
+static bool is_staple(struct store *s, struct object *obj)
+{
+	size_t i;
+
+	for (i = 0; i < s->always_num; i++)
+		if (obj->kind == s->always_table[i] && !obj->ego) return true;
+
+	return false;
+}
+
+int test_long_absence(void *state) {
+	struct object *obj;
+	int i;
+
+	/* Mark what's in stock now */
+	for (i = 0; i < MAX_STORES; i++)
+		for (obj = stores[i].stock; obj; obj = obj->next)
+			obj->origin_depth = 99;
+
+	/* Years away turn over everything that can be sold */
+	daycount = 20000;
+	store_update();
+	eq(daycount, 0);
+	for (i = 0; i < MAX_STORES; i++) {
+		if (i == STORE_HOME) continue;
+		require(store_ok(&stores[i]));
+		if (!stores[i].turnover) continue;
+		for (obj = stores[i].stock; obj; obj = obj->next)
+			require(obj->origin_depth != 99 || is_staple(&stores[i], obj));
+	}
+	ok;
+}
+
+int test_days(void *state) {
+	int days, i;
+
+	/* Any absence leaves the stores in order */
+	for (days = 1; days < 40; days += 3) {
+		daycount = days;
+		store_update();
+		eq(daycount, 0);
+		for (i = 0; i < MAX_STORES; i++) {
+			if (i == STORE_HOME) continue;
+			require(store_ok(&stores[i]));
+		}
+	}
+	ok;
+}
+
+const char *suite_name = "game/stores";
+struct test tests[] = {
+	{ "long-absence", test_long_absence },
+	{ "days", test_days },
+	{ NULL, NULL }
+};
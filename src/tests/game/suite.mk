@@ -1,2 +1,11 @@
 TESTPROGS += game/basic \
-	game/mage
+	game/floor \
+	game/journal \
+	game/levels \
+	game/mage \
+	game/nearby \
+	game/noise \
+	game/persist \
+	game/schedule \
+	game/stores \
+	game/view
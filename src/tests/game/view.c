@@ -0,0 +1,324 @@
+/* game/view.c */
+
+#include "unit-test.h"
+#include "unit-test-data.h"
+#include "test-utils.h"
+
+#include <stdio.h>
+#include "cave.h"
+#include "cmd-core.h"
+#include "game-event.h"
+#include "game-world.h"
+#include "init.h"
+#include "mon-make.h"
+#include "mon-util.h"
+#include "player.h"
+#include "player-calcs.h"
+#include "player-timed.h"
+#include "player-util.h"
+#include "z-util.h"
+
+static void println(const char *str) {
+	printf("%s\n", str);
+}
+
+int setup_tests(void **state) {
+	/* Register a basic error handler */
+	plog_aux = println;
+
+	/* Init the game */
+	set_file_paths();
+	init_angband();
+
+	/* Make a new character */
+	cmdq_push(CMD_BIRTH_INIT);
+	cmdq_push(CMD_BIRTH_RESET);
+	cmdq_push(CMD_CHOOSE_RACE);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_CHOOSE_CLASS);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_ROLL_STATS);
+	cmdq_push(CMD_NAME_CHOICE);
+	cmd_set_arg_string(cmdq_peek(), "name", "Tester");
+	cmdq_push(CMD_ACCEPT_CHARACTER);
+	cmdq_execute(CTX_BIRTH);
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	wipe_mon_list(cave, player);
+	cleanup_angband();
+	return 0;
+}
+
+/**
+ * The view calculation as it was before update_view() used precomputed lines
+ * of sight and restricted itself to the area around the player: every grid
+ * of the level is tested with los().
+ */
+static void ref_become_viewable(struct chunk *c, struct loc grid,
+								struct player *p, bool close)
+{
+	if (square_isview(c, grid)) return;
+
+	sqinfo_on(square_info(c, grid), SQUARE_VIEW);
+	if (close)
+		sqinfo_on(square_info(c, grid), SQUARE_SEEN);
+
+	if (square_islit(c, grid)) {
+		if (square_iswall(c, grid)) {
+			int xc = (grid.x < p->grid.x) ? (grid.x + 1) :
+				(grid.x > p->grid.x) ? (grid.x - 1) : grid.x;
+			int yc = (grid.y < p->grid.y) ? (grid.y + 1) :
+				(grid.y > p->grid.y) ? (grid.y - 1) : grid.y;
+			if (square_islit(c, loc(xc, yc))) {
+				sqinfo_on(square_info(c, grid), SQUARE_SEEN);
+			}
+		} else {
+			sqinfo_on(square_info(c, grid), SQUARE_SEEN);
+		}
+	}
+}
+
+static void ref_update_view_one(struct chunk *c, struct loc grid,
+								struct player *p)
+{
+	int x = grid.x, y = grid.y;
+	int xc = x, yc = y;
+	int d = distance(grid, p->grid);
+	bool close = d < p->state.cur_light;
+
+	if (d > z_info->max_sight) return;
+
+	if (player_has(p, PF_UNLIGHT) && (p->state.cur_light <= 1)) {
+		close = d < (2 + p->lev / 6 - p->state.cur_light);
+	}
+
+	if (square_iswall(c, grid)) {
+		int dx = x - p->grid.x;
+		int dy = y - p->grid.y;
+		int ax = ABS(dx);
+		int ay = ABS(dy);
+		int sx = dx > 0 ? 1 : -1;
+		int sy = dy > 0 ? 1 : -1;
+
+		xc = (x < p->grid.x) ? (x + 1) : (x > p->grid.x) ? (x - 1) : x;
+		yc = (y < p->grid.y) ? (y + 1) : (y > p->grid.y) ? (y - 1) : y;
+
+		if (square_iswall(c, loc(xc, yc))) {
+			xc = x;
+			yc = y;
+		}
+
+		if (ax == 2 && ay == 1) {
+			if (!square_iswall(c, loc(x - sx, y))
+				&& square_iswall(c, loc(x - sx, y - sy))) {
+				xc = x;
+				yc = y;
+			}
+		} else if (ax == 1 && ay == 2) {
+			if (!square_iswall(c, loc(x, y - sy))
+				&& square_iswall(c, loc(x - sx, y - sy))) {
+				xc = x;
+				yc = y;
+			}
+		}
+	}
+
+	if (los(c, p->grid, loc(xc, yc)))
+		ref_become_viewable(c, grid, p, close);
+}
+
+/**
+ * Check update_view() against the reference from one player grid; the
+ * lighting calculated by update_view() is reused by the reference.
+ */
+static bool view_matches(struct chunk *c, struct player *p)
+{
+	int x, y, n = c->height * c->width;
+	bitflag *view = mem_zalloc(n * sizeof(bitflag));
+	bitflag *seen = mem_zalloc(n * sizeof(bitflag));
+	bool match = true;
+
+	update_view(c, p);
+	for (y = 0; y < c->height; y++) {
+		for (x = 0; x < c->width; x++) {
+			struct loc grid = loc(x, y);
+			view[square_idx(c, grid)] = square_isview(c, grid);
+			seen[square_idx(c, grid)] = square_isseen(c, grid);
+		}
+	}
+
+	/* Recalculate from scratch the old way */
+	for (y = 0; y < c->height; y++) {
+		for (x = 0; x < c->width; x++) {
+			sqinfo_off(square_info(c, loc(x, y)), SQUARE_VIEW);
+			sqinfo_off(square_info(c, loc(x, y)), SQUARE_SEEN);
+		}
+	}
+	sqinfo_on(square_info(c, p->grid), SQUARE_VIEW);
+	if (p->state.cur_light > 0 || square_isglow(c, p->grid) ||
+		player_has(p, PF_UNLIGHT)) {
+		sqinfo_on(square_info(c, p->grid), SQUARE_SEEN);
+	}
+	for (y = 0; y < c->height; y++)
+		for (x = 0; x < c->width; x++)
+			ref_update_view_one(c, loc(x, y), p);
+
+	for (y = 0; y < c->height && match; y++) {
+		for (x = 0; x < c->width; x++) {
+			struct loc grid = loc(x, y);
+			if (view[square_idx(c, grid)] != square_isview(c, grid) ||
+				seen[square_idx(c, grid)] != square_isseen(c, grid)) {
+				printf("Mismatch at (%d, %d) viewed from (%d, %d)\n",
+					   x, y, p->grid.x, p->grid.y);
+				match = false;
+				break;
+			}
+		}
+	}
+
+	mem_free(view);
+	mem_free(seen);
+	return match;
+}
+
+int test_view_matches_los(void *state) {
+	int depths[] = { 0, 1, 5, 12, 25, 40, 70 };
+	size_t i;
+
+	for (i = 0; i < N_ELEMENTS(depths); i++) {
+		int x, y, n = 0;
+
+		dungeon_change_level(player, depths[i]);
+		prepare_next_level(&cave, player);
+		on_new_level();
+
+		/* View from a spread of open grids, including long jumps */
+		for (y = 1; y < cave->height - 1; y++) {
+			for (x = 1; x < cave->width - 1; x++) {
+				struct loc grid = loc(x, y);
+				if (!square_ispassable(cave, grid)) continue;
+				if (n++ % 5) continue;
+				player->grid = grid;
+				require(view_matches(cave, player));
+			}
+		}
+	}
+	ok;
+}
+
+/**
+ * Light at a grid as calc_lighting() used to find it, with monster light
+ * limited to grids within max_sight of the player
+ */
+static int ref_source_light(struct loc centre, int light, struct loc grid)
+{
+	int radius = ABS(light) - 1;
+	int dist = distance(centre, grid);
+
+	if (dist > radius) return 0;
+	return (light > 0) ? light - dist : light + dist;
+}
+
+static int ref_light(struct chunk *c, struct player *p, struct loc grid)
+{
+	int d, k, light = square_isglow(c, grid) ? 1 : 0;
+
+	/* Bright grids light only the neighbours before them row by row, as
+	 * each grid was reset when it came up in the scan */
+	for (d = 0; d < 9; d++) {
+		struct loc adj = loc_sum(grid, ddgrid_ddd[d]);
+		if (!square_in_bounds(c, adj) || !square_isbright(c, adj)) continue;
+		if (loc_eq(adj, grid)) {
+			light += 2;
+		} else if ((adj.y > grid.y) ||
+				   ((adj.y == grid.y) && (adj.x > grid.x))) {
+			light += 1;
+		}
+	}
+
+	light += ref_source_light(p->grid, p->state.cur_light, grid);
+
+	if (distance(p->grid, grid) > z_info->max_sight) return light;
+	for (k = 1; k < cave_monster_max(c); k++) {
+		struct monster *mon = cave_monster(c, k);
+		if (!mon->race || (ABS(mon->race->light) <= 1)) continue;
+		light += ref_source_light(mon->grid, mon->race->light, grid);
+	}
+
+	return light;
+}
+
+static bool light_matches(struct chunk *c, struct player *p)
+{
+	int x, y;
+
+	update_view(c, p);
+	for (y = 0; y < c->height; y++) {
+		for (x = 0; x < c->width; x++) {
+			struct loc grid = loc(x, y);
+			if (distance(p->grid, grid) > z_info->max_sight) continue;
+			if (square_light(c, grid) != ref_light(c, p, grid)) {
+				printf("Light %d, expected %d at (%d, %d) from (%d, %d)\n",
+					   square_light(c, grid), ref_light(c, p, grid),
+					   x, y, p->grid.x, p->grid.y);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+int test_light_matches(void *state) {
+	int depths[] = { 3, 30, 60 };
+	size_t i;
+
+	for (i = 0; i < N_ELEMENTS(depths); i++) {
+		int x, y, n = 0;
+
+		dungeon_change_level(player, depths[i]);
+		prepare_next_level(&cave, player);
+		on_new_level();
+
+		for (y = 1; y < cave->height - 1; y++) {
+			for (x = 1; x < cave->width - 1; x++) {
+				struct loc grid = loc(x, y);
+				if (!square_isfloor(cave, grid)) continue;
+				if (n++ % 37) continue;
+
+				/* Change permanent light and terrain as we go */
+				if (n % 3 == 0) {
+					square_set_feat(cave, loc(x - 1, y), FEAT_LAVA);
+				} else if (square_isglow(cave, grid)) {
+					square_unglow(cave, grid);
+				} else {
+					square_glow(cave, grid);
+				}
+
+				/* Move a monster as well */
+				if (cave_monster_max(cave) > 1) {
+					struct monster *mon = cave_monster(cave,
+						n % (cave_monster_max(cave) - 1) + 1);
+					struct loc to = loc_sum(grid, loc(2, 1));
+					if (mon->race && square_in_bounds_fully(cave, to) &&
+						square_isempty(cave, to))
+						monster_swap(mon->grid, to);
+				}
+
+				monster_swap(player->grid, grid);
+				require(light_matches(cave, player));
+			}
+		}
+	}
+	ok;
+}
+
+const char *suite_name = "game/view";
+struct test tests[] = {
+	{ "view-matches-los", test_view_matches_los },
+	{ "light-matches", test_light_matches },
+	{ NULL, NULL }
+};
@@ -0,0 +1,98 @@
+/* message/message.c */
+
+#include "unit-test.h"
+#include "message.h"
+#include "z-form.h"
+#include "z-util.h"
+
+int setup_tests(void **state) {
+	messages_init();
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	messages_free();
+	return 0;
+}
+
+int test_repeat(void *state) {
+	message_add("You hit the orc.", MSG_GENERIC);
+	message_add("You hit the orc.", MSG_GENERIC);
+	message_add("You hit the orc.", MSG_HIT);
+	message_add("You hit the orc.", MSG_HIT);
+	message_add("You hit the orc.", MSG_HIT);
+
+	eq(messages_num(), 2);
+	eq(message_count(0), 3);
+	eq(message_type(0), MSG_HIT);
+	eq(message_count(1), 2);
+	eq(message_type(1), MSG_GENERIC);
+	require(streq(message_str(0), message_str(1)));
+	require(streq(message_str(2), ""));
+	eq(message_count(2), 0);
+	ok;
+}
+
+int test_wrap(void *state) {
+	char buf[80];
+	int i, n = MESSAGES_MAX * 10 - 1;
+
+	/* Enough long, distinct messages to refill the arena many times over */
+	for (i = 0; i < MESSAGES_MAX * 10; i++) {
+		strnfmt(buf, sizeof(buf), "%d: The cave troll bites you, and you "
+				"feel your life draining away.", i);
+		message_add(buf, i % 2 ? MSG_GENERIC : MSG_HIT);
+		if (i % 3 == 0)
+			message_add("The cave troll misses you.", MSG_MISS);
+	}
+
+	/* The newest messages are kept, in order */
+	eq(messages_num(), MESSAGES_MAX);
+	for (i = 0; i < MESSAGES_MAX; i++) {
+		const char *str = message_str(i);
+
+		if (message_type(i) == MSG_MISS) {
+			require(streq(str, "The cave troll misses you."));
+			continue;
+		}
+		eq(atoi(str), n--);
+		eq(message_count(i), 1);
+	}
+	require(streq(message_str(MESSAGES_MAX), ""));
+	ok;
+}
+
+int test_search(void *state) {
+	int misses = 0, i;
+
+	message_add("The Grip, Farmer Maggot's Dog bites you.", MSG_HIT);
+	message_add("You have no more Flasks of Oil.", MSG_GENERIC);
+	message_add("The Grip, Farmer Maggot's Dog bites you.", MSG_HIT);
+	message_add("You feel better.", MSG_GENERIC);
+
+	eq(message_search("MAGGOT", 0), 1);
+	eq(message_search("MAGGOT", 2), 3);
+	eq(message_search("flasks", 0), 2);
+	eq(message_search("flasks", 3), -1);
+	eq(message_search("no such thing", 0), -1);
+
+	/* The answers don't go stale as the messages change */
+	message_add("You have no more Flasks of Oil.", MSG_GENERIC);
+	eq(message_search("flasks", 0), 0);
+	eq(message_search("flasks", 1), 3);
+	for (i = message_search("misses", 0); i >= 0;
+		 i = message_search("misses", i + 1)) {
+		require(streq(message_str(i), "The cave troll misses you."));
+		misses++;
+	}
+	require(misses > 0);
+	ok;
+}
+
+const char *suite_name = "message/message";
+struct test tests[] = {
+	{ "repeat", test_repeat },
+	{ "wrap", test_wrap },
+	{ "search", test_search },
+	{ NULL, NULL }
+};
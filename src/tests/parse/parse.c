@@ -394,6 +394,90 @@ int test_char1(void *state) {
 	ok;
 }
 
+struct snap_result {
+	int lines;
+	int total;
+	int dice;
+	unsigned int line;
+	char rest[32];
+};
+
+static enum parser_error helper_snap0(struct parser *p) {
+	struct snap_result *res = parser_priv(p);
+	struct parser_state s;
+
+	if (!streq(parser_getsym(p, "s"), res->lines ? "b" : "a"))
+		return PARSE_ERROR_GENERIC;
+	res->lines++;
+	res->total += parser_getint(p, "i");
+	res->dice += parser_getrand(p, "r").dice * parser_getrand(p, "r").sides;
+	if (parser_hasval(p, "rest"))
+		my_strcpy(res->rest, parser_getstr(p, "rest"), sizeof(res->rest));
+	parser_getstate(p, &s);
+	res->line = s.line;
+	return PARSE_ERROR_NONE;
+}
+
+int test_snapshot0(void *state) {
+	struct snap_result parsed, replayed;
+	char *snap;
+	size_t len;
+	errr r = parser_reg(state, "test-snap0 sym s int i rand r ?str rest",
+						helper_snap0);
+	eq(r, 0);
+
+	/* Record some lines as they are parsed */
+	memset(&parsed, 0, sizeof(parsed));
+	parser_setpriv(state, &parsed);
+	parser_record(state);
+	eq(parser_parse(state, "test-snap0:a:1:2d3"), PARSE_ERROR_NONE);
+	eq(parser_parse(state, "# comment"), PARSE_ERROR_NONE);
+	eq(parser_parse(state, "test-snap0:b:-4:d5:the rest: here"),
+	   PARSE_ERROR_NONE);
+	snap = parser_recording(state, &len);
+	eq(parsed.lines, 2);
+	eq(parsed.total, -3);
+	eq(parsed.dice, 11);
+	require(streq(parsed.rest, "the rest: here"));
+
+	/* Replaying them runs the hook on the same values */
+	memset(&replayed, 0, sizeof(replayed));
+	parser_setpriv(state, &replayed);
+	require(parser_snapshot_valid(state, snap, len));
+	eq(parser_replay(state, snap, len), PARSE_ERROR_NONE);
+	require(!memcmp(&parsed, &replayed, sizeof(parsed)));
+
+	/* A cut off snapshot can't be replayed */
+	require(!parser_snapshot_valid(state, snap, len - 1));
+	mem_free(snap);
+	ok;
+}
+
+int test_snapshot1(void *state) {
+	struct parser *p = parser_new();
+	char *snap;
+	size_t len;
+	int wasok = 0;
+
+	/* Characters are converted again on replay */
+	parser_setpriv(state, &wasok);
+	parser_record(state);
+	eq(parser_parse(state, "test-char1:::34:::lala"), PARSE_ERROR_NONE);
+	snap = parser_recording(state, &len);
+	eq(wasok, 1);
+	wasok = 0;
+	require(parser_snapshot_valid(state, snap, len));
+	eq(parser_replay(state, snap, len), PARSE_ERROR_NONE);
+	eq(wasok, 1);
+
+	/* A parser whose hook has a different format can't replay it */
+	eq(parser_reg(p, "test-char1 char c0 int i0 char c1 sym s", ignored), 0);
+	require(!parser_snapshot_valid(p, snap, len));
+	parser_destroy(p);
+	mem_free(snap);
+	ok;
+}
+
 const char *suite_name = "parse/parser";
 struct test tests[] = {
 	{ "priv", test_priv },
@@ -437,5 +521,8 @@ struct test tests[] = {
 
 	{ "baddir", test_baddir },
 
+	{ "snapshot0", test_snapshot0 },
+	{ "snapshot1", test_snapshot1 },
+
 	{ NULL, NULL }
 };
@@ -2,6 +2,7 @@
 
 #include "unit-test.h"
 #include "unit-test-data.h"
+#include "obj-pile.h"
 #include "player-birth.h"
 #include "player-quest.h"
 
@@ -25,10 +26,7 @@ int teardown_tests(void *state) {
 	mem_free(p->upkeep->quiver);
 	mem_free(p->upkeep);
 	mem_free(p->timed);
-	mem_free(p->obj_k->brands);
-	mem_free(p->obj_k->slays);
-	mem_free(p->obj_k->curses);
-	mem_free(p->obj_k);
+	object_free(p->obj_k);
 	mem_free(state);
 	return 0;
 }
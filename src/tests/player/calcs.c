@@ -0,0 +1,143 @@
+/* player/calcs.c */
+
+#include "unit-test.h"
+#include "unit-test-data.h"
+#include "test-utils.h"
+
+#include <stdio.h>
+#include "cave.h"
+#include "cmd-core.h"
+#include "init.h"
+#include "obj-gear.h"
+#include "obj-knowledge.h"
+#include "obj-make.h"
+#include "obj-pile.h"
+#include "obj-tval.h"
+#include "player-calcs.h"
+#include "z-util.h"
+
+static void println(const char *str) {
+	printf("%s\n", str);
+}
+
+int setup_tests(void **state) {
+	/* Register a basic error handler */
+	plog_aux = println;
+
+	/* Init the game */
+	set_file_paths();
+	init_angband();
+
+	/* Make a new character */
+	cmdq_push(CMD_BIRTH_INIT);
+	cmdq_push(CMD_BIRTH_RESET);
+	cmdq_push(CMD_CHOOSE_RACE);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_CHOOSE_CLASS);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_ROLL_STATS);
+	cmdq_push(CMD_NAME_CHOICE);
+	cmd_set_arg_string(cmdq_peek(), "name", "Tester");
+	cmdq_push(CMD_ACCEPT_CHARACTER);
+	cmdq_execute(CTX_BIRTH);
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	cleanup_angband();
+	return 0;
+}
+
+/**
+ * Work out the known state with `obj` in `slot` without using the cache
+ */
+static void fresh_swap(struct player_state *state, int slot,
+					   struct object *obj)
+{
+	struct object *current = slot_object(player, slot);
+	u32b update = player->upkeep->update;
+
+	player->upkeep->update |= (PU_BONUS);
+	player->body.slots[slot].obj = obj;
+	calc_bonuses(player, state, true, false);
+	player->body.slots[slot].obj = current;
+	player->upkeep->update = update;
+}
+
+/**
+ * Compare calc_bonuses_swap() with the whole calculation for every wearable
+ * object kind
+ */
+static bool swaps_match(void)
+{
+	int i;
+
+	for (i = 1; i < z_info->k_max; i++) {
+		struct object_kind *kind = &k_info[i];
+		struct player_state cached, fresh;
+		struct object *obj;
+		int slot;
+		bool same;
+
+		if (!kind->name || !kind->base) continue;
+		if (kf_has(kind->kind_flags, KF_INSTA_ART)) continue;
+
+		obj = object_new();
+		object_prep(obj, kind, 20, RANDOMISE);
+		if (!tval_is_wearable(obj)) {
+			object_free(obj);
+			continue;
+		}
+		obj->known = object_new();
+		object_set_base_known(obj);
+		object_touch(player, obj);
+		slot = wield_slot(obj);
+
+		memset(&cached, 0, sizeof(cached));
+		memset(&fresh, 0, sizeof(fresh));
+		calc_bonuses_swap(player, &cached, slot, obj);
+		fresh_swap(&fresh, slot, obj);
+		same = !memcmp(&cached, &fresh, sizeof(cached));
+
+		object_free(obj->known);
+		object_free(obj);
+		if (!same) return false;
+	}
+	return true;
+}
+
+int test_swap(void *state) {
+	struct player_state cached, fresh;
+
+	player->upkeep->update |= (PU_BONUS);
+	update_stuff(player);
+
+	/* Nothing swapped */
+	memset(&cached, 0, sizeof(cached));
+	memset(&fresh, 0, sizeof(fresh));
+	calc_bonuses(player, &cached, true, false);
+	fresh_swap(&fresh, 0, slot_object(player, 0));
+	require(!memcmp(&cached, &fresh, sizeof(cached)));
+
+	require(swaps_match());
+	ok;
+}
+
+int test_learn(void *state) {
+	/* Learning runes changes what the player knows of their gear */
+	player->upkeep->update &= ~(PU_BONUS);
+	player_learn_all_runes(player);
+	require(player->upkeep->update & (PU_BONUS));
+
+	update_stuff(player);
+	require(swaps_match());
+	ok;
+}
+
+const char *suite_name = "player/calcs";
+struct test tests[] = {
+	{ "swap", test_swap },
+	{ "learn", test_learn },
+	{ NULL, NULL }
+};
@@ -1,11 +1,50 @@
 /* player/pathfind */
 
 #include "unit-test.h"
+#include "unit-test-data.h"
+#include "test-utils.h"
+
+#include <stdio.h>
 #include "cave.h"
+#include "cmd-core.h"
+#include "init.h"
+#include "player.h"
 #include "player-path.h"
+#include "player-util.h"
+#include "z-util.h"
+
+static void println(const char *str) {
+	printf("%s\n", str);
+}
+
+int setup_tests(void **state) {
+	/* Register a basic error handler */
+	plog_aux = println;
+
+	/* Init the game */
+	set_file_paths();
+	init_angband();
+
+	/* Make a new character */
+	cmdq_push(CMD_BIRTH_INIT);
+	cmdq_push(CMD_BIRTH_RESET);
+	cmdq_push(CMD_CHOOSE_RACE);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_CHOOSE_CLASS);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_ROLL_STATS);
+	cmdq_push(CMD_NAME_CHOICE);
+	cmd_set_arg_string(cmdq_peek(), "name", "Tester");
+	cmdq_push(CMD_ACCEPT_CHARACTER);
+	cmdq_execute(CTX_BIRTH);
 
-NOSETUP
-NOTEARDOWN
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	cleanup_angband();
+	return 0;
+}
 
 int test_dir_to(void *state) {
 	eq(pathfind_direction_to(loc(0,0), loc(0,1)), DIR_S);
@@ -24,8 +63,210 @@ int test_dir_to(void *state) {
 	ok;
 }
 
+static struct chunk *old_cave, *old_known;
+
+/**
+ * Build a known level from a picture: '#' is granite, '@' the player and
+ * anything else floor
+ */
+static void layout_start(const char **rows, int height)
+{
+	int width = strlen(rows[0]);
+	int x, y;
+
+	old_cave = cave;
+	old_known = player->cave;
+	cave = cave_new(height, width);
+	player->cave = cave_new(height, width);
+	for (y = 0; y < height; y++) {
+		for (x = 0; x < width; x++) {
+			struct loc grid = loc(x, y);
+			square_set_feat(cave, grid,
+							rows[y][x] == '#' ? FEAT_GRANITE : FEAT_FLOOR);
+			square_memorize(cave, grid);
+			if (rows[y][x] == '@') player_place(cave, player, grid);
+		}
+	}
+}
+
+static void layout_end(void)
+{
+	cave_free(cave);
+	cave_free(player->cave);
+	cave = old_cave;
+	player->cave = old_known;
+}
+
+/**
+ * Steps to a grid and the first of them, as the old pathfinder found them:
+ * distances by breadth-first search, then a path traced back from the target
+ * taking the first direction in the order 2, 4, 6, 8, 1, 3, 7, 9 which goes
+ * one step closer
+ */
+static int old_path(struct loc target, int *first)
+{
+	static const int order[8] = { 2, 4, 6, 8, 1, 3, 7, 9 };
+	int n = cave->height * cave->width;
+	int *dist = mem_alloc(n * sizeof(int));
+	int *queue = mem_alloc(n * sizeof(int));
+	int i, head = 0, tail = 0, length;
+	struct loc grid;
+
+	for (i = 0; i < n; i++) dist[i] = -1;
+	dist[square_idx(cave, player->grid)] = 0;
+	queue[tail++] = square_idx(cave, player->grid);
+	while (head < tail) {
+		int idx = queue[head++], d;
+		i_to_grid(idx, cave->width, &grid);
+		for (d = 0; d < 8; d++) {
+			struct loc next = loc_sum(grid, ddgrid_ddd[d]);
+			int next_idx;
+			if (!square_in_bounds_fully(cave, next)) continue;
+			if (!square_ispassable(cave, next)) continue;
+			next_idx = square_idx(cave, next);
+			if (dist[next_idx] >= 0) continue;
+			dist[next_idx] = dist[idx] + 1;
+			queue[tail++] = next_idx;
+		}
+	}
+
+	length = dist[square_idx(cave, target)];
+	*first = DIR_NONE;
+	grid = target;
+	while (length > 0 && !loc_eq(grid, player->grid)) {
+		int step = dist[square_idx(cave, grid)] - 1;
+		for (i = 0; i < 8; i++) {
+			struct loc next = loc_sum(grid, ddgrid[order[i]]);
+			if (square_in_bounds(cave, next) &&
+				(dist[square_idx(cave, next)] == step)) {
+				*first = 10 - order[i];
+				grid = next;
+				break;
+			}
+		}
+	}
+
+	mem_free(queue);
+	mem_free(dist);
+	return length;
+}
+
+/**
+ * Check the path to every reachable grid against the old pathfinder
+ */
+static bool paths_match(void)
+{
+	int x, y;
+
+	for (y = 1; y < cave->height - 1; y++) {
+		for (x = 1; x < cave->width - 1; x++) {
+			struct loc grid = loc(x, y);
+			int length, first, dir;
+
+			if (loc_eq(grid, player->grid)) continue;
+			length = old_path(grid, &first);
+			if (length < 0) {
+				if (findpath(y, x)) return false;
+				continue;
+			}
+			if (!findpath(y, x)) return false;
+			if ((pathfind_steps(&dir) != length) || (dir != first)) {
+				printf("Path to (%d, %d): %d steps starting %d, expected %d "
+					   "starting %d\n", x, y, pathfind_steps(&dir), dir,
+					   length, first);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+int test_open_room(void *state) {
+	const char *rows[] = {
+		"###########",
+		"#@........#",
+		"#.........#",
+		"#.........#",
+		"###########",
+	};
+	int dir;
+
+	layout_start(rows, N_ELEMENTS(rows));
+
+	/* Many equally short paths; the old tie-break goes diagonally first */
+	require(findpath(3, 5));
+	eq(pathfind_steps(&dir), 4);
+	eq(dir, DIR_SE);
+
+	/* Straight along the wall */
+	require(findpath(1, 9));
+	eq(pathfind_steps(&dir), 8);
+	eq(dir, DIR_E);
+
+	require(paths_match());
+	layout_end();
+	ok;
+}
+
+int test_around_walls(void *state) {
+	const char *rows[] = {
+		"#########",
+		"#@#.....#",
+		"#.#.###.#",
+		"#.#...#.#",
+		"#.###.#.#",
+		"#.....#.#",
+		"#########",
+		"#.......#",
+		"#########",
+	};
+	int dir;
+
+	layout_start(rows, N_ELEMENTS(rows));
+
+	/* The only way out is south */
+	require(findpath(1, 3));
+	eq(pathfind_steps(&dir), 10);
+	eq(dir, DIR_S);
+
+	/* Cut off from the player */
+	require(!findpath(7, 1));
+
+	require(paths_match());
+	layout_end();
+	ok;
+}
+
+int test_two_routes(void *state) {
+	const char *rows[] = {
+		"#########",
+		"#.......#",
+		"#.#####.#",
+		"#@#...#.#",
+		"#.#####.#",
+		"#.......#",
+		"#########",
+	};
+	int dir;
+
+	layout_start(rows, N_ELEMENTS(rows));
+
+	/* Round the top and round the bottom are equally long */
+	require(findpath(3, 7));
+	eq(pathfind_steps(&dir), 8);
+	eq(dir, DIR_S);
+
+	require(paths_match());
+	layout_end();
+	ok;
+}
+
 const char *suite_name = "player/pathfind";
 struct test tests[] = {
 	{ "dir-to", test_dir_to },
+	{ "open-room", test_open_room },
+	{ "around-walls", test_around_walls },
+	{ "two-routes", test_two_routes },
 	{ NULL, NULL },
 };
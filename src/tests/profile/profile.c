@@ -0,0 +1,143 @@
+/* profile/profile.c */
+
+#include "unit-test.h"
+#include "profile.h"
+#include "z-file.h"
+#include "z-util.h"
+
+NOSETUP
+NOTEARDOWN
+
+/**
+ * Spend a little time in a section, so it has something to show
+ */
+static void busy_section(enum profile_section section, int work)
+{
+	volatile int sum = 0;
+	int i;
+
+	profile_start(section);
+	for (i = 0; i < work * 10000; i++)
+		sum += i;
+	profile_stop(section);
+}
+
+int test_turns(void *state) {
+	const struct profile_level *level, *session;
+
+	profile_reset();
+	profile_new_level(5, 100);
+
+	/* A nested section and a recursive one */
+	profile_start(PROF_HANDLE);
+	busy_section(PROF_UPDATE, 1);
+	busy_section(PROF_HANDLE, 1);
+	profile_stop(PROF_HANDLE);
+	profile_end_turn(100);
+	busy_section(PROF_MONSTERS, 1);
+	profile_end_turn(101);
+
+	level = profile_recent_level(0);
+	require(level && level->depth == 5 && level->first_turn == 100);
+	eq(level->turns, 2);
+	eq(level->count[PROF_HANDLE].calls, 2);
+	eq(level->count[PROF_UPDATE].calls, 1);
+	eq(level->count[PROF_MONSTERS].calls, 1);
+	eq(level->count[PROF_VIEW].calls, 0);
+	require(level->count[PROF_HANDLE].nsecs >= level->count[PROF_UPDATE].nsecs);
+	require(level->busy == level->count[PROF_HANDLE].nsecs +
+			level->count[PROF_MONSTERS].nsecs);
+	require(level->worst_busy <= level->busy);
+
+	/* Turns on the next level go there, and both count for the session */
+	profile_new_level(6, 102);
+	busy_section(PROF_WORLD, 1);
+	profile_end_turn(102);
+	level = profile_recent_level(0);
+	require(level && level->depth == 6);
+	eq(level->turns, 1);
+	eq(level->count[PROF_WORLD].calls, 1);
+	eq(profile_recent_level(1)->depth, 5);
+	null(profile_recent_level(2));
+	session = profile_session();
+	eq(session->turns, 3);
+	eq(session->count[PROF_WORLD].calls, 1);
+	eq(session->count[PROF_HANDLE].calls, 2);
+
+	/* Arriving on a level which has just been started changes nothing */
+	profile_new_level(7, 103);
+	profile_new_level(7, 103);
+	eq(profile_recent_level(0)->depth, 7);
+	eq(profile_recent_level(1)->depth, 6);
+	null(profile_recent_level(3));
+	ok;
+}
+
+int test_slowest(void *state) {
+	const struct profile_turn *t;
+	int i;
+
+	profile_reset();
+	profile_new_level(1, 0);
+	for (i = 0; i < PROFILE_SLOWEST * 2; i++) {
+		busy_section(PROF_PROJECT, 1 + (i * 7) % 5);
+		profile_end_turn(i);
+	}
+
+	/* Idle turns aren't interesting */
+	profile_end_turn(i);
+
+	for (i = 0; i < PROFILE_SLOWEST; i++) {
+		t = profile_slowest(i);
+		require(t);
+		eq(t->depth, 1);
+		eq(t->count[PROF_PROJECT].calls, 1);
+		require(t->busy == t->count[PROF_PROJECT].nsecs);
+		if (i) require(t->busy <= profile_slowest(i - 1)->busy);
+	}
+	null(profile_slowest(PROFILE_SLOWEST));
+	eq(profile_slowest(0)->busy, profile_session()->worst_busy);
+	ok;
+}
+
+int test_dump(void *state) {
+	char buf[1024];
+	ang_file *f;
+	int lines = 0;
+
+	profile_reset();
+	profile_new_level(3, 10);
+	busy_section(PROF_VIEW, 1);
+	profile_end_turn(10);
+	profile_end_turn(11);
+	profile_new_level(4, 12);
+	busy_section(PROF_FRESH, 1);
+	profile_end_turn(12);
+
+	require(profile_dump("profile.csv"));
+	f = file_open("profile.csv", MODE_READ, FTYPE_TEXT);
+	require(f);
+	require(file_getl(f, buf, sizeof(buf)));
+	require(prefix(buf, "kind,depth,turn,turns,busy_us,world_calls,world_us,"));
+	while (file_getl(f, buf, sizeof(buf))) {
+		lines++;
+		if (lines == 1) require(prefix(buf, "level,3,10,2,"));
+		if (lines == 2) require(prefix(buf, "level,4,12,1,"));
+		if (lines == 3) require(prefix(buf, "turn,3,10,1,"));
+		if (lines == 4) require(prefix(buf, "turn,4,12,1,"));
+	}
+	file_close(f);
+	file_delete("profile.csv");
+
+	/* Two levels and the two turns which did anything */
+	eq(lines, 4);
+	ok;
+}
+
+const char *suite_name = "profile/profile";
+struct test tests[] = {
+	{ "turns", test_turns },
+	{ "slowest", test_slowest },
+	{ "dump", test_dump },
+	{ NULL, NULL }
+};
@@ -0,0 +1 @@
+TESTPROGS += profile/profile
@@ -0,0 +1,151 @@
+/* ui-map/map.c */
+
+#include "unit-test.h"
+#include "unit-test-data.h"
+#include "test-utils.h"
+
+#include <stdio.h>
+#include "cave.h"
+#include "cmd-core.h"
+#include "game-world.h"
+#include "generate.h"
+#include "init.h"
+#include "mon-make.h"
+#include "player.h"
+#include "ui-map.h"
+#include "ui-prefs.h"
+#include "ui-term.h"
+#include "z-util.h"
+
+static term t;
+
+static void println(const char *str) {
+	printf("%s\n", str);
+}
+
+static errr text_nothing(int x, int y, int n, int a, const wchar_t *s)
+{
+	return 0;
+}
+
+int setup_tests(void **state) {
+	/* Register a basic error handler */
+	plog_aux = println;
+
+	/* Init the game */
+	set_file_paths();
+	init_angband();
+
+	/* Make a new character */
+	cmdq_push(CMD_BIRTH_INIT);
+	cmdq_push(CMD_BIRTH_RESET);
+	cmdq_push(CMD_CHOOSE_RACE);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_CHOOSE_CLASS);
+	cmd_set_arg_choice(cmdq_peek(), "choice", 0);
+	cmdq_push(CMD_ROLL_STATS);
+	cmdq_push(CMD_NAME_CHOICE);
+	cmd_set_arg_string(cmdq_peek(), "name", "Tester");
+	cmdq_push(CMD_ACCEPT_CHARACTER);
+	cmdq_execute(CTX_BIRTH);
+
+	/* Default glyphs */
+	textui_prefs_init();
+
+	/* A screen to draw the map on */
+	term_init(&t, 80, 24, 16);
+	t.text_hook = text_nothing;
+	Term_activate(&t);
+	angband_term[0] = &t;
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	map_cache_free();
+	textui_prefs_free();
+	angband_term[0] = NULL;
+	Term_activate(NULL);
+	term_nuke(&t);
+	wipe_mon_list(cave, player);
+	cleanup_angband();
+	return 0;
+}
+
+static void new_level(int depth)
+{
+	dungeon_change_level(player, depth);
+	prepare_next_level(&cave, player);
+	on_new_level();
+	player->upkeep->generate_level = false;
+}
+
+/**
+ * Check that a grid on the screen looks as map_info() says it should
+ */
+static bool shows(struct loc grid)
+{
+	struct grid_data g;
+	int a, ta, sa;
+	wchar_t c, tc, sc;
+
+	map_info(grid, &g);
+	grid_data_as_text(&g, &a, &c, &ta, &tc);
+	Term_what(grid.x - t.offset_x + COL_MAP, grid.y - t.offset_y + ROW_MAP,
+			  &sa, &sc);
+	return (sa == a) && (sc == c);
+}
+
+int test_panel(void *state) {
+	int x, y;
+
+	new_level(5);
+	wiz_light(cave, player, false);
+	t.offset_x = t.offset_y = 0;
+
+	map_mark_all();
+	prt_map();
+	for (y = 0; y < SCREEN_HGT; y++)
+		for (x = 0; x < SCREEN_WID; x++) {
+			if (!square_in_bounds(cave, loc(x, y))) continue;
+			require(shows(loc(x, y)));
+		}
+	ok;
+}
+
+int test_grid(void *state) {
+	struct loc grid;
+	int x, y;
+
+	/* Find a floor grid on the panel */
+	for (y = 1; y < SCREEN_HGT; y++)
+		for (x = 1; x < SCREEN_WID; x++) {
+			grid = loc(x, y);
+			if (square_in_bounds_fully(cave, grid) &&
+				square_isempty(cave, grid))
+				goto found;
+		}
+	require(false);
+
+found:
+	square_set_feat(cave, grid, FEAT_RUBBLE);
+	square_memorize(cave, grid);
+
+	/* Unmarked grids are drawn as they were */
+	prt_map();
+	require(!shows(grid));
+
+	/* Marked ones are looked at again */
+	prt_map_grid(grid);
+	require(shows(grid));
+	prt_map();
+	require(shows(grid));
+	ok;
+}
+
+const char *suite_name = "ui-map/map";
+struct test tests[] = {
+	{ "panel", test_panel },
+	{ "grid", test_grid },
+	{ NULL, NULL }
+};
@@ -0,0 +1 @@
+TESTPROGS += ui-term/term
@@ -0,0 +1,106 @@
+/* ui-term/term.c */
+
+#include "unit-test.h"
+#include "ui-term.h"
+#include "z-color.h"
+
+static term t;
+static int freshes, delays;
+
+static errr xtra_count(int n, int v)
+{
+	if (n == TERM_XTRA_FRESH) freshes++;
+	if (n == TERM_XTRA_DELAY) delays++;
+
+	/* Any wait for a key gets one */
+	if (n == TERM_XTRA_EVENT && v) Term_keypress('a', 0);
+	return 0;
+}
+
+static errr text_nothing(int x, int y, int n, int a, const wchar_t *s)
+{
+	return 0;
+}
+
+int setup_tests(void **state) {
+	term_init(&t, 80, 24, 16);
+	t.xtra_hook = xtra_count;
+	t.text_hook = text_nothing;
+	Term_activate(&t);
+	angband_term[0] = &t;
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	angband_term[0] = NULL;
+	Term_activate(NULL);
+	term_nuke(&t);
+	return 0;
+}
+
+int test_put_off(void *state) {
+	ui_event ke;
+
+	term_frame_rate = 0;
+	freshes = 0;
+
+	/* Redraws in a row are shown together */
+	Term_putstr(0, 0, -1, COLOUR_WHITE, "one");
+	Term_fresh_later();
+	Term_putstr(0, 1, -1, COLOUR_WHITE, "two");
+	Term_fresh_later();
+	eq(freshes, 0);
+	require(t.fresh_pending);
+
+	/* Looking for a key doesn't show them, but waiting for one does */
+	require(Term_inkey(&ke, false, true));
+	eq(freshes, 0);
+	require(!Term_inkey(&ke, true, true));
+	eq(ke.key.code, 'a');
+	eq(freshes, 1);
+	require(!t.fresh_pending);
+
+	/* Nothing more to show */
+	Term_fresh_pending();
+	eq(freshes, 1);
+	ok;
+}
+
+int test_delay(void *state) {
+	term_frame_rate = 0;
+	freshes = delays = 0;
+
+	Term_putstr(0, 2, -1, COLOUR_WHITE, "three");
+	Term_fresh_later();
+	eq(freshes, 0);
+	Term_xtra(TERM_XTRA_DELAY, 10);
+	eq(freshes, 1);
+	eq(delays, 1);
+	ok;
+}
+
+int test_frame_rate(void *state) {
+	term_frame_rate = 1;
+	Term_fresh_pending();
+	freshes = 0;
+
+	/* Within a frame nothing is shown... */
+	Term_putstr(0, 3, -1, COLOUR_WHITE, "four");
+	Term_fresh_later();
+	eq(freshes, 0);
+
+	/* ...and every refresh is shown with no limit */
+	term_frame_rate = 1000000;
+	Term_putstr(0, 4, -1, COLOUR_WHITE, "five");
+	Term_fresh_later();
+	eq(freshes, 1);
+	ok;
+}
+
+const char *suite_name = "ui-term/term";
+struct test tests[] = {
+	{ "put off", test_put_off },
+	{ "delay", test_delay },
+	{ "frame rate", test_frame_rate },
+	{ NULL, NULL }
+};
@@ -0,0 +1,116 @@
+/* z-bitflag/bench.c */
+
+#include "unit-test.h"
+#include "z-bitflag.h"
+#include "z-rand.h"
+#include <time.h>
+
+NOSETUP
+NOTEARDOWN
+
+#define BENCH_SETS 1000
+#define BENCH_ROUNDS 2000
+
+/* The size of the object flag sets, and of the monster race ones */
+#define SMALL_SIZE 5
+#define LARGE_SIZE 14
+
+static bitflag sets[BENCH_SETS][LARGE_SIZE];
+
+static void fill_sets(size_t size, int density)
+{
+	int i, f;
+
+	Rand_init();
+	for (i = 0; i < BENCH_SETS; i++) {
+		flag_wipe(sets[i], size);
+		for (f = FLAG_START; f < FLAG_MAX(size); f++)
+			if (randint0(100) < density) flag_on(sets[i], size, f);
+	}
+}
+
+/**
+ * Time counting and walking through the flags of sparse sets, as the object
+ * and monster code does all the time
+ */
+static double bench_iterate(size_t size, long *total)
+{
+	clock_t start = clock();
+	int r, i, f;
+
+	*total = 0;
+	for (r = 0; r < BENCH_ROUNDS; r++) {
+		for (i = 0; i < BENCH_SETS; i++) {
+			*total += flag_count(sets[i], size);
+			for (f = flag_next(sets[i], size, FLAG_START); f != FLAG_END;
+				 f = flag_next(sets[i], size, f + 1))
+				*total += f;
+		}
+	}
+
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/**
+ * Time combining and comparing sets
+ */
+static double bench_combine(size_t size, long *total)
+{
+	bitflag acc[LARGE_SIZE];
+	clock_t start = clock();
+	int r, i;
+
+	*total = 0;
+	for (r = 0; r < BENCH_ROUNDS; r++) {
+		flag_wipe(acc, size);
+		for (i = 0; i < BENCH_SETS; i++) {
+			if (flag_is_inter(acc, sets[i], size)) (*total)++;
+			if (!flag_is_subset(acc, sets[i], size))
+				flag_union(acc, sets[i], size);
+			else
+				flag_diff(acc, sets[(i + 1) % BENCH_SETS], size);
+		}
+	}
+
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int test_iterate(void *state) {
+	long total;
+	double secs;
+
+	fill_sets(SMALL_SIZE, 10);
+	secs = bench_iterate(SMALL_SIZE, &total);
+	require(total > 0);
+	if (verbose)
+		printf("  %d %d-byte sets counted and walked in %.3fs\n",
+			   BENCH_SETS * BENCH_ROUNDS, SMALL_SIZE, secs);
+
+	fill_sets(LARGE_SIZE, 10);
+	secs = bench_iterate(LARGE_SIZE, &total);
+	require(total > 0);
+	if (verbose)
+		printf("  %d %d-byte sets counted and walked in %.3fs\n",
+			   BENCH_SETS * BENCH_ROUNDS, LARGE_SIZE, secs);
+	ok;
+}
+
+int test_combine(void *state) {
+	long total;
+	double secs;
+
+	fill_sets(LARGE_SIZE, 20);
+	secs = bench_combine(LARGE_SIZE, &total);
+	require(total > 0);
+	if (verbose)
+		printf("  %d %d-byte sets combined in %.3fs\n",
+			   BENCH_SETS * BENCH_ROUNDS, LARGE_SIZE, secs);
+	ok;
+}
+
+const char *suite_name = "z-bitflag/bench";
+struct test tests[] = {
+	{ "iterate", test_iterate },
+	{ "combine", test_combine },
+	{ NULL, NULL }
+};
@@ -0,0 +1,168 @@
+/* z-bitflag/bitflag.c */
+
+#include "unit-test.h"
+#include "z-bitflag.h"
+#include "z-rand.h"
+
+NOSETUP
+NOTEARDOWN
+
+/* Sizes either side of a word, and a few words with some left over */
+static const size_t sizes[] = { 1, 3, 7, 8, 9, 16, 20, 33 };
+#define MAX_SIZE 33
+
+/**
+ * Fill a set with random flags; 'density' in 0..100 is the chance of each
+ */
+static void fill(bitflag *f, size_t size, int density)
+{
+	int i;
+
+	flag_wipe(f, size);
+	for (i = FLAG_START; i < FLAG_MAX(size); i++)
+		if (randint0(100) < density) flag_on(f, size, i);
+}
+
+/**
+ * Naive versions, one flag at a time, to check against
+ */
+static int slow_count(const bitflag *f, size_t size)
+{
+	int i, n = 0;
+
+	for (i = FLAG_START; i < FLAG_MAX(size); i++)
+		if (flag_has(f, size, i)) n++;
+	return n;
+}
+
+static int slow_next(const bitflag *f, size_t size, int flag)
+{
+	int i;
+
+	for (i = flag; i < FLAG_MAX(size); i++)
+		if (flag_has(f, size, i)) return i;
+	return FLAG_END;
+}
+
+int test_single(void *state) {
+	bitflag f[2];
+
+	flag_wipe(f, 2);
+	require(flag_on(f, 2, 1));
+	require(!flag_on(f, 2, 1));
+	require(flag_on(f, 2, 16));
+	require(flag_has(f, 2, 1) && flag_has(f, 2, 16));
+	require(!flag_has(f, 2, 2) && !flag_has(f, 2, FLAG_END));
+	eq(f[0], 1);
+	eq(f[1], 0x80);
+	require(flag_off(f, 2, 16));
+	require(!flag_off(f, 2, 16));
+	eq(f[1], 0);
+	ok;
+}
+
+int test_count_next(void *state) {
+	bitflag f[MAX_SIZE];
+	size_t s;
+	int density, i;
+
+	Rand_init();
+	for (s = 0; s < N_ELEMENTS(sizes); s++) {
+		size_t size = sizes[s];
+
+		for (density = 0; density <= 100; density += 5) {
+			fill(f, size, density);
+			eq(flag_count(f, size), slow_count(f, size));
+			eq(flag_next(f, size, FLAG_END), slow_next(f, size, FLAG_START));
+			for (i = FLAG_START; i <= FLAG_MAX(size); i++)
+				eq(flag_next(f, size, i), slow_next(f, size, i));
+			eq(flag_is_empty(f, size), slow_count(f, size) == 0);
+			eq(flag_is_full(f, size),
+			   slow_count(f, size) == (int) (size * FLAG_WIDTH));
+		}
+	}
+	ok;
+}
+
+int test_sets(void *state) {
+	bitflag a[MAX_SIZE], b[MAX_SIZE], c[MAX_SIZE];
+	size_t s;
+	int n, i;
+
+	Rand_init();
+	for (s = 0; s < N_ELEMENTS(sizes); s++) {
+		size_t size = sizes[s];
+
+		for (n = 0; n < 50; n++) {
+			bool inter = false, subset = true, changed;
+
+			fill(a, size, randint0(101));
+			fill(b, size, randint0(101));
+			if (n % 10 == 0) flag_copy(b, a, size);
+			for (i = FLAG_START; i < FLAG_MAX(size); i++) {
+				if (flag_has(a, size, i) && flag_has(b, size, i)) inter = true;
+				if (!flag_has(a, size, i) && flag_has(b, size, i))
+					subset = false;
+			}
+			eq(flag_is_inter(a, b, size), inter);
+			eq(flag_is_subset(a, b, size), subset);
+
+			/* Union */
+			flag_copy(c, a, size);
+			changed = flag_union(c, b, size);
+			eq(changed, !subset);
+			for (i = FLAG_START; i < FLAG_MAX(size); i++)
+				eq(flag_has(c, size, i),
+				   flag_has(a, size, i) || flag_has(b, size, i));
+
+			/* Intersection */
+			flag_copy(c, a, size);
+			changed = flag_inter(c, b, size);
+			eq(changed, !flag_is_equal(a, b, size));
+			for (i = FLAG_START; i < FLAG_MAX(size); i++)
+				eq(flag_has(c, size, i),
+				   flag_has(a, size, i) && flag_has(b, size, i));
+
+			/* Difference */
+			flag_copy(c, a, size);
+			changed = flag_diff(c, b, size);
+			eq(changed, inter);
+			for (i = FLAG_START; i < FLAG_MAX(size); i++)
+				eq(flag_has(c, size, i),
+				   flag_has(a, size, i) && !flag_has(b, size, i));
+
+			/* Negation */
+			flag_copy(c, a, size);
+			flag_negate(c, size);
+			for (i = FLAG_START; i < FLAG_MAX(size); i++)
+				eq(flag_has(c, size, i), !flag_has(a, size, i));
+		}
+	}
+	ok;
+}
+
+int test_mask(void *state) {
+	bitflag f[MAX_SIZE], big[100];
+
+	flag_setall(f, 3);
+	require(flags_mask(f, 3, 2, 24, FLAG_END));
+	eq(flag_count(f, 3), 2);
+	require(flag_has(f, 3, 2) && flag_has(f, 3, 24));
+	require(!flags_mask(f, 3, 2, 24, FLAG_END));
+
+	/* Sets too big for the mask on the stack */
+	flag_setall(big, 100);
+	require(flags_mask(big, 100, 800, FLAG_END));
+	eq(flag_count(big, 100), 1);
+	eq(flag_next(big, 100, FLAG_START), 800);
+	ok;
+}
+
+const char *suite_name = "z-bitflag/bitflag";
+struct test tests[] = {
+	{ "single", test_single },
+	{ "count-next", test_count_next },
+	{ "sets", test_sets },
+	{ "mask", test_mask },
+	{ NULL, NULL }
+};
@@ -0,0 +1,2 @@
+TESTPROGS += z-bitflag/bitflag \
+	z-bitflag/bench
@@ -0,0 +1,79 @@
+/* z-names/names.c */
+
+#include "unit-test.h"
+#include "z-names.h"
+#include "z-form.h"
+
+NOSETUP
+NOTEARDOWN
+
+int test_find(void *state) {
+	struct name_map *map = name_map_new(0);
+
+	name_map_add(map, "Grip, Farmer Maggot's Dog", 1);
+	name_map_add(map, "Fang, Farmer Maggot's Dog", 2);
+
+	eq(name_map_find(map, "Grip, Farmer Maggot's Dog"), 1);
+	eq(name_map_find(map, "fang, farmer maggot's dog"), 2);
+	eq(name_map_find(map, "Fang"), -1);
+	eq(name_map_find(map, ""), -1);
+	name_map_free(map);
+	ok;
+}
+
+int test_first_wins(void *state) {
+	struct name_map *map = name_map_new(0);
+
+	name_map_add(map, "Robe", 3);
+	name_map_add(map, "ROBE", 4);
+	eq(name_map_find(map, "robe"), 3);
+	eq(name_map_count(map), 1);
+	name_map_free(map);
+	ok;
+}
+
+int test_grow(void *state) {
+	struct name_map *map = name_map_new(4);
+	int i;
+
+	for (i = 0; i < 5000; i++)
+		name_map_add(map, format("name %d", i), i);
+	eq(name_map_count(map), 5000);
+	for (i = 0; i < 5000; i++)
+		eq(name_map_find(map, format("NAME %d", i)), i);
+	name_map_free(map);
+	ok;
+}
+
+int test_set_remove(void *state) {
+	struct name_map *map = name_map_new(0);
+	int i;
+
+	name_map_set(map, "Level 1", 1);
+	name_map_set(map, "level 1", 2);
+	eq(name_map_find(map, "Level 1"), 2);
+	require(name_map_remove(map, "LEVEL 1"));
+	require(!name_map_remove(map, "Level 1"));
+	eq(name_map_find(map, "Level 1"), -1);
+	eq(name_map_count(map), 0);
+
+	/* Names further along a probe run can still be found after removals */
+	for (i = 0; i < 1000; i++)
+		name_map_add(map, format("Level %d", i), i);
+	for (i = 0; i < 1000; i += 3)
+		require(name_map_remove(map, format("Level %d", i)));
+	for (i = 0; i < 1000; i++)
+		eq(name_map_find(map, format("Level %d", i)), (i % 3) ? i : -1);
+	eq(name_map_count(map), 666);
+	name_map_free(map);
+	ok;
+}
+
+const char *suite_name = "z-names/names";
+struct test tests[] = {
+	{ "find", test_find },
+	{ "first-wins", test_first_wins },
+	{ "grow", test_grow },
+	{ "set-remove", test_set_remove },
+	{ NULL, NULL }
+};
@@ -0,0 +1,95 @@
+/* z-pool/pool.c */
+
+#include "unit-test.h"
+#include "z-pool.h"
+#include "z-util.h"
+
+NOSETUP
+NOTEARDOWN
+
+static void find_stats(const struct mem_stats *stats, void *data)
+{
+	struct mem_stats *found = data;
+
+	if (streq(stats->name, found->name))
+		*found = *stats;
+}
+
+int test_pool_reuse(void *state) {
+	struct mem_pool *pool = mem_pool_new("test pool", 24, 4);
+	struct mem_stats stats = { "test pool" };
+	char *a = mem_pool_alloc(pool);
+	char *b = mem_pool_alloc(pool);
+	int i;
+
+	require(a && b && a != b);
+	for (i = 0; i < 24; i++)
+		a[i] = 'x';
+
+	/* The freed block comes back, zeroed */
+	mem_pool_free(pool, a);
+	b = mem_pool_alloc(pool);
+	ptreq(b, a);
+	for (i = 0; i < 24; i++)
+		eq(b[i], 0);
+
+	mem_stats_visit(find_stats, &stats);
+	eq(stats.count, 2);
+	eq(stats.peak, 2);
+	eq(stats.total, 3);
+	mem_pool_destroy(pool);
+	ok;
+}
+
+int test_pool_slabs(void *state) {
+	struct mem_pool *pool = mem_pool_new("test slabs", 8, 16);
+	struct mem_stats stats = { "test slabs" };
+	void *blocks[100];
+	int i, j;
+
+	for (i = 0; i < 100; i++) {
+		blocks[i] = mem_pool_alloc(pool);
+		for (j = 0; j < i; j++)
+			require(blocks[j] != blocks[i]);
+	}
+	for (i = 0; i < 100; i += 2)
+		mem_pool_free(pool, blocks[i]);
+
+	mem_stats_visit(find_stats, &stats);
+	eq(stats.count, 50);
+	eq(stats.peak, 100);
+	eq(stats.used, 50 * stats.size);
+	mem_pool_destroy(pool);
+	ok;
+}
+
+int test_arena(void *state) {
+	struct mem_arena *arena = mem_arena_new("test arena", 64);
+	struct mem_stats stats = { "test arena" };
+	char *small = mem_arena_alloc(arena, 10);
+	char *big = mem_arena_alloc(arena, 1000);
+	char *after = mem_arena_alloc(arena, 10);
+	int i;
+
+	require(small && big && after);
+	null(mem_arena_alloc(arena, 0));
+
+	/* A big block doesn't waste the rest of the current one */
+	require(after > small && after < small + 64);
+	for (i = 0; i < 1000; i++)
+		eq(big[i], 0);
+
+	mem_stats_visit(find_stats, &stats);
+	eq(stats.count, 3);
+	require(stats.reserved >= 1064);
+	mem_arena_destroy(arena);
+	ok;
+}
+
+const char *suite_name = "z-pool/pool";
+struct test tests[] = {
+	{ "pool-reuse", test_pool_reuse },
+	{ "pool-slabs", test_pool_slabs },
+	{ "arena", test_arena },
+	{ NULL, NULL }
+};
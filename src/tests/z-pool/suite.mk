@@ -0,0 +1 @@
+TESTPROGS += z-pool/pool
@@ -0,0 +1,74 @@
+/* z-quark/bench.c */
+
+#include "unit-test.h"
+#include "z-form.h"
+#include "z-quark.h"
+#include "z-util.h"
+#include <time.h>
+
+#define BENCH_QUARKS 20000
+
+int setup_tests(void **state) {
+	quarks_init();
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	quarks_free();
+	return 0;
+}
+
+/**
+ * Time interning many distinct strings and then looking them all up again;
+ * with a linear scan this is quadratic in the number of quarks.
+ */
+static double bench_quarks(quark_t *qs, bool reserve) {
+	char buf[32];
+	clock_t start = clock();
+	int i;
+
+	if (reserve) quarks_reserve(BENCH_QUARKS);
+	for (i = 0; i < BENCH_QUARKS; i++) {
+		strnfmt(buf, sizeof(buf), "%s-%d", reserve ? "r" : "q", i);
+		qs[i] = quark_add(buf);
+	}
+	for (i = 0; i < BENCH_QUARKS; i++) {
+		strnfmt(buf, sizeof(buf), "%s-%d", reserve ? "r" : "q", i);
+		if (quark_add(buf) != qs[i]) return -1.0;
+	}
+
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int test_add_lookup(void *state) {
+	static quark_t qs[BENCH_QUARKS];
+	double secs = bench_quarks(qs, false);
+	int i;
+
+	require(secs >= 0.0);
+	for (i = 0; i < BENCH_QUARKS; i++)
+		require(quark_str(qs[i]) != NULL);
+	require(!strcmp(quark_str(qs[BENCH_QUARKS - 1]), "q-19999"));
+	if (verbose)
+		printf("  %d quarks added and found in %.3fs\n", BENCH_QUARKS, secs);
+	ok;
+}
+
+int test_reserve(void *state) {
+	static quark_t qs[BENCH_QUARKS];
+	double secs = bench_quarks(qs, true);
+
+	require(secs >= 0.0);
+	require(!strcmp(quark_str(qs[0]), "r-0"));
+	if (verbose)
+		printf("  %d quarks added and found in %.3fs after reserving\n",
+			   BENCH_QUARKS, secs);
+	ok;
+}
+
+const char *suite_name = "z-quark/bench";
+struct test tests[] = {
+	{ "add-lookup", test_add_lookup },
+	{ "reserve", test_reserve },
+	{ NULL, NULL }
+};
@@ -1 +1,2 @@
-TESTPROGS += z-quark/quark
+TESTPROGS += z-quark/quark \
+	z-quark/bench
@@ -19,6 +19,7 @@
 #include "angband.h"
 #include "cave.h"
 #include "effects.h"
+#include "generate.h"
 #include "init.h"
 #include "mon-util.h"
 #include "obj-knowledge.h"
@@ -26,9 +27,16 @@
 #include "player-timed.h"
 #include "player-util.h"
 #include "trap.h"
+#include "z-pool.h"
 
 struct trap_kind *trap_info;
 
+/**
+ * Traps, locks and runes are made for every level generated, and copied
+ * whenever the player notices them, so they come from a pool
+ */
+static struct mem_pool *trap_pool;
+
 /**
  * Find a trap kind based on its short description
  */
@@ -135,7 +143,7 @@ static bool square_verify_trap(struct chunk *c, struct loc grid, int vis)
     /* No traps in this location. */
     if (!trap_exists) {
 		/* No traps */
-		sqinfo_off(square(c, grid).info, SQUARE_TRAP);
+		sqinfo_off(square_info(c, grid), SQUARE_TRAP);
 
 		/* Take note */
 		square_note_spot(c, grid);
@@ -170,6 +178,7 @@ bool square_player_trap_allowed(struct chunk *c, struct loc grid)
  */
 static int pick_trap(struct chunk *c, int feat, int trap_level)
 {
+	struct player *p = gen_player(c);
     int i, pick;
 	int *trap_probs = NULL;
 	int trap_prob_max = 0;
@@ -204,14 +213,14 @@ static int pick_trap(struct chunk *c, int feat, int trap_level)
 		/* Check legality of trapdoors. */
 		if (trf_has(kind->flags, TRF_DOWN)) {
 			/* No trap doors on quest levels */
-			if (is_quest(player->depth)) continue;
+			if (is_quest(p, p->depth)) continue;
 
 			/* No trap doors on the deepest level */
-			if (player->depth >= z_info->max_depth - 1)
+			if (p->depth >= z_info->max_depth - 1)
 				continue;
 
 			/* No trap doors with persistent levels (for now) */
-			if (OPT(player, birth_levels_persist))
+			if (OPT(p, birth_levels_persist))
 				continue;
 	    }
 
@@ -240,6 +249,33 @@ static int pick_trap(struct chunk *c, int feat, int trap_level)
     return i < z_info->trap_max ? i : -1;
 }
 
+/**
+ * Allocate a new, blank trap
+ */
+struct trap *trap_new(void)
+{
+	if (!trap_pool)
+		trap_pool = mem_pool_new("traps", sizeof(struct trap), 256);
+	return mem_pool_alloc(trap_pool);
+}
+
+/**
+ * Free a single trap; its list is not touched
+ */
+void trap_free(struct trap *trap)
+{
+	mem_pool_free(trap_pool, trap);
+}
+
+/**
+ * Release the memory of the trap pool, once every trap has been freed
+ */
+void trap_pool_destroy(void)
+{
+	mem_pool_destroy(trap_pool);
+	trap_pool = NULL;
+}
+
 /**
  * Make a new trap of the given type.  Return true if successful.
  *
@@ -258,14 +294,14 @@ void place_trap(struct chunk *c, struct loc grid, int t_idx, int trap_level)
 		/* Require the correct terrain */
 		if (!square_player_trap_allowed(c, grid)) return;
 
-		t_idx = pick_trap(c, square(c, grid).feat, trap_level);
+		t_idx = pick_trap(c, square_fidx(c, grid), trap_level);
     }
 
     /* Failure */
     if (t_idx < 0) return;
 
 	/* Allocate a new trap for this grid (at the front of the list) */
-	new_trap = mem_zalloc(sizeof(*new_trap));
+	new_trap = trap_new();
 	new_trap->next = square_trap(c, grid);
 	square_set_trap(c, grid, new_trap);
 
@@ -277,7 +313,7 @@ void place_trap(struct chunk *c, struct loc grid, int t_idx, int trap_level)
 	trf_copy(new_trap->flags, trap_info[t_idx].flags);
 
 	/* Toggle on the trap marker */
-	sqinfo_on(square(c, grid).info, SQUARE_TRAP);
+	sqinfo_on(square_info(c, grid), SQUARE_TRAP);
 
 	/* Redraw the grid */
 	square_note_spot(c, grid);
@@ -293,7 +329,7 @@ void square_free_trap(struct chunk *c, struct loc grid)
 
 	while (trap) {
 		next = trap->next;
-		mem_free(trap);
+		trap_free(trap);
 		trap = next;
 	}
 }
@@ -363,7 +399,7 @@ bool square_reveal_trap(struct chunk *c, struct loc grid, bool always,
  */
 void square_memorize_traps(struct chunk *c, struct loc grid)
 {
-	struct trap *trap = square(c, grid).trap;
+	struct trap *trap = square_trap(c, grid);
 	struct trap *current = NULL;
 	if (c != cave) return;
 
@@ -375,12 +411,12 @@ void square_memorize_traps(struct chunk *c, struct loc grid)
 		if (square_isvisibletrap(c, grid)) {
 			struct trap *next;
 			if (current) {
-				next = mem_zalloc(sizeof(*next));
+				next = trap_new();
 				current->next = next;
 				current = next;
 			} else {
-				current = mem_zalloc(sizeof(*current));
-				player->cave->squares[grid.y][grid.x].trap = current;
+				current = trap_new();
+				player->cave->squares.trap[square_idx(player->cave, grid)] = current;
 			}
 			memcpy(current, trap, sizeof(*trap));
 			current->next = NULL;
@@ -510,13 +546,13 @@ extern void hit_trap(struct loc grid, int delayed)
  */
 bool square_remove_all_traps(struct chunk *c, struct loc grid)
 {
-	struct trap *trap = square(c, grid).trap;
+	struct trap *trap = square_trap(c, grid);
 	bool were_there_traps = trap == NULL ? false : true;
 
 	assert(square_in_bounds(c, grid));
 	while (trap) {
 		struct trap *next_trap = trap->next;
-		mem_free(trap);
+		trap_free(trap);
 		trap = next_trap;
 	}
 
@@ -543,14 +579,14 @@ bool square_remove_trap(struct chunk *c, struct loc grid, int t_idx_remove)
 
 	/* Look at the traps in this grid */
 	struct trap *prev_trap = NULL;
-	struct trap *trap = square(c, grid).trap;
+	struct trap *trap = square_trap(c, grid);
 
 	assert(square_in_bounds(c, grid));
 	while (trap) {
 		struct trap *next_trap = trap->next;
 
 		if (t_idx_remove == trap->t_idx) {
-			mem_free(trap);
+			trap_free(trap);
 			removed = true;
 
 			if (prev_trap) {
@@ -588,7 +624,7 @@ bool square_set_trap_timeout(struct chunk *c, struct loc grid, bool domsg,
 	assert(square_in_bounds(c, grid));
 
 	/* Look at the traps in this grid */
-	current_trap = square(c, grid).trap;
+	current_trap = square_trap(c, grid);
 	while (current_trap) {
 		/* Get the next trap (may be NULL) */
 		struct trap *next_trap = current_trap->next;
@@ -627,7 +663,7 @@ bool square_set_trap_timeout(struct chunk *c, struct loc grid, bool domsg,
  */
 int square_trap_timeout(struct chunk *c, struct loc grid, int t_idx)
 {
-	struct trap *current_trap = square(c, grid).trap;
+	struct trap *current_trap = square_trap(c, grid);
 	while (current_trap) {
 		/* Get the next trap (may be NULL) */
 		struct trap *next_trap = current_trap->next;
@@ -102,6 +102,9 @@ void square_memorize_traps(struct chunk *c, struct loc grid);
 bool trap_check_hit(int power);
 void hit_trap(struct loc grid, int delayed);
 bool square_player_trap_allowed(struct chunk *c, struct loc grid);
+struct trap *trap_new(void);
+void trap_free(struct trap *trap);
+void trap_pool_destroy(void);
 void place_trap(struct chunk *c, struct loc grid, int t_idx, int trap_level);
 void square_free_trap(struct chunk *c, struct loc grid);
 void wipe_trap_list(struct chunk *c);
@@ -995,59 +995,20 @@ static void trace_map_updates(game_event_type type, game_event_data *data,
 #endif
 
 /**
- * Update either a single map grid or a whole map
+ * Update either a single map grid or a whole map, on the main screen and
+ * every map subwindow
  */
 static void update_maps(game_event_type type, game_event_data *data, void *user)
 {
 	term *t = user;
 
 	/* This signals a whole-map redraw. */
-	if (data->point.x == -1 && data->point.y == -1)
+	if (data->point.x == -1 && data->point.y == -1) {
+		map_mark_all();
 		prt_map();
-
-	/* Single point to be redrawn */
-	else {
-		struct grid_data g;
-		int a, ta;
-		wchar_t c, tc;
-
-		int ky, kx;
-		int vy, vx;
-
-		/* Location relative to panel */
-		ky = data->point.y - t->offset_y;
-		kx = data->point.x - t->offset_x;
-
-		if (t == angband_term[0]) {
-			/* Verify location */
-			if ((ky < 0) || (ky >= SCREEN_HGT)) return;
-			if ((kx < 0) || (kx >= SCREEN_WID)) return;
-
-			/* Location in window */
-			vy = tile_height * ky + ROW_MAP;
-			vx = tile_width * kx + COL_MAP;
-		} else {
-			/* Verify location */
-			if ((ky < 0) || (ky >= t->hgt / tile_height)) return;
-			if ((kx < 0) || (kx >= t->wid / tile_width)) return;
-
-			/* Location in window */
-			vy = tile_height * ky;
-			vx = tile_width * kx;
-		}
-
-
-		/* Redraw the grid spot */
-		map_info(data->point, &g);
-		grid_data_as_text(&g, &a, &c, &ta, &tc);
-		Term_queue_char(t, vx, vy, a, c, ta, tc);
-#ifdef MAP_DEBUG
-		/* Plot 'spot' updates in light green to make them visible */
-		Term_queue_char(t, vx, vy, COLOUR_L_GREEN, c, ta, tc);
-#endif
-
-		if ((tile_width > 1) || (tile_height > 1))
-			Term_big_queue_char(t, vx, vy, a, c, COLOUR_WHITE, ' ');
+	} else {
+		/* Single point to be redrawn */
+		prt_map_grid(data->point);
 	}
 
 	/* Refresh the main screen unless the map needs to center */
@@ -1061,7 +1022,7 @@ static void update_maps(game_event_type type, game_event_data *data, void *user)
 			return;
 	}
 
-	Term_fresh();
+	Term_fresh_later();
 }
 
 /**
@@ -1413,7 +1374,7 @@ static void update_inven_subwindow(game_event_type type, game_event_data *data,
 	else
 		show_equip(OLIST_WINDOW | OLIST_WEIGHT, NULL);
 
-	Term_fresh();
+	Term_fresh_later();
 	
 	/* Restore */
 	Term_activate(old);
@@ -1433,7 +1394,7 @@ static void update_equip_subwindow(game_event_type type, game_event_data *data,
 	else
 		show_inven(OLIST_WINDOW | OLIST_WEIGHT | OLIST_QUIVER, NULL);
 
-	Term_fresh();
+	Term_fresh_later();
 	
 	/* Restore */
 	Term_activate(old);
@@ -1485,7 +1446,7 @@ static void update_itemlist_subwindow(game_event_type type,
 
     clear_from(0);
     object_list_show_subwindow(Term->hgt, Term->wid);
-	Term_fresh();
+	Term_fresh_later();
 	
 	/* Restore */
 	Term_activate(old);
@@ -1502,7 +1463,7 @@ static void update_monlist_subwindow(game_event_type type,
 
 	clear_from(0);
 	monster_list_show_subwindow(Term->hgt, Term->wid);
-	Term_fresh();
+	Term_fresh_later();
 	
 	/* Restore */
 	Term_activate(old);
@@ -1523,7 +1484,7 @@ static void update_monster_subwindow(game_event_type type,
 		lore_show_subwindow(player->upkeep->monster_race, 
 							get_lore(player->upkeep->monster_race));
 
-	Term_fresh();
+	Term_fresh_later();
 	
 	/* Restore */
 	Term_activate(old);
@@ -1543,7 +1504,7 @@ static void update_object_subwindow(game_event_type type,
 		display_object_recall(player->upkeep->object);
 	else if (player->upkeep->object_kind)
 		display_object_kind_recall(player->upkeep->object_kind);
-	Term_fresh();
+	Term_fresh_later();
 	
 	/* Restore */
 	Term_activate(old);
@@ -1591,7 +1552,7 @@ static void update_messages_subwindow(game_event_type type,
 		Term_erase(x, y, 255);
 	}
 
-	Term_fresh();
+	Term_fresh_later();
 	
 	/* Restore */
 	Term_activate(old);
@@ -1623,7 +1584,7 @@ static void update_minimap_subwindow(game_event_type type,
 
 		/* Redraw map */
 		display_map(NULL, NULL);
-		Term_fresh();
+		Term_fresh_later();
 
 		/* Restore */
 		Term_activate(old);
@@ -1660,7 +1621,7 @@ static void update_player0_subwindow(game_event_type type,
 	/* Display flags */
 	display_player(0);
 
-	Term_fresh();
+	Term_fresh_later();
 	
 	/* Restore */
 	Term_activate(old);
@@ -1681,7 +1642,7 @@ static void update_player1_subwindow(game_event_type type,
 	/* Display flags */
 	display_player(1);
 
-	Term_fresh();
+	Term_fresh_later();
 	
 	/* Restore */
 	Term_activate(old);
@@ -1739,7 +1700,7 @@ static void update_player_compact_subwindow(game_event_type type,
 	/* Monster health */
 	prt_health(row++, col);
 
-	Term_fresh();
+	Term_fresh_later();
 	
 	/* Restore */
 	Term_activate(old);
@@ -1755,7 +1716,7 @@ static void flush_subwindow(game_event_type type, game_event_data *data,
 	/* Activate */
 	Term_activate(t);
 
-	Term_fresh();
+	Term_fresh_later();
 	
 	/* Restore */
 	Term_activate(old);
@@ -1893,10 +1854,7 @@ static void subwindow_flag_changed(int win_idx, u32b flag, bool new_state)
 
 		case PW_OVERHEAD:
 		{
-			register_or_deregister(EVENT_MAP,
-					       update_maps,
-					       angband_term[win_idx]);
-
+			/* The main screen's update_maps() draws this too */
 			register_or_deregister(EVENT_END,
 					       flush_subwindow,
 					       angband_term[win_idx]);
@@ -2097,7 +2055,8 @@ static void refresh(game_event_type type, game_event_data *data, void *user)
 		move_cursor_relative(target.y, target.x);
 	}
 
-	Term_fresh();
+	/* Shown when the game next waits, or when the next frame is due */
+	Term_fresh_later();
 }
 
 static void repeated_command_display(game_event_type type,
@@ -2416,6 +2375,7 @@ static void ui_leave_world(game_event_type type, game_event_data *data,
 #ifdef MAP_DEBUG
 	event_remove_handler(EVENT_MAP, trace_map_updates, angband_term[0]);
 #endif
+	map_cache_free();
 
 	/* Check if the panel should shift when the player's moved */
 	event_remove_handler(EVENT_PLAYERMOVED, check_panel, NULL);
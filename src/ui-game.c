@@ -23,6 +23,7 @@
 #include "game-world.h"
 #include "grafmode.h"
 #include "init.h"
+#include "journal.h"
 #include "mon-lore.h"
 #include "mon-make.h"
 #include "obj-util.h"
@@ -431,6 +432,13 @@ void play_game(bool new_game)
 	/* Load a savefile or birth a character, or both */
 	start_game(new_game);
 
+	/* Record the session from a fresh save if asked */
+	if (journal_file) {
+		save_game();
+		if (!journal_record_start(journal_file, savefile))
+			msg("Could not start the journal %s.", journal_file);
+	}
+
 	/* Get commands from the user, then process the game world until the
 	 * command queue is empty and a new player command is needed */
 	while (!player->is_dead && player->upkeep->playing) {
@@ -439,6 +447,9 @@ void play_game(bool new_game)
 		run_game_loop();
 	}
 
+	/* Finish the journal */
+	journal_stop();
+
 	/* Close game on death or quitting */
 	close_game();
 
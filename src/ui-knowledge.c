@@ -2840,19 +2840,10 @@ void do_cmd_messages(void)
 
 		/* Find the next item */
 		if (ke.key.code == '-' && shower[0]) {
-			s16b z;
+			int z = message_search(shower, i + 1);
 
-			/* Scan messages */
-			for (z = i + 1; z < n; z++) {
-				/* Search for it */
-				if (my_stristr(message_str(z), shower)) {
-					/* New location */
-					i = z;
-
-					/* Done */
-					break;
-				}
-			}
+			/* New location */
+			if (z >= 0) i = z;
 		}
 	}
 
@@ -521,11 +521,167 @@ void print_rel(wchar_t c, byte a, int y, int x)
 }
 
 
+/**
+ * ------------------------------------------------------------------------
+ * The map cache
+ *
+ * How each grid of the current level looks is kept between redraws, so
+ * that map_info() and grid_data_as_text() are only called again for grids
+ * which have changed.  The game reports those with EVENT_MAP, which marks
+ * them in a bitmap; a marked grid is worked out again the next time any map
+ * shows it, and the main map, map subwindows and overhead map all share the
+ * result.
+ * ------------------------------------------------------------------------ */
+struct map_cell {
+	int a, ta;				/* As the maps show it */
+	wchar_t c, tc;
+	int lit_a, lit_ta;		/* As display_map() shows it, always lit */
+	wchar_t lit_c, lit_tc;
+	byte priority;			/* Which grid display_map() shows in a block */
+};
+
+static struct map_cache {
+	struct chunk *c;		/* The level cached */
+	int width, height;
+	struct map_cell *cells;
+	bitflag *dirty;			/* Grids to work out again */
+	size_t dirty_size;
+} map_cache;
+
+/**
+ * Forget the cached map
+ */
+void map_cache_free(void)
+{
+	mem_free(map_cache.cells);
+	mem_free(map_cache.dirty);
+	memset(&map_cache, 0, sizeof(map_cache));
+}
+
+/**
+ * Make sure the cache is for the current level, starting again if not
+ */
+static void map_cache_check(void)
+{
+	if (map_cache.c == cave && map_cache.width == cave->width &&
+		map_cache.height == cave->height)
+		return;
+
+	map_cache_free();
+	map_cache.c = cave;
+	map_cache.width = cave->width;
+	map_cache.height = cave->height;
+	map_cache.cells = mem_zalloc(cave->width * cave->height *
+								 sizeof(*map_cache.cells));
+	map_cache.dirty_size = FLAG_SIZE(cave->width * cave->height);
+	map_cache.dirty = mem_zalloc(map_cache.dirty_size * sizeof(bitflag));
+	flag_setall(map_cache.dirty, map_cache.dirty_size);
+}
+
+/**
+ * Note that a grid has changed
+ */
+void map_mark(struct loc grid)
+{
+	map_cache_check();
+	flag_on(map_cache.dirty, map_cache.dirty_size,
+			grid.y * map_cache.width + grid.x + FLAG_START);
+}
+
+/**
+ * Note that any grid may have changed
+ */
+void map_mark_all(void)
+{
+	map_cache_check();
+	flag_setall(map_cache.dirty, map_cache.dirty_size);
+}
+
+/**
+ * How a grid looks, worked out again if it has changed
+ */
+static const struct map_cell *map_cell(struct loc grid)
+{
+	int i = grid.y * map_cache.width + grid.x;
+	struct map_cell *cell = &map_cache.cells[i];
+
+	if (flag_off(map_cache.dirty, map_cache.dirty_size, i + FLAG_START)) {
+		struct grid_data g;
+
+		map_info(grid, &g);
+		grid_data_as_text(&g, &cell->a, &cell->c, &cell->ta, &cell->tc);
+
+		/* Stuff on top of terrain gets higher priority */
+		if ((cell->a != cell->ta) || (cell->c != cell->tc))
+			cell->priority = 20;
+		else
+			cell->priority = f_info[g.f_idx].priority;
+
+		/* Hack - make every grid on the small map lit */
+		g.lighting = LIGHTING_LIT;
+		grid_data_as_text(&g, &cell->lit_a, &cell->lit_c, &cell->lit_ta,
+						  &cell->lit_tc);
+	}
+
+	return cell;
+}
+
+/**
+ * Queue a grid on a map term, if it's on the term's panel; `is_main` is true
+ * for the main screen
+ */
+static void prt_map_cell(term *t, bool is_main, struct loc grid)
+{
+	const struct map_cell *cell;
+	int ky = grid.y - t->offset_y;
+	int kx = grid.x - t->offset_x;
+	int vy, vx;
+
+	if (is_main) {
+		if ((ky < 0) || (ky >= SCREEN_HGT)) return;
+		if ((kx < 0) || (kx >= SCREEN_WID)) return;
+		vy = tile_height * ky + ROW_MAP;
+		vx = tile_width * kx + COL_MAP;
+	} else {
+		if ((ky < 0) || (ky >= t->hgt / tile_height)) return;
+		if ((kx < 0) || (kx >= t->wid / tile_width)) return;
+		vy = tile_height * ky;
+		vx = tile_width * kx;
+	}
+
+	cell = map_cell(grid);
+	Term_queue_char(t, vx, vy, cell->a, cell->c, cell->ta, cell->tc);
+#ifdef MAP_DEBUG
+	/* Plot 'spot' updates in light green to make them visible */
+	Term_queue_char(t, vx, vy, COLOUR_L_GREEN, cell->c, cell->ta, cell->tc);
+#endif
+
+	if ((tile_width > 1) || (tile_height > 1))
+		Term_big_queue_char(t, vx, vy, cell->a, cell->c, COLOUR_WHITE, L' ');
+}
+
+/**
+ * Redraw one grid on the main map and the overhead subwindows; the minimap
+ * subwindows are scaled, and redraw themselves
+ */
+void prt_map_grid(struct loc grid)
+{
+	int j;
+
+	if (!square_in_bounds(cave, grid)) return;
+	map_mark(grid);
+
+	for (j = 0; j < ANGBAND_TERM_MAX; j++) {
+		term *t = angband_term[j];
+		if (!t) continue;
+		if (j && !(window_flag[j] & (PW_OVERHEAD))) continue;
+		prt_map_cell(t, j == 0, grid);
+	}
+}
+
 static void prt_map_aux(void)
 {
-	int a, ta;
-	wchar_t c, tc;
-	struct grid_data g;
+	const struct map_cell *cell;
 
 	int y, x;
 	int vy, vx;
@@ -556,9 +712,9 @@ static void prt_map_aux(void)
 				if (vx + tile_width - 1 >= t->wid) continue;
 
 				/* Determine what is there */
-				map_info(loc(x, y), &g);
-				grid_data_as_text(&g, &a, &c, &ta, &tc);
-				Term_queue_char(t, vx, vy, a, c, ta, tc);
+				cell = map_cell(loc(x, y));
+				Term_queue_char(t, vx, vy, cell->a, cell->c, cell->ta,
+								cell->tc);
 
 				if ((tile_width > 1) || (tile_height > 1))
 					Term_big_queue_char(t, vx, vy, 255, -1, 0, 0);
@@ -572,20 +728,21 @@ static void prt_map_aux(void)
 /**
  * Redraw (on the screen) the current map panel
  *
- * Note the inline use of "light_spot()" for efficiency.
+ * Only grids which have changed since they were last drawn are worked out
+ * again; see "The map cache" above.
  *
  * The main screen will always be at least 24x80 in size.
  */
 void prt_map(void)
 {
-	int a, ta;
-	wchar_t c, tc;
-	struct grid_data g;
+	const struct map_cell *cell;
 
 	int y, x;
 	int vy, vx;
 	int ty, tx;
 
+	map_cache_check();
+
 	/* Redraw map sub-windows */
 	prt_map_aux();
 
@@ -600,14 +757,15 @@ void prt_map(void)
 			if (!square_in_bounds(cave, loc(x, y))) continue;
 
 			/* Determine what is there */
-			map_info(loc(x, y), &g);
-			grid_data_as_text(&g, &a, &c, &ta, &tc);
+			cell = map_cell(loc(x, y));
 
 			/* Hack -- Queue it */
-			Term_queue_char(Term, vx, vy, a, c, ta, tc);
+			Term_queue_char(Term, vx, vy, cell->a, cell->c, cell->ta,
+							cell->tc);
 
 			if ((tile_width > 1) || (tile_height > 1))
-				Term_big_queue_char(Term, vx, vy, a, c, COLOUR_WHITE, L' ');
+				Term_big_queue_char(Term, vx, vy, cell->a, cell->c,
+									COLOUR_WHITE, L' ');
 		}
 }
 
@@ -632,20 +790,15 @@ void display_map(int *cy, int *cx)
 	int row, col;
 
 	int x, y;
-	struct grid_data g;
+	const struct map_cell *cell;
 
-	int a, ta;
-	wchar_t c, tc;
+	int ta;
+	wchar_t tc;
 
-	byte tp;
+	byte *mp;
 
 	struct monster_race *race = &r_info[0];
 
-	/* Priority array */
-	byte **mp = mem_zalloc(cave->height * sizeof(byte*));
-	for (y = 0; y < cave->height; y++)
-		mp[y] = mem_zalloc(cave->width * sizeof(byte));
-
 	/* Desired map height */
 	map_hgt = Term->hgt - 2;
 	map_wid = Term->wid - 2;
@@ -655,18 +808,12 @@ void display_map(int *cy, int *cx)
 	if (map_wid > cave->width) map_wid = cave->width;
 
 	/* Prevent accidents */
-	if ((map_wid < 1) || (map_hgt < 1)) {
-		for (y = 0; y < cave->height; y++)
-			mem_free(mp[y]);
-		mem_free(mp);
-		return;
-	}
+	if ((map_wid < 1) || (map_hgt < 1)) return;
+
+	/* Priority array, one for each grid of the small map */
+	mp = mem_zalloc(map_hgt * map_wid * sizeof(byte));
 
-	/* Nothing here */
-	a = COLOUR_WHITE;
-    c = L' ';
-	ta = COLOUR_WHITE;
-	tc = L' ';
+	map_cache_check();
 
 	/* Draw a box around the edge of the term */
 	window_make(0, 0, map_wid + 1, map_hgt + 1);
@@ -683,28 +830,18 @@ void display_map(int *cy, int *cx)
 				row = row - (row % tile_height);
 
 			/* Get the attr/char at that map location */
-			map_info(loc(x, y), &g);
-			grid_data_as_text(&g, &a, &c, &ta, &tc);
-
-			/* Get the priority of that attr/char */
-			tp = f_info[g.f_idx].priority;
-
-			/* Stuff on top of terrain gets higher priority */
-			if ((a != ta) || (c != tc)) tp = 20;
+			cell = map_cell(loc(x, y));
 
 			/* Save "best" */
-			if (mp[row][col] < tp) {
-				/* Hack - make every grid on the map lit */
-				g.lighting = LIGHTING_LIT;
-				grid_data_as_text(&g, &a, &c, &ta, &tc);
-
-				Term_queue_char(Term, col + 1, row + 1, a, c, ta, tc);
+			if (mp[row * map_wid + col] < cell->priority) {
+				Term_queue_char(Term, col + 1, row + 1, cell->lit_a,
+								cell->lit_c, cell->lit_ta, cell->lit_tc);
 
 				if ((tile_width > 1) || (tile_height > 1))
 					Term_big_queue_char(Term, col + 1, row + 1, 255, -1, 0, 0);
 
 				/* Save priority */
-				mp[row][col] = tp;
+				mp[row * map_wid + col] = cell->priority;
 			}
 		}
 
@@ -733,8 +870,6 @@ void display_map(int *cy, int *cx)
 	if (cy != NULL) (*cy) = row + 1;
 	if (cx != NULL) (*cx) = col + 1;
 
-	for (y = 0; y < cave->height; y++)
-		mem_free(mp[y]);
 	mem_free(mp);
 }
 
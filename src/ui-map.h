@@ -20,6 +20,10 @@ extern void grid_data_as_text(struct grid_data *g, int *ap, wchar_t *cp,
 							  int *tap, wchar_t *tcp);
 extern void move_cursor_relative(int y, int x);
 extern void print_rel(wchar_t c, byte a, int y, int x);
+extern void map_cache_free(void);
+extern void map_mark(struct loc grid);
+extern void map_mark_all(void);
+extern void prt_map_grid(struct loc grid);
 extern void prt_map(void);
 extern void display_map(int *cy, int *cx);
 extern void do_cmd_view_map(void);
@@ -17,11 +17,14 @@
  */
 #include "buildid.h"
 #include "h-basic.h"
+#include "profile.h"
 #include "ui-term.h"
 #include "z-color.h"
 #include "z-util.h"
 #include "z-virt.h"
 
+#include <time.h>
+
 /**
  * This file provides a generic, efficient, terminal window package,
  * which can be used not only on standard terminal environments such
@@ -270,6 +273,12 @@
  */
 term *angband_term[ANGBAND_TERM_MAX];
 
+/**
+ * The most times a second that refreshes put off by Term_fresh_later() are
+ * shown while the game is busy; with 0, they wait until it needs input
+ */
+int term_frame_rate = 30;
+
 
 /**
  * The array[ANGBAND_TERM_MAX] of window names (modifiable?)
@@ -429,6 +438,9 @@ errr Term_xtra(int n, int v)
 	/* Verify the hook */
 	if (!Term->xtra_hook) return (-1);
 
+	/* Show anything put off before pausing */
+	if (n == TERM_XTRA_DELAY && v > 0) Term_fresh_pending();
+
 	/* Call the hook */
 	return ((*Term->xtra_hook)(n, v));
 }
@@ -1143,6 +1155,9 @@ errr Term_fresh(void)
 	term_win *scr = Term->scr;
 
 
+	/* Anything put off is done now */
+	Term->fresh_pending = false;
+
 	/* Do nothing unless "mapped" */
 	if (!Term->mapped_flag) return (1);
 
@@ -1158,6 +1173,7 @@ errr Term_fresh(void)
 		return (1);
 	}
 
+	PROFILE_START(FRESH);
 
 	/* Paranoia -- use "fake" hooks to prevent core dumps */
 	if (!Term->curs_hook) Term->curs_hook = Term_curs_hack;
@@ -1326,12 +1342,83 @@ errr Term_fresh(void)
 	/* Actually flush the output */
 	Term_xtra(TERM_XTRA_FRESH, 0);
 
+	PROFILE_STOP(FRESH);
+
 	/* Success */
 	return (0);
 }
 
 
 
+/**
+ * Read a monotonic clock, in milliseconds; clock() is the time since the
+ * program started on Windows, and processor time elsewhere
+ */
+static u32b term_msecs(void)
+{
+#if defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u32b)ts.tv_sec * 1000 + (u32b)(ts.tv_nsec / 1000000);
+#else
+	return (u32b)((u64b)clock() * 1000 / CLOCKS_PER_SEC);
+#endif
+}
+
+/**
+ * When the last frame was shown, by term_msecs()
+ */
+static u32b frame_shown;
+
+/**
+ * Ask for the active term to be refreshed, but put it off until the game
+ * waits for a keypress or pauses, or until the next frame is due.
+ *
+ * The game redraws and refreshes several times in each game turn; doing it
+ * this way, those all reach the screen together, at most term_frame_rate
+ * times a second.  Term_fresh() still refreshes at once.
+ */
+errr Term_fresh_later(void)
+{
+	/* Do nothing unless "mapped" */
+	if (!Term->mapped_flag) return (1);
+
+	Term->fresh_pending = true;
+
+	/* Keep the screen moving while the game is busy */
+	if (term_frame_rate > 0 &&
+		term_msecs() - frame_shown >= (u32b)(1000 / term_frame_rate))
+		Term_fresh_pending();
+
+	return (0);
+}
+
+/**
+ * Refresh every term which has had a refresh put off
+ */
+void Term_fresh_pending(void)
+{
+	term *old = Term;
+	int i;
+
+	frame_shown = term_msecs();
+
+	/* The active term need not be one of the windows */
+	if (Term && Term->fresh_pending) Term_fresh();
+
+	for (i = 0; i < ANGBAND_TERM_MAX; i++) {
+		term *t = angband_term[i];
+		if (!t || !t->fresh_pending) continue;
+
+		Term_activate(t);
+		Term_fresh();
+	}
+
+	Term_activate(old);
+}
+
+
 /**
  * ------------------------------------------------------------------------
  * Output routines
@@ -2027,6 +2114,10 @@ errr Term_inkey(ui_event *ch, bool wait, bool take)
 		/* Process random events */
 		Term_xtra(TERM_XTRA_BORED, 0);
 
+	/* Show anything put off before waiting */
+	if (wait && Term->key_head == Term->key_tail)
+		Term_fresh_pending();
+
 	/* Wait or not */
 	if (wait)
 		/* Process pending events while necessary */
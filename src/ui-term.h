@@ -216,6 +216,9 @@ struct term
 	/* Number of times saved */
 	byte saved;
 
+	/* A refresh has been put off by Term_fresh_later() */
+	bool fresh_pending;
+
 	void (*init_hook)(term *t);
 	void (*nuke_hook)(term *t);
 
@@ -342,6 +345,7 @@ extern bool smlcurs;
 extern term *angband_term[ANGBAND_TERM_MAX];
 extern char angband_term_name[ANGBAND_TERM_MAX][16];
 extern u32b window_flag[ANGBAND_TERM_MAX];
+extern int term_frame_rate;
 
 /**
  * Hack -- The main "screen"
@@ -362,6 +366,8 @@ extern void Term_big_queue_char(term *t, int x, int y, int a, wchar_t c, int a1,
 extern void Term_queue_chars(int x, int y, int n, int a, const wchar_t *s);
 
 extern errr Term_fresh(void);
+extern errr Term_fresh_later(void);
+extern void Term_fresh_pending(void);
 extern errr Term_set_cursor(bool v);
 extern errr Term_gotoxy(int x, int y);
 extern errr Term_draw(int x, int y, int a, wchar_t c);
@@ -40,6 +40,7 @@
 #include "player-calcs.h"
 #include "player-timed.h"
 #include "player-util.h"
+#include "profile.h"
 #include "project.h"
 #include "target.h"
 #include "trap.h"
@@ -50,9 +51,11 @@
 #include "ui-input.h"
 #include "ui-map.h"
 #include "ui-menu.h"
+#include "ui-output.h"
 #include "ui-prefs.h"
 #include "ui-target.h"
 #include "wizard.h"
+#include "z-pool.h"
 
 
 static void proj_display(struct menu *m, int type, bool cursor,
@@ -540,14 +543,14 @@ static struct object *wiz_create_item_object_from_kind(struct object_kind *kind)
 
 	/* Create the item */
 	if (tval_is_money_k(kind))
-		obj = make_gold(player->depth, kind->name);
+		obj = make_gold(cave, player->depth, kind->name);
 	else {
 		/* Get object */
 		obj = object_new();
 		object_prep(obj, kind, player->depth, RANDOMISE);
 
 		/* Apply magic (no messages, no artifacts) */
-		apply_magic(obj, player->depth, false, false, false, false);
+		apply_magic(cave, obj, player->depth, false, false, false, false);
 	}
 
 	return obj;
@@ -1002,19 +1005,19 @@ static void wiz_reroll_item(struct object *obj)
 			changed = true;
 			object_wipe(new);
 			object_prep(new, obj->kind, player->depth, RANDOMISE);
-			apply_magic(new, player->depth, false, false, false, false);
+			apply_magic(cave, new, player->depth, false, false, false, false);
 		} else if (ch == 'g' || ch == 'G') {
 			/* Apply good magic, but first clear object */
 			changed = true;
 			object_wipe(new);
 			object_prep(new, obj->kind, player->depth, RANDOMISE);
-			apply_magic(new, player->depth, false, true, false, false);
+			apply_magic(cave, new, player->depth, false, true, false, false);
 		} else if (ch == 'e' || ch == 'E') {
 			/* Apply great magic, but first clear object */
 			changed = true;
 			object_wipe(new);
 			object_prep(new, obj->kind, player->depth, RANDOMISE);
-			apply_magic(new, player->depth, false, true, true, false);
+			apply_magic(cave, new, player->depth, false, true, true, false);
 		}
 	}
 
@@ -1686,7 +1689,7 @@ static void do_cmd_wiz_query(void)
 			if (!square_in_bounds_fully(cave, grid)) continue;
 
 			/* Given flag, show only those grids */
-			if (flag && !sqinfo_has(square(cave, grid).info, flag)) continue;
+			if (flag && !sqinfo_has(square_info(cave, grid), flag)) continue;
 
 			/* Given no flag, show known grids */
 			if (!flag && (!square_isknown(cave, grid))) continue;
@@ -1794,7 +1797,7 @@ static void do_cmd_wiz_features(void)
 
 			/* Given feature, show only those grids */
 			for (i = 0; i < length; i++)
-				if (square(cave, grid).feat == feat[i]) show = true;
+				if (square_fidx(cave, grid) == feat[i]) show = true;
 
 			/* Color */
 			if (square_ispassable(cave, grid)) a = COLOUR_YELLOW;
@@ -1838,13 +1841,13 @@ static void wiz_test_kind(int tval)
 
 		/* Create the item */
 		if (tval == TV_GOLD)
-			obj = make_gold(player->depth, kind->name);
+			obj = make_gold(cave, player->depth, kind->name);
 		else {
 			obj = object_new();
 			object_prep(obj, kind, player->depth, RANDOMISE);
 
 			/* Apply magic (no messages, no artifacts) */
-			apply_magic(obj, player->depth, false, false, false, false);
+			apply_magic(cave, obj, player->depth, false, false, false, false);
 
 			/* Mark as cheat, and where created */
 			obj->origin = ORIGIN_CHEAT;
@@ -1862,6 +1865,121 @@ static void wiz_test_kind(int tval)
 	msg("Done.");
 }
 
+/**
+ * Add the statistics for one pool or arena to a textblock
+ */
+static void wiz_memory_line(const struct mem_stats *stats, void *data)
+{
+	textblock *tb = data;
+
+	textblock_append(tb, "%-22s %5lu %7lu %7lu %9lu %7luk %7luk\n",
+					 stats->name, (unsigned long)stats->size,
+					 (unsigned long)stats->count, (unsigned long)stats->peak,
+					 (unsigned long)stats->total,
+					 (unsigned long)(stats->used / 1024),
+					 (unsigned long)(stats->reserved / 1024));
+}
+
+/**
+ * Show what the memory pools and chunk arenas are holding.
+ */
+static void do_cmd_wiz_memory(void)
+{
+	textblock *tb = textblock_new();
+	region area = { 0, 0, 0, 0 };
+
+	textblock_append(tb, "%-22s %5s %7s %7s %9s %8s %8s\n", "", "size",
+					 "blocks", "peak", "total", "used", "reserved");
+	mem_stats_visit(wiz_memory_line, tb);
+	textui_textblock_show(tb, area, "Memory pools and arenas");
+	textblock_free(tb);
+}
+
+#ifdef USE_PROFILE
+/**
+ * Add the counts for a level, or the session, to a textblock
+ */
+static void wiz_profile_table(textblock *tb, const struct profile_level *level)
+{
+	u32b turns = MAX(level->turns, 1);
+	int i;
+
+	textblock_append(tb, "%-10s %10s %10s %10s %10s\n", "", "calls",
+					 "total ms", "us/turn", "worst ms");
+	for (i = 0; i < PROF_MAX; i++) {
+		textblock_append(tb, "%-10s %10lu %10.1f %10.1f %10.2f\n",
+						 profile_name(i), (unsigned long)level->count[i].calls,
+						 level->count[i].nsecs / 1e6,
+						 level->count[i].nsecs / 1e3 / turns,
+						 level->worst[i] / 1e6);
+	}
+	textblock_append(tb, "%-10s %10s %10.1f %10.1f %10.2f\n\n", "busy", "",
+					 level->busy / 1e6, level->busy / 1e3 / turns,
+					 level->worst_busy / 1e6);
+}
+#endif
+
+/**
+ * Show where the time went on this level, in the session, on recent levels
+ * and in the slowest game turns, and offer to save it all to a CSV file.
+ */
+static void do_cmd_wiz_profile(void)
+{
+#ifdef USE_PROFILE
+	textblock *tb = textblock_new();
+	region area = { 0, 0, 0, 0 };
+	const struct profile_level *level = profile_recent_level(0);
+	const struct profile_turn *t;
+	char path[1024];
+	int i;
+
+	if (level) {
+		textblock_append(tb, "This level (depth %d, %lu game turns)\n",
+						 level->depth, (unsigned long)level->turns);
+		wiz_profile_table(tb, level);
+	}
+	textblock_append(tb, "Whole session (%lu game turns)\n",
+					 (unsigned long)profile_session()->turns);
+	wiz_profile_table(tb, profile_session());
+
+	textblock_append(tb, "Recent levels\n%-10s %10s %10s %10s %10s\n", "",
+					 "depth", "turns", "busy ms", "worst ms");
+	for (i = 0; (level = profile_recent_level(i)) && i < 20; i++) {
+		textblock_append(tb, "%-10s %10d %10lu %10.1f %10.2f\n",
+						 i ? "" : "(current)", level->depth,
+						 (unsigned long)level->turns, level->busy / 1e6,
+						 level->worst_busy / 1e6);
+	}
+
+	textblock_append(tb, "\nSlowest game turns\n%-10s %10s %10s  %s\n",
+					 "turn", "depth", "busy ms", "slowest section");
+	for (i = 0; (t = profile_slowest(i)); i++) {
+		int j, worst = 0;
+
+		for (j = 1; j < PROF_MAX; j++)
+			if (t->count[j].nsecs > t->count[worst].nsecs) worst = j;
+		textblock_append(tb, "%-10ld %10d %10.2f  %s (%.2f ms)\n",
+						 (long)t->turn, t->depth, t->busy / 1e6,
+						 profile_name(worst), t->count[worst].nsecs / 1e6);
+	}
+
+	textui_textblock_show(tb, area, "Profile");
+	textblock_free(tb);
+
+	if (get_check("Write the profile to a CSV file? ")) {
+		path_build(path, sizeof(path), ANGBAND_DIR_USER, "profile.csv");
+		if (profile_dump(path))
+			msg("Wrote %s.", path);
+		else
+			msg("Couldn't write %s.", path);
+	}
+	if (get_check("Reset the profile? "))
+		profile_reset();
+#else
+	msg("The profiler is not compiled in; configure with --enable-profile.");
+#endif
+}
+
 /**
  * Display the debug commands help file.
  */
@@ -2156,6 +2274,13 @@ void get_debug_command(void)
 			break;
 		}
 
+		/* Memory statistics */
+		case 'M':
+		{
+			do_cmd_wiz_memory();
+			break;
+		}
+
 		/* Summon Named Monster */
 		case 'n':
 		{
@@ -2275,6 +2400,13 @@ void get_debug_command(void)
 			break;
 		}
 
+		/* Profile */
+		case 'R':
+		{
+			do_cmd_wiz_profile();
+			break;
+		}
+
 		/* Summon Random Monster(s) */
 		case 's':
 		{
@@ -20,43 +20,68 @@
 
 
 /**
- * Tests if a flag is "on" in a bitflag set.
- *
- * true is returned when `flag` is on in `flags`, and false otherwise.
- * The flagset size is supplied in `size`.
+ * The set operations below work on a machine word of flags at a time, and
+ * then on any bytes left over.  Words are read and written with memcpy(), so
+ * flag sets need no particular alignment; the compiler turns those into
+ * plain loads and stores.
  */
-bool flag_has(const bitflag *flags, const size_t size, const int flag)
-{
-	const size_t flag_offset = FLAG_OFFSET(flag);
-	const int flag_binary = FLAG_BINARY(flag);
-
-	if (flag == FLAG_END) return false;
+typedef u64b flag_word;
+#define WORD_BYTES	sizeof(flag_word)
 
-	assert(flag_offset < size);
-
-	if (flags[flag_offset] & flag_binary) return true;
-
-	return false;
+static inline flag_word word_get(const bitflag *flags)
+{
+	flag_word w;
+	memcpy(&w, flags, WORD_BYTES);
+	return w;
 }
 
-bool flag_has_dbg(const bitflag *flags, const size_t size, const int flag,
-				  const char *fi, const char *fl)
+static inline void word_put(bitflag *flags, flag_word w)
 {
-	const size_t flag_offset = FLAG_OFFSET(flag);
-	const int flag_binary = FLAG_BINARY(flag);
+	memcpy(flags, &w, WORD_BYTES);
+}
 
-	if (flag == FLAG_END) return false;
+/**
+ * Count the bits set in a word
+ */
+static inline int word_count(flag_word w)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(w);
+#else
+	w = w - ((w >> 1) & 0x5555555555555555ULL);
+	w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+	w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
 
-	if (flag_offset >= size) {
-		quit_fmt("Error in flag_has(%s, %s): FlagID[%d] Size[%u] FlagOff[%u] FlagBV[%d]\n",
-		         fi, fl, flag, (unsigned int) size, (unsigned int) flag_offset, flag_binary);
+/**
+ * The position of the lowest bit set in a non-zero byte
+ */
+static inline int byte_first(bitflag b)
+{
+#if defined(__GNUC__)
+	return __builtin_ctz(b);
+#else
+	int n = 0;
+	while (!(b & 1)) {
+		b >>= 1;
+		n++;
 	}
+	return n;
+#endif
+}
 
-	assert(flag_offset < size);
-
-	if (flags[flag_offset] & flag_binary) return true;
 
-	return false;
+/**
+ * Report a flag which is outside its set, and give up
+ */
+void flag_fail(const char *func, const size_t size, const int flag,
+			   const char *fi, const char *fl)
+{
+	quit_fmt("Error in %s(%s, %s): FlagID[%d] Size[%u] FlagOff[%u] FlagBV[%d]\n",
+			 func, fi, fl, flag, (unsigned int) size,
+			 (unsigned int) FLAG_OFFSET(flag), FLAG_BINARY(flag));
 }
 
 
@@ -70,17 +95,26 @@ bool flag_has_dbg(const bitflag *flags, const size_t size, const int flag,
  */
 int flag_next(const bitflag *flags, const size_t size, const int flag)
 {
-	const int max_flags = FLAG_MAX(size);
-	int f, flag_offset, flag_binary;
-
-	for (f = flag; f < max_flags; f++) {
-		flag_offset = FLAG_OFFSET(f);
-		flag_binary = FLAG_BINARY(f);
-
-		if (flags[flag_offset] & flag_binary) return f;
+	size_t i = FLAG_OFFSET(flag == FLAG_END ? FLAG_START : flag);
+	bitflag b;
+
+	if (i >= size) return FLAG_END;
+
+	/* Flags below the start in its byte don't count */
+	b = flags[i] & (bitflag) (0xFF << ((flag == FLAG_END ? 0 :
+										flag - FLAG_START) % FLAG_WIDTH));
+
+	/* Skip empty bytes to a word boundary, then empty words */
+	while (!b) {
+		if (++i >= size) return FLAG_END;
+		if (i % WORD_BYTES == 0)
+			while (i + WORD_BYTES <= size && !word_get(flags + i))
+				i += WORD_BYTES;
+		if (i >= size) return FLAG_END;
+		b = flags[i];
 	}
 
-	return FLAG_END;
+	return (int) (i * FLAG_WIDTH) + byte_first(b) + FLAG_START;
 }
 
 
@@ -91,16 +125,13 @@ int flag_next(const bitflag *flags, const size_t size, const int flag)
  */
 int flag_count(const bitflag *flags, const size_t size)
 {
-	size_t i, j;
+	size_t i = 0;
 	int count = 0;
 
-	for (i = 0; i < size; i++) {
-		for (j = 0; j < FLAG_WIDTH; j++) {
-			if (flags[i] & FLAG_BINARY(j)) {
-				count++;
-			}
-		}
-	}
+	for (; i + WORD_BYTES <= size; i += WORD_BYTES)
+		count += word_count(word_get(flags + i));
+	for (; i < size; i++)
+		count += word_count(flags[i]);
 
 	return count;
 }
@@ -114,10 +145,12 @@ int flag_count(const bitflag *flags, const size_t size)
  */
 bool flag_is_empty(const bitflag *flags, const size_t size)
 {
-	size_t i;
+	size_t i = 0;
 
-	for (i = 0; i < size; i++)
-		if (flags[i] > 0) return false;
+	for (; i + WORD_BYTES <= size; i += WORD_BYTES)
+		if (word_get(flags + i)) return false;
+	for (; i < size; i++)
+		if (flags[i]) return false;
 
 	return true;
 }
@@ -131,9 +164,11 @@ bool flag_is_empty(const bitflag *flags, const size_t size)
  */
 bool flag_is_full(const bitflag *flags, const size_t size)
 {
-	size_t i;
+	size_t i = 0;
 
-	for (i = 0; i < size; i++)
+	for (; i + WORD_BYTES <= size; i += WORD_BYTES)
+		if (word_get(flags + i) != (flag_word) -1) return false;
+	for (; i < size; i++)
 		if (flags[i] != (bitflag) -1) return false;
 
 	return true;
@@ -149,9 +184,11 @@ bool flag_is_full(const bitflag *flags, const size_t size)
 bool flag_is_inter(const bitflag *flags1, const bitflag *flags2,
 				   const size_t size)
 {
-	size_t i;
+	size_t i = 0;
 
-	for (i = 0; i < size; i++)
+	for (; i + WORD_BYTES <= size; i += WORD_BYTES)
+		if (word_get(flags1 + i) & word_get(flags2 + i)) return true;
+	for (; i < size; i++)
 		if (flags1[i] & flags2[i]) return true;
 
 	return false;
@@ -167,9 +204,11 @@ bool flag_is_inter(const bitflag *flags1, const bitflag *flags2,
 bool flag_is_subset(const bitflag *flags1, const bitflag *flags2,
 					const size_t size)
 {
-	size_t i;
+	size_t i = 0;
 
-	for (i = 0; i < size; i++)
+	for (; i + WORD_BYTES <= size; i += WORD_BYTES)
+		if (~word_get(flags1 + i) & word_get(flags2 + i)) return false;
+	for (; i < size; i++)
 		if (~flags1[i] & flags2[i]) return false;
 
 	return true;
@@ -189,70 +228,6 @@ bool flag_is_equal(const bitflag *flags1, const bitflag *flags2,
 }
 
 
-/**
- * Sets one bitflag in a bitfield.
- *
- * The bitflag identified by `flag` is set in `flags`. The bitfield size is
- * supplied in `size`.  true is returned when changes were made, false
- * otherwise.
- */
-bool flag_on(bitflag *flags, const size_t size, const int flag)
-{
-	const size_t flag_offset = FLAG_OFFSET(flag);
-	const int flag_binary = FLAG_BINARY(flag);
-
-	assert(flag_offset < size);
-
-	if (flags[flag_offset] & flag_binary) return false;
-
-	flags[flag_offset] |= flag_binary;
-
-	return true;
-}
-
-bool flag_on_dbg(bitflag *flags, const size_t size, const int flag,
-				 const char *fi, const char *fl)
-{
-	const size_t flag_offset = FLAG_OFFSET(flag);
-	const int flag_binary = FLAG_BINARY(flag);
-
-	if (flag_offset >= size) {
-		quit_fmt("Error in flag_on(%s, %s): FlagID[%d] Size[%u] FlagOff[%u] FlagBV[%d]\n",
-		         fi, fl, flag, (unsigned int) size, (unsigned int) flag_offset, flag_binary);
-	}
-
-	assert(flag_offset < size);
-
-	if (flags[flag_offset] & flag_binary) return false;
-
-	flags[flag_offset] |= flag_binary;
-
-	return true;
-}
-
-
-/**
- * Clears one flag in a bitfield.
- *
- * The bitflag identified by `flag` is cleared in `flags`. The bitfield size
- * is supplied in `size`.  true is returned when changes were made, false
- * otherwise.
- */
-bool flag_off(bitflag *flags, const size_t size, const int flag)
-{
-	const size_t flag_offset = FLAG_OFFSET(flag);
-	const int flag_binary = FLAG_BINARY(flag);
-
-	assert(flag_offset < size);
-
-	if (!(flags[flag_offset] & flag_binary)) return false;
-
-	flags[flag_offset] &= ~flag_binary;
-
-	return true;
-}
-
-
 /**
  * Clears all flags in a bitfield.
  *
@@ -282,9 +257,11 @@ void flag_setall(bitflag *flags, const size_t size)
  */
 void flag_negate(bitflag *flags, const size_t size)
 {
-	size_t i;
-	
-	for (i = 0; i < size; i++)
+	size_t i = 0;
+
+	for (; i + WORD_BYTES <= size; i += WORD_BYTES)
+		word_put(flags + i, ~word_get(flags + i));
+	for (; i < size; i++)
 		flags[i] = ~flags[i];
 }
 
@@ -310,17 +287,22 @@ void flag_copy(bitflag *flags1, const bitflag *flags2, const size_t size)
  */
 bool flag_union(bitflag *flags1, const bitflag *flags2, const size_t size)
 {
-	size_t i;
-	bool delta = false;
+	size_t i = 0;
+	flag_word delta = 0;
 
-	for (i = 0; i < size; i++) {
-		/* !flag_is_subset() */
-		if (~flags1[i] & flags2[i]) delta = true;
+	for (; i + WORD_BYTES <= size; i += WORD_BYTES) {
+		flag_word w1 = word_get(flags1 + i), w2 = word_get(flags2 + i);
 
+		/* !flag_is_subset() */
+		delta |= ~w1 & w2;
+		word_put(flags1 + i, w1 | w2);
+	}
+	for (; i < size; i++) {
+		delta |= (bitflag) (~flags1[i] & flags2[i]);
 		flags1[i] |= flags2[i];
 	}
 
-	return delta;
+	return delta ? true : false;
 }
 
 
@@ -333,18 +315,22 @@ bool flag_union(bitflag *flags1, const bitflag *flags2, const size_t size)
  */
 bool flag_inter(bitflag *flags1, const bitflag *flags2, const size_t size)
 {
-	size_t i;
-	bool delta = false;
+	size_t i = 0;
+	flag_word delta = 0;
 
-	for (i = 0; i < size; i++) {
-		/* !flag_is_equal() */
-		if (!(flags1[i] == flags2[i])) delta = true;
+	for (; i + WORD_BYTES <= size; i += WORD_BYTES) {
+		flag_word w1 = word_get(flags1 + i), w2 = word_get(flags2 + i);
 
+		/* !flag_is_equal() */
+		delta |= w1 ^ w2;
+		word_put(flags1 + i, w1 & w2);
+	}
+	for (; i < size; i++) {
+		delta |= flags1[i] ^ flags2[i];
 		flags1[i] &= flags2[i];
 	}
 
-	return delta;
-
+	return delta ? true : false;
 }
 
 
@@ -357,17 +343,22 @@ bool flag_inter(bitflag *flags1, const bitflag *flags2, const size_t size)
  */
 bool flag_diff(bitflag *flags1, const bitflag *flags2, const size_t size)
 {
-	size_t i;
-	bool delta = false;
+	size_t i = 0;
+	flag_word delta = 0;
 
-	for (i = 0; i < size; i++) {
-		/* flag_is_inter() */
-		if (flags1[i] & flags2[i]) delta = true;
+	for (; i + WORD_BYTES <= size; i += WORD_BYTES) {
+		flag_word w1 = word_get(flags1 + i), w2 = word_get(flags2 + i);
 
+		/* flag_is_inter() */
+		delta |= w1 & w2;
+		word_put(flags1 + i, w1 & ~w2);
+	}
+	for (; i < size; i++) {
+		delta |= flags1[i] & flags2[i];
 		flags1[i] &= ~flags2[i];
 	}
 
-	return delta;
+	return delta ? true : false;
 }
 
 
@@ -568,10 +559,13 @@ bool flags_mask(bitflag *flags, const size_t size, ...)
 	va_list args;
 	bool delta = false;
 
-	bitflag *mask;
+	bitflag buf[64], *mask = buf;
 
-	/* Build the mask */
-	mask = mem_zalloc(size * sizeof(bitflag));
+	/* Build the mask; most flag sets are small enough not to need memory */
+	if (size > N_ELEMENTS(buf))
+		mask = mem_zalloc(size * sizeof(bitflag));
+	else
+		memset(mask, 0, size * sizeof(bitflag));
 
 	va_start(args, size);
 
@@ -584,8 +578,8 @@ bool flags_mask(bitflag *flags, const size_t size, ...)
 	delta = flag_inter(flags, mask, size);
 
 	/* Free the mask */
-
-	mem_free(mask);
+	if (mask != buf)
+		mem_free(mask);
 
 	return delta;
 }
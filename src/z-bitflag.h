@@ -58,10 +58,103 @@ typedef byte bitflag;
  */
 #define FLAG_BINARY(id)   (1 << ((id) - FLAG_START) % FLAG_WIDTH)
 
+void flag_fail(const char *func, const size_t size, const int flag,
+			   const char *fi, const char *fl);
+
+/**
+ * Testing, setting and clearing single flags is done all over the game, so
+ * these are inline; when the size is a constant, as it is for the *_has()
+ * and *_on() macros, the bounds check costs nothing.
+ */
+
+/**
+ * Tests if a flag is "on" in a bitflag set.
+ *
+ * true is returned when `flag` is on in `flags`, and false otherwise.
+ * The flagset size is supplied in `size`.
+ */
+static inline bool flag_has(const bitflag *flags, const size_t size,
+							const int flag)
+{
+	const size_t flag_offset = FLAG_OFFSET(flag);
+
+	if (flag == FLAG_END) return false;
+
+	assert(flag_offset < size);
+
+	return (flags[flag_offset] & FLAG_BINARY(flag)) ? true : false;
+}
+
+static inline bool flag_has_dbg(const bitflag *flags, const size_t size,
+								const int flag, const char *fi, const char *fl)
+{
+	const size_t flag_offset = FLAG_OFFSET(flag);
+
+	if (flag == FLAG_END) return false;
+
+	if (flag_offset >= size) flag_fail("flag_has", size, flag, fi, fl);
+
+	return (flags[flag_offset] & FLAG_BINARY(flag)) ? true : false;
+}
+
+/**
+ * Sets one bitflag in a bitfield.
+ *
+ * The bitflag identified by `flag` is set in `flags`. The bitfield size is
+ * supplied in `size`.  true is returned when changes were made, false
+ * otherwise.
+ */
+static inline bool flag_on(bitflag *flags, const size_t size, const int flag)
+{
+	const size_t flag_offset = FLAG_OFFSET(flag);
+	const int flag_binary = FLAG_BINARY(flag);
+
+	assert(flag_offset < size);
+
+	if (flags[flag_offset] & flag_binary) return false;
+
+	flags[flag_offset] |= flag_binary;
+
+	return true;
+}
+
+static inline bool flag_on_dbg(bitflag *flags, const size_t size,
+							   const int flag, const char *fi, const char *fl)
+{
+	const size_t flag_offset = FLAG_OFFSET(flag);
+	const int flag_binary = FLAG_BINARY(flag);
+
+	if (flag_offset >= size) flag_fail("flag_on", size, flag, fi, fl);
+
+	if (flags[flag_offset] & flag_binary) return false;
+
+	flags[flag_offset] |= flag_binary;
+
+	return true;
+}
+
+/**
+ * Clears one flag in a bitfield.
+ *
+ * The bitflag identified by `flag` is cleared in `flags`. The bitfield size
+ * is supplied in `size`.  true is returned when changes were made, false
+ * otherwise.
+ */
+static inline bool flag_off(bitflag *flags, const size_t size, const int flag)
+{
+	const size_t flag_offset = FLAG_OFFSET(flag);
+	const int flag_binary = FLAG_BINARY(flag);
+
+	assert(flag_offset < size);
+
+	if (!(flags[flag_offset] & flag_binary)) return false;
+
+	flags[flag_offset] &= ~flag_binary;
+
+	return true;
+}
+
 
-bool flag_has       (const bitflag *flags, const size_t size, const int flag);
-bool flag_has_dbg   (const bitflag *flags, const size_t size, const int flag,
-					 const char *fi, const char *fl);
 int  flag_next      (const bitflag *flags, const size_t size, const int flag);
 int  flag_count     (const bitflag *flags, const size_t size);
 bool flag_is_empty  (const bitflag *flags, const size_t size);
@@ -72,10 +165,6 @@ bool flag_is_subset (const bitflag *flags1, const bitflag *flags2,
 					 const size_t size);
 bool flag_is_equal  (const bitflag *flags1, const bitflag *flags2,
 					 const size_t size);
-bool flag_on        (bitflag *flags, const size_t size, const int flag);
-bool flag_on_dbg    (bitflag *flags, const size_t size, const int flag,
-					 const char *fi, const char *fl);
-bool flag_off       (bitflag *flags, const size_t size, const int flag);
 void flag_wipe      (bitflag *flags, const size_t size);
 void flag_setall    (bitflag *flags, const size_t size);
 void flag_negate    (bitflag *flags, const size_t size);
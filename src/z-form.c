@@ -559,8 +559,9 @@ void strnfcat(char *str, size_t max, size_t *end, const char *fmt, ...)
 }
 
 
-static char *format_buf = NULL;
-static size_t format_len = 0;
+/* Each thread formats into its own buffer */
+static THREAD_LOCAL char *format_buf = NULL;
+static THREAD_LOCAL size_t format_len = 0;
 
 
 /**
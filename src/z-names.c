@@ -0,0 +1,182 @@
+/**
+ * \file z-names.c
+ * \brief Case-insensitive lookup of indices by name
+ *
+ * Copyright (c) 2026 Angband developers
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+#include "z-names.h"
+#include "z-util.h"
+#include "z-virt.h"
+
+#define NAME_MAP_MIN	16
+
+/**
+ * Open-addressed table of names and values; a NULL name marks an empty slot.
+ * The size is a power of two and the table is kept at most half full.
+ */
+struct name_map {
+	char **names;
+	int *values;
+	size_t size;
+	size_t count;
+};
+
+/**
+ * Hash a name the same way regardless of case; this is djb2 on the
+ * upper-cased characters, to agree with my_stricmp()
+ */
+static u32b name_hash(const char *name)
+{
+	u32b hash = 5381;
+
+	while (*name) {
+		hash = ((hash << 5) + hash) + toupper((unsigned char) *name);
+		name++;
+	}
+
+	return hash;
+}
+
+/**
+ * Find the slot for a name - either the slot holding it, or the empty slot
+ * where it belongs
+ */
+static size_t name_map_slot(const struct name_map *map, const char *name)
+{
+	size_t mask = map->size - 1;
+	size_t i = name_hash(name) & mask;
+
+	while (map->names[i] && my_stricmp(map->names[i], name))
+		i = (i + 1) & mask;
+
+	return i;
+}
+
+/**
+ * Set the table size, rehashing everything already present
+ */
+static void name_map_resize(struct name_map *map, size_t size)
+{
+	char **old_names = map->names;
+	int *old_values = map->values;
+	size_t i, old_size = map->size;
+
+	map->names = mem_zalloc(size * sizeof(*map->names));
+	map->values = mem_zalloc(size * sizeof(*map->values));
+	map->size = size;
+
+	for (i = 0; i < old_size; i++) {
+		size_t slot;
+
+		if (!old_names[i]) continue;
+		slot = name_map_slot(map, old_names[i]);
+		map->names[slot] = old_names[i];
+		map->values[slot] = old_values[i];
+	}
+
+	mem_free(old_names);
+	mem_free(old_values);
+}
+
+struct name_map *name_map_new(size_t n)
+{
+	struct name_map *map = mem_zalloc(sizeof(*map));
+	size_t size = NAME_MAP_MIN;
+
+	while (size < n * 2)
+		size *= 2;
+	name_map_resize(map, size);
+
+	return map;
+}
+
+void name_map_add(struct name_map *map, const char *name, int value)
+{
+	size_t slot = name_map_slot(map, name);
+
+	if (map->names[slot]) return;
+
+	map->names[slot] = string_make(name);
+	map->values[slot] = value;
+	map->count++;
+
+	if (map->count * 2 > map->size)
+		name_map_resize(map, map->size * 2);
+}
+
+void name_map_set(struct name_map *map, const char *name, int value)
+{
+	size_t slot = name_map_slot(map, name);
+
+	if (map->names[slot])
+		map->values[slot] = value;
+	else
+		name_map_add(map, name, value);
+}
+
+/**
+ * Removing a name leaves no gap in the probe sequences: each later name in
+ * the same run is moved back into the hole if its home slot allows it
+ */
+bool name_map_remove(struct name_map *map, const char *name)
+{
+	size_t mask = map->size - 1;
+	size_t hole = name_map_slot(map, name);
+	size_t i;
+
+	if (!map->names[hole]) return false;
+
+	string_free(map->names[hole]);
+	map->names[hole] = NULL;
+	map->count--;
+
+	for (i = (hole + 1) & mask; map->names[i]; i = (i + 1) & mask) {
+		size_t home = name_hash(map->names[i]) & mask;
+
+		/* Leave names which would be found before reaching the hole */
+		if (((i - home) & mask) < ((i - hole) & mask)) continue;
+
+		map->names[hole] = map->names[i];
+		map->values[hole] = map->values[i];
+		map->names[i] = NULL;
+		hole = i;
+	}
+
+	return true;
+}
+
+int name_map_find(const struct name_map *map, const char *name)
+{
+	size_t slot = name_map_slot(map, name);
+
+	return map->names[slot] ? map->values[slot] : -1;
+}
+
+size_t name_map_count(const struct name_map *map)
+{
+	return map->count;
+}
+
+void name_map_free(struct name_map *map)
+{
+	size_t i;
+
+	if (!map) return;
+
+	for (i = 0; i < map->size; i++)
+		string_free(map->names[i]);
+	mem_free(map->names);
+	mem_free(map->values);
+	mem_free(map);
+}
@@ -0,0 +1,66 @@
+/**
+ * \file z-names.h
+ * \brief Case-insensitive lookup of indices by name
+ *
+ * Copyright (c) 2026 Angband developers
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+
+#ifndef INCLUDED_Z_NAMES_H
+#define INCLUDED_Z_NAMES_H
+
+#include "h-basic.h"
+
+/**
+ * A hash table mapping names, compared as by my_stricmp(), to non-negative
+ * values such as indices into an info array
+ */
+struct name_map;
+
+/**
+ * Make an empty map with room for at least n names before it has to grow
+ */
+struct name_map *name_map_new(size_t n);
+
+/**
+ * Map 'name' to 'value'; if the name is already present, the existing
+ * value is kept, so that the first of several equal names wins
+ */
+void name_map_add(struct name_map *map, const char *name, int value);
+
+/**
+ * Map 'name' to 'value', replacing any value it already has
+ */
+void name_map_set(struct name_map *map, const char *name, int value);
+
+/**
+ * Remove 'name' from the map; return whether it was there
+ */
+bool name_map_remove(struct name_map *map, const char *name);
+
+/**
+ * Return the value for 'name', or -1 if it is not present
+ */
+int name_map_find(const struct name_map *map, const char *name);
+
+/**
+ * Return the number of names in the map
+ */
+size_t name_map_count(const struct name_map *map);
+
+/**
+ * Free a map and its copies of the names
+ */
+void name_map_free(struct name_map *map);
+
+#endif /* !INCLUDED_Z_NAMES_H */
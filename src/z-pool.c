@@ -0,0 +1,288 @@
+/**
+ * \file z-pool.c
+ * \brief Pools of fixed-size blocks, and arenas freed all at once
+ *
+ * Copyright (c) 2026 Angband developers
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+#include "z-pool.h"
+#include "z-util.h"
+#include "z-virt.h"
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+/**
+ * Blocks are aligned as strictly as anything mem_alloc() returns is likely
+ * to need to be
+ */
+union mem_align {
+	void *p;
+	long l;
+	double d;
+};
+
+#define MEM_ALIGN		sizeof(union mem_align)
+#define MEM_ROUND(n)	(((n) + MEM_ALIGN - 1) / MEM_ALIGN * MEM_ALIGN)
+
+/**
+ * A slab of pool blocks; the blocks follow the header
+ */
+struct pool_slab {
+	struct pool_slab *next;
+};
+
+#define SLAB_HEADER		MEM_ROUND(sizeof(struct pool_slab))
+
+struct mem_pool {
+	struct mem_stats stats;
+	size_t per_slab;
+	struct pool_slab *slabs;
+
+	/* Freed blocks, linked through their first bytes */
+	void *free_list;
+
+	/* Blocks of the newest slab not yet handed out */
+	char *fresh;
+	size_t fresh_count;
+
+	struct mem_pool *next;
+};
+
+/**
+ * A block of arena memory; the memory follows the header
+ */
+struct arena_block {
+	struct arena_block *next;
+};
+
+#define BLOCK_HEADER	MEM_ROUND(sizeof(struct arena_block))
+
+struct mem_arena {
+	struct mem_stats stats;
+	size_t block;
+	struct arena_block *blocks;
+
+	/* Unused end of the current block */
+	char *fresh;
+	size_t fresh_len;
+
+	struct mem_arena *next;
+};
+
+/**
+ * Everything in existence, for statistics
+ */
+static struct mem_pool *pools;
+static struct mem_arena *arenas;
+
+/**
+ * Pools are shared by every thread, so levels can be generated in the
+ * background; an arena is only ever used by one thread at a time, but the
+ * list of them is shared
+ */
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+# define POOL_LOCK()	pthread_mutex_lock(&pool_lock)
+# define POOL_UNLOCK()	pthread_mutex_unlock(&pool_lock)
+#else
+# define POOL_LOCK()
+# define POOL_UNLOCK()
+#endif
+
+/**
+ * Note an allocation of 'len' bytes in a set of statistics
+ */
+static void stats_alloc(struct mem_stats *stats, size_t len)
+{
+	stats->count++;
+	stats->total++;
+	stats->used += len;
+	if (stats->count > stats->peak)
+		stats->peak = stats->count;
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * Pools
+ * ------------------------------------------------------------------------ */
+struct mem_pool *mem_pool_new(const char *name, size_t size, size_t per_slab)
+{
+	struct mem_pool *pool = mem_zalloc(sizeof(*pool));
+
+	/* Freed blocks must hold a pointer */
+	pool->stats.name = name;
+	pool->stats.size = MEM_ROUND(MAX(size, sizeof(void *)));
+	pool->per_slab = MAX(per_slab, 1);
+
+	POOL_LOCK();
+	pool->next = pools;
+	pools = pool;
+	POOL_UNLOCK();
+	return pool;
+}
+
+void *mem_pool_alloc(struct mem_pool *pool)
+{
+	void *p;
+
+	POOL_LOCK();
+	if (pool->free_list) {
+		p = pool->free_list;
+		pool->free_list = *(void **)p;
+	} else {
+		if (!pool->fresh_count) {
+			size_t len = SLAB_HEADER + pool->per_slab * pool->stats.size;
+			struct pool_slab *slab = mem_alloc(len);
+
+			slab->next = pool->slabs;
+			pool->slabs = slab;
+			pool->fresh = (char *)slab + SLAB_HEADER;
+			pool->fresh_count = pool->per_slab;
+			pool->stats.reserved += len;
+		}
+		p = pool->fresh;
+		pool->fresh += pool->stats.size;
+		pool->fresh_count--;
+	}
+	stats_alloc(&pool->stats, pool->stats.size);
+	POOL_UNLOCK();
+
+	memset(p, 0, pool->stats.size);
+	return p;
+}
+
+void mem_pool_free(struct mem_pool *pool, void *p)
+{
+	if (!p) return;
+
+	if (mem_flags & MEM_POISON_FREE)
+		memset(p, 0xCD, pool->stats.size);
+	POOL_LOCK();
+	*(void **)p = pool->free_list;
+	pool->free_list = p;
+
+	pool->stats.count--;
+	pool->stats.used -= pool->stats.size;
+	POOL_UNLOCK();
+}
+
+void mem_pool_destroy(struct mem_pool *pool)
+{
+	struct mem_pool **link = &pools;
+
+	if (!pool) return;
+
+	POOL_LOCK();
+	while (*link != pool)
+		link = &(*link)->next;
+	*link = pool->next;
+	POOL_UNLOCK();
+
+	while (pool->slabs) {
+		struct pool_slab *next = pool->slabs->next;
+		mem_free(pool->slabs);
+		pool->slabs = next;
+	}
+	mem_free(pool);
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * Arenas
+ * ------------------------------------------------------------------------ */
+struct mem_arena *mem_arena_new(const char *name, size_t block)
+{
+	struct mem_arena *arena = mem_zalloc(sizeof(*arena));
+
+	arena->stats.name = name;
+	arena->block = MEM_ROUND(MAX(block, MEM_ALIGN));
+
+	POOL_LOCK();
+	arena->next = arenas;
+	arenas = arena;
+	POOL_UNLOCK();
+	return arena;
+}
+
+void *mem_arena_alloc(struct mem_arena *arena, size_t len)
+{
+	void *p;
+
+	/* Allow allocation of "zero bytes" */
+	if (len == 0) return NULL;
+	len = MEM_ROUND(len);
+
+	if (len > arena->fresh_len) {
+		size_t size = MAX(len, arena->block);
+		struct arena_block *block = mem_zalloc(BLOCK_HEADER + size);
+
+		block->next = arena->blocks;
+		arena->blocks = block;
+		arena->stats.reserved += BLOCK_HEADER + size;
+
+		/* Keep the rest of the current block if this one is used up */
+		if (size - len >= arena->fresh_len) {
+			arena->fresh = (char *)block + BLOCK_HEADER;
+			arena->fresh_len = size;
+		} else {
+			stats_alloc(&arena->stats, len);
+			return (char *)block + BLOCK_HEADER;
+		}
+	}
+
+	p = arena->fresh;
+	arena->fresh += len;
+	arena->fresh_len -= len;
+
+	stats_alloc(&arena->stats, len);
+	return p;
+}
+
+void mem_arena_destroy(struct mem_arena *arena)
+{
+	struct mem_arena **link = &arenas;
+
+	if (!arena) return;
+
+	POOL_LOCK();
+	while (*link != arena)
+		link = &(*link)->next;
+	*link = arena->next;
+	POOL_UNLOCK();
+
+	while (arena->blocks) {
+		struct arena_block *next = arena->blocks->next;
+		mem_free(arena->blocks);
+		arena->blocks = next;
+	}
+	mem_free(arena);
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * Statistics
+ * ------------------------------------------------------------------------ */
+void mem_stats_visit(void (*visit)(const struct mem_stats *stats, void *data),
+					 void *data)
+{
+	struct mem_pool *pool;
+	struct mem_arena *arena;
+
+	POOL_LOCK();
+	for (pool = pools; pool; pool = pool->next)
+		visit(&pool->stats, data);
+	for (arena = arenas; arena; arena = arena->next)
+		visit(&arena->stats, data);
+	POOL_UNLOCK();
+}
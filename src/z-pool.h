@@ -0,0 +1,91 @@
+/**
+ * \file z-pool.h
+ * \brief Pools of fixed-size blocks, and arenas freed all at once
+ *
+ * Copyright (c) 2026 Angband developers
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+
+#ifndef INCLUDED_Z_POOL_H
+#define INCLUDED_Z_POOL_H
+
+#include "h-basic.h"
+
+/**
+ * A pool hands out blocks of one size, carved from large slabs; freed blocks
+ * are kept for reuse rather than returned to the system
+ */
+struct mem_pool;
+
+/**
+ * An arena hands out blocks of any size, which are only freed together when
+ * the arena is destroyed
+ */
+struct mem_arena;
+
+/**
+ * Allocation statistics for a pool or an arena
+ */
+struct mem_stats {
+	const char *name;
+	size_t size;		/* Bytes per block for a pool, 0 for an arena */
+	size_t count;		/* Blocks in use */
+	size_t peak;		/* Most blocks in use at once */
+	size_t total;		/* Blocks ever handed out */
+	size_t used;		/* Bytes in use */
+	size_t reserved;	/* Bytes taken from the system */
+};
+
+/**
+ * Make a pool of blocks of 'size' bytes, allocated 'per_slab' at a time
+ */
+struct mem_pool *mem_pool_new(const char *name, size_t size, size_t per_slab);
+
+/**
+ * Return a zeroed block from a pool
+ */
+void *mem_pool_alloc(struct mem_pool *pool);
+
+/**
+ * Return a block to the pool it came from; NULL is ignored
+ */
+void mem_pool_free(struct mem_pool *pool, void *p);
+
+/**
+ * Free a pool and every block in it
+ */
+void mem_pool_destroy(struct mem_pool *pool);
+
+/**
+ * Make an arena which takes memory from the system 'block' bytes at a time
+ */
+struct mem_arena *mem_arena_new(const char *name, size_t block);
+
+/**
+ * Return 'len' zeroed bytes from an arena
+ */
+void *mem_arena_alloc(struct mem_arena *arena, size_t len);
+
+/**
+ * Free an arena and everything allocated from it
+ */
+void mem_arena_destroy(struct mem_arena *arena);
+
+/**
+ * Call 'visit' with the statistics of every pool and arena in existence,
+ * pools first
+ */
+void mem_stats_visit(void (*visit)(const struct mem_stats *stats, void *data),
+					 void *data);
+
+#endif /* !INCLUDED_Z_POOL_H */
@@ -19,22 +19,64 @@
  */
 #include "z-virt.h"
 #include "z-quark.h"
+#include "z-util.h"
 #include "init.h"
 
 static char **quarks;
 static size_t nr_quarks = 1;
 static size_t alloc_quarks = 0;
 
+/**
+ * Open-addressed index into quarks[], keyed on the string hash; 0 marks an
+ * empty slot, since quark 0 is never handed out.  The table size is a power
+ * of two and is kept at most half full.
+ */
+static quark_t *quark_table;
+static size_t quark_table_size = 0;
+
 #define QUARKS_INIT	16
 
-quark_t quark_add(const char *str)
+/**
+ * Find the table slot for a string - either the slot holding its quark, or
+ * the empty slot where its quark belongs.
+ */
+static size_t quark_slot(const char *str)
+{
+	size_t mask = quark_table_size - 1;
+	size_t i = djb2_hash(str) & mask;
+
+	while (quark_table[i] && strcmp(quarks[quark_table[i]], str))
+		i = (i + 1) & mask;
+
+	return i;
+}
+
+/**
+ * Make the hash table big enough for a number of quarks, rehashing the
+ * existing ones if it has to grow
+ */
+static void quark_table_resize(size_t wanted)
 {
+	size_t size = quark_table_size ? quark_table_size : QUARKS_INIT * 2;
 	quark_t q;
 
-	for (q = 1; q < nr_quarks; q++) {
-		if (!strcmp(quarks[q], str))
-			return q;
-	}
+	while (size < wanted * 2)
+		size *= 2;
+	if (size == quark_table_size) return;
+
+	mem_free(quark_table);
+	quark_table = mem_zalloc(size * sizeof(quark_t));
+	quark_table_size = size;
+	for (q = 1; q < nr_quarks; q++)
+		quark_table[quark_slot(quarks[q])] = q;
+}
+
+quark_t quark_add(const char *str)
+{
+	size_t slot = quark_slot(str);
+	quark_t q = quark_table[slot];
+
+	if (q) return q;
 
 	if (nr_quarks == alloc_quarks) {
 		alloc_quarks *= 2;
@@ -44,6 +86,12 @@ quark_t quark_add(const char *str)
 	q = nr_quarks++;
 	quarks[q] = string_make(str);
 
+	/* Grow the table if needed, otherwise use the slot already found */
+	if (nr_quarks * 2 > quark_table_size)
+		quark_table_resize(nr_quarks);
+	else
+		quark_table[slot] = q;
+
 	return q;
 }
 
@@ -52,10 +100,24 @@ const char *quark_str(quark_t q)
 	return (q >= nr_quarks ? NULL : quarks[q]);
 }
 
+void quarks_reserve(size_t n)
+{
+	size_t wanted = nr_quarks + n;
+
+	if (wanted > alloc_quarks) {
+		while (alloc_quarks < wanted)
+			alloc_quarks *= 2;
+		quarks = mem_realloc(quarks, alloc_quarks * sizeof(char *));
+	}
+
+	quark_table_resize(wanted);
+}
+
 void quarks_init(void)
 {
 	alloc_quarks = QUARKS_INIT;
 	quarks = mem_zalloc(alloc_quarks * sizeof(char*));
+	quark_table_resize(alloc_quarks);
 }
 
 void quarks_free(void)
@@ -67,6 +129,12 @@ void quarks_free(void)
 		string_free(quarks[i]);
 
 	mem_free(quarks);
+	mem_free(quark_table);
+	quarks = NULL;
+	quark_table = NULL;
+	nr_quarks = 1;
+	alloc_quarks = 0;
+	quark_table_size = 0;
 }
 
 struct init_module z_quark_module = {
@@ -39,6 +39,12 @@ quark_t quark_add(const char *str);
  */
 const char *quark_str(quark_t q);
 
+/**
+ * Make room for at least n more quarks, so that adding them all does not
+ * need the storage to grow; for use before interning many strings at once
+ */
+void quarks_reserve(size_t n);
+
 /**
  * Initialise the quarks package
  */
@@ -33,6 +33,9 @@
  * "Rand_value = seed". After that it will be automatically used instead of
  * the "complex" RNG. When you are done, you can de-activate it via
  * "Rand_quick = false". You can also choose a new seed.
+ *
+ * Where threads are available each thread has its own state for both
+ * generators, and a new thread starts with the "quick" one.
  */
 
 /* begin WELL RNG
@@ -50,12 +53,12 @@
 #define MAT0NEG(t, v) (v ^ (v << (-(t))))
 #define Identity(v) (v)
 
-u32b state_i = 0;
-u32b STATE[RAND_DEG] = {0, 0, 0, 0, 0, 0, 0, 0,
+THREAD_LOCAL u32b state_i = 0;
+THREAD_LOCAL u32b STATE[RAND_DEG] = {0, 0, 0, 0, 0, 0, 0, 0,
 						0, 0, 0, 0, 0, 0, 0, 0,
 						0, 0, 0, 0, 0, 0, 0, 0,
 						0, 0, 0, 0, 0, 0, 0, 0};
-u32b z0, z1, z2;
+THREAD_LOCAL u32b z0, z1, z2;
 
 #define V0    STATE[state_i]
 #define VM1   STATE[(state_i + M1) & 0x0000001fU]
@@ -85,15 +88,15 @@ static u32b WELLRNG1024a (void){
 /**
  * Whether to use the simple RNG or not.
  */
-bool Rand_quick = true;
+THREAD_LOCAL bool Rand_quick = true;
 
 /**
  * The current "seed" of the simple RNG.
  */
-u32b Rand_value;
+THREAD_LOCAL u32b Rand_value;
 
-static bool rand_fixed = false;
-static u32b rand_fixval = 0;
+static THREAD_LOCAL bool rand_fixed = false;
+static THREAD_LOCAL u32b rand_fixval = 0;
 
 /**
  * Initialize the complex RNG using a new seed.
@@ -122,6 +125,36 @@ void Rand_state_init(u32b seed)
 	}
 }
 
+/**
+ * Set a saved RNG state to start from the given seed; unlike
+ * Rand_state_init(), the result only depends on the seed
+ */
+void Rand_state_seed(struct rand_state *s, u32b seed)
+{
+	struct rand_state fresh = { 0 };
+
+	Rand_state_swap(&fresh);
+	Rand_state_init(seed);
+	Rand_state_swap(&fresh);
+	*s = fresh;
+}
+
+/**
+ * Exchange the RNG state with a saved one, so that later numbers come from
+ * the saved stream, and the current stream can be picked up again by
+ * swapping back
+ */
+void Rand_state_swap(struct rand_state *s)
+{
+	struct rand_state old;
+
+	old.state_i = state_i;
+	memcpy(old.STATE, STATE, sizeof(STATE));
+	state_i = s->state_i % RAND_DEG;
+	memcpy(STATE, s->STATE, sizeof(STATE));
+	*s = old;
+}
+
 /**
  * Initialise the RNG
  */
@@ -49,6 +49,15 @@ typedef struct random {
  */
 #define RAND_DEG 32
 
+/**
+ * A saved state of the "complex" RNG, so that part of the game can draw on a
+ * stream of numbers of its own
+ */
+struct rand_state {
+	u32b state_i;
+	u32b STATE[RAND_DEG];
+};
+
 /**
  * Random aspects used by damcalc, m_bonus_calc, and ranvals
  */
@@ -92,21 +101,21 @@ typedef enum {
 /**
  * Whether we are currently using the "quick" method or not.
  */
-extern bool Rand_quick;
+extern THREAD_LOCAL bool Rand_quick;
 
 /**
  * The state used by the "quick" RNG.
  */
-extern u32b Rand_value;
+extern THREAD_LOCAL u32b Rand_value;
 
 /**
  * The state used by the "complex" RNG.
  */
-extern u32b state_i;
-extern u32b STATE[RAND_DEG];
-extern u32b z0;
-extern u32b z1;
-extern u32b z2;
+extern THREAD_LOCAL u32b state_i;
+extern THREAD_LOCAL u32b STATE[RAND_DEG];
+extern THREAD_LOCAL u32b z0;
+extern THREAD_LOCAL u32b z1;
+extern THREAD_LOCAL u32b z2;
 
 
 /**
@@ -114,6 +123,16 @@ extern u32b z2;
  */
 void Rand_state_init(u32b seed);
 
+/**
+ * Set a saved RNG state to start from the given seed.
+ */
+void Rand_state_seed(struct rand_state *s, u32b seed);
+
+/**
+ * Exchange the RNG state with a saved one.
+ */
+void Rand_state_swap(struct rand_state *s);
+
 /**
  * Initialise the RNG
  */